@@ -0,0 +1,140 @@
+// Measures the lookup throughput of the player registry from many I/O threads.
+//
+// Usage: Merrie_Commons_Benchmark_ShardedHashMap [threads] [seconds per scenario] [players]
+//
+// Every thread looks up random players, like the I/O threads do for every received packet. The scenarios compare a single
+// std::map behind one std::shared_mutex with the ShardedHashMap, with lookups only and with some of the lookups creating
+// new players.
+
+#include <Commons/Containers.hpp>
+#include <Commons/Time.hpp>
+
+#include <cstdio>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+using namespace Merrie;
+
+namespace {
+    using _Value = std::shared_ptr<uint64_t>;
+
+    struct _Scenario {
+        const char* Name;
+        uint32_t CreatePerMille; // how many of the lookups are of new keys
+    };
+
+    /**
+     * The registry as it used to be, one map behind one lock.
+     */
+    class _LockedMap {
+        public:
+            std::optional<_Value> Find(uint64_t key) const {
+                std::shared_lock lock(m_mutex);
+                return FindInMap(m_values, key);
+            }
+
+            template<typename Factory>
+            std::pair<_Value, bool> GetOrCreate(uint64_t key, Factory factory) {
+                {
+                    std::shared_lock lock(m_mutex);
+                    const auto iterator = m_values.find(key);
+
+                    if (iterator != m_values.end())
+                        return {iterator->second, false};
+                }
+
+                std::unique_lock lock(m_mutex);
+                const auto[iterator, created] = m_values.try_emplace(key, factory());
+                return {iterator->second, created};
+            }
+
+        private:
+            mutable std::shared_mutex m_mutex{};
+            std::map<uint64_t, _Value> m_values{};
+    };
+
+    /**
+     * Looks up random keys until the time is up, returns the amount of the lookups.
+     */
+    template<typename Map>
+    uint64_t _RunThread(Map& map, const _Scenario& scenario, uint64_t keyCount, uint64_t seed, DefaultClock::time_point end) {
+        std::mt19937_64 random(seed);
+        std::uniform_int_distribution<uint64_t> keys(0, keyCount - 1);
+        std::uniform_int_distribution<uint32_t> perMille(0, 999);
+
+        uint64_t lookups = 0;
+        uint64_t found = 0;
+
+        // checking the clock on every lookup would cost more than the lookup
+        while (DefaultClock::now() < end) {
+            for (int i = 0; i < 1024; i++) {
+                if (perMille(random) < scenario.CreatePerMille) {
+                    const uint64_t key = keyCount + random();
+                    map.GetOrCreate(key, [key]() {
+                        return std::make_shared<uint64_t>(key);
+                    });
+                } else {
+                    found += map.Find(keys(random)).has_value();
+                }
+            }
+
+            lookups += 1024;
+        }
+
+        if (found == 0)
+            std::printf("no keys were found\n");
+
+        return lookups;
+    }
+
+    template<typename Map>
+    void _RunScenario(const char* mapName, const _Scenario& scenario, size_t threadCount, std::chrono::seconds duration, uint64_t keyCount) {
+        Map map;
+
+        for (uint64_t key = 0; key < keyCount; key++) {
+            map.GetOrCreate(key, [key]() {
+                return std::make_shared<uint64_t>(key);
+            });
+        }
+
+        const auto end = DefaultClock::now() + duration;
+        std::vector<std::thread> threads;
+        std::atomic<uint64_t> lookups{0};
+
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&, i] {
+                lookups += _RunThread(map, scenario, keyCount, i + 1, end);
+            });
+        }
+
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        std::printf("%-30s %-30s %10.2f M lookups/s\n",
+                    mapName,
+                    scenario.Name,
+                    static_cast<double>(lookups.load()) / static_cast<double>(duration.count()) / 1e6);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t threadCount = argc > 1 ? std::stoul(argv[1]) : 64;
+    const std::chrono::seconds duration(argc > 2 ? std::stoul(argv[2]) : 5);
+    const uint64_t keyCount = argc > 3 ? std::stoull(argv[3]) : 10000;
+
+    const _Scenario scenarios[] = {
+            {"lookups only",    0},
+            {"1% joining",      10},
+    };
+
+    std::printf("%zu threads, %ld seconds per scenario, %lu players\n", threadCount, static_cast<long>(duration.count()), static_cast<unsigned long>(keyCount));
+
+    for (const _Scenario& scenario : scenarios) {
+        _RunScenario<_LockedMap>("std::map + std::shared_mutex", scenario, threadCount, duration, keyCount);
+        _RunScenario<ShardedHashMap<uint64_t, _Value>>("ShardedHashMap", scenario, threadCount, duration, keyCount);
+    }
+
+    return 0;
+}
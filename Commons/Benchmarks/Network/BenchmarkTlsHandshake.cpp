@@ -0,0 +1,222 @@
+// Measures the TLS handshake throughput of the HttpServer against local clients.
+//
+// Usage: Merrie_Commons_Benchmark_TlsHandshake [client threads] [seconds per scenario]
+//
+// Every client connects, does the handshake, sends a single request and closes the connection. The scenarios compare full
+// handshakes with sessions resumed from the server session cache and from session tickets.
+
+#include <Commons/Network/Http.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/core.hpp>
+#include <cstdio>
+#include <iostream>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+using namespace Merrie;
+
+namespace {
+    enum class _Resumption {
+            None,
+            SessionCache,
+            SessionTickets,
+    };
+
+    struct _Scenario {
+        const char* Name;
+        _Resumption Resumption;
+        size_t HandshakeThreadCount;
+    };
+
+    class _BenchmarkServer : public HttpServer {
+        public:
+            explicit _BenchmarkServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                connection->GetResponse().result(http::status::ok);
+                connection->GetResponse().body() = "ok";
+                connection->SendResponse();
+            }
+    };
+
+    /**
+     * Generates a self-signed P-256 certificate for localhost and writes it with its private key to the given files.
+     */
+    void _GenerateCertificate(const std::string& certificateFile, const std::string& privateKeyFile) {
+        EVP_PKEY* key = nullptr;
+        EVP_PKEY_CTX* keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        EVP_PKEY_keygen_init(keyContext);
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext, NID_X9_62_prime256v1);
+        EVP_PKEY_keygen(keyContext, &key);
+        EVP_PKEY_CTX_free(keyContext);
+
+        X509* certificate = X509_new();
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 60 * 60 * 24);
+        X509_set_pubkey(certificate, key);
+
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_sign(certificate, key, EVP_sha256());
+
+        FILE* file = std::fopen(certificateFile.c_str(), "wb");
+        PEM_write_X509(file, certificate);
+        std::fclose(file);
+
+        file = std::fopen(privateKeyFile.c_str(), "wb");
+        PEM_write_PrivateKey(file, key, nullptr, nullptr, 0, nullptr, nullptr);
+        std::fclose(file);
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    /**
+     * Connects to the server until the time is up, returns the amount of completed requests.
+     */
+    uint64_t _RunClient(const tcp::endpoint& endpoint, bool resume, DefaultClock::time_point end) {
+        boost::asio::io_context ioContext;
+        ssl::context context(ssl::context::tls_client);
+        context.set_verify_mode(ssl::verify_none);
+        SSL_CTX_set_session_cache_mode(context.native_handle(), SSL_SESS_CACHE_CLIENT);
+
+        http::request<http::empty_body> request(http::verb::get, "/", 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(false);
+
+        SSL_SESSION* session = nullptr;
+        uint64_t completed = 0;
+
+        while (DefaultClock::now() < end) {
+            ssl::stream<tcp::socket> stream(ioContext, context);
+            boost::system::error_code error;
+
+            stream.next_layer().connect(endpoint, error);
+            if (error)
+                continue;
+
+            if (session != nullptr)
+                SSL_set_session(stream.native_handle(), session);
+
+            stream.handshake(ssl::stream_base::client, error);
+            if (error)
+                continue;
+
+            boost::beast::flat_buffer buffer;
+            http::response<http::string_body> response;
+            http::write(stream, request, error);
+            http::read(stream, buffer, response, error);
+
+            if (error)
+                continue;
+
+            // the session (or the ticket) is available once the server has sent it after the handshake
+            if (resume) {
+                if (session != nullptr)
+                    SSL_SESSION_free(session);
+
+                session = SSL_get1_session(stream.native_handle());
+            }
+
+            // OpenSSL does not resume sessions of connections that were not shut down
+            stream.shutdown(error);
+            completed++;
+        }
+
+        if (session != nullptr)
+            SSL_SESSION_free(session);
+
+        return completed;
+    }
+
+    void _RunScenario(const _Scenario& scenario, NetworkPort port, const std::string& certificateFile, const std::string& privateKeyFile,
+                      size_t clientThreads, std::chrono::seconds duration) {
+        HttpServerSettings settings{
+                {"127.0.0.1", port, 2},
+                false,
+                15,
+                15,
+                100,
+                8192,
+                {},
+                {
+                        true,
+                        certificateFile,
+                        privateKeyFile,
+                        20480,
+                        300,
+                        scenario.Resumption == _Resumption::SessionTickets,
+                        scenario.HandshakeThreadCount,
+                        1024,
+                }
+        };
+
+        _BenchmarkServer server(settings);
+        server.Start();
+
+        const auto end = DefaultClock::now() + duration;
+        std::vector<std::thread> clients;
+        std::atomic<uint64_t> completed{0};
+
+        for (size_t i = 0; i < clientThreads; i++) {
+            clients.emplace_back([&] {
+                completed += _RunClient(server.GetEndpoint(), scenario.Resumption != _Resumption::None, end);
+            });
+        }
+
+        for (std::thread& client : clients) {
+            client.join();
+        }
+
+        const TlsStatistics statistics = server.GetTlsStatistics();
+        std::printf("%-40s %10.1f handshakes/s  (full: %lu, resumed: %lu, failed: %lu, rejected: %lu)\n",
+                    scenario.Name,
+                    static_cast<double>(completed.load()) / static_cast<double>(duration.count()),
+                    static_cast<unsigned long>(statistics.FullHandshakes),
+                    static_cast<unsigned long>(statistics.ResumedHandshakes),
+                    static_cast<unsigned long>(statistics.FailedHandshakes),
+                    static_cast<unsigned long>(statistics.RejectedHandshakes));
+
+        server.Stop();
+        server.Join();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t clientThreads = argc > 1 ? std::stoul(argv[1]) : 4;
+    const std::chrono::seconds duration(argc > 2 ? std::stoul(argv[2]) : 5);
+
+    // a trace message for every connection would skew the results
+    boost::log::core::get()->set_logging_enabled(false);
+
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory);
+
+    const std::string certificateFile = (directory / "certificate.pem").string();
+    const std::string privateKeyFile = (directory / "private_key.pem").string();
+    _GenerateCertificate(certificateFile, privateKeyFile);
+
+    const _Scenario scenarios[] = {
+            {"full handshakes, I/O threads",             _Resumption::None,           0},
+            {"full handshakes, 2 handshake threads",     _Resumption::None,           2},
+            {"resumed from the session cache",           _Resumption::SessionCache,   2},
+            {"resumed from session tickets",             _Resumption::SessionTickets, 2},
+    };
+
+    std::printf("%zu client threads, %ld seconds per scenario\n", clientThreads, static_cast<long>(duration.count()));
+
+    NetworkPort port = 18443;
+    for (const _Scenario& scenario : scenarios) {
+        _RunScenario(scenario, port++, certificateFile, privateKeyFile, clientThreads, duration);
+    }
+
+    boost::filesystem::remove_all(directory);
+    return 0;
+}
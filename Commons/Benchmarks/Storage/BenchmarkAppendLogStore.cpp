@@ -0,0 +1,148 @@
+// Measures the write throughput and the load latency of the player store.
+//
+// Usage: Merrie_Commons_Benchmark_AppendLogStore [seconds per scenario] [players] [value size] [directory]
+//
+// The writes are queued from one thread, like the main thread saves the players, and compared with appending and syncing
+// every record on its own. The time the writing thread spends in Put() is reported separately, it is all the main thread
+// ever waits for. The loads are done after the store is reopened, like the players are loaded when they join.
+
+#include <Commons/Storage/AppendLogStore.hpp>
+#include <Commons/Time.hpp>
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <fcntl.h>
+#include <random>
+#include <unistd.h>
+
+using namespace Merrie;
+
+namespace {
+    double _ToMicroseconds(DefaultClock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    void _RunSyncedWrites(const boost::filesystem::path& directory, std::chrono::seconds duration, const std::string& value) {
+        const boost::filesystem::path path = directory / "synced";
+        const int descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if (descriptor < 0) {
+            std::perror("open");
+            return;
+        }
+
+        uint64_t writes = 0;
+        const DefaultClock::time_point start = DefaultClock::now();
+
+        while (DefaultClock::now() - start < duration) {
+            if (::write(descriptor, value.data(), value.size()) != static_cast<ssize_t>(value.size()) || ::fdatasync(descriptor) != 0) {
+                std::perror("write");
+                break;
+            }
+
+            writes++;
+        }
+
+        const double seconds = std::chrono::duration<double>(DefaultClock::now() - start).count();
+        std::printf("%-34s %12.0f writes/s\n", "write + fdatasync per record", static_cast<double>(writes) / seconds);
+
+        ::close(descriptor);
+        boost::filesystem::remove(path);
+    }
+
+    void _RunQueuedWrites(const boost::filesystem::path& directory, std::chrono::seconds duration, uint64_t keyCount, const std::string& value) {
+        AppendLogStore store({true, directory.string(), 64 * 1024 * 1024});
+        std::mt19937_64 random(1);
+
+        // every player exists before the loads
+        for (uint64_t key = 0; key < keyCount; key++) {
+            store.Put(key, value);
+        }
+
+        store.Flush();
+        const AppendLogStoreStatistics before = store.GetStatistics();
+
+        uint64_t puts = 0;
+        DefaultClock::duration putTime{};
+        DefaultClock::duration maxPutTime{};
+        const DefaultClock::time_point start = DefaultClock::now();
+
+        while (DefaultClock::now() - start < duration) {
+            const uint64_t key = random() % keyCount;
+            std::string copy = value;
+
+            const DefaultClock::time_point putStart = DefaultClock::now();
+            store.Put(key, std::move(copy));
+            const DefaultClock::duration putDuration = DefaultClock::now() - putStart;
+
+            putTime += putDuration;
+            maxPutTime = std::max(maxPutTime, putDuration);
+            puts++;
+        }
+
+        store.Flush();
+
+        const double seconds = std::chrono::duration<double>(DefaultClock::now() - start).count();
+        const AppendLogStoreStatistics after = store.GetStatistics();
+        const uint64_t written = after.WrittenRecords - before.WrittenRecords;
+        const uint64_t commits = after.Commits - before.Commits;
+
+        std::printf("%-34s %12.0f puts/s, %.0f records/s synced in %lu commits (%.1f records per commit), %lu compactions\n",
+                    "AppendLogStore", static_cast<double>(puts) / seconds, static_cast<double>(written) / seconds,
+                    static_cast<unsigned long>(commits), commits ? static_cast<double>(written) / static_cast<double>(commits) : 0.0,
+                    static_cast<unsigned long>(after.Compactions - before.Compactions));
+        std::printf("%-34s %12.2f us average, %.2f us max\n", "  time spent in Put()",
+                    _ToMicroseconds(putTime) / static_cast<double>(puts), _ToMicroseconds(maxPutTime));
+    }
+
+    void _RunLoads(const boost::filesystem::path& directory, std::chrono::seconds duration, uint64_t keyCount) {
+        const DefaultClock::time_point openStart = DefaultClock::now();
+        AppendLogStore store({true, directory.string(), 64 * 1024 * 1024});
+        const AppendLogStoreStatistics statistics = store.GetStatistics();
+
+        std::printf("%-34s %12.2f ms for %lu keys, %lu bytes of snapshot and %lu bytes of log\n", "opening",
+                    _ToMicroseconds(DefaultClock::now() - openStart) / 1000, static_cast<unsigned long>(statistics.Keys),
+                    static_cast<unsigned long>(statistics.SnapshotSize), static_cast<unsigned long>(statistics.LogSize));
+
+        std::mt19937_64 random(2);
+        std::vector<DefaultClock::duration> latencies;
+        const DefaultClock::time_point start = DefaultClock::now();
+
+        while (DefaultClock::now() - start < duration) {
+            const DefaultClock::time_point loadStart = DefaultClock::now();
+            const std::optional<std::string> value = store.Load(random() % keyCount);
+            latencies.push_back(DefaultClock::now() - loadStart);
+
+            if (!value) {
+                std::printf("missing value\n");
+                return;
+            }
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        std::printf("%-34s %12.2f us median, %.2f us p99, %.2f us max\n", "Load()",
+                    _ToMicroseconds(latencies[latencies.size() / 2]), _ToMicroseconds(latencies[latencies.size() * 99 / 100]),
+                    _ToMicroseconds(latencies.back()));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::seconds duration(argc > 1 ? std::stoul(argv[1]) : 5);
+    const uint64_t keyCount = argc > 2 ? std::stoull(argv[2]) : 10000;
+    const size_t valueSize = argc > 3 ? std::stoul(argv[3]) : 512;
+    const boost::filesystem::path directory = argc > 4 ? boost::filesystem::path(argv[4]) / boost::filesystem::unique_path() : boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    std::printf("%ld seconds per scenario, %lu players, %zu bytes per player, in %s\n", static_cast<long>(duration.count()),
+                static_cast<unsigned long>(keyCount), valueSize, directory.c_str());
+
+    boost::filesystem::create_directories(directory);
+    const std::string value(valueSize, 'x');
+
+    _RunSyncedWrites(directory, duration, value);
+    _RunQueuedWrites(directory, duration, keyCount, value);
+    _RunLoads(directory, duration, keyCount);
+
+    boost::filesystem::remove_all(directory);
+    return 0;
+}
@@ -2,7 +2,17 @@
 #define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CONTAINERS_HPP
 
 #include "Commons.hpp"
+#include "Time.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace Merrie {
@@ -40,6 +50,455 @@ namespace Merrie {
     template<typename C, typename Predicate>
     inline void RemoveIf(C& container, Predicate predicate);
 
+    /**
+     * Gets a small number that identifies the calling thread, the threads are numbered in the order they first call this.
+     */
+    inline size_t GetThreadShardIndex() noexcept;
+
+    /**
+     * A multi-producer queue that is emptied in batches by a single consumer.
+     *
+     * The values are pushed into the shard of the calling thread, so the producers running on different threads rarely wait
+     * for each other. The consumer takes the values of a whole shard with a single lock and the vectors keep their capacity
+     * between the batches, so a steady stream of values does not allocate.
+     *
+     * @tparam T type of the values
+     */
+    template<typename T>
+    class ShardedInbox {
+        public: // Constructors & destructors
+            NON_COPYABLE(ShardedInbox);
+            NON_MOVEABLE(ShardedInbox);
+
+            /**
+             * Creates the inbox.
+             *
+             * @param shardCount amount of the shards, usually the amount of the producer threads
+             */
+            explicit ShardedInbox(size_t shardCount);
+
+        public: // Public methods
+            /**
+             * Pushes a value into the shard of the calling thread, can be called from any thread.
+             */
+            void Push(T value);
+
+            /**
+             * Takes all values out of the inbox and passes them to the consumer, must not be called from multiple threads at once.
+             *
+             * @param consumer function called as consumer(T& value, size_t shard) for every value in the order of the pushes of a shard, if it throws the rest of the shard's batch is dropped
+             * @return amount of the values taken out
+             */
+            template<typename Consumer>
+            size_t Drain(Consumer consumer);
+
+            /**
+             * Gets the amount of the shards.
+             */
+            [[nodiscard]] size_t GetShardCount() const noexcept;
+
+        private: // Private types
+            // every shard has its own cache line, the producers do not share them
+            struct alignas(64) Shard {
+                std::mutex Mutex{};
+                std::vector<T> Values{};
+                std::vector<T> Batch{}; // accessed only by the consumer
+            };
+
+        private: // Private fields
+            const size_t m_shardCount;
+            std::unique_ptr<Shard[]> m_shards;
+    };
+
+    /**
+     * A lock-free queue with many producers and a single consumer, that holds a limited amount of values.
+     *
+     * Pushing takes a single atomic exchange, the producers never wait for each other or for the consumer. The consumer pops
+     * the values in the order they were linked into the queue.
+     *
+     * @tparam T type of the values
+     */
+    template<typename T>
+    class BoundedMpscQueue {
+        public: // Constructors & destructors
+            NON_COPYABLE(BoundedMpscQueue);
+            NON_MOVEABLE(BoundedMpscQueue);
+
+            /**
+             * Creates the queue.
+             *
+             * @param capacity maximum amount of the values in the queue
+             */
+            explicit BoundedMpscQueue(size_t capacity);
+
+            ~BoundedMpscQueue();
+
+        public: // Public methods
+            /**
+             * Pushes the value, can be called from any thread.
+             *
+             * @return false if the queue is full, the value is dropped
+             */
+            bool Push(T value);
+
+            /**
+             * Pops all values that are in the queue, must be called from the consumer thread only.
+             *
+             * @param consumer function called as consumer(T& value) for every value
+             * @return amount of the values popped
+             */
+            template<typename Consumer>
+            size_t Drain(Consumer consumer);
+
+            /**
+             * Checks whether or not there are values to pop, must be called from the consumer thread only.
+             */
+            [[nodiscard]] bool IsEmpty() const noexcept;
+
+            /**
+             * Gets the amount of the values in the queue, including the ones that are being pushed right now.
+             */
+            [[nodiscard]] size_t GetSize() const noexcept;
+
+            [[nodiscard]] size_t GetCapacity() const noexcept;
+
+        private: // Private types
+            struct Node {
+                std::atomic<Node*> Next{nullptr};
+                std::optional<T> Value{};
+            };
+
+        private: // Private fields
+            const size_t m_capacity;
+            std::atomic<size_t> m_size{0};
+            std::atomic<Node*> m_head; // the last node, pushed to by the producers
+            Node* m_tail; // the node before the first value, accessed only by the consumer
+    };
+
+
+    /**
+     * A hash map that can be used from many threads at once, split into shards that have their own locks.
+     *
+     * A key always belongs to the same shard, so the threads that work with different keys rarely wait for each other and
+     * the lookups of the same shard only take its lock shared. The operations that go over the whole map lock one shard at
+     * a time, so they never block the whole map.
+     *
+     * @tparam K type of the keys
+     * @tparam V type of the values, copied out of the map by the lookups, usually a std::shared_ptr
+     * @tparam Hash hash of the keys
+     */
+    template<typename K, typename V, typename Hash = std::hash<K>>
+    class ShardedHashMap {
+        public: // Constructors & destructors
+            NON_COPYABLE(ShardedHashMap);
+            NON_MOVEABLE(ShardedHashMap);
+
+            /**
+             * Creates the map.
+             *
+             * @param shardCount amount of the shards, rounded up to a power of two
+             */
+            explicit ShardedHashMap(size_t shardCount = 64);
+
+        public: // Public methods
+            /**
+             * Finds the value of the key.
+             *
+             * @return copy of the value or std::nullopt if there is none
+             */
+            [[nodiscard]] std::optional<V> Find(const K& key) const;
+
+            /**
+             * Finds the value of the key or creates it if there is none. The factory is called only if the key is not in the
+             * map, while its shard is locked, so exactly one value is ever created for a key.
+             *
+             * @param factory function called as factory() that returns the new value
+             * @return copy of the value and whether or not it was created
+             */
+            template<typename Factory>
+            std::pair<V, bool> GetOrCreate(const K& key, Factory factory);
+
+            /**
+             * Sets the value of the key, replaces the previous one.
+             *
+             * @return whether or not the value was inserted, false if it was replaced
+             */
+            bool InsertOrAssign(const K& key, V value);
+
+            /**
+             * Removes the value of the key.
+             *
+             * @return whether or not there was a value
+             */
+            bool Remove(const K& key);
+
+            /**
+             * Removes all values that match the predicate.
+             *
+             * @param predicate function called as predicate(const K& key, V& value) with the shard of the value locked
+             * @return amount of the removed values
+             */
+            template<typename Predicate>
+            size_t RemoveIf(Predicate predicate);
+
+            /**
+             * Calls the function for every value.
+             *
+             * @param function function called as function(const K& key, const V& value) with the shard of the value locked shared
+             */
+            template<typename Function>
+            void ForEach(Function function) const;
+
+            /**
+             * Gets the amount of the values, the shards are counted one after another so it is not exact while the map changes.
+             */
+            [[nodiscard]] size_t GetSize() const;
+
+            [[nodiscard]] size_t GetShardCount() const noexcept;
+
+        private: // Private types
+            struct alignas(64) Shard {
+                mutable std::shared_mutex Mutex{};
+                std::unordered_map<K, V, Hash> Values{};
+            };
+
+        private: // Private methods
+            /**
+             * Rounds the amount of the shards up to a power of two and gets the mask of the shard indexes.
+             */
+            static size_t GetShardMask(size_t shardCount) noexcept;
+
+            [[nodiscard]] Shard& GetShard(const K& key) const noexcept;
+
+        private: // Private fields
+            const size_t m_shardMask;
+            std::unique_ptr<Shard[]> m_shards;
+            const Hash m_hash{};
+    };
+
+
+    /**
+     * Values that come due at the given times, kept in a wheel of slots that all cover the same span of time.
+     *
+     * Scheduling a value and taking a due one out are constant time, advancing the wheel only visits the slots that came
+     * due since the last advance and the values in them, never the values that are not due yet. A value is never taken out
+     * before its time, but it may be taken out up to one resolution later. The times beyond the horizon of the wheel are
+     * cut to it, so the values that wait for longer come out early and have to be scheduled again.
+     *
+     * The wheel does not support cancelling, the consumer is expected to check whether a value that came out is still due,
+     * and to schedule it again for its new time if not. Must not be used from multiple threads at once.
+     *
+     * @tparam T type of the values
+     */
+    template<typename T>
+    class TimingWheel {
+        public: // Constructors & destructors
+            NON_COPYABLE(TimingWheel);
+            TRIVIALLY_MOVEABLE(TimingWheel);
+
+            /**
+             * Creates the wheel, its time starts now.
+             *
+             * @param resolution span of time that a slot covers
+             * @param slotCount amount of the slots, the horizon is slotCount * resolution
+             */
+            TimingWheel(DefaultClock::duration resolution, size_t slotCount);
+
+        public: // Public methods
+            /**
+             * Schedules the value, the times that have already passed come due with the next advance.
+             */
+            void Schedule(T value, DefaultClock::time_point time);
+
+            /**
+             * Takes the values that came due out of the wheel.
+             *
+             * @param now the current time
+             * @param consumer function called as consumer(T& value) for every value that came due, it may schedule values
+             * @return amount of the values taken out
+             */
+            template<typename Consumer>
+            size_t Advance(DefaultClock::time_point now, Consumer consumer);
+
+            /**
+             * Gets the amount of the scheduled values.
+             */
+            [[nodiscard]] size_t GetSize() const noexcept;
+
+        private: // Private fields
+            DefaultClock::duration m_resolution;
+            DefaultClock::time_point m_start;
+            std::vector<std::vector<T>> m_slots;
+            std::vector<T> m_batch{}; // the slot that is being taken out, keeps its capacity
+            uint64_t m_current = 0; // the slot that comes due next, counted from the start
+            size_t m_size = 0;
+    };
+
+
+    /**
+     * Handle of a value in a SlotMap.
+     */
+    using SlotHandle = uint64_t;
+
+    /**
+     * A handle that never belongs to any value.
+     */
+    constexpr const SlotHandle InvalidSlotHandle = 0;
+
+    /**
+     * Values that are addressed by generational handles and stored next to each other.
+     *
+     * A handle consists of the index of a slot and of the generation of the slot, that changes whenever its value is
+     * removed, so the handles of the removed values never reach the values that reuse their slots. The values themselves
+     * are kept in a dense vector, going over all of them touches no holes. Removing a value moves the last value into its
+     * place, so the pointers to the values are only valid until the next insertion or removal.
+     *
+     * Must not be used from multiple threads at once.
+     *
+     * @tparam T type of the values
+     */
+    template<typename T>
+    class SlotMap {
+        public: // Constructors & destructors
+            NON_COPYABLE(SlotMap);
+            TRIVIALLY_MOVEABLE(SlotMap);
+
+            SlotMap() = default;
+
+        public: // Public methods
+            /**
+             * Inserts the value.
+             *
+             * @return handle of the value
+             */
+            SlotHandle Insert(T value);
+
+            /**
+             * Removes the value of the handle.
+             *
+             * @return false if the handle is not valid
+             */
+            bool Remove(SlotHandle handle);
+
+            /**
+             * Gets the value of the handle.
+             *
+             * @return the value or nullptr if the handle is not valid
+             */
+            [[nodiscard]] T* Get(SlotHandle handle) noexcept;
+
+            [[nodiscard]] const T* Get(SlotHandle handle) const noexcept;
+
+            /**
+             * Calls the function for every value, in the order of their storage.
+             *
+             * @param function function called as function(SlotHandle handle, T& value), it must not insert or remove values
+             */
+            template<typename Function>
+            void ForEach(Function function);
+
+            [[nodiscard]] size_t GetSize() const noexcept;
+
+            void Reserve(size_t capacity);
+
+        private: // Private types
+            struct Slot {
+                uint32_t Generation = 1;
+                uint32_t Index = 0; // index of the value if the slot is used, of the next free slot otherwise
+            };
+
+            static constexpr const uint32_t NoSlot = std::numeric_limits<uint32_t>::max();
+
+        private: // Private methods
+            [[nodiscard]] const Slot* FindSlot(SlotHandle handle) const noexcept;
+
+        private: // Private fields
+            std::vector<T> m_values{};
+            std::vector<uint32_t> m_valueSlots{}; // the slot of every value
+            std::vector<Slot> m_slots{};
+            uint32_t m_freeSlot = NoSlot; // first of the free slots, they are linked through their indexes
+    };
+
+
+    /**
+     * Values at 2D positions, for finding the values near a position without going over all of them.
+     *
+     * The area is split into square cells, every cell keeps its values with their positions next to each other. A range
+     * query only goes over the cells that overlap the range, so with the cell size about the size of the usual range it
+     * touches a few cells and the values near the position. Moving a value within its cell only updates its position.
+     * Positions outside of the area are kept in the cells at its edges.
+     *
+     * Must not be used from multiple threads at once.
+     *
+     * @tparam T type of the values, small and cheap to compare, like handles or ids
+     */
+    template<typename T>
+    class UniformGrid {
+        public: // Types
+            struct Entry {
+                T Value;
+                int32_t X;
+                int32_t Y;
+            };
+
+        public: // Constructors & destructors
+            TRIVIALLY_COPYABLE(UniformGrid);
+            TRIVIALLY_MOVEABLE(UniformGrid);
+
+            /**
+             * Creates the grid of the area.
+             *
+             * @param width width of the area, the positions are from 0 to width - 1
+             * @param height height of the area, the positions are from 0 to height - 1
+             * @param cellSize width and height of the cells
+             */
+            UniformGrid(int32_t width, int32_t height, int32_t cellSize);
+
+        public: // Public methods
+            /**
+             * Adds the value at the position, the value must not be in the grid yet.
+             */
+            void Insert(const T& value, int32_t x, int32_t y);
+
+            /**
+             * Moves the value from its current position to the new one.
+             *
+             * @return false if the value is not in the cell of the current position
+             */
+            bool Move(const T& value, int32_t fromX, int32_t fromY, int32_t toX, int32_t toY);
+
+            /**
+             * Removes the value from its current position.
+             *
+             * @return false if the value is not in the cell of the position
+             */
+            bool Remove(const T& value, int32_t x, int32_t y);
+
+            /**
+             * Calls the function for every value at most the range away from the position on both axes.
+             *
+             * @param function function called as function(const Entry& entry), it must not change the grid
+             */
+            template<typename Function>
+            void ForEachInRange(int32_t x, int32_t y, int32_t range, Function function) const;
+
+            [[nodiscard]] size_t GetSize() const noexcept;
+
+        private: // Private methods
+            [[nodiscard]] int32_t GetColumn(int32_t x) const noexcept;
+
+            [[nodiscard]] int32_t GetRow(int32_t y) const noexcept;
+
+            [[nodiscard]] std::vector<Entry>& GetCell(int32_t x, int32_t y) noexcept;
+
+        private: // Private fields
+            int32_t m_cellSize;
+            int32_t m_columns;
+            int32_t m_rows;
+            std::vector<std::vector<Entry>> m_cells; // by rows
+            size_t m_size = 0;
+    };
+
 }
 
 #include "Containers.tcc"
@@ -25,6 +25,513 @@ namespace Merrie {
     inline void RemoveIf(C& container, Predicate predicate) {
         container.erase(std::remove_if(begin(container), end(container), predicate), end(container));
     }
+
+    inline size_t GetThreadShardIndex() noexcept {
+        static std::atomic<size_t> nextIndex{0};
+        thread_local const size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+
+        return index;
+    }
+
+    // ================================================================================
+    // =  ShardedInbox                                                                =
+    // ================================================================================
+
+    template<typename T>
+    ShardedInbox<T>::ShardedInbox(size_t shardCount) : m_shardCount(std::max<size_t>(shardCount, 1)), m_shards(std::make_unique<Shard[]>(m_shardCount)) {
+    }
+
+    template<typename T>
+    void ShardedInbox<T>::Push(T value) {
+        Shard& shard = m_shards[GetThreadShardIndex() % m_shardCount];
+
+        std::scoped_lock lock(shard.Mutex);
+        shard.Values.emplace_back(std::move(value));
+    }
+
+    template<typename T>
+    template<typename Consumer>
+    size_t ShardedInbox<T>::Drain(Consumer consumer) {
+        size_t count = 0;
+
+        for (size_t i = 0; i < m_shardCount; i++) {
+            Shard& shard = m_shards[i];
+
+            {
+                std::scoped_lock lock(shard.Mutex);
+                if (shard.Values.empty())
+                    continue;
+
+                // the empty batch from the last drain keeps its capacity for the next pushes
+                std::swap(shard.Values, shard.Batch);
+            }
+
+            // the batch is cleared even when the consumer throws, a later swap must not bring back the consumed values
+            struct BatchGuard {
+                std::vector<T>& Batch;
+
+                ~BatchGuard() {
+                    Batch.clear();
+                }
+            } guard{shard.Batch};
+
+            for (T& value : shard.Batch) {
+                consumer(value, i);
+            }
+
+            count += shard.Batch.size();
+        }
+
+        return count;
+    }
+
+    template<typename T>
+    size_t ShardedInbox<T>::GetShardCount() const noexcept {
+        return m_shardCount;
+    }
+
+    // ================================================================================
+    // =  BoundedMpscQueue                                                            =
+    // ================================================================================
+
+    template<typename T>
+    BoundedMpscQueue<T>::BoundedMpscQueue(size_t capacity) : m_capacity(capacity), m_head(new Node()) {
+        m_tail = m_head.load(std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    BoundedMpscQueue<T>::~BoundedMpscQueue() {
+        Node* node = m_tail;
+
+        while (node != nullptr) {
+            Node* next = node->Next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    template<typename T>
+    bool BoundedMpscQueue<T>::Push(T value) {
+        // reserve a place first, so the queue never goes over the capacity
+        if (m_size.fetch_add(1, std::memory_order_relaxed) >= m_capacity) {
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        Node* node = new Node();
+        node->Value.emplace(std::move(value));
+
+        // the consumer sees the node once the previous one links to it
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->Next.store(node, std::memory_order_release);
+        return true;
+    }
+
+    template<typename T>
+    template<typename Consumer>
+    size_t BoundedMpscQueue<T>::Drain(Consumer consumer) {
+        size_t count = 0;
+
+        for (Node* next = m_tail->Next.load(std::memory_order_acquire); next != nullptr; next = m_tail->Next.load(std::memory_order_acquire)) {
+            // the popped node becomes the new stub, its value is no longer needed
+            T value = std::move(*next->Value);
+            next->Value.reset();
+
+            delete m_tail;
+            m_tail = next;
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+
+            consumer(value);
+            count++;
+        }
+
+        return count;
+    }
+
+    template<typename T>
+    bool BoundedMpscQueue<T>::IsEmpty() const noexcept {
+        return m_tail->Next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    template<typename T>
+    size_t BoundedMpscQueue<T>::GetSize() const noexcept {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    template<typename T>
+    size_t BoundedMpscQueue<T>::GetCapacity() const noexcept {
+        return m_capacity;
+    }
+
+    // ================================================================================
+    // =  ShardedHashMap                                                              =
+    // ================================================================================
+
+    template<typename K, typename V, typename Hash>
+    ShardedHashMap<K, V, Hash>::ShardedHashMap(size_t shardCount) : m_shardMask(GetShardMask(shardCount)), m_shards(std::make_unique<Shard[]>(m_shardMask + 1)) {
+    }
+
+    template<typename K, typename V, typename Hash>
+    std::optional<V> ShardedHashMap<K, V, Hash>::Find(const K& key) const {
+        const Shard& shard = GetShard(key);
+
+        std::shared_lock lock(shard.Mutex);
+        const auto iterator = shard.Values.find(key);
+
+        return iterator == shard.Values.end()
+               ? std::nullopt
+               : std::make_optional(iterator->second);
+    }
+
+    template<typename K, typename V, typename Hash>
+    template<typename Factory>
+    std::pair<V, bool> ShardedHashMap<K, V, Hash>::GetOrCreate(const K& key, Factory factory) {
+        Shard& shard = GetShard(key);
+
+        {
+            std::shared_lock lock(shard.Mutex);
+            const auto iterator = shard.Values.find(key);
+
+            if (iterator != shard.Values.end())
+                return {iterator->second, false};
+        }
+
+        // another thread may have created it in the meantime
+        std::unique_lock lock(shard.Mutex);
+        auto iterator = shard.Values.find(key);
+
+        if (iterator != shard.Values.end())
+            return {iterator->second, false};
+
+        iterator = shard.Values.emplace(key, factory()).first;
+        return {iterator->second, true};
+    }
+
+    template<typename K, typename V, typename Hash>
+    bool ShardedHashMap<K, V, Hash>::InsertOrAssign(const K& key, V value) {
+        Shard& shard = GetShard(key);
+
+        std::unique_lock lock(shard.Mutex);
+        return shard.Values.insert_or_assign(key, std::move(value)).second;
+    }
+
+    template<typename K, typename V, typename Hash>
+    bool ShardedHashMap<K, V, Hash>::Remove(const K& key) {
+        Shard& shard = GetShard(key);
+
+        std::unique_lock lock(shard.Mutex);
+        return shard.Values.erase(key) != 0;
+    }
+
+    template<typename K, typename V, typename Hash>
+    template<typename Predicate>
+    size_t ShardedHashMap<K, V, Hash>::RemoveIf(Predicate predicate) {
+        size_t count = 0;
+
+        for (size_t i = 0; i <= m_shardMask; i++) {
+            Shard& shard = m_shards[i];
+            std::unique_lock lock(shard.Mutex);
+
+            for (auto iterator = shard.Values.begin(); iterator != shard.Values.end();) {
+                if (predicate(iterator->first, iterator->second)) {
+                    iterator = shard.Values.erase(iterator);
+                    count++;
+                } else {
+                    ++iterator;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    template<typename K, typename V, typename Hash>
+    template<typename Function>
+    void ShardedHashMap<K, V, Hash>::ForEach(Function function) const {
+        for (size_t i = 0; i <= m_shardMask; i++) {
+            const Shard& shard = m_shards[i];
+            std::shared_lock lock(shard.Mutex);
+
+            for (const auto& [key, value] : shard.Values) {
+                function(key, value);
+            }
+        }
+    }
+
+    template<typename K, typename V, typename Hash>
+    size_t ShardedHashMap<K, V, Hash>::GetSize() const {
+        size_t size = 0;
+
+        for (size_t i = 0; i <= m_shardMask; i++) {
+            std::shared_lock lock(m_shards[i].Mutex);
+            size += m_shards[i].Values.size();
+        }
+
+        return size;
+    }
+
+    template<typename K, typename V, typename Hash>
+    size_t ShardedHashMap<K, V, Hash>::GetShardCount() const noexcept {
+        return m_shardMask + 1;
+    }
+
+    template<typename K, typename V, typename Hash>
+    size_t ShardedHashMap<K, V, Hash>::GetShardMask(size_t shardCount) noexcept {
+        size_t powerOfTwo = 1;
+
+        while (powerOfTwo < shardCount)
+            powerOfTwo <<= 1;
+
+        return powerOfTwo - 1;
+    }
+
+    template<typename K, typename V, typename Hash>
+    typename ShardedHashMap<K, V, Hash>::Shard& ShardedHashMap<K, V, Hash>::GetShard(const K& key) const noexcept {
+        // std::hash of the integers is the identity, the bits are mixed so that consecutive keys spread over the shards
+        const uint64_t hash = static_cast<uint64_t>(m_hash(key)) * 0x9E3779B97F4A7C15ULL;
+
+        return m_shards[(hash >> 32) & m_shardMask];
+    }
+
+    // ================================================================================
+    // =  TimingWheel                                                                 =
+    // ================================================================================
+
+    template<typename T>
+    TimingWheel<T>::TimingWheel(DefaultClock::duration resolution, size_t slotCount)
+            : m_resolution(resolution), m_start(DefaultClock::now()), m_slots(std::max<size_t>(slotCount, 1)) {
+        M_ASSERT(resolution.count() > 0, "The resolution has to be positive");
+    }
+
+    template<typename T>
+    void TimingWheel<T>::Schedule(T value, DefaultClock::time_point time) {
+        // slot n covers the times from m_start + n * m_resolution, it comes due once all of them have passed
+        uint64_t slot = time <= m_start ? 0 : static_cast<uint64_t>((time - m_start) / m_resolution);
+        slot = std::clamp<uint64_t>(slot, m_current, m_current + m_slots.size() - 1);
+
+        m_slots[slot % m_slots.size()].emplace_back(std::move(value));
+        m_size++;
+    }
+
+    template<typename T>
+    template<typename Consumer>
+    size_t TimingWheel<T>::Advance(DefaultClock::time_point now, Consumer consumer) {
+        size_t count = 0;
+
+        while (m_start + static_cast<DefaultClock::rep>(m_current + 1) * m_resolution <= now) {
+            // the consumer may schedule values, even into the slot that is being taken out
+            std::swap(m_batch, m_slots[m_current % m_slots.size()]);
+            m_current++;
+            m_size -= m_batch.size();
+
+            for (T& value : m_batch) {
+                consumer(value);
+            }
+
+            count += m_batch.size();
+            m_batch.clear();
+        }
+
+        return count;
+    }
+
+    template<typename T>
+    size_t TimingWheel<T>::GetSize() const noexcept {
+        return m_size;
+    }
+
+    // ================================================================================
+    // =  SlotMap                                                                     =
+    // ================================================================================
+
+    template<typename T>
+    SlotHandle SlotMap<T>::Insert(T value) {
+        uint32_t slotIndex = m_freeSlot;
+
+        if (slotIndex == NoSlot) {
+            M_ASSERT(m_slots.size() < NoSlot, "The slot map is full");
+
+            slotIndex = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        } else {
+            m_freeSlot = m_slots[slotIndex].Index;
+        }
+
+        Slot& slot = m_slots[slotIndex];
+        slot.Index = static_cast<uint32_t>(m_values.size());
+        m_values.emplace_back(std::move(value));
+        m_valueSlots.emplace_back(slotIndex);
+
+        return static_cast<SlotHandle>(slot.Generation) << 32 | slotIndex;
+    }
+
+    template<typename T>
+    bool SlotMap<T>::Remove(SlotHandle handle) {
+        if (FindSlot(handle) == nullptr)
+            return false;
+
+        const auto slotIndex = static_cast<uint32_t>(handle);
+        Slot& slot = m_slots[slotIndex];
+
+        // the last value takes the place of the removed one
+        if (slot.Index != m_values.size() - 1) {
+            const uint32_t lastSlot = m_valueSlots.back();
+            m_values[slot.Index] = std::move(m_values.back());
+            m_valueSlots[slot.Index] = lastSlot;
+            m_slots[lastSlot].Index = slot.Index;
+        }
+
+        m_values.pop_back();
+        m_valueSlots.pop_back();
+
+        // the generation 0 is left out, so no handle is ever InvalidSlotHandle
+        if (++slot.Generation == 0)
+            slot.Generation = 1;
+
+        slot.Index = m_freeSlot;
+        m_freeSlot = slotIndex;
+        return true;
+    }
+
+    template<typename T>
+    T* SlotMap<T>::Get(SlotHandle handle) noexcept {
+        const Slot* slot = FindSlot(handle);
+        return slot == nullptr ? nullptr : &m_values[slot->Index];
+    }
+
+    template<typename T>
+    const T* SlotMap<T>::Get(SlotHandle handle) const noexcept {
+        const Slot* slot = FindSlot(handle);
+        return slot == nullptr ? nullptr : &m_values[slot->Index];
+    }
+
+    template<typename T>
+    template<typename Function>
+    void SlotMap<T>::ForEach(Function function) {
+        for (size_t i = 0; i < m_values.size(); i++) {
+            const uint32_t slotIndex = m_valueSlots[i];
+            function(static_cast<SlotHandle>(m_slots[slotIndex].Generation) << 32 | slotIndex, m_values[i]);
+        }
+    }
+
+    template<typename T>
+    size_t SlotMap<T>::GetSize() const noexcept {
+        return m_values.size();
+    }
+
+    template<typename T>
+    void SlotMap<T>::Reserve(size_t capacity) {
+        m_values.reserve(capacity);
+        m_valueSlots.reserve(capacity);
+        m_slots.reserve(capacity);
+    }
+
+    template<typename T>
+    const typename SlotMap<T>::Slot* SlotMap<T>::FindSlot(SlotHandle handle) const noexcept {
+        const auto slotIndex = static_cast<uint32_t>(handle);
+        const auto generation = static_cast<uint32_t>(handle >> 32);
+
+        if (slotIndex >= m_slots.size() || m_slots[slotIndex].Generation != generation)
+            return nullptr;
+
+        return &m_slots[slotIndex];
+    }
+
+    // ================================================================================
+    // =  UniformGrid                                                                 =
+    // ================================================================================
+
+    template<typename T>
+    UniformGrid<T>::UniformGrid(int32_t width, int32_t height, int32_t cellSize)
+            : m_cellSize(cellSize),
+              m_columns(std::max<int32_t>((width + cellSize - 1) / cellSize, 1)),
+              m_rows(std::max<int32_t>((height + cellSize - 1) / cellSize, 1)),
+              m_cells(static_cast<size_t>(m_columns) * static_cast<size_t>(m_rows)) {
+        M_ASSERT(cellSize > 0, "The cells have to have a size");
+    }
+
+    template<typename T>
+    void UniformGrid<T>::Insert(const T& value, int32_t x, int32_t y) {
+        GetCell(x, y).push_back(Entry{value, x, y});
+        m_size++;
+    }
+
+    template<typename T>
+    bool UniformGrid<T>::Move(const T& value, int32_t fromX, int32_t fromY, int32_t toX, int32_t toY) {
+        std::vector<Entry>& from = GetCell(fromX, fromY);
+        const auto iterator = std::find_if(from.begin(), from.end(), [&value](const Entry& entry) {
+            return entry.Value == value;
+        });
+
+        if (iterator == from.end())
+            return false;
+
+        std::vector<Entry>& to = GetCell(toX, toY);
+        if (&from == &to) {
+            iterator->X = toX;
+            iterator->Y = toY;
+            return true;
+        }
+
+        // the order within a cell does not matter, the last entry fills the hole
+        *iterator = std::move(from.back());
+        from.pop_back();
+        to.push_back(Entry{value, toX, toY});
+        return true;
+    }
+
+    template<typename T>
+    bool UniformGrid<T>::Remove(const T& value, int32_t x, int32_t y) {
+        std::vector<Entry>& cell = GetCell(x, y);
+        const auto iterator = std::find_if(cell.begin(), cell.end(), [&value](const Entry& entry) {
+            return entry.Value == value;
+        });
+
+        if (iterator == cell.end())
+            return false;
+
+        *iterator = std::move(cell.back());
+        cell.pop_back();
+        m_size--;
+        return true;
+    }
+
+    template<typename T>
+    template<typename Function>
+    void UniformGrid<T>::ForEachInRange(int32_t x, int32_t y, int32_t range, Function function) const {
+        const int32_t firstColumn = GetColumn(x - range);
+        const int32_t lastColumn = GetColumn(x + range);
+        const int32_t lastRow = GetRow(y + range);
+
+        for (int32_t row = GetRow(y - range); row <= lastRow; row++) {
+            for (int32_t column = firstColumn; column <= lastColumn; column++) {
+                for (const Entry& entry : m_cells[static_cast<size_t>(row) * static_cast<size_t>(m_columns) + static_cast<size_t>(column)]) {
+                    if (std::abs(entry.X - x) <= range && std::abs(entry.Y - y) <= range)
+                        function(entry);
+                }
+            }
+        }
+    }
+
+    template<typename T>
+    size_t UniformGrid<T>::GetSize() const noexcept {
+        return m_size;
+    }
+
+    template<typename T>
+    int32_t UniformGrid<T>::GetColumn(int32_t x) const noexcept {
+        return std::clamp<int32_t>(x / m_cellSize, 0, m_columns - 1);
+    }
+
+    template<typename T>
+    int32_t UniformGrid<T>::GetRow(int32_t y) const noexcept {
+        return std::clamp<int32_t>(y / m_cellSize, 0, m_rows - 1);
+    }
+
+    template<typename T>
+    std::vector<typename UniformGrid<T>::Entry>& UniformGrid<T>::GetCell(int32_t x, int32_t y) noexcept {
+        return m_cells[static_cast<size_t>(GetRow(y)) * static_cast<size_t>(m_columns) + static_cast<size_t>(GetColumn(x))];
+    }
 }
 
 
@@ -0,0 +1,33 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_HMAC_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_HMAC_HPP
+
+#include "../Commons.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace Merrie {
+
+    #ifdef M_HAS_OPENSSL_CRYPTO
+
+    /**
+     * Computes the HMAC of the data with SHA-256.
+     *
+     * @param key secret key of the MAC
+     * @param data data to authenticate
+     *
+     * @return the 32 bytes of the MAC
+     */
+    std::vector<uint8_t> HmacSha256(std::string_view key, std::string_view data);
+
+    #endif // M_HAS_OPENSSL_CRYPTO
+
+    /**
+     * Compares the strings in time that depends only on their sizes, so comparing a forged MAC with the real one does not
+     * tell how much of it is right.
+     */
+    [[nodiscard]] bool ConstantTimeEquals(std::string_view first, std::string_view second) noexcept;
+
+} // namespace Merrie
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_HMAC_HPP
@@ -0,0 +1,197 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_PASSWORDHASHING_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_PASSWORDHASHING_HPP
+
+#include "../Commons.hpp"
+
+#include <atomic>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <chrono>
+#include <functional>
+#include <string_view>
+
+namespace Merrie {
+
+    // ================================================================================
+    // =  Settings & statistics                                                       =
+    // ================================================================================
+
+    /**
+     * Thrown when a PasswordHashingPool cannot be created.
+     */
+    M_DECLARE_EXCEPTION(PasswordHashingException);
+
+    /**
+     * Settings of a PasswordHashingPool
+     */
+    struct PasswordHashingSettings {
+        /**
+         * Amount of threads dedicated to hashing the passwords.
+         */
+        size_t ThreadCount{};
+
+        /**
+         * Maximum amount of hashes and checks waiting or in progress, the ones above the limit are rejected right away. 0 for
+         * no limit.
+         */
+        size_t MaxPendingChecks{};
+
+        /**
+         * PBKDF2 iterations of the new hashes, 0 to measure how many take TargetDuration on this machine.
+         */
+        uint32_t Iterations{};
+
+        /**
+         * How long hashing a password should take in milliseconds when the iterations are measured.
+         */
+        uint32_t TargetDuration{};
+    };
+
+    /**
+     * A snapshot of the statistics of a PasswordHashingPool
+     */
+    struct PasswordHashingStatistics {
+        /**
+         * Amount of the passwords hashed.
+         */
+        uint64_t Hashed{};
+
+        /**
+         * Amount of the passwords checked against their hashes.
+         */
+        uint64_t Verified{};
+
+        /**
+         * Amount of the hashes and checks rejected because of the MaxPendingChecks limit.
+         */
+        uint64_t Rejected{};
+
+        /**
+         * Amount of the hashes and checks waiting or in progress.
+         */
+        uint64_t Pending{};
+    };
+
+    #ifdef M_HAS_OPENSSL_CRYPTO
+
+    // ================================================================================
+    // =  Password hashes                                                             =
+    // ================================================================================
+
+    /**
+     * Hashes the password with PBKDF2-HMAC-SHA256 and a random salt. Deliberately slow, see PasswordHashingPool.
+     *
+     * @return "pbkdf2-sha256$<iterations>$<salt in hex>$<hash in hex>"
+     */
+    [[nodiscard]] std::string HashPassword(std::string_view password, uint32_t iterations);
+
+    /**
+     * Checks the password against a hash created by HashPassword(), with the iterations of the hash.
+     *
+     * @return false if the password does not match or the hash is malformed
+     */
+    [[nodiscard]] bool VerifyPassword(std::string_view password, std::string_view hash);
+
+    /**
+     * Gets the iterations of a hash created by HashPassword().
+     *
+     * @return the iterations or 0 if the hash is malformed
+     */
+    [[nodiscard]] uint32_t GetPasswordHashIterations(std::string_view hash) noexcept;
+
+    /**
+     * Measures how many PBKDF2 iterations take about the target duration on the calling thread.
+     */
+    [[nodiscard]] uint32_t MeasurePasswordHashIterations(std::chrono::milliseconds target);
+
+    // ================================================================================
+    // =  PasswordHashingPool                                                         =
+    // ================================================================================
+
+    /**
+     * Hashes and checks the passwords on dedicated threads, so a slow KDF never stalls the I/O threads.
+     *
+     * The amount of the pending work is bounded: when the pool is saturated, for example by a login storm after a restart,
+     * new requests are rejected right away instead of queueing behind minutes of hashing. The results are posted to the
+     * executor given with every request, usually the one of the connection that asked. All methods can be called from any
+     * thread.
+     */
+    class PasswordHashingPool {
+        public: // Types
+            using HashCallback = std::function<void(std::string hash)>;
+
+            using VerifyCallback = std::function<void(bool valid)>;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(PasswordHashingPool);
+            NON_MOVEABLE(PasswordHashingPool);
+
+            /**
+             * Starts the threads, measures the iterations first if they are not set.
+             *
+             * \throw PasswordHashingException if the settings are not valid
+             */
+            explicit PasswordHashingPool(const PasswordHashingSettings& settings);
+
+            /**
+             * Waits for the threads to finish, the pending requests are dropped.
+             */
+            ~PasswordHashingPool();
+
+        public: // Public methods
+            /**
+             * Hashes the password with the iterations of the pool.
+             *
+             * @param executor executor that the callback is posted to
+             * @return false if the pool is saturated, the callback is not called then
+             */
+            bool Hash(std::string password, const boost::asio::any_io_executor& executor, HashCallback callback);
+
+            /**
+             * Checks the password against the hash.
+             *
+             * @param executor executor that the callback is posted to
+             * @return false if the pool is saturated, the callback is not called then
+             */
+            bool Verify(std::string password, std::string hash, const boost::asio::any_io_executor& executor, VerifyCallback callback);
+
+            /**
+             * Checks whether or not the hash was created with other iterations than the current ones, so it should be replaced
+             * once the password is known.
+             */
+            [[nodiscard]] bool NeedsRehash(std::string_view hash) const noexcept;
+
+            /**
+             * Gets the PBKDF2 iterations of the new hashes.
+             */
+            [[nodiscard]] uint32_t GetIterations() const noexcept;
+
+            /**
+             * Gets the current values of the counters.
+             */
+            [[nodiscard]] PasswordHashingStatistics GetStatistics() const noexcept;
+
+        private: // Private methods
+            /**
+             * Registers a request that is about to be queued.
+             *
+             * @return false if it should be rejected
+             */
+            [[nodiscard]] bool TryBegin() noexcept;
+
+        private: // Private fields
+            const size_t m_maxPendingChecks;
+            const uint32_t m_iterations;
+            boost::asio::thread_pool m_pool;
+
+            std::atomic<uint64_t> m_hashed{0};
+            std::atomic<uint64_t> m_verified{0};
+            std::atomic<uint64_t> m_rejected{0};
+            std::atomic<uint64_t> m_pending{0};
+    };
+
+    #endif // M_HAS_OPENSSL_CRYPTO
+
+} // namespace Merrie
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_PASSWORDHASHING_HPP
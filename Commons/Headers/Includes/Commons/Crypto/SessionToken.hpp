@@ -0,0 +1,77 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_SESSIONTOKEN_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_SESSIONTOKEN_HPP
+
+#include "../Commons.hpp"
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+namespace Merrie {
+
+    /**
+     * Thrown when a SessionTokenSigner cannot be created.
+     */
+    M_DECLARE_EXCEPTION(SessionTokenException);
+
+    /**
+     * What a session token says about its bearer.
+     */
+    struct SessionToken {
+        /**
+         * Id of the account that the session belongs to.
+         */
+        uint64_t Aid{};
+
+        /**
+         * The token is not accepted after this time, it is kept with a precision of seconds.
+         */
+        std::chrono::system_clock::time_point Expiry{};
+    };
+
+    #ifdef M_HAS_OPENSSL_CRYPTO
+
+    /**
+     * Signs and verifies the session tokens with HMAC-SHA256, so whoever knows the secret can issue them and the server can
+     * check them without storing anything.
+     *
+     * A token is "<aid>.<expiry in seconds since the epoch>.<MAC of the first two parts in hex>", it fits into a cookie as it
+     * is. The signer is immutable and can be used from any thread.
+     */
+    class SessionTokenSigner {
+        public: // Constructors & destructors
+            TRIVIALLY_COPYABLE(SessionTokenSigner);
+            TRIVIALLY_MOVEABLE(SessionTokenSigner);
+
+            /**
+             * Creates a signer with the secret shared with whoever issues the tokens.
+             *
+             * \throw SessionTokenException if the secret is empty
+             */
+            explicit SessionTokenSigner(std::string secret);
+
+        public: // Public methods
+            /**
+             * Creates the token of the session.
+             */
+            [[nodiscard]] std::string Sign(const SessionToken& token) const;
+
+            /**
+             * Checks the MAC and the expiry of the token.
+             *
+             * @return the session or std::nullopt if the token is malformed, forged or expired
+             */
+            [[nodiscard]] std::optional<SessionToken> Verify(std::string_view token) const;
+
+        private: // Private methods
+            [[nodiscard]] std::string CreateMac(std::string_view payload) const;
+
+        private: // Private fields
+            std::string m_secret;
+    };
+
+    #endif // M_HAS_OPENSSL_CRYPTO
+
+} // namespace Merrie
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_CRYPTO_SESSIONTOKEN_HPP
@@ -0,0 +1,120 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONTEMPLATE_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONTEMPLATE_HPP
+
+#include "JsonWriter.hpp"
+
+#include <type_traits>
+
+namespace Merrie {
+
+    /**
+     * Serialized JSON with slots that the values are filled into when it is rendered.
+     *
+     * The constant parts are serialized once, rendering only copies them and serializes the values of the slots. A template is
+     * usually written once with a JsonWriter, with JsonTemplate::Slot written as the raw value of every slot:
+     *
+     *     JsonWriter writer;
+     *     writer.BeginObject();
+     *     writer.Field("t", "stop");
+     *     writer.Key("e");
+     *     writer.RawValue(JsonTemplate::Slot);
+     *     writer.EndObject();
+     *
+     *     const JsonTemplate stopPacket(writer.TakeString());
+     *     stopPacket.Render("invalid action"); // {"t":"stop","e":"invalid action"}
+     *
+     * The slots are filled in the order they appear in. JsonWriter escapes all control characters in the strings, so the
+     * marker of a slot can never be a part of the values of the template.
+     */
+    class JsonTemplate {
+        public: // Constants
+            /**
+             * Marks a slot in the serialized template.
+             */
+            static constexpr const std::string_view Slot = "\x01";
+
+        public: // Public types
+            /**
+             * A value of a slot that is already serialized, it is rendered as it is, like JsonWriter::RawValue().
+             */
+            struct Raw {
+                std::string_view Json;
+            };
+
+        public: // Constructors & destructors
+            TRIVIALLY_COPYABLE(JsonTemplate);
+            TRIVIALLY_MOVEABLE(JsonTemplate);
+
+            /**
+             * Creates the template.
+             *
+             * @param json serialized template with the slots marked with JsonTemplate::Slot
+             */
+            explicit JsonTemplate(std::string_view json);
+
+        public: // Public methods
+            /**
+             * Renders the template.
+             *
+             * @param values values of the slots, anything that JsonWriter::Value() accepts or JsonTemplate::Raw
+             * @return the serialized JSON
+             */
+            template<typename... T>
+            [[nodiscard]] std::string Render(T&&... values) const;
+
+            /**
+             * Renders the template, which has to be an object, into the current object of the writer.
+             *
+             * @param values values of the slots, anything that JsonWriter::Value() accepts or JsonTemplate::Raw
+             */
+            template<typename... T>
+            void RenderMembers(JsonWriter& writer, T&&... values) const;
+
+            /**
+             * Gets the amount of the slots.
+             */
+            [[nodiscard]] size_t GetSlotCount() const noexcept;
+
+        private: // Private methods
+            template<typename T>
+            static void AppendValue(std::string& json, T&& value);
+
+        private: // Private fields
+            std::vector<std::string> m_fragments{}; // the text between the slots, one more than the slots
+            size_t m_size = 0; // size of all fragments
+    };
+
+    template<typename... T>
+    std::string JsonTemplate::Render(T&&... values) const {
+        M_ASSERT(sizeof...(T) == GetSlotCount(), "The amount of the values does not match the amount of the slots");
+
+        std::string json;
+        json.reserve(m_size + sizeof...(T) * 16);
+        json += m_fragments[0];
+
+        size_t fragment = 1;
+        ((AppendValue(json, std::forward<T>(values)), json += m_fragments[fragment++]), ...);
+
+        return json;
+    }
+
+    template<typename... T>
+    void JsonTemplate::RenderMembers(JsonWriter& writer, T&&... values) const {
+        writer.RawMembers(Render(std::forward<T>(values)...));
+    }
+
+    template<typename T>
+    void JsonTemplate::AppendValue(std::string& json, T&& value) {
+        // a writer that starts with the rendered text appends exactly one value to it
+        JsonWriter writer(std::move(json));
+
+        if constexpr (std::is_same_v<std::decay_t<T>, Raw>)
+            writer.RawValue(value.Json);
+        else
+            writer.Value(std::forward<T>(value));
+
+        json = writer.TakeString();
+    }
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONTEMPLATE_HPP
@@ -0,0 +1,183 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONWRITER_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONWRITER_HPP
+
+#include "Commons.hpp"
+
+#include <array>
+#include <charconv>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Merrie {
+
+    /**
+     * Writes JSON straight into a string buffer, without building a document first.
+     *
+     * The writer is forward-only: the values are written in the order of the calls and cannot be changed afterwards. It only
+     * keeps a small fixed-size stack of the open objects and arrays, so the only allocations are the ones of the output buffer,
+     * which can be reserved up front or reused between the packets, and of the list of the keys of the root object.
+     *
+     * The strings are escaped but not validated, they are expected to be valid UTF-8.
+     */
+    class JsonWriter {
+        public: // Constants
+            /**
+             * How deep the objects and arrays can be nested.
+             */
+            static constexpr const size_t MaxDepth = 32;
+
+        public: // Constructors & destructors
+            TRIVIALLY_COPYABLE(JsonWriter);
+            TRIVIALLY_MOVEABLE(JsonWriter);
+
+            JsonWriter() = default;
+
+            /**
+             * Creates a writer that appends to the buffer.
+             *
+             * @param buffer initial content of the output, usually an empty string with reserved capacity
+             */
+            explicit JsonWriter(std::string buffer);
+
+        public: // Public methods
+            void BeginObject();
+
+            void EndObject();
+
+            void BeginArray();
+
+            void EndArray();
+
+            /**
+             * Writes the key of the next value, only allowed directly inside of an object.
+             */
+            void Key(std::string_view key);
+
+            void Null();
+
+            void Value(bool value);
+
+            void Value(std::string_view value);
+
+            void Value(const char* value);
+
+            void Value(double value);
+
+            /**
+             * Writes any integer, bool is handled by its own overload.
+             */
+            template<typename T, typename = std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+            void Value(T value);
+
+            /**
+             * Writes an already serialized JSON value as it is, for example a pre-rendered fragment.
+             */
+            void RawValue(std::string_view json);
+
+            /**
+             * Writes the members of an already serialized JSON object into the current object, the keys written into the
+             * root object are remembered like the ones written with Key().
+             *
+             * @param object serialized object including its braces, an empty object writes nothing
+             */
+            void RawMembers(std::string_view object);
+
+            /**
+             * Writes a key and its value.
+             */
+            template<typename T>
+            void Field(std::string_view key, T&& value);
+
+            /**
+             * Writes a key and opens an object as its value.
+             */
+            void BeginObject(std::string_view key);
+
+            /**
+             * Writes a key and opens an array as its value.
+             */
+            void BeginArray(std::string_view key);
+
+            /**
+             * Checks whether or not the root object has the key, the keys are compared in their escaped form.
+             */
+            [[nodiscard]] bool HasRootKey(std::string_view key) const noexcept;
+
+            /**
+             * Checks whether or not all objects and arrays are closed and a value was written.
+             */
+            [[nodiscard]] bool IsComplete() const noexcept;
+
+            /**
+             * Gets the amount of the open objects and arrays.
+             */
+            [[nodiscard]] size_t GetDepth() const noexcept;
+
+            /**
+             * Gets what was written so far.
+             */
+            [[nodiscard]] const std::string& GetString() const noexcept;
+
+            /**
+             * Takes the output out of the writer, all objects and arrays have to be closed.
+             */
+            [[nodiscard]] std::string TakeString();
+
+            /**
+             * Clears the output and keeps its capacity.
+             */
+            void Clear() noexcept;
+
+        private: // Private types
+            struct Scope {
+                bool IsObject = false;
+                bool IsEmpty = true;
+                bool HasKey = false; // a key was written and waits for its value
+            };
+
+        private: // Private methods
+            /**
+             * Writes the separator that comes before a value and marks the current scope as not empty.
+             */
+            void BeforeValue();
+
+            void Open(bool isObject, char character);
+
+            void Close(bool isObject, char character);
+
+            /**
+             * Remembers the keys of the raw members of the root object that start at the offset.
+             */
+            void AddRootKeys(size_t membersOffset);
+
+            void AppendEscaped(std::string_view text);
+
+        private: // Private fields
+            std::string m_buffer{};
+            std::array<Scope, MaxDepth> m_scopes{};
+            size_t m_depth = 0;
+            bool m_hasRootValue = false;
+
+            // offsets and lengths of the keys of the root object in the buffer
+            std::vector<std::pair<size_t, size_t>> m_rootKeys{};
+    };
+
+    template<typename T, typename>
+    void JsonWriter::Value(T value) {
+        BeforeValue();
+
+        char digits[24];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        m_buffer.append(digits, result.ptr);
+    }
+
+    template<typename T>
+    void JsonWriter::Field(std::string_view key, T&& value) {
+        Key(key);
+        Value(std::forward<T>(value));
+    }
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_JSONWRITER_HPP
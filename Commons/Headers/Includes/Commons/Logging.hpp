@@ -3,6 +3,7 @@
 
 #include "Commons.hpp"
 
+#include <boost/log/keywords/severity.hpp>
 #include <boost/log/sources/record_ostream.hpp>
 #include <boost/log/sources/severity_feature.hpp>
 #include <boost/log/sources/severity_logger.hpp>
@@ -78,6 +79,12 @@
  */
 #define M_DECLARE_LOGGER_EX(name)      mutable Merrie::Logger m_logger = Merrie::LoggingSystem::InitLogger(name)
 
+/**
+ * Declares a new ContextLogger for the entity of the given kind and id as a field called m_logger.
+ * This can be placed only inside a class declaration, the kind has to be a string literal.
+ */
+#define M_DECLARE_CONTEXT_LOGGER(kind, id) mutable Merrie::ContextLogger m_logger{kind, id}
+
 /**
  * Creates a stream for writing a log message to a logger with the given severity.
  * This can be used only inside a class member method that has a logger initialized with M_DECLARE_LOGGER or M_DECLARE_LOGGER_EX.
@@ -155,6 +162,59 @@ namespace Merrie {
      */
     using Logger = boost::log::sources::severity_logger<LoggingSeverity>;
 
+    /**
+     * A logger of one of many entities of the same kind, like the players, that is named after the kind and the id of the
+     * entity ("Player#42").
+     *
+     * Unlike Logger, it only holds the kind and the id. The name, the attributes and the record are created only when a
+     * message is written, so the entities pay nothing for the logging until they log. The messages below the minimum
+     * severity of the LoggingSystem are dropped before that, the filters of the sinks match the names, so the other
+     * messages build them, also the ones that the sinks drop. It works with all M_LOG macros and can be used from any thread.
+     */
+    class ContextLogger {
+        public: // Types
+            using char_type = char;
+
+        public: // Constructors & destructors
+            TRIVIALLY_COPYABLE(ContextLogger);
+            TRIVIALLY_MOVEABLE(ContextLogger);
+
+            /**
+             * Creates the logger.
+             *
+             * @param kind kind of the entity, it is not copied and has to outlive the logger
+             * @param id id of the entity
+             */
+            constexpr ContextLogger(std::string_view kind, uint64_t id) noexcept : m_kind(kind), m_id(id) {
+            }
+
+        public: // Public methods
+            /**
+             * Gets the name that the messages are logged with.
+             */
+            [[nodiscard]] std::string GetName() const;
+
+            /**
+             * Opens a record with the severity of the arguments, for the M_LOG macros.
+             */
+            template<typename Arguments>
+            boost::log::record open_record(const Arguments& arguments) const {
+                return OpenRecord(arguments[boost::log::keywords::severity]);
+            }
+
+            /**
+             * Writes the record, for the M_LOG macros.
+             */
+            void push_record(boost::log::record&& record) const;
+
+        private: // Private methods
+            [[nodiscard]] boost::log::record OpenRecord(LoggingSeverity severity) const;
+
+        private: // Private fields
+            std::string_view m_kind;
+            uint64_t m_id;
+    };
+
     /**
      * A RAII helper class for initializing and destructing the logging system.
      */
@@ -193,14 +253,20 @@ namespace Merrie {
             /**
              * Updates the filters used for filtering logging messages.
              * @param filters filters to set.
+             * @param minimumSeverity messages with a lower severity are not logged.
              */
-            static void UpdateFilters(std::vector<std::string> filters);
+            static void UpdateFilters(std::vector<std::string> filters, LoggingSeverity minimumSeverity = LoggingSeverity::Trace);
 
             /**
              * Gets the list of the filters used for filtering logging messages.
              */
             static const std::vector<std::string>& GetFilters() noexcept;
 
+            /**
+             * Gets the lowest severity that is logged, it can be read from any thread.
+             */
+            static LoggingSeverity GetMinimumSeverity() noexcept;
+
         private: // Private variables
             struct Data;
             static std::unique_ptr<Data> s_data;
@@ -0,0 +1,225 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_BUFFERPOOL_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_BUFFERPOOL_HPP
+
+#include "../Commons.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <boost/asio/buffer.hpp>
+
+namespace Merrie {
+
+    class BufferPool; // Forward declaration
+
+    // ================================================================================
+    // =  BufferPoolBlock                                                             =
+    // ================================================================================
+
+    /**
+     * A block of memory borrowed from a BufferPool, it is returned to the pool when destroyed.
+     */
+    class BufferPoolBlock {
+        public: // Constructors & destructors
+            NON_COPYABLE(BufferPoolBlock);
+
+            /**
+             * Creates an empty block that holds no memory.
+             */
+            BufferPoolBlock() noexcept = default;
+
+            BufferPoolBlock(BufferPoolBlock&& rhs) noexcept;
+
+            BufferPoolBlock& operator=(BufferPoolBlock&& rhs) noexcept;
+
+            ~BufferPoolBlock();
+
+        public: // Public methods
+            /**
+             * Gets the memory of this block, nullptr if the block is empty.
+             */
+            [[nodiscard]] char* GetData() const noexcept;
+
+            /**
+             * Gets the size of the memory of this block in bytes.
+             */
+            [[nodiscard]] size_t GetSize() const noexcept;
+
+            /**
+             * Checks whether or not this block holds any memory.
+             */
+            [[nodiscard]] bool IsEmpty() const noexcept;
+
+            /**
+             * Returns the memory to the pool, the block is empty afterwards.
+             */
+            void Reset() noexcept;
+
+        private: // Friend methods
+            friend class BufferPool;
+
+            BufferPoolBlock(BufferPool* pool, char* data, size_t size) noexcept;
+
+        private: // Private fields
+            BufferPool* m_pool = nullptr;
+            char* m_data = nullptr;
+            size_t m_size = 0;
+    };
+
+    // ================================================================================
+    // =  BufferPool                                                                  =
+    // ================================================================================
+
+    /**
+     * A snapshot of the statistics of a BufferPool
+     */
+    struct BufferPoolStatistics {
+        /**
+         * Amount of blocks that are currently borrowed from the pool.
+         */
+        size_t BorrowedBlocks{};
+
+        /**
+         * Total size in bytes of the blocks that are currently borrowed from the pool.
+         */
+        size_t BorrowedBytes{};
+
+        /**
+         * Amount of free blocks that are kept by the pool for reuse.
+         */
+        size_t CachedBlocks{};
+
+        /**
+         * Total size in bytes of the free blocks that are kept by the pool for reuse.
+         */
+        size_t CachedBytes{};
+    };
+
+    /**
+     * A thread-safe pool of memory blocks, grouped in power-of-two size classes.
+     * Requests larger than the largest size class are served with unpooled memory.
+     */
+    class BufferPool {
+        public: // Constants
+            /**
+             * Size of the smallest size class.
+             */
+            static constexpr const size_t SmallestBlockSize = 1024;
+
+            /**
+             * Amount of size classes, the largest one is SmallestBlockSize * 2^(SizeClassCount - 1).
+             */
+            static constexpr const size_t SizeClassCount = 7;
+
+            /**
+             * Size of the largest size class.
+             */
+            static constexpr const size_t LargestBlockSize = SmallestBlockSize << (SizeClassCount - 1);
+
+        public: // Constructors & destructors
+            NON_COPYABLE(BufferPool);
+            NON_MOVEABLE(BufferPool);
+
+            /**
+             * Creates a new BufferPool
+             *
+             * @param maxCachedBytesPerClass how much memory of free blocks at most can be kept for reuse in every size class
+             */
+            explicit BufferPool(size_t maxCachedBytesPerClass);
+
+            ~BufferPool();
+
+        public: // Public methods
+            /**
+             * Borrows a block of at least the given size from the pool.
+             *
+             * @param minimumSize minimum size of the block
+             * @return the block, its size is rounded up to the size class
+             */
+            [[nodiscard]] BufferPoolBlock Acquire(size_t minimumSize);
+
+            /**
+             * Gets the current statistics of this pool.
+             */
+            [[nodiscard]] BufferPoolStatistics GetStatistics() const noexcept;
+
+        private: // Friend methods
+            friend class BufferPoolBlock;
+
+            void Release(char* data, size_t size) noexcept;
+
+        private: // Private types
+            struct SizeClass {
+                std::mutex Mutex{};
+                std::vector<char*> FreeBlocks{};
+            };
+
+        private: // Private fields
+            const size_t m_maxCachedBytesPerClass;
+            std::array<SizeClass, SizeClassCount> m_sizeClasses{};
+            std::atomic<size_t> m_borrowedBlocks{0};
+            std::atomic<size_t> m_borrowedBytes{0};
+            std::atomic<size_t> m_cachedBlocks{0};
+            std::atomic<size_t> m_cachedBytes{0};
+    };
+
+    // ================================================================================
+    // =  PooledFlatBuffer                                                            =
+    // ================================================================================
+
+    /**
+     * A contiguous DynamicBuffer that borrows its memory from a BufferPool.
+     * It grows by moving to a bigger size class and can give its memory back to the pool once it is empty.
+     */
+    class PooledFlatBuffer {
+        public: // Types
+            using const_buffers_type = boost::asio::const_buffer;
+            using mutable_buffers_type = boost::asio::mutable_buffer;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(PooledFlatBuffer);
+            NON_MOVEABLE(PooledFlatBuffer);
+
+            /**
+             * Creates a new buffer, it does not hold any memory until prepare() is called.
+             *
+             * @param pool the pool to borrow the memory from, must outlive the buffer
+             * @param maxSize maximum amount of bytes the buffer can hold
+             */
+            PooledFlatBuffer(BufferPool& pool, size_t maxSize) noexcept;
+
+        public: // DynamicBuffer
+            [[nodiscard]] size_t size() const noexcept;
+
+            [[nodiscard]] size_t max_size() const noexcept;
+
+            [[nodiscard]] size_t capacity() const noexcept;
+
+            [[nodiscard]] const_buffers_type data() const noexcept;
+
+            /**
+             * \throw std::length_error when size() + n exceeds max_size()
+             */
+            mutable_buffers_type prepare(size_t n);
+
+            void commit(size_t n) noexcept;
+
+            void consume(size_t n) noexcept;
+
+        public: // Public methods
+            /**
+             * Gives the memory back to the pool if the buffer holds no readable bytes.
+             */
+            void ReleaseIfEmpty() noexcept;
+
+        private: // Private fields
+            BufferPool& m_pool;
+            const size_t m_maxSize;
+            BufferPoolBlock m_block{};
+            size_t m_readOffset = 0;
+            size_t m_writeOffset = 0;
+            size_t m_preparedSize = 0;
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_BUFFERPOOL_HPP
@@ -3,16 +3,26 @@
 
 #include "../Commons.hpp"
 #include "../Time.hpp"
+#include "BufferPool.hpp"
+#include "HttpCompression.hpp"
+#include "HttpStaticFiles.hpp"
 #include "NetworkServer.hpp"
+#include "Tls.hpp"
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
+#include <optional>
 
 namespace Merrie {
 
     class HttpServer; // Forward declaration
     class HttpConnection;
+    class HttpFileResponse; // HttpStaticFiles.cpp
+    class HttpResponseStream; // HttpResponseStream.hpp
+    class HttpRouteMetrics; // HttpRouter.hpp
+    class WebSocketConnection; // WebSocket.hpp
+    struct WebSocketCallbacks; // WebSocket.hpp
 
 
     // ================================================================================
@@ -77,6 +87,26 @@ namespace Merrie {
          * KeepAlive max - indicates the maximum number of requests that can be sent on this connection before closing it.
          */
         uint16_t KeepAliveMax{};
+
+        /**
+         * Maximum size of the request headers in bytes, requests with bigger headers are rejected with 431.
+         */
+        size_t MaxHeaderSize{};
+
+        /**
+         * Settings for the response compression.
+         */
+        HttpCompressionSettings CompressionSettings{};
+
+        /**
+         * Settings for the TLS termination (HTTPS and WSS).
+         */
+        TlsSettings TlsSettingsValue{};
+
+        /**
+         * Settings for serving the files of a local directory.
+         */
+        HttpStaticFilesSettings StaticFilesSettings{};
     };
 
     /**
@@ -110,25 +140,105 @@ namespace Merrie {
              */
             void SendResponse();
 
+            /**
+             * Sends the headers of the cached response (the one returned by GetResponse()) using the chunked transfer encoding
+             * and returns a stream that the body can be written to. The body of the cached response is ignored.
+             * The response is finished with HttpResponseStream::Finish(). Only the headers are sent in the response to HEAD.
+             *
+             * @return the stream or nullptr if the connection is no longer valid or the request is HEAD
+             */
+            std::shared_ptr<HttpResponseStream> StartStreamingResponse();
+
+            /**
+             * Sends the headers of the cached response (the one returned by GetResponse()) followed by the given range of the file.
+             * The body of the cached response is ignored. Plain connections send the file with sendfile where it is available,
+             * TLS connections copy it through the send buffer pool. Declared here, defined in HttpStaticFiles.cpp.
+             *
+             * @param file opened file
+             * @param offset offset of the first byte to send
+             * @param length amount of bytes to send
+             */
+            void SendFileResponse(boost::beast::file file, uint64_t offset, uint64_t length);
+
+            /**
+             * Allows or forbids the compression of the response to the last request, it is allowed again for the next request.
+             */
+            void SetCompressionAllowed(bool allowed) noexcept;
+
+            /**
+             * Checks whether or not the last request asks for an upgrade to the WebSocket protocol.
+             */
+            [[nodiscard]] bool IsWebSocketUpgrade() const;
+
+            /**
+             * Accepts the WebSocket upgrade request, the connection is then no longer used for HTTP. The callbacks are called
+             * from the I/O threads. Declared here, defined in WebSocket.cpp.
+             *
+             * @return the WebSocket connection or nullptr if the connection is no longer valid or the last request is not an upgrade request
+             */
+            std::shared_ptr<WebSocketConnection> UpgradeToWebSocket(WebSocketCallbacks callbacks);
+
         public: // Overriden functions
             bool IsValid() override;
 
         protected: // Friend methods
             friend class HttpServer;
+            friend class HttpFileResponse;
+            friend class HttpResponseStream;
+            friend class HttpRouter;
+            friend class WebSocketConnection;
 
             void ReadData(std::shared_ptr<NetworkConnection> connectionOwnership);
 
+            void OnResponseWritten(std::shared_ptr<NetworkConnection> connectionOwnership, boost::beast::error_code error);
+
+            /**
+             * Calls the function with the stream that the HTTP messages are read from and written to, either the socket or the TLS stream.
+             */
+            template<typename Function>
+            void VisitStream(Function&& function) {
+                #ifdef M_HAS_OPENSSL_SSL
+                if (m_tlsStream) {
+                    function(*m_tlsStream);
+                    return;
+                }
+                #endif
+
+                function(GetSocket());
+            }
+
         private: // Private methods
             void SetTimeout();
 
+            void Handshake(std::shared_ptr<NetworkConnection> connectionOwnership);
+
+            void ReadRequest(std::shared_ptr<NetworkConnection> connectionOwnership);
+
+            void PrepareResponseHeaders();
+
+            void CompressResponse();
+
+            void SendReadError(http::status status);
+
         private: // Private fields
             bool m_keepAlive = false;
             bool m_invalidated = false;
+            bool m_upgraded = false;
+            bool m_compressionAllowed = true;
             DefaultClock::time_point m_timeout;
+            DefaultClock::time_point m_requestStart{};
+            HttpRouteMetrics* m_routeMetrics = nullptr;
             HttpServer* m_server;
-            boost::beast::flat_static_buffer<8192> m_buffer;
+            PooledFlatBuffer m_buffer;
+            std::optional<http::request_parser<http::string_body>> m_parser{};
             http::request<http::string_body> m_request{};
             http::response<http::string_body> m_response{};
+
+            #ifdef M_HAS_OPENSSL_SSL
+            std::optional<ssl::stream<tcp::socket&>> m_tlsStream{};
+            bool m_tlsHandshakeDone = false;
+            char m_firstRequestByte{};
+            #endif
     };
 
     /**
@@ -141,6 +251,8 @@ namespace Merrie {
 
             /**
              * Creates a new HttpServer with the given settings
+             *
+             * \throw TlsException when TLS is enabled, but the context cannot be created
              */
             explicit HttpServer(HttpServerSettings settings);
 
@@ -151,6 +263,31 @@ namespace Merrie {
              */
             [[nodiscard]] const HttpServerSettings& GetHttpSettings() const;
 
+            /**
+             * Gets the statistics of the response compression of this HttpServer
+             */
+            [[nodiscard]] HttpCompressionStatistics GetCompressionStatistics() const noexcept;
+
+            /**
+             * Gets the statistics of the pool that the receive buffers of the connections are borrowed from
+             */
+            [[nodiscard]] BufferPoolStatistics GetReceiveBufferStatistics() const noexcept;
+
+            /**
+             * Gets the statistics of the pool that the chunks of the streamed responses are borrowed from
+             */
+            [[nodiscard]] BufferPoolStatistics GetSendBufferStatistics() const noexcept;
+
+            /**
+             * Gets the statistics of the TLS handshakes of this HttpServer, all zeros when TLS is not enabled
+             */
+            [[nodiscard]] TlsStatistics GetTlsStatistics() const noexcept;
+
+            /**
+             * Gets the static files served by this HttpServer, nullptr when they are not enabled. The subclasses route the requests to it.
+             */
+            [[nodiscard]] HttpStaticFiles* GetStaticFiles() noexcept;
+
         protected: // Protected methods
             void ReadData(std::shared_ptr<NetworkConnection> connection) override;
 
@@ -164,6 +301,14 @@ namespace Merrie {
         private: // Private fields
             const HttpServerSettings m_settings;
             const std::string m_keepAliveHeader;
+            HttpCompressionMetrics m_compressionMetrics;
+            BufferPool m_receiveBufferPool;
+            BufferPool m_sendBufferPool;
+            std::unique_ptr<HttpStaticFiles> m_staticFiles;
+
+            #ifdef M_HAS_OPENSSL_SSL
+            std::unique_ptr<TlsServerContext> m_tlsContext;
+            #endif
     };
 }
 
@@ -0,0 +1,153 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPCOMPRESSION_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPCOMPRESSION_HPP
+
+#include "../Commons.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+namespace Merrie {
+
+    // ================================================================================
+    // =  Content encoding                                                            =
+    // ================================================================================
+
+    /**
+     * Thrown when compressing a response body fails.
+     */
+    M_DECLARE_EXCEPTION(HttpCompressionException);
+
+    /**
+     * Content encodings that the HttpServer is able to produce.
+     */
+    enum class HttpContentEncoding : uint8_t {
+            Identity,
+            Deflate,
+            Gzip,
+    };
+
+    /**
+     * Gets the name of the given encoding, as used in the Content-Encoding header.
+     */
+    [[nodiscard]] std::string_view GetContentEncodingName(HttpContentEncoding encoding) noexcept;
+
+    /**
+     * Chooses the best content encoding that is acceptable according to the given Accept-Encoding header value.
+     * Gzip is preferred over deflate when both have the same quality value.
+     *
+     * @param acceptEncoding value of the Accept-Encoding request header, may be empty
+     * @return the chosen encoding or HttpContentEncoding::Identity if the client does not accept any supported encoding
+     */
+    [[nodiscard]] HttpContentEncoding NegotiateContentEncoding(std::string_view acceptEncoding) noexcept;
+
+    /**
+     * Compresses the given input using the given encoding and stores the result in the output.
+     * The compressor state is kept per thread and reused between calls, the output string is only reallocated when its capacity is too small.
+     *
+     * @param encoding encoding to use, must not be HttpContentEncoding::Identity
+     * @param level zlib compression level (0-9, -1 for the zlib default)
+     * @param input data to be compressed
+     * @param output string to write the compressed data to, its previous content is discarded
+     *
+     * \throw HttpCompressionException
+     */
+    void CompressHttpBody(HttpContentEncoding encoding, int level, std::string_view input, std::string& output);
+
+    // ================================================================================
+    // =  Settings & statistics                                                       =
+    // ================================================================================
+
+    /**
+     * Settings of the HttpServer response compression
+     */
+    struct HttpCompressionSettings {
+        /**
+         * Should responses be compressed when the client accepts it.
+         */
+        bool Enabled{};
+
+        /**
+         * Bodies smaller than this amount of bytes are never compressed.
+         */
+        size_t MinimumSize{};
+
+        /**
+         * zlib compression level (0-9, -1 for the zlib default).
+         */
+        int Level{};
+    };
+
+    /**
+     * A snapshot of the compression statistics of an HttpServer
+     */
+    struct HttpCompressionStatistics {
+        /**
+         * Amount of responses that were compressed.
+         */
+        uint64_t CompressedResponses{};
+
+        /**
+         * Amount of responses that were sent uncompressed, either because they were too small or the client did not accept any encoding.
+         */
+        uint64_t SkippedResponses{};
+
+        /**
+         * Total size of the compressed responses, before the compression.
+         */
+        uint64_t UncompressedBytes{};
+
+        /**
+         * Total size of the compressed responses, after the compression.
+         */
+        uint64_t CompressedBytes{};
+
+        /**
+         * Total time spent compressing.
+         */
+        std::chrono::nanoseconds CompressionTime{};
+
+        /**
+         * Gets the amount of bytes that were saved by the compression.
+         */
+        [[nodiscard]] uint64_t GetSavedBytes() const noexcept {
+            return UncompressedBytes > CompressedBytes ? UncompressedBytes - CompressedBytes : 0;
+        }
+    };
+
+    /**
+     * Thread-safe counters of the HttpServer response compression
+     */
+    class HttpCompressionMetrics {
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpCompressionMetrics);
+            NON_MOVEABLE(HttpCompressionMetrics);
+
+            HttpCompressionMetrics() = default;
+
+        public: // Public methods
+            /**
+             * Records a response that was compressed.
+             */
+            void RecordCompressed(size_t uncompressedSize, size_t compressedSize, std::chrono::nanoseconds time) noexcept;
+
+            /**
+             * Records a response that was not compressed.
+             */
+            void RecordSkipped() noexcept;
+
+            /**
+             * Gets the current values of the counters.
+             */
+            [[nodiscard]] HttpCompressionStatistics GetStatistics() const noexcept;
+
+        private: // Private fields
+            std::atomic<uint64_t> m_compressedResponses{0};
+            std::atomic<uint64_t> m_skippedResponses{0};
+            std::atomic<uint64_t> m_uncompressedBytes{0};
+            std::atomic<uint64_t> m_compressedBytes{0};
+            std::atomic<int64_t> m_compressionNanoseconds{0};
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPCOMPRESSION_HPP
@@ -0,0 +1,124 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPRESPONSESTREAM_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPRESPONSESTREAM_HPP
+
+#include "../Commons.hpp"
+#include "BufferPool.hpp"
+#include "Http.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string_view>
+
+namespace Merrie {
+
+    /**
+     * A body of an HTTP response that is sent with the chunked transfer encoding while it is being produced.
+     *
+     * The producer writes to the stream from a single thread at a time (not necessarily an I/O thread), the socket is written to
+     * only from the strand of the connection. The data is copied into
+     * chunks borrowed from the server's BufferPool and every chunk is written to the socket as soon as it fills up. At most
+     * MaxPendingBytes wait for the socket, a write takes only the part of the data that fits and the producer continues with
+     * the rest when the WhenDrained() callback is called, so the whole body is never held in memory. Created by
+     * HttpConnection::StartStreamingResponse().
+     */
+    class HttpResponseStream : public std::enable_shared_from_this<HttpResponseStream> {
+        public: // Constants
+            /**
+             * Size of a single chunk of the body.
+             */
+            static constexpr const size_t ChunkSize = 16 * 1024;
+
+            /**
+             * Amount of bytes that can wait for the socket, the writes are accepted again once half of it is sent.
+             */
+            static constexpr const size_t MaxPendingBytes = 4 * ChunkSize;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpResponseStream);
+            NON_MOVEABLE(HttpResponseStream);
+
+            /**
+             * Creates a new stream, use HttpConnection::StartStreamingResponse() instead.
+             *
+             * @param connection connection that the response is sent to
+             * @param pool pool that the chunks are borrowed from
+             */
+            HttpResponseStream(std::shared_ptr<HttpConnection> connection, BufferPool& pool);
+
+        public: // Public methods
+            /**
+             * Appends as much of the data to the body as fits below MaxPendingBytes. Full chunks are queued for sending.
+             * The data is discarded if the stream has failed or was finished.
+             *
+             * @return amount of the bytes taken, the producer should wait for the WhenDrained() callback before writing the rest
+             */
+            size_t Write(std::string_view data);
+
+            /**
+             * Calls the callback once, from the strand of the connection, as soon as the writes are accepted again or the stream
+             * has failed. It is called right away (but not from this function) if the writes are accepted already.
+             */
+            void WhenDrained(std::function<void()> callback);
+
+            /**
+             * Queues the partially filled chunk for sending.
+             */
+            void Flush();
+
+            /**
+             * Sends the remaining data and ends the response. The stream cannot be written to afterwards.
+             */
+            void Finish();
+
+            /**
+             * Checks whether or not writing to the socket has failed, the remaining data will be discarded in such case.
+             */
+            [[nodiscard]] bool IsFailed() const noexcept;
+
+            /**
+             * Gets the amount of bytes that were written to the stream, but not yet to the socket.
+             */
+            [[nodiscard]] size_t GetPendingBytes() const noexcept;
+
+        private: // Friend methods
+            friend class HttpConnection;
+
+            void Start(http::response_header<> header, bool headerOnly);
+
+        private: // Private methods
+            void QueueCurrentChunk();
+
+            void ScheduleWrite();
+
+            void WriteNext(std::unique_lock<std::mutex>& lock);
+
+            void OnWritten(boost::beast::error_code error);
+
+        private: // Private types
+            struct Chunk {
+                BufferPoolBlock Block;
+                size_t Size;
+            };
+
+        private: // Private fields
+            const std::shared_ptr<HttpConnection> m_connection;
+            BufferPool& m_pool;
+
+            http::response<http::empty_body> m_header{};
+            std::optional<http::response_serializer<http::empty_body>> m_serializer{};
+
+            mutable std::mutex m_mutex{};
+            BufferPoolBlock m_currentBlock{};
+            size_t m_currentSize = 0;
+            std::deque<Chunk> m_queue{};
+            size_t m_pendingBytes = 0;
+            bool m_writing = false;
+            bool m_finishing = false;
+            bool m_lastChunkSent = false;
+            bool m_failed = false;
+            std::function<void()> m_drainedCallback{};
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPRESPONSESTREAM_HPP
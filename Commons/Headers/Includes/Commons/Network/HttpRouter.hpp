@@ -0,0 +1,278 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPROUTER_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPROUTER_HPP
+
+#include "../Commons.hpp"
+#include "Http.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+namespace Merrie {
+
+    // ================================================================================
+    // =  Routes                                                                      =
+    // ================================================================================
+
+    /**
+     * Thrown when a route cannot be added to an HttpRouter.
+     */
+    M_DECLARE_EXCEPTION(HttpRouterException);
+
+    /**
+     * How the path of a route is matched against the path of a request.
+     */
+    enum class HttpRouteMatch : uint8_t {
+            /**
+             * The paths have to be equal.
+             */
+            Exact,
+
+            /**
+             * The path of the request has to start with the path of the route, the longest prefix wins.
+             */
+            Prefix,
+    };
+
+    /**
+     * Called when a request matches a route.
+     */
+    using HttpRouteHandler = std::function<void(std::shared_ptr<HttpConnection> connection, const DecodedUrl& url)>;
+
+    /**
+     * Called when a request cannot be routed, it has to send the response.
+     */
+    using HttpRouteErrorHandler = std::function<void(const std::shared_ptr<HttpConnection>& connection, http::status status, std::string_view message)>;
+
+    /**
+     * CORS headers of a route
+     */
+    struct HttpCorsOptions {
+        /**
+         * Value of the Access-Control-Allow-Origin header, no CORS headers are sent when empty.
+         */
+        std::string AllowOrigin{};
+
+        /**
+         * Value of the Access-Control-Allow-Headers header.
+         */
+        std::string AllowHeaders = "*";
+
+        /**
+         * Should the Access-Control-Allow-Credentials header be sent.
+         */
+        bool AllowCredentials = false;
+
+        /**
+         * How long the preflight response can be cached in seconds.
+         */
+        uint32_t MaxAge = 86400;
+    };
+
+    /**
+     * Options of a route
+     */
+    struct HttpRouteOptions {
+        /**
+         * CORS headers of the route, OPTIONS requests to a route with CORS are answered by the router.
+         */
+        HttpCorsOptions Cors{};
+
+        /**
+         * Can the responses of the route be compressed, if the compression is enabled in the HttpServer.
+         */
+        bool AllowCompression = true;
+    };
+
+    /**
+     * A route of an HttpRouter
+     */
+    struct HttpRoute {
+        HttpRouteMatch Match{};
+        std::string Path{};
+
+        /**
+         * Methods accepted by the route, all methods are accepted when empty.
+         */
+        std::vector<http::verb> Methods{};
+
+        HttpRouteHandler Handler{};
+        HttpRouteOptions Options{};
+
+        /**
+         * Checks whether or not the route accepts the method.
+         */
+        [[nodiscard]] bool AcceptsMethod(http::verb method) const noexcept;
+    };
+
+    // ================================================================================
+    // =  Statistics                                                                  =
+    // ================================================================================
+
+    /**
+     * A snapshot of the statistics of a route
+     */
+    struct HttpRouteStatistics {
+        HttpRouteMatch Match{};
+        std::string Path{};
+
+        /**
+         * Amount of responses sent.
+         */
+        uint64_t Requests{};
+
+        /**
+         * Total time from receiving the requests to sending the responses.
+         */
+        std::chrono::nanoseconds TotalLatency{};
+
+        /**
+         * The longest time from receiving a request to sending the response.
+         */
+        std::chrono::nanoseconds MaxLatency{};
+
+        /**
+         * Gets the average time from receiving a request to sending the response.
+         */
+        [[nodiscard]] std::chrono::nanoseconds GetAverageLatency() const noexcept {
+            return Requests != 0 ? TotalLatency / static_cast<int64_t>(Requests) : std::chrono::nanoseconds::zero();
+        }
+    };
+
+    /**
+     * Thread-safe latency counters of a route
+     */
+    class HttpRouteMetrics {
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpRouteMetrics);
+            NON_MOVEABLE(HttpRouteMetrics);
+
+            HttpRouteMetrics() = default;
+
+        public: // Public methods
+            /**
+             * Records a response that was sent.
+             */
+            void RecordRequest(std::chrono::nanoseconds latency) noexcept;
+
+            [[nodiscard]] uint64_t GetRequests() const noexcept;
+
+            [[nodiscard]] std::chrono::nanoseconds GetTotalLatency() const noexcept;
+
+            [[nodiscard]] std::chrono::nanoseconds GetMaxLatency() const noexcept;
+
+        private: // Private fields
+            std::atomic<uint64_t> m_requests{0};
+            std::atomic<int64_t> m_totalNanoseconds{0};
+            std::atomic<int64_t> m_maxNanoseconds{0};
+    };
+
+    // ================================================================================
+    // =  HttpRouter                                                                  =
+    // ================================================================================
+
+    /**
+     * Routes the requests of an HttpServer to the handlers.
+     *
+     * The routes are added at startup and then compiled into a flat byte trie by Freeze(), so a lookup is a single walk over
+     * the request path, no matter how many routes there are. The router cannot be modified after it was frozen, so the lookups
+     * do not need any locking.
+     */
+    class HttpRouter {
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpRouter);
+            NON_MOVEABLE(HttpRouter);
+
+            /**
+             * Creates a router with no routes.
+             *
+             * @param errorHandler sends the response when a request cannot be routed, a plain text response is sent when it is empty
+             */
+            explicit HttpRouter(HttpRouteErrorHandler errorHandler = {});
+
+        public: // Public methods
+            /**
+             * Adds a route, routes with the same path can be added for different methods.
+             *
+             * \throw HttpRouterException if the router is frozen or the route conflicts with one that was added before
+             */
+            void AddRoute(HttpRouteMatch match, std::string path, std::vector<http::verb> methods, HttpRouteHandler handler, HttpRouteOptions options = {});
+
+            /**
+             * Compiles the routes, no routes can be added afterwards.
+             */
+            void Freeze();
+
+            /**
+             * Checks whether or not the router was frozen.
+             */
+            [[nodiscard]] bool IsFrozen() const noexcept;
+
+            /**
+             * Finds the route of the request, the router has to be frozen.
+             *
+             * @param path path of the request, without the query string
+             * @param method method of the request
+             * @param[out] pathMatched set to true when a route matches the path, but not the method
+             * @return the route or nullptr if none matches
+             */
+            [[nodiscard]] const HttpRoute* Find(std::string_view path, http::verb method, bool& pathMatched) const;
+
+            /**
+             * Routes the last request of the connection: decodes the URL, finds the route, sets the CORS headers and calls the handler.
+             * Sends an error response when the URL is invalid (400), no route matches (404) or the method is not accepted (405).
+             */
+            void Route(std::shared_ptr<HttpConnection> connection) const;
+
+            /**
+             * Gets the statistics of all the routes, in the order in which they were added.
+             */
+            [[nodiscard]] std::vector<HttpRouteStatistics> GetStatistics() const;
+
+        private: // Private types
+            struct Entry {
+                HttpRoute Route;
+
+                // updated by the connections, the route itself is immutable
+                mutable HttpRouteMetrics Metrics{};
+            };
+
+            struct Node {
+                uint32_t FirstEdge = 0;
+                uint32_t EdgeCount = 0;
+                uint32_t FirstExactRoute = 0;
+                uint32_t ExactRouteCount = 0;
+                uint32_t FirstPrefixRoute = 0;
+                uint32_t PrefixRouteCount = 0;
+            };
+
+            struct Edge {
+                char Character;
+                uint32_t Node;
+            };
+
+        private: // Private methods
+            /**
+             * Finds the route of the request, pathEntry is set to a route that matches the path, but not the method, when none matches both.
+             */
+            [[nodiscard]] const Entry* FindEntry(std::string_view path, http::verb method, const Entry*& pathEntry) const;
+
+            const Entry* FindInRoutes(uint32_t first, uint32_t count, http::verb method, const Entry*& pathEntry) const;
+
+            void SendError(const std::shared_ptr<HttpConnection>& connection, http::status status, std::string_view message) const;
+
+            static void SetCorsHeaders(HttpConnection& connection, const HttpRoute& route);
+
+        private: // Private fields
+            const HttpRouteErrorHandler m_errorHandler;
+            bool m_frozen = false;
+            std::vector<std::unique_ptr<Entry>> m_entries{};
+
+            // compiled trie, the root is the first node
+            std::vector<Node> m_nodes{};
+            std::vector<Edge> m_edges{};
+            std::vector<uint32_t> m_nodeRoutes{};
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPROUTER_HPP
@@ -0,0 +1,194 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPSTATICFILES_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPSTATICFILES_HPP
+
+#include "../Commons.hpp"
+#include "../Time.hpp"
+
+#include <atomic>
+#include <ctime>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace Merrie {
+
+    class HttpConnection; // Http.hpp
+
+    // ================================================================================
+    // =  Settings & statistics                                                       =
+    // ================================================================================
+
+    /**
+     * Thrown when the static files cannot be served from the configured directory.
+     */
+    M_DECLARE_EXCEPTION(HttpStaticFilesException);
+
+    /**
+     * Settings of the static files served by an HTTP server
+     */
+    struct HttpStaticFilesSettings {
+        /**
+         * Should the files be served.
+         */
+        bool Enabled{};
+
+        /**
+         * Directory that the files are served from.
+         */
+        std::string RootDirectory{};
+
+        /**
+         * Path prefix of the URLs of the files, for example "/assets/".
+         */
+        std::string UrlPrefix{};
+
+        /**
+         * Files up to this size in bytes are kept in memory, bigger files are sent from the disk. 0 disables the cache.
+         */
+        size_t MaxCachedFileSize{};
+
+        /**
+         * Maximum amount of memory in bytes used by the cached files, the least recently used files are evicted.
+         */
+        size_t MaxCacheSize{};
+
+        /**
+         * Value of the max-age directive of the Cache-Control header in seconds.
+         */
+        uint32_t MaxAge{};
+    };
+
+    /**
+     * A snapshot of the statistics of the static files
+     */
+    struct HttpStaticFilesStatistics {
+        /**
+         * Amount of responses sent from the memory cache.
+         */
+        uint64_t CacheHits{};
+
+        /**
+         * Amount of responses sent from the disk.
+         */
+        uint64_t CacheMisses{};
+
+        /**
+         * Amount of 304 responses to conditional requests.
+         */
+        uint64_t NotModifiedResponses{};
+
+        /**
+         * Amount of 206 responses to range requests.
+         */
+        uint64_t PartialResponses{};
+
+        /**
+         * Amount of files in the memory cache.
+         */
+        uint64_t CachedFiles{};
+
+        /**
+         * Size of the files in the memory cache in bytes.
+         */
+        uint64_t CachedBytes{};
+    };
+
+    // ================================================================================
+    // =  HttpStaticFiles                                                             =
+    // ================================================================================
+
+    /**
+     * Serves the files of a local directory.
+     *
+     * Small files are kept in an in-memory LRU cache together with their ETags, they are checked against the disk at most once
+     * a second. Bigger files are sent straight from the disk with HttpConnection::SendFileResponse(). Conditional requests
+     * (If-None-Match) and single byte ranges (Range, If-Range) are supported. The responses are never compressed, so the ETags
+     * and the byte ranges always refer to the bytes on the disk.
+     */
+    class HttpStaticFiles {
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpStaticFiles);
+            NON_MOVEABLE(HttpStaticFiles);
+
+            /**
+             * Creates the static files of the directory.
+             *
+             * \throw HttpStaticFilesException if the root directory does not exist
+             */
+            explicit HttpStaticFiles(HttpStaticFilesSettings settings);
+
+        public: // Public methods
+            /**
+             * Responds to the last GET or HEAD request of the connection with the file.
+             *
+             * @param connection connection that the request came from
+             * @param path path of the file relative to the root directory, paths that leave the directory are rejected with 404
+             */
+            void Serve(const std::shared_ptr<HttpConnection>& connection, std::string_view path);
+
+            /**
+             * Gets the settings of the static files.
+             */
+            [[nodiscard]] const HttpStaticFilesSettings& GetSettings() const noexcept;
+
+            /**
+             * Gets the current values of the counters.
+             */
+            [[nodiscard]] HttpStaticFilesStatistics GetStatistics() const;
+
+        private: // Private types
+            /**
+             * What identifies a version of a file.
+             */
+            struct FileVersion {
+                uint64_t Size = 0;
+                std::time_t ModificationTime = 0;
+            };
+
+            struct CachedFile {
+                std::string Path;
+                FileVersion Version;
+                std::string ETag;
+                std::string Content;
+
+                /**
+                 * The file is checked against the disk again after this point.
+                 */
+                DefaultClock::time_point ValidUntil;
+            };
+
+            using CacheList = std::list<std::shared_ptr<CachedFile>>;
+
+        private: // Private methods
+            std::shared_ptr<const CachedFile> FindCachedFile(const std::string& path);
+
+            void AddCachedFile(std::shared_ptr<CachedFile> file);
+
+            void RemoveCachedFile(const std::string& path);
+
+            /**
+             * Sets the common headers and handles the conditional and range requests.
+             *
+             * @param[out] offset offset of the first byte of the body
+             * @param[out] length length of the body
+             * @return false if the response has no body (304, 416)
+             */
+            bool PrepareResponse(HttpConnection& connection, std::string_view path, const std::string& eTag, uint64_t size, uint64_t& offset, uint64_t& length);
+
+        private: // Private fields
+            const HttpStaticFilesSettings m_settings;
+
+            mutable std::mutex m_cacheMutex;
+            CacheList m_cache{}; // the most recently used file is at the front
+            std::unordered_map<std::string, CacheList::iterator> m_cacheIndex{};
+            size_t m_cachedBytes = 0;
+
+            std::atomic<uint64_t> m_cacheHits{0};
+            std::atomic<uint64_t> m_cacheMisses{0};
+            std::atomic<uint64_t> m_notModifiedResponses{0};
+            std::atomic<uint64_t> m_partialResponses{0};
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_HTTPSTATICFILES_HPP
@@ -46,7 +46,7 @@ namespace Merrie {
             NON_MOVEABLE(NetworkConnection);
 
             /**
-             * Creates a new NetworkConnection with the given ioContext that will be used for intiializing socket.
+             * Creates a new NetworkConnection, its socket is created on a new strand of the given ioContext.
              */
             explicit NetworkConnection(boost::asio::io_context& ioContext);
 
@@ -60,11 +60,24 @@ namespace Merrie {
              * Get remote endpoint of this connection, if it exists
              */
             [[nodiscard]] const std::optional<tcp::endpoint>& GetRemoteEndpoint() const;
+
+            /**
+             * Gets the strand that all reads and writes of the connection are started from and completed on. It is the executor
+             * of the socket too, so the timers of the streams layered on the socket run on it as well. Work that touches the
+             * state of the connection from outside of its handlers is posted to it.
+             */
+            [[nodiscard]] boost::asio::strand<boost::asio::io_context::executor_type>& GetStrand() noexcept {
+                return m_strand;
+            }
+
         protected: // Friend methods
             tcp::socket& GetSocket();
 
             friend class NetworkServer;
 
+        protected: // Protected fields
+            boost::asio::strand<boost::asio::io_context::executor_type> m_strand;
+
         private: // Private fields
             tcp::socket m_socket;
             std::optional<tcp::endpoint> m_remoteEndpoint;
@@ -118,6 +131,11 @@ namespace Merrie {
             [[nodiscard]] bool IsRunning() const noexcept;
 
         protected: // Protected methods
+            /**
+             * Gets the io_context that the worker threads run, handlers posted to it run on one of them.
+             */
+            [[nodiscard]] boost::asio::io_context& GetIoContext() noexcept;
+
             virtual std::shared_ptr<NetworkConnection> CreateNetworkConnection(boost::asio::io_context& context) = 0;
 
             virtual void ReadData(std::shared_ptr<NetworkConnection> connection) = 0;
@@ -127,6 +145,11 @@ namespace Merrie {
 
             void HandleNewConnection(const boost::system::error_code& error, std::shared_ptr<NetworkConnection> connection);
 
+            /**
+             * Closes the socket of the connection from its strand.
+             */
+            static void CloseConnection(const std::shared_ptr<NetworkConnection>& connection);
+
         private: // Private fields
             const NetworkServerSettings m_settings;
             const tcp::endpoint m_endpoint;
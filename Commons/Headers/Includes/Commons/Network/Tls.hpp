@@ -0,0 +1,174 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_TLS_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_TLS_HPP
+
+#include "../Commons.hpp"
+
+#include <atomic>
+#include <memory>
+
+#ifdef M_HAS_OPENSSL_SSL
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/thread_pool.hpp>
+#endif
+
+namespace Merrie {
+
+    // ================================================================================
+    // =  Settings & statistics                                                       =
+    // ================================================================================
+
+    /**
+     * Thrown when the TLS context cannot be created.
+     */
+    M_DECLARE_EXCEPTION(TlsException);
+
+    /**
+     * Settings of the TLS termination of a server
+     */
+    struct TlsSettings {
+        /**
+         * Should the connections use TLS, requires OpenSSL.
+         */
+        bool Enabled{};
+
+        /**
+         * Path to the PEM file with the certificate chain, starting with the server certificate.
+         */
+        std::string CertificateChainFile{};
+
+        /**
+         * Path to the PEM file with the private key of the server certificate.
+         */
+        std::string PrivateKeyFile{};
+
+        /**
+         * Maximum amount of sessions in the session cache shared by all the connections, 0 for the OpenSSL default.
+         */
+        size_t SessionCacheSize{};
+
+        /**
+         * How long a session can be resumed in seconds, 0 for the OpenSSL default.
+         */
+        uint32_t SessionTimeout{};
+
+        /**
+         * Should session tickets be issued, so the clients can resume sessions that are no longer in the cache.
+         */
+        bool SessionTickets{};
+
+        /**
+         * Amount of threads dedicated to the handshakes, 0 to do the handshakes on the I/O threads.
+         */
+        size_t HandshakeThreadCount{};
+
+        /**
+         * Maximum amount of handshakes in progress, connections above the limit are closed right away. 0 for no limit.
+         */
+        size_t MaxPendingHandshakes{};
+    };
+
+    /**
+     * A snapshot of the TLS statistics of a server
+     */
+    struct TlsStatistics {
+        /**
+         * Amount of handshakes that completed with a new session.
+         */
+        uint64_t FullHandshakes{};
+
+        /**
+         * Amount of handshakes that resumed a session, from the cache or from a ticket.
+         */
+        uint64_t ResumedHandshakes{};
+
+        /**
+         * Amount of handshakes that failed.
+         */
+        uint64_t FailedHandshakes{};
+
+        /**
+         * Amount of connections closed because of the MaxPendingHandshakes limit.
+         */
+        uint64_t RejectedHandshakes{};
+
+        /**
+         * Amount of handshakes in progress.
+         */
+        uint64_t PendingHandshakes{};
+    };
+
+    #ifdef M_HAS_OPENSSL_SSL
+
+    // ================================================================================
+    // =  TlsServerContext                                                            =
+    // ================================================================================
+
+    /**
+     * Shorter namespace definition for the boost ssl namespace
+     */
+    namespace ssl = boost::asio::ssl;
+
+    /**
+     * TLS state shared by all the connections of a server: the SSL context with the session cache and the handshake threads.
+     */
+    class TlsServerContext {
+        public: // Constructors & destructors
+            NON_COPYABLE(TlsServerContext);
+            NON_MOVEABLE(TlsServerContext);
+
+            /**
+             * Creates the SSL context and starts the handshake threads.
+             *
+             * \throw TlsException
+             */
+            explicit TlsServerContext(const TlsSettings& settings);
+
+            /**
+             * Waits for the handshake threads to finish.
+             */
+            ~TlsServerContext();
+
+        public: // Public methods
+            /**
+             * Gets the SSL context that the connections are created with.
+             */
+            [[nodiscard]] ssl::context& GetSslContext() noexcept;
+
+            /**
+             * Gets the pool that the handshakes are done on, nullptr if they are done on the I/O threads.
+             */
+            [[nodiscard]] boost::asio::thread_pool* GetHandshakePool() noexcept;
+
+            /**
+             * Registers a handshake that is about to start.
+             *
+             * @return false if the connection should be closed because there are too many handshakes in progress
+             */
+            [[nodiscard]] bool TryBeginHandshake() noexcept;
+
+            /**
+             * Registers a finished handshake.
+             */
+            void EndHandshake(bool success, bool resumed) noexcept;
+
+            /**
+             * Gets the current values of the counters.
+             */
+            [[nodiscard]] TlsStatistics GetStatistics() const noexcept;
+
+        private: // Private fields
+            const size_t m_maxPendingHandshakes;
+            ssl::context m_context;
+            std::unique_ptr<boost::asio::thread_pool> m_handshakePool;
+
+            std::atomic<uint64_t> m_fullHandshakes{0};
+            std::atomic<uint64_t> m_resumedHandshakes{0};
+            std::atomic<uint64_t> m_failedHandshakes{0};
+            std::atomic<uint64_t> m_rejectedHandshakes{0};
+            std::atomic<uint64_t> m_pendingHandshakes{0};
+    };
+
+    #endif
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_TLS_HPP
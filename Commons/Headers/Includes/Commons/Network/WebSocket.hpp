@@ -0,0 +1,138 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_WEBSOCKET_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_WEBSOCKET_HPP
+
+#include "../Commons.hpp"
+#include "Http.hpp"
+
+#include <atomic>
+#include <boost/beast/websocket.hpp>
+#include <deque>
+
+namespace Merrie {
+
+    class WebSocketConnection; // Forward declaration
+
+    /**
+     * Called when a text message is received from the client.
+     */
+    using WebSocketMessageHandler = std::function<void(const std::shared_ptr<WebSocketConnection>& connection, std::string message)>;
+
+    /**
+     * Called once when the WebSocket connection is closed, either by the client, the server or because of an error.
+     */
+    using WebSocketCloseHandler = std::function<void(const std::shared_ptr<WebSocketConnection>& connection)>;
+
+    /**
+     * Callbacks of a WebSocketConnection, they are called from the I/O threads.
+     */
+    struct WebSocketCallbacks {
+        WebSocketMessageHandler OnMessage;
+        WebSocketCloseHandler OnClose;
+    };
+
+    /**
+     * Shorter namespace definition for the boost websocket namespace
+     */
+    namespace websocket = boost::beast::websocket;
+
+    /**
+     * A WebSocket connection, created by upgrading an HttpConnection with HttpConnection::UpgradeToWebSocket().
+     * Only text messages are supported.
+     *
+     * All operations are serialized on a strand, so the public methods can be called from any thread. The messages are
+     * sent in the order in which Send() was called.
+     */
+    class WebSocketConnection : public std::enable_shared_from_this<WebSocketConnection> {
+        public: // Constants
+            /**
+             * Maximum size of a single message received from the client.
+             */
+            static constexpr const size_t MaxMessageSize = 64 * 1024;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(WebSocketConnection);
+            NON_MOVEABLE(WebSocketConnection);
+
+            virtual ~WebSocketConnection() = default;
+
+        public: // Public methods
+            /**
+             * Queues a text message to be sent to the client.
+             */
+            void Send(std::string message);
+
+            /**
+             * Queues a text message to be sent to the client, the buffer is shared and not copied.
+             */
+            void Send(std::shared_ptr<const std::string> message);
+
+            /**
+             * Closes the connection gracefully, queued messages are sent first.
+             */
+            void Close();
+
+            /**
+             * Checks whether or not the connection is still open.
+             */
+            [[nodiscard]] bool IsOpen() const noexcept;
+
+            /**
+             * Gets the HttpConnection that was upgraded, its request is the upgrade request.
+             */
+            [[nodiscard]] const std::shared_ptr<HttpConnection>& GetHttpConnection() const noexcept;
+
+            /**
+             * Gets the strand that the callbacks are called from and that all operations of the connection are serialized on.
+             * It is the strand of the upgraded HttpConnection, the executor of the socket, so the idle timer and the keep-alive
+             * pings of the stream run on it too.
+             */
+            [[nodiscard]] boost::asio::strand<boost::asio::io_context::executor_type>& GetStrand() noexcept {
+                return m_strand;
+            }
+
+        protected: // Protected methods
+            WebSocketConnection(std::shared_ptr<HttpConnection> connection, WebSocketCallbacks callbacks);
+
+            /**
+             * Accepts the upgrade request and starts reading messages.
+             */
+            virtual void Start(const http::request<http::string_body>& request) = 0;
+
+            virtual void DoRead() = 0;
+
+            virtual void DoWrite(const std::string& message) = 0;
+
+            virtual void DoClose() = 0;
+
+            void OnAccepted(boost::beast::error_code error);
+
+            void OnRead(boost::beast::error_code error, std::string message);
+
+            void OnWritten(boost::beast::error_code error);
+
+            void OnClosed();
+
+        protected: // Protected fields
+            boost::asio::strand<boost::asio::io_context::executor_type> m_strand;
+
+        private: // Friend methods
+            friend class HttpConnection;
+
+        private: // Private methods
+            void WriteNext();
+
+        private: // Private fields
+            const std::shared_ptr<HttpConnection> m_connection;
+            const WebSocketCallbacks m_callbacks;
+
+            // accessed only from the strand
+            std::deque<std::shared_ptr<const std::string>> m_queue{};
+            bool m_writing = false;
+            bool m_closeRequested = false;
+            bool m_closed = false;
+
+            std::atomic<bool> m_open{false};
+    };
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_NETWORK_WEBSOCKET_HPP
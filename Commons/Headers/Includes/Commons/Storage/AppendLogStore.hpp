@@ -0,0 +1,230 @@
+#ifndef MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_STORAGE_APPENDLOGSTORE_HPP
+#define MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_STORAGE_APPENDLOGSTORE_HPP
+
+#include "../Commons.hpp"
+#include "../Logging.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Merrie {
+
+    // ================================================================================
+    // =  Settings & statistics                                                       =
+    // ================================================================================
+
+    /**
+     * Thrown when the files of a store cannot be opened or read.
+     */
+    M_DECLARE_EXCEPTION(StorageException);
+
+    /**
+     * Settings of an AppendLogStore
+     */
+    struct AppendLogStoreSettings {
+        /**
+         * Should the data be stored.
+         */
+        bool Enabled{};
+
+        /**
+         * Directory of the files of the store, it is created if it does not exist.
+         */
+        std::string Directory{};
+
+        /**
+         * The log is compacted into a new snapshot once it is bigger than this many bytes and than the snapshot.
+         */
+        uint64_t CompactionThreshold{};
+    };
+
+    /**
+     * A snapshot of the statistics of an AppendLogStore
+     */
+    struct AppendLogStoreStatistics {
+        /**
+         * Amount of the batches written to the log, every batch is synced to the disk once.
+         */
+        uint64_t Commits{};
+
+        /**
+         * Amount of the records written to the log.
+         */
+        uint64_t WrittenRecords{};
+
+        /**
+         * Amount of the compactions of the log into a new snapshot.
+         */
+        uint64_t Compactions{};
+
+        /**
+         * Amount of the keys that have values.
+         */
+        uint64_t Keys{};
+
+        /**
+         * Size of the log in bytes.
+         */
+        uint64_t LogSize{};
+
+        /**
+         * Size of the snapshot in bytes.
+         */
+        uint64_t SnapshotSize{};
+    };
+
+    // ================================================================================
+    // =  AppendLogStore                                                              =
+    // ================================================================================
+
+    /**
+     * Values by 64-bit keys, persisted in a local directory.
+     *
+     * The changes are written behind: they are only queued in memory by the callers and a writer thread appends them to the
+     * log in batches. A batch contains all changes queued while the previous one was written and is synced to the disk with a
+     * single fsync, so the amount of the syncs does not grow with the amount of the changes. Only the last change of a key in
+     * a batch is written. Once the log grows bigger than the snapshot and the compaction threshold, the writer thread writes
+     * all values into a new snapshot and starts a new log.
+     *
+     * Only the locations of the values are kept in memory, the values are read from the disk when they are loaded. A torn
+     * record at the end of the log, left by a crash during a write, is cut off when the store is opened.
+     *
+     * All methods can be called from any thread.
+     */
+    class AppendLogStore {
+        public: // Types
+            using Key = uint64_t;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(AppendLogStore);
+            NON_MOVEABLE(AppendLogStore);
+
+            /**
+             * Opens the store, reads the locations of all values and starts the writer thread.
+             *
+             * \throw StorageException if the files cannot be opened or read
+             */
+            explicit AppendLogStore(AppendLogStoreSettings settings);
+
+            /**
+             * Writes the queued changes and stops the writer thread.
+             */
+            ~AppendLogStore();
+
+        public: // Public methods
+            /**
+             * Queues the value to be written, never waits for the disk.
+             */
+            void Put(Key key, std::string value);
+
+            /**
+             * Queues the removal of the value, never waits for the disk.
+             */
+            void Erase(Key key);
+
+            /**
+             * Loads the value, including the queued changes. Reads from the disk, so it should not be called from threads that
+             * must not wait.
+             *
+             * @return the value or std::nullopt if there is none
+             * \throw StorageException if the value cannot be read
+             */
+            [[nodiscard]] std::optional<std::string> Load(Key key) const;
+
+            /**
+             * Waits until all changes queued so far are synced to the disk.
+             */
+            void Flush();
+
+            /**
+             * Gets the settings of the store.
+             */
+            [[nodiscard]] const AppendLogStoreSettings& GetSettings() const noexcept;
+
+            /**
+             * Gets the current values of the counters.
+             */
+            [[nodiscard]] AppendLogStoreStatistics GetStatistics() const;
+
+        private: // Private types
+            enum class File : uint8_t {
+                    Snapshot,
+                    Log,
+            };
+
+            /**
+             * Where a value is stored.
+             */
+            struct Location {
+                File File_;
+                uint32_t Size;
+                uint64_t Offset; // of the value, after the header of its record
+            };
+
+            // the queued changes by their keys, std::nullopt removes the value
+            using Changes = std::unordered_map<Key, std::optional<std::string>>;
+
+        private: // Private methods
+            /**
+             * Reads the records of a file into the index.
+             *
+             * @return the size of the valid records, a torn record at the end is not counted
+             */
+            uint64_t ReadFile(File file, int descriptor);
+
+            void RunWriter();
+
+            /**
+             * Appends the changes to the log and syncs it.
+             *
+             * @return false if writing failed
+             */
+            bool WriteBatch(const Changes& changes);
+
+            /**
+             * Writes all values into a new snapshot and empties the log.
+             *
+             * @return false if writing failed
+             */
+            bool Compact();
+
+            /**
+             * Reads the value from its location, the index lock has to be held.
+             */
+            std::string ReadValue(const Location& location) const;
+
+            [[nodiscard]] int GetDescriptor(File file) const noexcept;
+
+        private: // Private fields
+            const AppendLogStoreSettings m_settings;
+
+            // the files and the index, the writer thread is the only one that changes them
+            mutable std::shared_mutex m_indexMutex{};
+            std::unordered_map<Key, Location> m_index{};
+            int m_snapshotFile = -1;
+            int m_logFile = -1;
+            uint64_t m_snapshotSize = 0;
+            uint64_t m_logSize = 0;
+
+            mutable std::mutex m_mutex{};
+            std::condition_variable m_changesQueued{};
+            std::condition_variable m_batchWritten{};
+            Changes m_queued{};
+            Changes m_writing{}; // the batch that is being written, it can still be loaded from here
+            uint64_t m_startedBatches = 0;
+            uint64_t m_writtenBatches = 0;
+            bool m_stopping = false;
+            AppendLogStoreStatistics m_statistics{};
+
+            std::thread m_writer{};
+
+            M_DECLARE_LOGGER;
+    };
+
+}
+
+#endif //MERRIE_COMMONS_HEADERS_INCLUDES_COMMONS_STORAGE_APPENDLOGSTORE_HPP
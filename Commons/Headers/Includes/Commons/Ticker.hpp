@@ -312,6 +312,23 @@ namespace Merrie {
              */
             std::shared_ptr<Task> DoInMainThread(TaskAction action, bool repeat);
 
+            /**
+             * Schedules an action to be done in the main thread after all the tasks scheduled by DoInMainThread() in the tick.
+             *
+             * Unlike DoInMainThread() the action is never called on the spot, when called from a task it is done at the end
+             * of the current tick.
+             *
+             * @param[in] action
+             *     Function to be called in the main thread at the end of a tick.
+             *
+             * @param[in] repeat
+             *     Should this task be repeated at the end of every tick.
+             *
+             * @return
+             *     A pointer to the newly created Task.
+             */
+            std::shared_ptr<Task> DoAtEndOfTick(TaskAction action, bool repeat);
+
             /**
              * Process one tick or sleeps if it is not time yet.
              *
@@ -322,10 +339,13 @@ namespace Merrie {
         private: // Private methods
             void RunTasks();
 
+            void RunTasks(std::vector<std::shared_ptr<Task>>& tasks);
+
         private: // Private variables
             std::thread::id m_mainThread{};
             std::mutex m_taskMutex{};
             std::vector<std::shared_ptr<Task>> m_tasks{};
+            std::vector<std::shared_ptr<Task>> m_endOfTickTasks{};
 
             unsigned int m_tps = 0;
             double m_exponents[3] = {0.0};
@@ -1,5 +1,6 @@
 #include <Commons/Crypto/Digest.hpp>
 
+#include <limits>
 #include <sstream>
 #include <iomanip>
 
@@ -0,0 +1,37 @@
+#include <Commons/Crypto/Hmac.hpp>
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+#   include <openssl/evp.h>
+#   include <openssl/hmac.h>
+#endif
+
+namespace Merrie {
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+
+    std::vector<uint8_t> HmacSha256(std::string_view key, std::string_view data) {
+        std::vector<uint8_t> mac(EVP_MAX_MD_SIZE);
+        unsigned int size = 0;
+
+        const unsigned char* success = HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), reinterpret_cast<const unsigned char*>(data.data()), data.size(), mac.data(), &size);
+        M_ASSERT(success, "Failed to compute HMAC");
+
+        mac.resize(size);
+        return mac;
+    }
+
+#endif // M_HAS_OPENSSL_CRYPTO
+
+    bool ConstantTimeEquals(std::string_view first, std::string_view second) noexcept {
+        if (first.size() != second.size())
+            return false;
+
+        unsigned char difference = 0;
+        for (size_t i = 0; i < first.size(); i++) {
+            difference |= static_cast<unsigned char>(first[i] ^ second[i]);
+        }
+
+        return difference == 0;
+    }
+
+}  // namespace Merrie
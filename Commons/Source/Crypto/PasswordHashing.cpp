@@ -0,0 +1,235 @@
+#include <Commons/Crypto/PasswordHashing.hpp>
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+
+#include <Commons/Time.hpp>
+#include <Commons/Crypto/Digest.hpp>
+#include <Commons/Crypto/Hmac.hpp>
+#include <algorithm>
+#include <boost/asio/post.hpp>
+#include <charconv>
+#include <limits>
+#include <optional>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace Merrie {
+
+    namespace {
+        constexpr const std::string_view c_hashPrefix = "pbkdf2-sha256$";
+        constexpr const size_t c_saltSize = 16;
+        constexpr const size_t c_hashSize = 32;
+
+        struct _ParsedHash {
+            uint32_t Iterations = 0;
+            std::vector<uint8_t> Salt{};
+            std::string_view Hash{}; // in hex
+        };
+
+        std::optional<std::vector<uint8_t>> _FromHex(std::string_view hex) {
+            if (hex.size() % 2 != 0)
+                return std::nullopt;
+
+            std::vector<uint8_t> bytes(hex.size() / 2);
+            for (size_t i = 0; i < bytes.size(); i++) {
+                const auto result = std::from_chars(hex.data() + i * 2, hex.data() + i * 2 + 2, bytes[i], 16);
+
+                if (result.ec != std::errc() || result.ptr != hex.data() + i * 2 + 2)
+                    return std::nullopt;
+            }
+
+            return bytes;
+        }
+
+        std::optional<_ParsedHash> _ParseHash(std::string_view hash) {
+            if (hash.substr(0, c_hashPrefix.size()) != c_hashPrefix)
+                return std::nullopt;
+
+            hash.remove_prefix(c_hashPrefix.size());
+
+            const size_t saltStart = hash.find('$');
+            const size_t hashStart = saltStart == std::string_view::npos ? saltStart : hash.find('$', saltStart + 1);
+            if (hashStart == std::string_view::npos)
+                return std::nullopt;
+
+            _ParsedHash parsed;
+            const auto result = std::from_chars(hash.data(), hash.data() + saltStart, parsed.Iterations);
+            if (result.ec != std::errc() || result.ptr != hash.data() + saltStart || parsed.Iterations == 0)
+                return std::nullopt;
+
+            std::optional<std::vector<uint8_t>> salt = _FromHex(hash.substr(saltStart + 1, hashStart - saltStart - 1));
+            if (!salt)
+                return std::nullopt;
+
+            parsed.Salt = std::move(*salt);
+            parsed.Hash = hash.substr(hashStart + 1);
+            return parsed;
+        }
+
+        std::string _DeriveKey(std::string_view password, const std::vector<uint8_t>& salt, uint32_t iterations) {
+            std::vector<uint8_t> key(c_hashSize);
+
+            const int success = PKCS5_PBKDF2_HMAC(password.data(), static_cast<int>(password.size()), salt.data(), static_cast<int>(salt.size()),
+                                                  static_cast<int>(std::min<uint32_t>(iterations, std::numeric_limits<int>::max())),
+                                                  EVP_sha256(), static_cast<int>(key.size()), key.data());
+            M_ASSERT(success, "Failed to derive the key");
+
+            return DigestToHex(key);
+        }
+
+        size_t _GetThreadCount(const PasswordHashingSettings& settings) {
+            if (settings.ThreadCount == 0)
+                throw PasswordHashingException("The password hashing pool needs at least one thread");
+
+            return settings.ThreadCount;
+        }
+
+        uint32_t _GetIterations(const PasswordHashingSettings& settings) {
+            if (settings.Iterations != 0)
+                return settings.Iterations;
+
+            if (settings.TargetDuration == 0)
+                throw PasswordHashingException("Either the iterations or the target duration of the password hashes have to be set");
+
+            return MeasurePasswordHashIterations(std::chrono::milliseconds(settings.TargetDuration));
+        }
+    }
+
+    // ================================================================================
+    // =  Password hashes                                                             =
+    // ================================================================================
+
+    std::string HashPassword(std::string_view password, uint32_t iterations) {
+        M_ASSERT(iterations > 0, "The iterations have to be positive");
+
+        std::vector<uint8_t> salt(c_saltSize);
+        const int success = RAND_bytes(salt.data(), static_cast<int>(salt.size()));
+        M_ASSERT(success == 1, "Failed to generate the salt");
+
+        return std::string(c_hashPrefix) + std::to_string(iterations) + "$" + DigestToHex(salt) + "$" + _DeriveKey(password, salt, iterations);
+    }
+
+    bool VerifyPassword(std::string_view password, std::string_view hash) {
+        const std::optional<_ParsedHash> parsed = _ParseHash(hash);
+        if (!parsed)
+            return false;
+
+        return ConstantTimeEquals(_DeriveKey(password, parsed->Salt, parsed->Iterations), parsed->Hash);
+    }
+
+    uint32_t GetPasswordHashIterations(std::string_view hash) noexcept {
+        try {
+            const std::optional<_ParsedHash> parsed = _ParseHash(hash);
+            return parsed ? parsed->Iterations : 0;
+        } catch (const std::bad_alloc&) {
+            return 0;
+        }
+    }
+
+    uint32_t MeasurePasswordHashIterations(std::chrono::milliseconds target) {
+        const std::vector<uint8_t> salt(c_saltSize);
+
+        // doubled until the measurement is long enough to be meaningful, then scaled to the target
+        uint64_t iterations = 1024;
+        DefaultClock::duration elapsed{};
+
+        while (true) {
+            const DefaultClock::time_point start = DefaultClock::now();
+            (void) _DeriveKey("password", salt, static_cast<uint32_t>(iterations));
+            elapsed = DefaultClock::now() - start;
+
+            if (elapsed >= std::chrono::milliseconds(20) || elapsed >= target || iterations >= std::numeric_limits<int32_t>::max() / 2)
+                break;
+
+            iterations *= 2;
+        }
+
+        const auto scaled = static_cast<uint64_t>(static_cast<double>(iterations) * std::chrono::duration<double>(target) / std::chrono::duration<double>(elapsed));
+        return static_cast<uint32_t>(std::clamp<uint64_t>(scaled, 1, std::numeric_limits<int32_t>::max()));
+    }
+
+    // ================================================================================
+    // =  PasswordHashingPool                                                         =
+    // ================================================================================
+
+    PasswordHashingPool::PasswordHashingPool(const PasswordHashingSettings& settings)
+            : m_maxPendingChecks(settings.MaxPendingChecks),
+              m_iterations(_GetIterations(settings)),
+              m_pool(_GetThreadCount(settings)) {
+    }
+
+    PasswordHashingPool::~PasswordHashingPool() {
+        m_pool.stop();
+        m_pool.join();
+    }
+
+    bool PasswordHashingPool::Hash(std::string password, const boost::asio::any_io_executor& executor, HashCallback callback) {
+        if (!TryBegin())
+            return false;
+
+        boost::asio::post(m_pool, [this, password = std::move(password), executor, callback = std::move(callback)]() mutable {
+            std::string hash = HashPassword(password, m_iterations);
+            OPENSSL_cleanse(password.data(), password.size());
+
+            boost::asio::post(executor, [callback = std::move(callback), hash = std::move(hash)]() mutable {
+                callback(std::move(hash));
+            });
+
+            m_hashed.fetch_add(1, std::memory_order_relaxed);
+            m_pending.fetch_sub(1, std::memory_order_release);
+        });
+
+        return true;
+    }
+
+    bool PasswordHashingPool::Verify(std::string password, std::string hash, const boost::asio::any_io_executor& executor, VerifyCallback callback) {
+        if (!TryBegin())
+            return false;
+
+        boost::asio::post(m_pool, [this, password = std::move(password), hash = std::move(hash), executor, callback = std::move(callback)]() mutable {
+            const bool valid = VerifyPassword(password, hash);
+            OPENSSL_cleanse(password.data(), password.size());
+
+            boost::asio::post(executor, [callback = std::move(callback), valid]() {
+                callback(valid);
+            });
+
+            m_verified.fetch_add(1, std::memory_order_relaxed);
+            m_pending.fetch_sub(1, std::memory_order_release);
+        });
+
+        return true;
+    }
+
+    bool PasswordHashingPool::NeedsRehash(std::string_view hash) const noexcept {
+        return GetPasswordHashIterations(hash) != m_iterations;
+    }
+
+    uint32_t PasswordHashingPool::GetIterations() const noexcept {
+        return m_iterations;
+    }
+
+    PasswordHashingStatistics PasswordHashingPool::GetStatistics() const noexcept {
+        return PasswordHashingStatistics{
+                m_hashed.load(std::memory_order_relaxed),
+                m_verified.load(std::memory_order_relaxed),
+                m_rejected.load(std::memory_order_relaxed),
+                m_pending.load(std::memory_order_acquire),
+        };
+    }
+
+    bool PasswordHashingPool::TryBegin() noexcept {
+        const uint64_t pending = m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_maxPendingChecks != 0 && pending >= m_maxPendingChecks) {
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+}
+
+#endif // M_HAS_OPENSSL_CRYPTO
@@ -0,0 +1,66 @@
+#include <Commons/Crypto/SessionToken.hpp>
+
+#include <Commons/Crypto/Digest.hpp>
+#include <Commons/Crypto/Hmac.hpp>
+#include <charconv>
+
+namespace Merrie {
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+
+    namespace {
+        template<typename Number>
+        bool _ParseNumber(std::string_view text, Number& number) {
+            if (text.empty())
+                return false;
+
+            const auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            return result.ec == std::errc() && result.ptr == text.data() + text.size();
+        }
+    }
+
+    SessionTokenSigner::SessionTokenSigner(std::string secret) : m_secret(std::move(secret)) {
+        if (m_secret.empty())
+            throw SessionTokenException("The secret of the session tokens is empty");
+    }
+
+    std::string SessionTokenSigner::Sign(const SessionToken& token) const {
+        const auto expiry = std::chrono::duration_cast<std::chrono::seconds>(token.Expiry.time_since_epoch()).count();
+        const std::string payload = std::to_string(token.Aid) + "." + std::to_string(expiry);
+
+        return payload + "." + CreateMac(payload);
+    }
+
+    std::optional<SessionToken> SessionTokenSigner::Verify(std::string_view token) const {
+        const size_t macSeparator = token.rfind('.');
+        if (macSeparator == std::string_view::npos)
+            return std::nullopt;
+
+        const std::string_view payload = token.substr(0, macSeparator);
+        const size_t expirySeparator = payload.find('.');
+        if (expirySeparator == std::string_view::npos)
+            return std::nullopt;
+
+        uint64_t aid;
+        int64_t expiry;
+
+        if (!_ParseNumber(payload.substr(0, expirySeparator), aid) || !_ParseNumber(payload.substr(expirySeparator + 1), expiry))
+            return std::nullopt;
+
+        if (!ConstantTimeEquals(CreateMac(payload), token.substr(macSeparator + 1)))
+            return std::nullopt;
+
+        const std::chrono::system_clock::time_point expiryTime{std::chrono::seconds(expiry)};
+        if (expiryTime <= std::chrono::system_clock::now())
+            return std::nullopt;
+
+        return SessionToken{aid, expiryTime};
+    }
+
+    std::string SessionTokenSigner::CreateMac(std::string_view payload) const {
+        return DigestToHex(HmacSha256(m_secret, payload));
+    }
+
+#endif // M_HAS_OPENSSL_CRYPTO
+
+}  // namespace Merrie
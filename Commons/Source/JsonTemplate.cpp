@@ -0,0 +1,20 @@
+#include <Commons/JsonTemplate.hpp>
+
+namespace Merrie {
+
+    JsonTemplate::JsonTemplate(std::string_view json) : m_size(json.size()) {
+        size_t fragmentStart = 0;
+
+        for (size_t slot = json.find(Slot); slot != std::string_view::npos; slot = json.find(Slot, fragmentStart)) {
+            m_fragments.emplace_back(json.substr(fragmentStart, slot - fragmentStart));
+            fragmentStart = slot + Slot.size();
+        }
+
+        m_fragments.emplace_back(json.substr(fragmentStart));
+        m_size -= (m_fragments.size() - 1) * Slot.size();
+    }
+
+    size_t JsonTemplate::GetSlotCount() const noexcept {
+        return m_fragments.size() - 1;
+    }
+}
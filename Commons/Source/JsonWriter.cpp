@@ -0,0 +1,296 @@
+#include <Commons/JsonWriter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace Merrie {
+
+    JsonWriter::JsonWriter(std::string buffer) : m_buffer(std::move(buffer)) {
+    }
+
+    void JsonWriter::BeginObject() {
+        Open(true, '{');
+    }
+
+    void JsonWriter::EndObject() {
+        Close(true, '}');
+    }
+
+    void JsonWriter::BeginArray() {
+        Open(false, '[');
+    }
+
+    void JsonWriter::EndArray() {
+        Close(false, ']');
+    }
+
+    void JsonWriter::Key(std::string_view key) {
+        M_ASSERT(m_depth != 0 && m_scopes[m_depth - 1].IsObject, "Keys can only be written inside of an object");
+
+        Scope& scope = m_scopes[m_depth - 1];
+        M_ASSERT(!scope.HasKey, "The previous key has no value");
+
+        if (!scope.IsEmpty)
+            m_buffer += ',';
+
+        m_buffer += '"';
+        const size_t keyOffset = m_buffer.size();
+        AppendEscaped(key);
+
+        if (m_depth == 1)
+            m_rootKeys.emplace_back(keyOffset, m_buffer.size() - keyOffset);
+
+        m_buffer += "\":";
+
+        scope.IsEmpty = false;
+        scope.HasKey = true;
+    }
+
+    void JsonWriter::Null() {
+        BeforeValue();
+        m_buffer += "null";
+    }
+
+    void JsonWriter::Value(bool value) {
+        BeforeValue();
+        m_buffer += value ? "true" : "false";
+    }
+
+    void JsonWriter::Value(std::string_view value) {
+        BeforeValue();
+        m_buffer += '"';
+        AppendEscaped(value);
+        m_buffer += '"';
+    }
+
+    void JsonWriter::Value(const char* value) {
+        Value(std::string_view(value));
+    }
+
+    void JsonWriter::Value(double value) {
+        // same as nlohmann::json, JSON has no infinities and NaNs
+        if (!std::isfinite(value)) {
+            Null();
+            return;
+        }
+
+        BeforeValue();
+
+        char digits[32];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        const std::string_view text(digits, result.ptr - digits);
+        m_buffer += text;
+
+        // keep the numbers that happen to be whole recognizable as floating point ones, like nlohmann::json does
+        if (text.find_first_of(".e") == std::string_view::npos)
+            m_buffer += ".0";
+    }
+
+    void JsonWriter::RawValue(std::string_view json) {
+        BeforeValue();
+        m_buffer += json;
+    }
+
+    void JsonWriter::RawMembers(std::string_view object) {
+        M_ASSERT(m_depth != 0 && m_scopes[m_depth - 1].IsObject, "Members can only be written inside of an object");
+        M_ASSERT(object.size() >= 2 && object.front() == '{' && object.back() == '}', "Not a serialized object");
+
+        const std::string_view members = object.substr(1, object.size() - 2);
+        if (members.empty())
+            return;
+
+        Scope& scope = m_scopes[m_depth - 1];
+        M_ASSERT(!scope.HasKey, "The previous key has no value");
+
+        if (!scope.IsEmpty)
+            m_buffer += ',';
+
+        const size_t membersOffset = m_buffer.size();
+        m_buffer += members;
+        scope.IsEmpty = false;
+
+        if (m_depth == 1)
+            AddRootKeys(membersOffset);
+    }
+
+    void JsonWriter::BeginObject(std::string_view key) {
+        Key(key);
+        BeginObject();
+    }
+
+    void JsonWriter::BeginArray(std::string_view key) {
+        Key(key);
+        BeginArray();
+    }
+
+    bool JsonWriter::HasRootKey(std::string_view key) const noexcept {
+        const std::string_view buffer = m_buffer;
+
+        return std::any_of(m_rootKeys.begin(), m_rootKeys.end(), [&](const std::pair<size_t, size_t>& rootKey) {
+            return buffer.substr(rootKey.first, rootKey.second) == key;
+        });
+    }
+
+    bool JsonWriter::IsComplete() const noexcept {
+        return m_depth == 0 && m_hasRootValue;
+    }
+
+    size_t JsonWriter::GetDepth() const noexcept {
+        return m_depth;
+    }
+
+    const std::string& JsonWriter::GetString() const noexcept {
+        return m_buffer;
+    }
+
+    std::string JsonWriter::TakeString() {
+        M_ASSERT(m_depth == 0, "Not all objects and arrays are closed");
+
+        std::string result = std::move(m_buffer);
+        Clear();
+        return result;
+    }
+
+    void JsonWriter::Clear() noexcept {
+        m_buffer.clear();
+        m_depth = 0;
+        m_hasRootValue = false;
+        m_rootKeys.clear();
+    }
+
+    void JsonWriter::BeforeValue() {
+        if (m_depth == 0) {
+            M_ASSERT(!m_hasRootValue, "Only one root value can be written");
+            m_hasRootValue = true;
+            return;
+        }
+
+        Scope& scope = m_scopes[m_depth - 1];
+
+        if (scope.IsObject) {
+            M_ASSERT(scope.HasKey, "The values inside of an object need keys");
+            scope.HasKey = false;
+            return;
+        }
+
+        if (!scope.IsEmpty)
+            m_buffer += ',';
+
+        scope.IsEmpty = false;
+    }
+
+    void JsonWriter::Open(bool isObject, char character) {
+        M_ASSERT(m_depth < MaxDepth, "The objects and arrays are nested too deep");
+
+        BeforeValue();
+        m_buffer += character;
+        m_scopes[m_depth++] = Scope{isObject};
+    }
+
+    void JsonWriter::Close(bool isObject, char character) {
+        M_ASSERT(m_depth != 0 && m_scopes[m_depth - 1].IsObject == isObject, "Closing a scope that is not open");
+        M_ASSERT(!m_scopes[m_depth - 1].HasKey, "The last key has no value");
+
+        m_depth--;
+        m_buffer += character;
+    }
+
+    void JsonWriter::AddRootKeys(size_t membersOffset) {
+        // the strings that directly follow the start or a comma of the members are the keys
+        size_t depth = 0;
+        bool inString = false;
+        bool expectKey = true;
+        size_t keyStart = std::string::npos;
+
+        for (size_t i = membersOffset; i < m_buffer.size(); i++) {
+            const char character = m_buffer[i];
+
+            if (inString) {
+                if (character == '\\') {
+                    i++;
+                } else if (character == '"') {
+                    inString = false;
+
+                    if (keyStart != std::string::npos) {
+                        m_rootKeys.emplace_back(keyStart, i - keyStart);
+                        keyStart = std::string::npos;
+                    }
+                }
+
+                continue;
+            }
+
+            switch (character) {
+                case '"':
+                    inString = true;
+
+                    if (depth == 0 && expectKey) {
+                        keyStart = i + 1;
+                        expectKey = false;
+                    }
+                    break;
+                case '{':
+                case '[':
+                    depth++;
+                    break;
+                case '}':
+                case ']':
+                    depth--;
+                    break;
+                case ',':
+                    expectKey = depth == 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void JsonWriter::AppendEscaped(std::string_view text) {
+        static constexpr const char c_hexDigits[] = "0123456789abcdef";
+
+        // append the runs of the characters that need no escaping at once
+        size_t runStart = 0;
+
+        for (size_t i = 0; i < text.size(); i++) {
+            const auto character = static_cast<unsigned char>(text[i]);
+
+            if (character >= 0x20 && character != '"' && character != '\\')
+                continue;
+
+            m_buffer.append(text.data() + runStart, i - runStart);
+            runStart = i + 1;
+
+            switch (character) {
+                case '"':
+                    m_buffer += "\\\"";
+                    break;
+                case '\\':
+                    m_buffer += "\\\\";
+                    break;
+                case '\b':
+                    m_buffer += "\\b";
+                    break;
+                case '\f':
+                    m_buffer += "\\f";
+                    break;
+                case '\n':
+                    m_buffer += "\\n";
+                    break;
+                case '\r':
+                    m_buffer += "\\r";
+                    break;
+                case '\t':
+                    m_buffer += "\\t";
+                    break;
+                default: {
+                    const char escaped[] = {'\\', 'u', '0', '0', c_hexDigits[character >> 4], c_hexDigits[character & 0xF]};
+                    m_buffer.append(escaped, sizeof(escaped));
+                }
+            }
+        }
+
+        m_buffer.append(text.data() + runStart, text.size() - runStart);
+    }
+}
@@ -1,5 +1,6 @@
 #include <Commons/Logging.hpp>
 
+#include <atomic>
 #include <iomanip>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/trim.hpp>
@@ -109,14 +110,21 @@ namespace Merrie {
         };
 
         /**
-         * Message filter, logs messages based on the mode and the given filters.
+         * Lowest severity that is logged, cached for the loggers that check it before they create their records.
+         */
+        std::atomic<LoggingSeverity> g_minimumSeverity{LoggingSeverity::Trace};
+
+        /**
+         * Message filter, logs messages based on the mode, the minimum severity and the given filters.
          */
         bool __NameFilter(
                 Mode mode,
+                LoggingSeverity minimumSeverity,
                 const std::vector<std::string>& filters,
                 const logging::value_ref<LoggingSeverity, tag::g_severityAttr>& level,
                 const logging::value_ref<std::string, tag::g_nameAttr>& name) {
 
+            if (level < minimumSeverity) return false;
             if (mode == Mode::Stdout && level >= LoggingSeverity::Warning) return false;
             if (mode == Mode::Stderr && level < LoggingSeverity::Warning) return false;
 
@@ -125,6 +133,37 @@ namespace Merrie {
 
     }
 
+    std::string ContextLogger::GetName() const {
+        std::string name;
+        name.reserve(m_kind.size() + 21);
+        name += m_kind;
+        name += '#';
+        name += std::to_string(m_id);
+        return name;
+    }
+
+    void ContextLogger::push_record(boost::log::record&& record) const {
+        logging::core::get()->push_record(std::move(record));
+    }
+
+    logging::record ContextLogger::OpenRecord(LoggingSeverity severity) const {
+        // the cheap checks go first, the name and the attributes are allocated only for the messages that can be logged
+        if (severity < g_minimumSeverity.load(std::memory_order_relaxed))
+            return logging::record();
+
+        const boost::shared_ptr<logging::core> core = logging::core::get();
+        if (!core->get_logging_enabled())
+            return logging::record();
+
+        // the same attributes that the severity_logger created by InitLogger() attaches to its records, the filters of the
+        // sinks match the name so it has to be there before the record is filtered
+        logging::attribute_set attributes;
+        attributes.insert(g_nameAttr.get_name(), logging::attributes::constant<std::string>(GetName()));
+        attributes.insert(g_severityAttr.get_name(), logging::attributes::constant<LoggingSeverity>(severity));
+
+        return core->open_record(attributes);
+    }
+
     struct LoggingSystem::Data {
         std::vector<std::string> m_filters{};
         boost::shared_ptr<sinks::synchronous_sink<sinks::text_file_backend>> m_fileSink{};
@@ -168,7 +207,7 @@ namespace Merrie {
         core->add_sink(s_data->m_stderr);
 
         // Update filters
-        UpdateFilters(s_data->m_filters);
+        UpdateFilters(s_data->m_filters, GetMinimumSeverity());
     }
 
     LoggingSystem::~LoggingSystem() = default;
@@ -207,19 +246,24 @@ namespace Merrie {
     }
 
 
-    void LoggingSystem::UpdateFilters(std::vector<std::string> filters) {
+    void LoggingSystem::UpdateFilters(std::vector<std::string> filters, LoggingSeverity minimumSeverity) {
         s_data->m_filters = std::move(filters);
+        g_minimumSeverity.store(minimumSeverity, std::memory_order_relaxed);
 
         if (s_data->m_fileSink)
-            s_data->m_fileSink->set_filter(boost::phoenix::bind(&__NameFilter, Mode::All, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
+            s_data->m_fileSink->set_filter(boost::phoenix::bind(&__NameFilter, Mode::All, minimumSeverity, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
         if (s_data->m_stdout)
-            s_data->m_stdout->set_filter(boost::phoenix::bind(&__NameFilter, Mode::Stdout, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
+            s_data->m_stdout->set_filter(boost::phoenix::bind(&__NameFilter, Mode::Stdout, minimumSeverity, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
         if (s_data->m_stderr)
-            s_data->m_stderr->set_filter(boost::phoenix::bind(&__NameFilter, Mode::Stderr, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
+            s_data->m_stderr->set_filter(boost::phoenix::bind(&__NameFilter, Mode::Stderr, minimumSeverity, s_data->m_filters, g_severityAttr.or_none(), g_nameAttr.or_none()));
     }
 
     const std::vector<std::string>& LoggingSystem::GetFilters() noexcept {
         return s_data->m_filters;
     }
 
+    LoggingSeverity LoggingSystem::GetMinimumSeverity() noexcept {
+        return g_minimumSeverity.load(std::memory_order_relaxed);
+    }
+
 } // namespace Merrie
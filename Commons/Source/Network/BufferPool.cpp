@@ -0,0 +1,219 @@
+#include <Commons/Network/BufferPool.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * Gets the index of the smallest size class that can fit the given size, SizeClassCount if none can.
+         */
+        size_t _GetSizeClass(size_t size) noexcept {
+            size_t sizeClass = 0;
+            size_t classSize = BufferPool::SmallestBlockSize;
+
+            while (classSize < size && sizeClass < BufferPool::SizeClassCount) {
+                classSize <<= 1U;
+                sizeClass++;
+            }
+
+            return sizeClass;
+        }
+    }
+
+    // ================================================================================
+    // =  BufferPoolBlock                                                             =
+    // ================================================================================
+
+    BufferPoolBlock::BufferPoolBlock(BufferPool* pool, char* data, size_t size) noexcept : m_pool(pool), m_data(data), m_size(size) {
+    }
+
+    BufferPoolBlock::BufferPoolBlock(BufferPoolBlock&& rhs) noexcept
+            : m_pool(std::exchange(rhs.m_pool, nullptr)),
+              m_data(std::exchange(rhs.m_data, nullptr)),
+              m_size(std::exchange(rhs.m_size, 0)) {
+    }
+
+    BufferPoolBlock& BufferPoolBlock::operator=(BufferPoolBlock&& rhs) noexcept {
+        if (this != &rhs) {
+            Reset();
+            m_pool = std::exchange(rhs.m_pool, nullptr);
+            m_data = std::exchange(rhs.m_data, nullptr);
+            m_size = std::exchange(rhs.m_size, 0);
+        }
+
+        return *this;
+    }
+
+    BufferPoolBlock::~BufferPoolBlock() {
+        Reset();
+    }
+
+    char* BufferPoolBlock::GetData() const noexcept {
+        return m_data;
+    }
+
+    size_t BufferPoolBlock::GetSize() const noexcept {
+        return m_size;
+    }
+
+    bool BufferPoolBlock::IsEmpty() const noexcept {
+        return m_data == nullptr;
+    }
+
+    void BufferPoolBlock::Reset() noexcept {
+        if (m_data == nullptr)
+            return;
+
+        m_pool->Release(m_data, m_size);
+        m_pool = nullptr;
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // ================================================================================
+    // =  BufferPool                                                                  =
+    // ================================================================================
+
+    BufferPool::BufferPool(size_t maxCachedBytesPerClass) : m_maxCachedBytesPerClass(maxCachedBytesPerClass) {
+    }
+
+    BufferPool::~BufferPool() {
+        for (SizeClass& sizeClass : m_sizeClasses) {
+            for (char* block : sizeClass.FreeBlocks) {
+                delete[] block;
+            }
+        }
+    }
+
+    BufferPoolBlock BufferPool::Acquire(size_t minimumSize) {
+        const size_t sizeClassIndex = _GetSizeClass(minimumSize);
+        const size_t size = sizeClassIndex < SizeClassCount ? SmallestBlockSize << sizeClassIndex : minimumSize;
+        char* data = nullptr;
+
+        if (sizeClassIndex < SizeClassCount) {
+            SizeClass& sizeClass = m_sizeClasses[sizeClassIndex];
+            std::scoped_lock lock(sizeClass.Mutex);
+
+            if (!sizeClass.FreeBlocks.empty()) {
+                data = sizeClass.FreeBlocks.back();
+                sizeClass.FreeBlocks.pop_back();
+
+                m_cachedBlocks.fetch_sub(1, std::memory_order_relaxed);
+                m_cachedBytes.fetch_sub(size, std::memory_order_relaxed);
+            }
+        }
+
+        if (data == nullptr)
+            data = new char[size];
+
+        m_borrowedBlocks.fetch_add(1, std::memory_order_relaxed);
+        m_borrowedBytes.fetch_add(size, std::memory_order_relaxed);
+        return BufferPoolBlock(this, data, size);
+    }
+
+    void BufferPool::Release(char* data, size_t size) noexcept {
+        m_borrowedBlocks.fetch_sub(1, std::memory_order_relaxed);
+        m_borrowedBytes.fetch_sub(size, std::memory_order_relaxed);
+
+        const size_t sizeClassIndex = _GetSizeClass(size);
+
+        if (sizeClassIndex < SizeClassCount) {
+            SizeClass& sizeClass = m_sizeClasses[sizeClassIndex];
+            std::scoped_lock lock(sizeClass.Mutex);
+
+            if ((sizeClass.FreeBlocks.size() + 1) * size <= m_maxCachedBytesPerClass) {
+                sizeClass.FreeBlocks.emplace_back(data);
+
+                m_cachedBlocks.fetch_add(1, std::memory_order_relaxed);
+                m_cachedBytes.fetch_add(size, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        delete[] data;
+    }
+
+    BufferPoolStatistics BufferPool::GetStatistics() const noexcept {
+        return BufferPoolStatistics{
+                m_borrowedBlocks.load(std::memory_order_relaxed),
+                m_borrowedBytes.load(std::memory_order_relaxed),
+                m_cachedBlocks.load(std::memory_order_relaxed),
+                m_cachedBytes.load(std::memory_order_relaxed),
+        };
+    }
+
+    // ================================================================================
+    // =  PooledFlatBuffer                                                            =
+    // ================================================================================
+
+    PooledFlatBuffer::PooledFlatBuffer(BufferPool& pool, size_t maxSize) noexcept : m_pool(pool), m_maxSize(maxSize) {
+    }
+
+    size_t PooledFlatBuffer::size() const noexcept {
+        return m_writeOffset - m_readOffset;
+    }
+
+    size_t PooledFlatBuffer::max_size() const noexcept {
+        return m_maxSize;
+    }
+
+    size_t PooledFlatBuffer::capacity() const noexcept {
+        return m_block.GetSize();
+    }
+
+    PooledFlatBuffer::const_buffers_type PooledFlatBuffer::data() const noexcept {
+        return const_buffers_type(m_block.GetData() + m_readOffset, size());
+    }
+
+    PooledFlatBuffer::mutable_buffers_type PooledFlatBuffer::prepare(size_t n) {
+        const size_t readable = size();
+
+        if (n > m_maxSize - readable)
+            throw std::length_error("PooledFlatBuffer overflow");
+
+        if (m_writeOffset + n > capacity()) {
+            if (readable + n <= capacity()) {
+                // there is enough space, the readable bytes only need to be moved to the front
+                std::memmove(m_block.GetData(), m_block.GetData() + m_readOffset, readable);
+            } else {
+                BufferPoolBlock block = m_pool.Acquire(readable + n);
+
+                if (readable != 0)
+                    std::memcpy(block.GetData(), m_block.GetData() + m_readOffset, readable);
+
+                m_block = std::move(block);
+            }
+
+            m_readOffset = 0;
+            m_writeOffset = readable;
+        }
+
+        m_preparedSize = n;
+        return mutable_buffers_type(m_block.GetData() + m_writeOffset, n);
+    }
+
+    void PooledFlatBuffer::commit(size_t n) noexcept {
+        m_writeOffset += std::min(n, m_preparedSize);
+        m_preparedSize = 0;
+    }
+
+    void PooledFlatBuffer::consume(size_t n) noexcept {
+        if (n >= size()) {
+            m_readOffset = m_writeOffset = 0;
+            return;
+        }
+
+        m_readOffset += n;
+    }
+
+    void PooledFlatBuffer::ReleaseIfEmpty() noexcept {
+        if (size() != 0)
+            return;
+
+        m_block.Reset();
+        m_readOffset = m_writeOffset = m_preparedSize = 0;
+    }
+}
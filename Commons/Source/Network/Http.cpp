@@ -1,5 +1,11 @@
 #include <Commons/Network/Http.hpp>
+
+#include <Commons/Network/HttpResponseStream.hpp>
+#include <Commons/Network/HttpRouter.hpp>
+#include <cstring>
+#include <limits>
 #include <optional>
+#include <type_traits>
 
 namespace Merrie {
 
@@ -66,6 +72,30 @@ namespace Merrie {
                 i++;
             }
         }
+
+        /**
+         * Header size limit used when none is configured, the same as the Beast default.
+         */
+        constexpr const size_t DefaultMaxHeaderSize = 8192;
+
+        /**
+         * How much memory of free receive buffers can be kept for reuse in every size class of the pool.
+         */
+        constexpr const size_t ReceiveBufferCacheSizePerClass = 4 * 1024 * 1024;
+
+        /**
+         * How much memory of free chunks of the streamed responses can be kept for reuse in every size class of the pool.
+         */
+        constexpr const size_t SendBufferCacheSizePerClass = 4 * 1024 * 1024;
+
+        size_t _GetMaxHeaderSize(const HttpServerSettings& settings) noexcept {
+            return settings.MaxHeaderSize != 0 ? settings.MaxHeaderSize : DefaultMaxHeaderSize;
+        }
+
+        /**
+         * Scratch buffer for compressed bodies, it is swapped with the response body so the allocations are reused.
+         */
+        thread_local std::string t_compressionBuffer;
     }
 
 
@@ -138,7 +168,20 @@ namespace Merrie {
     HttpServer::HttpServer(HttpServerSettings settings)
             : NetworkServer(settings.NetworkServerSettingsValue),
               m_settings(std::move(settings)),
-              m_keepAliveHeader("timeout=" + std::to_string(settings.KeepAliveTimeout) + ", max=" + std::to_string(settings.KeepAliveMax)) {
+              m_keepAliveHeader("timeout=" + std::to_string(settings.KeepAliveTimeout) + ", max=" + std::to_string(settings.KeepAliveMax)),
+              m_receiveBufferPool(ReceiveBufferCacheSizePerClass),
+              m_sendBufferPool(SendBufferCacheSizePerClass) {
+
+        if (m_settings.TlsSettingsValue.Enabled) {
+            #ifdef M_HAS_OPENSSL_SSL
+            m_tlsContext = std::make_unique<TlsServerContext>(m_settings.TlsSettingsValue);
+            #else
+            throw TlsException("TLS is enabled, but Merrie was compiled without OpenSSL");
+            #endif
+        }
+
+        if (m_settings.StaticFilesSettings.Enabled)
+            m_staticFiles = std::make_unique<HttpStaticFiles>(m_settings.StaticFilesSettings);
     }
 
     std::shared_ptr<NetworkConnection> HttpServer::CreateNetworkConnection(boost::asio::io_context& context) {
@@ -156,27 +199,180 @@ namespace Merrie {
         return m_settings;
     }
 
-    HttpConnection::HttpConnection(boost::asio::io_context& ioContext, HttpServer* server) : NetworkConnection(ioContext), m_server(server) {
+    HttpCompressionStatistics HttpServer::GetCompressionStatistics() const noexcept {
+        return m_compressionMetrics.GetStatistics();
+    }
+
+    BufferPoolStatistics HttpServer::GetReceiveBufferStatistics() const noexcept {
+        return m_receiveBufferPool.GetStatistics();
+    }
+
+    BufferPoolStatistics HttpServer::GetSendBufferStatistics() const noexcept {
+        return m_sendBufferPool.GetStatistics();
+    }
+
+    TlsStatistics HttpServer::GetTlsStatistics() const noexcept {
+        #ifdef M_HAS_OPENSSL_SSL
+        if (m_tlsContext)
+            return m_tlsContext->GetStatistics();
+        #endif
+
+        return TlsStatistics{};
+    }
+
+    HttpStaticFiles* HttpServer::GetStaticFiles() noexcept {
+        return m_staticFiles.get();
+    }
+
+    HttpConnection::HttpConnection(boost::asio::io_context& ioContext, HttpServer* server)
+            : NetworkConnection(ioContext),
+              m_server(server),
+              m_buffer(server->m_receiveBufferPool, _GetMaxHeaderSize(server->m_settings) + BufferPool::SmallestBlockSize) {
+
+        #ifdef M_HAS_OPENSSL_SSL
+        if (server->m_tlsContext)
+            m_tlsStream.emplace(GetSocket(), server->m_tlsContext->GetSslContext());
+        #endif
+
         SetTimeout();
     }
 
+    void HttpConnection::Handshake(std::shared_ptr<NetworkConnection> connectionOwnership) {
+        #ifdef M_HAS_OPENSSL_SSL
+        TlsServerContext& tlsContext = *m_server->m_tlsContext;
+
+        if (!tlsContext.TryBeginHandshake()) {
+            m_invalidated = true;
+            return;
+        }
+
+        auto handler = [this, &tlsContext, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code error) mutable {
+            tlsContext.EndHandshake(!error, !error && SSL_session_reused(m_tlsStream->native_handle()) == 1);
+
+            // the handler may run on the handshake threads, the state of the connection is only touched from its strand
+            boost::asio::post(m_strand, [this, error, connectionOwnership = std::move(connectionOwnership)]() mutable {
+                if (error) {
+                    m_invalidated = true;
+                    return;
+                }
+
+                m_tlsHandshakeDone = true;
+                SetTimeout();
+                ReadData(std::move(connectionOwnership));
+            });
+        };
+
+        // the intermediate handlers of the handshake run on the executor of the final handler, so the cryptography is done on the handshake threads
+        if (boost::asio::thread_pool* handshakePool = tlsContext.GetHandshakePool())
+            m_tlsStream->async_handshake(ssl::stream_base::server, boost::asio::bind_executor(*handshakePool, std::move(handler)));
+        else
+            m_tlsStream->async_handshake(ssl::stream_base::server, boost::asio::bind_executor(m_strand, std::move(handler)));
+        #else
+        (void) connectionOwnership;
+        #endif
+    }
+
     void HttpConnection::ReadData(std::shared_ptr<NetworkConnection> connectionOwnership) {
         if (!IsValid())
             return;
 
-        http::async_read(GetSocket(), m_buffer, m_request, [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code ec, std::size_t) mutable {
+        #ifdef M_HAS_OPENSSL_SSL
+        if (m_tlsStream && !m_tlsHandshakeDone) {
+            Handshake(std::move(connectionOwnership));
+            return;
+        }
+        #endif
+
+        // the bytes of a pipelined request are already buffered
+        if (m_buffer.size() != 0) {
+            ReadRequest(std::move(connectionOwnership));
+            return;
+        }
+
+        // http::async_read borrows the receive buffer before it starts reading, so it is only started once the request
+        // begins to arrive and the idle keep-alive connections hold no receive memory
+        VisitStream([&](auto& stream) {
+            using Stream = std::remove_reference_t<decltype(stream)>;
+
+            if constexpr (std::is_same_v<Stream, tcp::socket>) {
+                stream.async_wait(tcp::socket::wait_read, boost::asio::bind_executor(m_strand, [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code error) mutable {
+                    if (error) {
+                        m_invalidated = true;
+                        return;
+                    }
+
+                    ReadRequest(std::move(connectionOwnership));
+                }));
+            }
+            #ifdef M_HAS_OPENSSL_SSL
+            else {
+                // the TLS stream can hold received bytes that do not make the socket readable, so the first byte is read through it
+                stream.async_read_some(boost::asio::buffer(&m_firstRequestByte, 1), boost::asio::bind_executor(m_strand, [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code error, std::size_t bytesTransferred) mutable {
+                    if (error) {
+                        m_invalidated = true;
+                        return;
+                    }
+
+                    std::memcpy(m_buffer.prepare(bytesTransferred).data(), &m_firstRequestByte, bytesTransferred);
+                    m_buffer.commit(bytesTransferred);
+                    ReadRequest(std::move(connectionOwnership));
+                }));
+            }
+            #endif
+        });
+    }
+
+    void HttpConnection::ReadRequest(std::shared_ptr<NetworkConnection> connectionOwnership) {
+        m_parser.emplace();
+        m_parser->header_limit(static_cast<uint32_t>(_GetMaxHeaderSize(m_server->m_settings)));
+
+        auto handler = [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code ec, std::size_t) mutable {
+            // only the bytes of a pipelined request keep the receive buffer
+            m_buffer.ReleaseIfEmpty();
+
+            if (ec == http::error::header_limit || ec == http::error::buffer_overflow) {
+                SendReadError(http::status::request_header_fields_too_large);
+                return;
+            }
+
+            if (ec == http::error::body_limit) {
+                SendReadError(http::status::payload_too_large);
+                return;
+            }
+
             if (ec) {
                 // todo: handle error
+                m_parser.reset();
                 m_invalidated = true;
                 return;
             }
 
+            m_request = m_parser->release();
+            m_parser.reset();
+            m_requestStart = DefaultClock::now();
+
             m_keepAlive = m_server->m_settings.AllowKeepAlive && m_request.keep_alive();
             SetTimeout();
             m_server->HandleRequest(std::static_pointer_cast<HttpConnection>(connectionOwnership));
+        };
+
+        VisitStream([&](auto& stream) {
+            http::async_read(stream, m_buffer, *m_parser, boost::asio::bind_executor(m_strand, std::move(handler)));
         });
     }
 
+    void HttpConnection::SendReadError(http::status status) {
+        m_parser.reset();
+        m_buffer.consume(m_buffer.size());
+        m_buffer.ReleaseIfEmpty();
+
+        m_request = {};
+        m_keepAlive = false;
+        m_response = {};
+        m_response.result(status);
+        SendResponse();
+    }
+
     http::request<boost::beast::http::string_body>& HttpConnection::GetRequest() noexcept {
         return m_request;
     }
@@ -191,9 +387,53 @@ namespace Merrie {
 
         std::shared_ptr<NetworkConnection> connectionOwnership = shared_from_this();
 
-        // basic headers
+        CompressResponse();
+
+        // a 304 response describes the representation the client already has, it must not claim an empty one
+        if (m_response.result() != http::status::not_modified)
+            m_response.content_length(m_response.body().size());
+
+        // the response to HEAD has the headers of the response to GET, but no body
+        if (m_request.method() == http::verb::head)
+            m_response.body().clear();
+
+        PrepareResponseHeaders();
+
+        auto handler = [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code error, std::size_t) mutable {
+            OnResponseWritten(std::move(connectionOwnership), error);
+        };
+
+        VisitStream([&](auto& stream) {
+            http::async_write(stream, m_response, boost::asio::bind_executor(m_strand, std::move(handler)));
+        });
+    }
+
+    std::shared_ptr<HttpResponseStream> HttpConnection::StartStreamingResponse() {
+        if (!IsValid())
+            return nullptr;
+
+        m_response.body().clear();
+        m_response.chunked(true);
+        PrepareResponseHeaders();
+
+        auto stream = std::make_shared<HttpResponseStream>(std::static_pointer_cast<HttpConnection>(shared_from_this()), m_server->m_sendBufferPool);
+
+        // the response to HEAD has the headers of the response to GET, but no body
+        if (m_request.method() == http::verb::head) {
+            stream->Start(std::move(m_response.base()), true);
+            return nullptr;
+        }
+
+        stream->Start(std::move(m_response.base()), false);
+        return stream;
+    }
+
+    void HttpConnection::SetCompressionAllowed(bool allowed) noexcept {
+        m_compressionAllowed = allowed;
+    }
+
+    void HttpConnection::PrepareResponseHeaders() {
         m_response.version(m_request.version());
-        m_response.set(http::field::content_length, m_response.body().size());
 
         // keep alive
         m_response.keep_alive(m_keepAlive);
@@ -201,20 +441,77 @@ namespace Merrie {
             m_response.set(http::field::connection, "keep-alive");
             m_response.set(http::field::keep_alive, m_server->m_keepAliveHeader);
         }
+    }
+
+    void HttpConnection::OnResponseWritten(std::shared_ptr<NetworkConnection> connectionOwnership, boost::beast::error_code error) {
+        if (m_routeMetrics != nullptr) {
+            m_routeMetrics->RecordRequest(DefaultClock::now() - m_requestStart);
+            m_routeMetrics = nullptr;
+        }
 
-        http::async_write(GetSocket(), m_response, [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code error, std::size_t) mutable {
-            if (error || !m_keepAlive) {
+        m_compressionAllowed = true;
+
+        #ifdef M_HAS_OPENSSL_SSL
+        // OpenSSL removes sessions of connections that were not shut down from the session cache, they could not be resumed
+        if (!error && !m_keepAlive && m_tlsStream) {
+            m_tlsStream->async_shutdown(boost::asio::bind_executor(m_strand, [this, connectionOwnership = std::move(connectionOwnership)](boost::beast::error_code) {
                 m_invalidated = true;
-                return;
-            }
+            }));
+            return;
+        }
+        #endif
 
-            SetTimeout();
-            ReadData(std::move(connectionOwnership));
-        });
+        if (error || !m_keepAlive) {
+            m_invalidated = true;
+            return;
+        }
+
+        // the messages are reused by the next request, headers like Content-Encoding must not leak into it
+        m_request = {};
+        m_response = {};
+
+        SetTimeout();
+        ReadData(std::move(connectionOwnership));
+    }
+
+    void HttpConnection::CompressResponse() {
+        const HttpCompressionSettings& settings = m_server->m_settings.CompressionSettings;
+        std::string& body = m_response.body();
+
+        if (!settings.Enabled || !m_compressionAllowed || m_response.count(http::field::content_encoding) != 0)
+            return;
+
+        // the representation depends on the Accept-Encoding, caches must know about it
+        m_response.set(http::field::vary, "Accept-Encoding");
+
+        const auto acceptEncoding = m_request[http::field::accept_encoding];
+        const HttpContentEncoding encoding = body.size() < settings.MinimumSize
+                                             ? HttpContentEncoding::Identity
+                                             : NegotiateContentEncoding(std::string_view(acceptEncoding.data(), acceptEncoding.size()));
+
+        if (encoding == HttpContentEncoding::Identity) {
+            m_server->m_compressionMetrics.RecordSkipped();
+            return;
+        }
+
+        const auto start = DefaultClock::now();
+        try {
+            CompressHttpBody(encoding, settings.Level, body, t_compressionBuffer);
+        }
+        catch (const HttpCompressionException&) {
+            m_server->m_compressionMetrics.RecordSkipped();
+            return;
+        }
+
+        m_server->m_compressionMetrics.RecordCompressed(body.size(), t_compressionBuffer.size(), DefaultClock::now() - start);
+
+        const std::string_view encodingName = GetContentEncodingName(encoding);
+        m_response.set(http::field::content_encoding, boost::beast::string_view(encodingName.data(), encodingName.size()));
+        body.swap(t_compressionBuffer);
     }
 
     bool HttpConnection::IsValid() {
-        return NetworkConnection::IsValid() && !m_invalidated && !IsPast(m_timeout);
+        return NetworkConnection::IsValid() && !m_invalidated && (m_upgraded || !IsPast(m_timeout));
     }
 
     void HttpConnection::SetTimeout() {
@@ -0,0 +1,206 @@
+#include <Commons/Network/HttpCompression.hpp>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <cstdlib>
+
+#ifdef M_HAS_ZLIB
+#   include <zlib.h>
+#endif
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * Removes leading and trailing whitespaces from the view.
+         */
+        std::string_view _Trim(std::string_view view) noexcept {
+            const auto start = view.find_first_not_of(" \t");
+            if (start == std::string_view::npos)
+                return {};
+
+            return view.substr(start, view.find_last_not_of(" \t") - start + 1);
+        }
+
+        /**
+         * Parses the quality value of a single Accept-Encoding entry, returns 1.0 if there is none.
+         */
+        double _ParseQuality(std::string_view parameters) noexcept {
+            while (!parameters.empty()) {
+                const auto separator = parameters.find(';');
+                const std::string_view parameter = _Trim(parameters.substr(0, separator));
+                parameters = separator == std::string_view::npos ? std::string_view() : parameters.substr(separator + 1);
+
+                if (parameter.size() < 2 || (parameter[0] != 'q' && parameter[0] != 'Q') || parameter[1] != '=')
+                    continue;
+
+                const std::string value(parameter.substr(2));
+                char* end = nullptr;
+                const double quality = std::strtod(value.c_str(), &end);
+                return end == value.c_str() ? 0.0 : quality;
+            }
+
+            return 1.0;
+        }
+
+        #ifdef M_HAS_ZLIB
+        /**
+         * zlib deflate state for a single encoding, reused by all responses compressed on the owning thread.
+         */
+        class _Compressor {
+            public:
+                NON_COPYABLE(_Compressor);
+                NON_MOVEABLE(_Compressor);
+
+                explicit _Compressor(int windowBits) noexcept : m_windowBits(windowBits) {}
+
+                ~_Compressor() {
+                    if (m_initialized)
+                        deflateEnd(&m_stream);
+                }
+
+                void Compress(int level, std::string_view input, std::string& output) {
+                    Prepare(level);
+
+                    output.resize(deflateBound(&m_stream, static_cast<uLong>(input.size())));
+
+                    m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+                    m_stream.avail_in = static_cast<uInt>(input.size());
+                    m_stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                    m_stream.avail_out = static_cast<uInt>(output.size());
+
+                    const int result = deflate(&m_stream, Z_FINISH);
+                    if (result != Z_STREAM_END)
+                        throw HttpCompressionException("deflate failed with code " + std::to_string(result));
+
+                    output.resize(m_stream.total_out);
+                }
+
+            private:
+                void Prepare(int level) {
+                    if (!m_initialized) {
+                        const int result = deflateInit2(&m_stream, level, Z_DEFLATED, m_windowBits, 8, Z_DEFAULT_STRATEGY);
+                        if (result != Z_OK)
+                            throw HttpCompressionException("deflateInit2 failed with code " + std::to_string(result));
+
+                        m_initialized = true;
+                        m_level = level;
+                        return;
+                    }
+
+                    deflateReset(&m_stream);
+
+                    if (level != m_level) {
+                        deflateParams(&m_stream, level, Z_DEFAULT_STRATEGY);
+                        m_level = level;
+                    }
+                }
+
+            private:
+                const int m_windowBits;
+                bool m_initialized = false;
+                int m_level = Z_DEFAULT_COMPRESSION;
+                z_stream m_stream{};
+        };
+
+        thread_local _Compressor t_deflateCompressor(MAX_WBITS);
+        thread_local _Compressor t_gzipCompressor(MAX_WBITS + 16);
+        #endif
+    }
+
+    std::string_view GetContentEncodingName(HttpContentEncoding encoding) noexcept {
+        switch (encoding) {
+            case HttpContentEncoding::Deflate:
+                return "deflate";
+            case HttpContentEncoding::Gzip:
+                return "gzip";
+            case HttpContentEncoding::Identity:
+            default:
+                return "identity";
+        }
+    }
+
+    HttpContentEncoding NegotiateContentEncoding(std::string_view acceptEncoding) noexcept {
+        #ifdef M_HAS_ZLIB
+        double gzipQuality = -1.0;
+        double deflateQuality = -1.0;
+        double wildcardQuality = -1.0;
+
+        std::string_view remaining = acceptEncoding;
+        while (!remaining.empty()) {
+            const auto separator = remaining.find(',');
+            const std::string_view entry = remaining.substr(0, separator);
+            remaining = separator == std::string_view::npos ? std::string_view() : remaining.substr(separator + 1);
+
+            const auto parametersStart = entry.find(';');
+            const std::string_view coding = _Trim(entry.substr(0, parametersStart));
+
+            const double quality = parametersStart == std::string_view::npos ? 1.0 : _ParseQuality(entry.substr(parametersStart + 1));
+
+            if (boost::iequals(coding, "gzip") || boost::iequals(coding, "x-gzip"))
+                gzipQuality = quality;
+            else if (boost::iequals(coding, "deflate"))
+                deflateQuality = quality;
+            else if (coding == "*")
+                wildcardQuality = quality;
+        }
+
+        // encodings that are not mentioned explicitly get the quality of the wildcard
+        if (gzipQuality < 0.0)
+            gzipQuality = wildcardQuality;
+        if (deflateQuality < 0.0)
+            deflateQuality = wildcardQuality;
+
+        if (gzipQuality > 0.0 && gzipQuality >= deflateQuality)
+            return HttpContentEncoding::Gzip;
+        if (deflateQuality > 0.0)
+            return HttpContentEncoding::Deflate;
+        #else
+        (void) acceptEncoding;
+        #endif
+
+        return HttpContentEncoding::Identity;
+    }
+
+    void CompressHttpBody(HttpContentEncoding encoding, int level, std::string_view input, std::string& output) {
+        #ifdef M_HAS_ZLIB
+        switch (encoding) {
+            case HttpContentEncoding::Deflate:
+                t_deflateCompressor.Compress(level, input, output);
+                return;
+            case HttpContentEncoding::Gzip:
+                t_gzipCompressor.Compress(level, input, output);
+                return;
+            case HttpContentEncoding::Identity:
+            default:
+                throw HttpCompressionException("cannot compress using the identity encoding");
+        }
+        #else
+        (void) encoding;
+        (void) level;
+        (void) input;
+        (void) output;
+        throw HttpCompressionException("compression is not available, zlib was not found");
+        #endif
+    }
+
+    void HttpCompressionMetrics::RecordCompressed(size_t uncompressedSize, size_t compressedSize, std::chrono::nanoseconds time) noexcept {
+        m_compressedResponses.fetch_add(1, std::memory_order_relaxed);
+        m_uncompressedBytes.fetch_add(uncompressedSize, std::memory_order_relaxed);
+        m_compressedBytes.fetch_add(compressedSize, std::memory_order_relaxed);
+        m_compressionNanoseconds.fetch_add(time.count(), std::memory_order_relaxed);
+    }
+
+    void HttpCompressionMetrics::RecordSkipped() noexcept {
+        m_skippedResponses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    HttpCompressionStatistics HttpCompressionMetrics::GetStatistics() const noexcept {
+        return HttpCompressionStatistics{
+                m_compressedResponses.load(std::memory_order_relaxed),
+                m_skippedResponses.load(std::memory_order_relaxed),
+                m_uncompressedBytes.load(std::memory_order_relaxed),
+                m_compressedBytes.load(std::memory_order_relaxed),
+                std::chrono::nanoseconds(m_compressionNanoseconds.load(std::memory_order_relaxed)),
+        };
+    }
+}
@@ -0,0 +1,223 @@
+#include <Commons/Network/HttpResponseStream.hpp>
+
+#include <cstring>
+#include <utility>
+
+namespace Merrie {
+
+    HttpResponseStream::HttpResponseStream(std::shared_ptr<HttpConnection> connection, BufferPool& pool)
+            : m_connection(std::move(connection)),
+              m_pool(pool) {
+    }
+
+    void HttpResponseStream::Start(http::response_header<> header, bool headerOnly) {
+        std::unique_lock lock(m_mutex);
+
+        m_header = http::response<http::empty_body>(std::move(header));
+        m_serializer.emplace(m_header);
+        m_writing = true;
+
+        // the response to HEAD has the headers of the response to GET, but no body, not even the last chunk
+        if (headerOnly) {
+            m_finishing = true;
+            m_lastChunkSent = true;
+        }
+
+        boost::asio::post(m_connection->GetStrand(), [self = shared_from_this()] {
+            std::unique_lock lock(self->m_mutex);
+
+            self->m_connection->VisitStream([&self](auto& stream) {
+                http::async_write_header(stream, *self->m_serializer, boost::asio::bind_executor(self->m_connection->GetStrand(), [self](boost::beast::error_code error, std::size_t) {
+                    self->OnWritten(error);
+                }));
+            });
+        });
+    }
+
+    size_t HttpResponseStream::Write(std::string_view data) {
+        std::unique_lock lock(m_mutex);
+
+        if (m_failed || m_finishing)
+            return data.size();
+
+        // a single write of any size does not go over the limit either
+        data = data.substr(0, MaxPendingBytes - m_pendingBytes);
+        const size_t accepted = data.size();
+
+        if (accepted == 0)
+            return 0;
+
+        while (!data.empty()) {
+            if (m_currentBlock.IsEmpty()) {
+                m_currentBlock = m_pool.Acquire(ChunkSize);
+                m_currentSize = 0;
+            }
+
+            const size_t amount = std::min(data.size(), m_currentBlock.GetSize() - m_currentSize);
+            std::memcpy(m_currentBlock.GetData() + m_currentSize, data.data(), amount);
+            m_currentSize += amount;
+            m_pendingBytes += amount;
+            data.remove_prefix(amount);
+
+            if (m_currentSize == m_currentBlock.GetSize())
+                QueueCurrentChunk();
+        }
+
+        if (!m_writing)
+            ScheduleWrite();
+
+        return accepted;
+    }
+
+    void HttpResponseStream::WhenDrained(std::function<void()> callback) {
+        std::unique_lock lock(m_mutex);
+
+        if (m_failed || m_finishing || m_pendingBytes < MaxPendingBytes) {
+            boost::asio::post(m_connection->GetStrand(), std::move(callback));
+            return;
+        }
+
+        m_drainedCallback = std::move(callback);
+    }
+
+    void HttpResponseStream::Flush() {
+        std::unique_lock lock(m_mutex);
+
+        if (m_failed || m_finishing)
+            return;
+
+        QueueCurrentChunk();
+
+        if (!m_writing)
+            ScheduleWrite();
+    }
+
+    void HttpResponseStream::Finish() {
+        std::unique_lock lock(m_mutex);
+
+        if (m_finishing)
+            return;
+
+        QueueCurrentChunk();
+        m_finishing = true;
+
+        if (!m_writing)
+            ScheduleWrite();
+    }
+
+    bool HttpResponseStream::IsFailed() const noexcept {
+        std::scoped_lock lock(m_mutex);
+        return m_failed;
+    }
+
+    size_t HttpResponseStream::GetPendingBytes() const noexcept {
+        std::scoped_lock lock(m_mutex);
+        return m_pendingBytes;
+    }
+
+    void HttpResponseStream::QueueCurrentChunk() {
+        if (m_currentSize == 0)
+            return;
+
+        m_queue.push_back(Chunk{std::move(m_currentBlock), m_currentSize});
+        m_currentSize = 0;
+    }
+
+    void HttpResponseStream::ScheduleWrite() {
+        // the producer does not have to run on the strand of the connection, the socket is only written to from there
+        m_writing = true;
+
+        boost::asio::post(m_connection->GetStrand(), [self = shared_from_this()] {
+            std::unique_lock lock(self->m_mutex);
+            self->WriteNext(lock);
+        });
+    }
+
+    void HttpResponseStream::WriteNext(std::unique_lock<std::mutex>&) {
+        // the completion handlers are never invoked from the initiating function, so the lock can be held here
+        if (m_failed) {
+            m_writing = false;
+            return;
+        }
+
+        if (!m_queue.empty()) {
+            const Chunk& chunk = m_queue.front();
+            m_writing = true;
+
+            m_connection->VisitStream([this, &chunk](auto& stream) {
+                boost::asio::async_write(
+                        stream,
+                        http::make_chunk(boost::asio::const_buffer(chunk.Block.GetData(), chunk.Size)),
+                        boost::asio::bind_executor(m_connection->GetStrand(), [self = shared_from_this()](boost::beast::error_code error, std::size_t) {
+                            self->OnWritten(error);
+                        }));
+            });
+            return;
+        }
+
+        if (m_finishing && !m_lastChunkSent) {
+            m_writing = true;
+            m_lastChunkSent = true;
+
+            m_connection->VisitStream([this](auto& stream) {
+                boost::asio::async_write(stream, http::make_chunk_last(), boost::asio::bind_executor(m_connection->GetStrand(), [self = shared_from_this()](boost::beast::error_code error, std::size_t) {
+                    self->OnWritten(error);
+                }));
+            });
+            return;
+        }
+
+        m_writing = false;
+    }
+
+    void HttpResponseStream::OnWritten(boost::beast::error_code error) {
+        std::unique_lock lock(m_mutex);
+
+        if (error) {
+            m_failed = true;
+            m_writing = false;
+            m_queue.clear();
+            m_currentBlock.Reset();
+            m_currentSize = 0;
+            m_pendingBytes = 0;
+
+            // the producer learns about the failure from IsFailed()
+            std::function<void()> drainedCallback = std::exchange(m_drainedCallback, nullptr);
+            lock.unlock();
+
+            if (drainedCallback)
+                drainedCallback();
+
+            m_connection->OnResponseWritten(m_connection, error);
+            return;
+        }
+
+        if (m_serializer) {
+            // the header was written
+            m_serializer.reset();
+        } else if (!m_queue.empty()) {
+            m_pendingBytes -= m_queue.front().Size;
+            m_queue.pop_front();
+        }
+
+        if (m_lastChunkSent && m_queue.empty()) {
+            // the last chunk (or the header of the response to HEAD) was written, the connection can handle the next request
+            m_writing = false;
+            lock.unlock();
+
+            m_connection->OnResponseWritten(m_connection, error);
+            return;
+        }
+
+        std::function<void()> drainedCallback{};
+        if (m_drainedCallback && m_pendingBytes <= MaxPendingBytes / 2)
+            drainedCallback = std::exchange(m_drainedCallback, nullptr);
+
+        m_connection->SetTimeout();
+        WriteNext(lock);
+        lock.unlock();
+
+        if (drainedCallback)
+            drainedCallback();
+    }
+}
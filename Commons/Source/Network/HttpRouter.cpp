@@ -0,0 +1,321 @@
+#include <Commons/Network/HttpRouter.hpp>
+
+#include <algorithm>
+#include <map>
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * A node of the trie that the routes are inserted into before it is flattened.
+         */
+        struct _BuildNode {
+            std::map<char, std::unique_ptr<_BuildNode>> Children{};
+            std::vector<uint32_t> ExactRoutes{};
+            std::vector<uint32_t> PrefixRoutes{};
+        };
+
+        bool _MethodsOverlap(const std::vector<http::verb>& first, const std::vector<http::verb>& second) {
+            if (first.empty() || second.empty())
+                return true;
+
+            return std::any_of(first.begin(), first.end(), [&](http::verb method) {
+                return std::find(second.begin(), second.end(), method) != second.end();
+            });
+        }
+
+        std::string _JoinMethods(const std::vector<http::verb>& methods) {
+            std::string result;
+
+            for (http::verb method : methods) {
+                if (!result.empty())
+                    result += ", ";
+
+                const auto name = http::to_string(method);
+                result.append(name.data(), name.size());
+            }
+
+            return result;
+        }
+    }
+
+    // ================================================================================
+    // =  HttpRoute & HttpRouteMetrics                                                =
+    // ================================================================================
+
+    bool HttpRoute::AcceptsMethod(http::verb method) const noexcept {
+        return Methods.empty() || std::find(Methods.begin(), Methods.end(), method) != Methods.end();
+    }
+
+    void HttpRouteMetrics::RecordRequest(std::chrono::nanoseconds latency) noexcept {
+        const int64_t nanoseconds = latency.count();
+
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        m_totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        int64_t max = m_maxNanoseconds.load(std::memory_order_relaxed);
+        while (nanoseconds > max && !m_maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t HttpRouteMetrics::GetRequests() const noexcept {
+        return m_requests.load(std::memory_order_relaxed);
+    }
+
+    std::chrono::nanoseconds HttpRouteMetrics::GetTotalLatency() const noexcept {
+        return std::chrono::nanoseconds(m_totalNanoseconds.load(std::memory_order_relaxed));
+    }
+
+    std::chrono::nanoseconds HttpRouteMetrics::GetMaxLatency() const noexcept {
+        return std::chrono::nanoseconds(m_maxNanoseconds.load(std::memory_order_relaxed));
+    }
+
+    // ================================================================================
+    // =  HttpRouter                                                                  =
+    // ================================================================================
+
+    HttpRouter::HttpRouter(HttpRouteErrorHandler errorHandler) : m_errorHandler(std::move(errorHandler)) {
+    }
+
+    void HttpRouter::AddRoute(HttpRouteMatch match, std::string path, std::vector<http::verb> methods, HttpRouteHandler handler, HttpRouteOptions options) {
+        if (m_frozen)
+            throw HttpRouterException("cannot add the route " + path + ", the router is frozen");
+
+        for (const std::unique_ptr<Entry>& entry : m_entries) {
+            const HttpRoute& route = entry->Route;
+
+            if (route.Match == match && route.Path == path && _MethodsOverlap(route.Methods, methods))
+                throw HttpRouterException("the route " + path + " was already added for some of its methods");
+        }
+
+        auto entry = std::make_unique<Entry>();
+        entry->Route = HttpRoute{match, std::move(path), std::move(methods), std::move(handler), std::move(options)};
+        m_entries.emplace_back(std::move(entry));
+    }
+
+    void HttpRouter::Freeze() {
+        if (m_frozen)
+            return;
+
+        _BuildNode root;
+
+        for (uint32_t i = 0; i < m_entries.size(); i++) {
+            const HttpRoute& route = m_entries[i]->Route;
+            _BuildNode* node = &root;
+
+            for (char character : route.Path) {
+                std::unique_ptr<_BuildNode>& child = node->Children[character];
+                if (!child)
+                    child = std::make_unique<_BuildNode>();
+
+                node = child.get();
+            }
+
+            (route.Match == HttpRouteMatch::Exact ? node->ExactRoutes : node->PrefixRoutes).push_back(i);
+        }
+
+        // flatten breadth-first, so the children of a node have consecutive edges
+        std::vector<const _BuildNode*> queue{&root};
+        m_nodes.emplace_back();
+
+        for (size_t i = 0; i < queue.size(); i++) {
+            const _BuildNode& buildNode = *queue[i];
+            Node& node = m_nodes[i];
+
+            node.FirstExactRoute = static_cast<uint32_t>(m_nodeRoutes.size());
+            node.ExactRouteCount = static_cast<uint32_t>(buildNode.ExactRoutes.size());
+            m_nodeRoutes.insert(m_nodeRoutes.end(), buildNode.ExactRoutes.begin(), buildNode.ExactRoutes.end());
+
+            node.FirstPrefixRoute = static_cast<uint32_t>(m_nodeRoutes.size());
+            node.PrefixRouteCount = static_cast<uint32_t>(buildNode.PrefixRoutes.size());
+            m_nodeRoutes.insert(m_nodeRoutes.end(), buildNode.PrefixRoutes.begin(), buildNode.PrefixRoutes.end());
+
+            node.FirstEdge = static_cast<uint32_t>(m_edges.size());
+            node.EdgeCount = static_cast<uint32_t>(buildNode.Children.size());
+
+            // std::map keeps the children sorted, the edges can be binary searched
+            for (const auto&[character, child] : buildNode.Children) {
+                m_edges.push_back(Edge{character, static_cast<uint32_t>(queue.size())});
+                queue.push_back(child.get());
+                m_nodes.emplace_back();
+            }
+        }
+
+        m_frozen = true;
+    }
+
+    bool HttpRouter::IsFrozen() const noexcept {
+        return m_frozen;
+    }
+
+    const HttpRoute* HttpRouter::Find(std::string_view path, http::verb method, bool& pathMatched) const {
+        const Entry* pathEntry = nullptr;
+        const Entry* entry = FindEntry(path, method, pathEntry);
+
+        pathMatched = pathEntry != nullptr;
+        return entry != nullptr ? &entry->Route : nullptr;
+    }
+
+    const HttpRouter::Entry* HttpRouter::FindEntry(std::string_view path, http::verb method, const Entry*& pathEntry) const {
+        M_ASSERT(m_frozen, "The router has to be frozen before routing requests");
+
+        // the deeper prefix routes override the shallower ones while walking down the path
+        const Entry* prefixEntry = nullptr;
+        const Entry* prefixPathEntry = nullptr;
+        size_t matchedLength = 0;
+        uint32_t current = 0;
+
+        for (;;) {
+            const Node& node = m_nodes[current];
+
+            if (node.PrefixRouteCount != 0) {
+                if (const Entry* entry = FindInRoutes(node.FirstPrefixRoute, node.PrefixRouteCount, method, prefixPathEntry))
+                    prefixEntry = entry;
+            }
+
+            if (matchedLength == path.size())
+                break;
+
+            const Edge* edgesBegin = m_edges.data() + node.FirstEdge;
+            const Edge* edgesEnd = edgesBegin + node.EdgeCount;
+            const char character = path[matchedLength];
+
+            const Edge* edge = std::lower_bound(edgesBegin, edgesEnd, character, [](const Edge& e, char c) { return e.Character < c; });
+            if (edge == edgesEnd || edge->Character != character)
+                break;
+
+            current = edge->Node;
+            matchedLength++;
+        }
+
+        pathEntry = nullptr;
+
+        if (matchedLength == path.size()) {
+            const Node& node = m_nodes[current];
+
+            if (const Entry* entry = FindInRoutes(node.FirstExactRoute, node.ExactRouteCount, method, pathEntry))
+                return entry;
+        }
+
+        if (prefixEntry != nullptr) {
+            pathEntry = nullptr;
+            return prefixEntry;
+        }
+
+        if (pathEntry == nullptr)
+            pathEntry = prefixPathEntry;
+
+        return nullptr;
+    }
+
+    const HttpRouter::Entry* HttpRouter::FindInRoutes(uint32_t first, uint32_t count, http::verb method, const Entry*& pathEntry) const {
+        for (uint32_t i = first; i < first + count; i++) {
+            const Entry* entry = m_entries[m_nodeRoutes[i]].get();
+
+            if (entry->Route.AcceptsMethod(method))
+                return entry;
+
+            pathEntry = entry;
+        }
+
+        return nullptr;
+    }
+
+    void HttpRouter::Route(std::shared_ptr<HttpConnection> connection) const {
+        HttpConnection& httpConnection = *connection;
+        const auto& request = httpConnection.GetRequest();
+
+        DecodedUrl url;
+        try {
+            const auto target = request.target();
+            url = DecodeUrlQueryString(std::string_view(target.data(), target.size()));
+        }
+        catch (const UrlDecodeException& e) {
+            SendError(connection, http::status::bad_request, e.what());
+            return;
+        }
+
+        const http::verb method = request.method();
+        const Entry* pathEntry = nullptr;
+        const Entry* entry = FindEntry(url.Path, method, pathEntry);
+
+        // preflight requests are answered for the routes with CORS that do not handle OPTIONS themselves
+        if (entry == nullptr && pathEntry != nullptr && method == http::verb::options && !pathEntry->Route.Options.Cors.AllowOrigin.empty()) {
+            auto& response = httpConnection.GetResponse();
+            response.result(http::status::ok);
+            response.set(http::field::allow, _JoinMethods(pathEntry->Route.Methods) + ", OPTIONS");
+            SetCorsHeaders(httpConnection, pathEntry->Route);
+            response.set(http::field::access_control_max_age, std::to_string(pathEntry->Route.Options.Cors.MaxAge));
+            httpConnection.SendResponse();
+            return;
+        }
+
+        if (entry == nullptr) {
+            if (pathEntry != nullptr) {
+                httpConnection.GetResponse().set(http::field::allow, _JoinMethods(pathEntry->Route.Methods));
+                SendError(connection, http::status::method_not_allowed, "The method is not allowed for the requested resource");
+            } else {
+                SendError(connection, http::status::not_found, "Failed to find the requested resource");
+            }
+
+            return;
+        }
+
+        const HttpRoute& route = entry->Route;
+
+        httpConnection.m_routeMetrics = &entry->Metrics;
+        httpConnection.SetCompressionAllowed(route.Options.AllowCompression);
+        SetCorsHeaders(httpConnection, route);
+
+        route.Handler(std::move(connection), url);
+    }
+
+    std::vector<HttpRouteStatistics> HttpRouter::GetStatistics() const {
+        std::vector<HttpRouteStatistics> statistics;
+        statistics.reserve(m_entries.size());
+
+        for (const std::unique_ptr<Entry>& entry : m_entries) {
+            statistics.push_back(HttpRouteStatistics{
+                    entry->Route.Match,
+                    entry->Route.Path,
+                    entry->Metrics.GetRequests(),
+                    entry->Metrics.GetTotalLatency(),
+                    entry->Metrics.GetMaxLatency(),
+            });
+        }
+
+        return statistics;
+    }
+
+    void HttpRouter::SendError(const std::shared_ptr<HttpConnection>& connection, http::status status, std::string_view message) const {
+        if (m_errorHandler) {
+            m_errorHandler(connection, status, message);
+            return;
+        }
+
+        auto& response = connection->GetResponse();
+        response.result(status);
+        response.set(http::field::content_type, "text/plain");
+        response.body() = message;
+        connection->SendResponse();
+    }
+
+    void HttpRouter::SetCorsHeaders(HttpConnection& connection, const HttpRoute& route) {
+        const HttpCorsOptions& cors = route.Options.Cors;
+
+        if (cors.AllowOrigin.empty())
+            return;
+
+        auto& response = connection.GetResponse();
+        response.set(http::field::access_control_allow_origin, cors.AllowOrigin);
+        response.set(http::field::access_control_allow_headers, cors.AllowHeaders);
+
+        if (cors.AllowCredentials)
+            response.set(http::field::access_control_allow_credentials, "true");
+
+        if (route.Methods.empty())
+            response.set(http::field::access_control_allow_methods, "*");
+        else
+            response.set(http::field::access_control_allow_methods, _JoinMethods(route.Methods));
+    }
+}
@@ -0,0 +1,600 @@
+#include <Commons/Network/HttpStaticFiles.hpp>
+
+#include <Commons/Network/Http.hpp>
+#include <boost/filesystem.hpp>
+#include <cerrno>
+#include <charconv>
+
+#ifdef M_PLATFORM_UNIX
+#include <sys/sendfile.h>
+#endif
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * How long a cached file is served without checking whether it has changed on the disk.
+         */
+        constexpr const std::chrono::seconds RevalidateInterval(1);
+
+        /**
+         * Size of the chunks that the files are copied in when sendfile cannot be used.
+         */
+        constexpr const size_t CopyChunkSize = 64 * 1024;
+
+        /**
+         * How much is sent with sendfile before the other handlers of the I/O thread get a chance to run.
+         */
+        constexpr const size_t MaxSendfileBytesPerTurn = 1024 * 1024;
+
+        std::string_view _GetContentType(std::string_view path) {
+            static const std::unordered_map<std::string_view, std::string_view> ContentTypes{
+                    {"html",  "text/html; charset=utf-8"},
+                    {"htm",   "text/html; charset=utf-8"},
+                    {"css",   "text/css; charset=utf-8"},
+                    {"js",    "application/javascript; charset=utf-8"},
+                    {"json",  "application/json; charset=utf-8"},
+                    {"map",   "application/json; charset=utf-8"},
+                    {"txt",   "text/plain; charset=utf-8"},
+                    {"xml",   "application/xml"},
+                    {"png",   "image/png"},
+                    {"jpg",   "image/jpeg"},
+                    {"jpeg",  "image/jpeg"},
+                    {"gif",   "image/gif"},
+                    {"webp",  "image/webp"},
+                    {"svg",   "image/svg+xml"},
+                    {"ico",   "image/x-icon"},
+                    {"woff",  "font/woff"},
+                    {"woff2", "font/woff2"},
+                    {"ttf",   "font/ttf"},
+                    {"mp3",   "audio/mpeg"},
+                    {"ogg",   "audio/ogg"},
+                    {"wav",   "audio/wav"},
+            };
+
+            const size_t dot = path.rfind('.');
+            if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos)
+                return "application/octet-stream";
+
+            std::string extension(path.substr(dot + 1));
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+
+            const auto iterator = ContentTypes.find(extension);
+            return iterator != ContentTypes.end() ? iterator->second : "application/octet-stream";
+        }
+
+        /**
+         * Checks that the path stays inside the root directory: no empty, hidden, "." or ".." segments and no backslashes.
+         */
+        bool _IsSafePath(std::string_view path) {
+            if (path.empty() || path.find('\\') != std::string_view::npos || path.find('\0') != std::string_view::npos)
+                return false;
+
+            size_t start = 0;
+            while (start <= path.size()) {
+                const size_t end = std::min(path.find('/', start), path.size());
+
+                if (end == start || path[start] == '.')
+                    return false;
+
+                start = end + 1;
+            }
+
+            return true;
+        }
+
+        std::string _CreateETag(uint64_t size, std::time_t modificationTime) {
+            char buffer[48];
+            buffer[0] = '"';
+
+            char* position = std::to_chars(buffer + 1, buffer + sizeof(buffer), static_cast<uint64_t>(modificationTime), 16).ptr;
+            *position++ = '-';
+            position = std::to_chars(position, buffer + sizeof(buffer), size, 16).ptr;
+            *position++ = '"';
+
+            return std::string(buffer, position);
+        }
+
+        /**
+         * Checks whether the If-None-Match or If-Range header value lists the ETag. Weak comparison, as required for If-None-Match.
+         */
+        bool _MatchesETag(std::string_view header, std::string_view eTag) {
+            if (header == "*")
+                return true;
+
+            size_t start = 0;
+            while (start < header.size()) {
+                size_t end = header.find(',', start);
+                if (end == std::string_view::npos)
+                    end = header.size();
+
+                std::string_view candidate = header.substr(start, end - start);
+
+                while (!candidate.empty() && candidate.front() == ' ')
+                    candidate.remove_prefix(1);
+
+                while (!candidate.empty() && candidate.back() == ' ')
+                    candidate.remove_suffix(1);
+
+                if (candidate.substr(0, 2) == "W/")
+                    candidate.remove_prefix(2);
+
+                if (candidate == eTag)
+                    return true;
+
+                start = end + 1;
+            }
+
+            return false;
+        }
+
+        enum class _RangeResult {
+                None,
+                Satisfiable,
+                Unsatisfiable,
+        };
+
+        /**
+         * Parses a single byte range ("bytes=a-b", "bytes=a-" or "bytes=-n"). Multiple ranges and malformed headers are ignored
+         * and the whole file is sent, as allowed by RFC 7233.
+         */
+        _RangeResult _ParseRange(std::string_view header, uint64_t size, uint64_t& offset, uint64_t& length) {
+            constexpr std::string_view Prefix = "bytes=";
+
+            if (header.substr(0, Prefix.size()) != Prefix)
+                return _RangeResult::None;
+
+            header.remove_prefix(Prefix.size());
+
+            const size_t dash = header.find('-');
+            if (dash == std::string_view::npos || header.find(',') != std::string_view::npos)
+                return _RangeResult::None;
+
+            const std::string_view firstPart = header.substr(0, dash);
+            const std::string_view lastPart = header.substr(dash + 1);
+            uint64_t first = 0;
+            uint64_t last = 0;
+
+            const auto parse = [](std::string_view text, uint64_t& value) {
+                const auto[end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+                return error == std::errc() && end == text.data() + text.size();
+            };
+
+            if (firstPart.empty()) {
+                // suffix range, the last n bytes
+                if (!parse(lastPart, last))
+                    return _RangeResult::None;
+
+                if (last == 0 || size == 0)
+                    return _RangeResult::Unsatisfiable;
+
+                length = std::min(last, size);
+                offset = size - length;
+                return _RangeResult::Satisfiable;
+            }
+
+            if (!parse(firstPart, first))
+                return _RangeResult::None;
+
+            if (lastPart.empty())
+                last = size - 1;
+            else if (!parse(lastPart, last) || last < first)
+                return _RangeResult::None;
+
+            if (first >= size)
+                return _RangeResult::Unsatisfiable;
+
+            offset = first;
+            length = std::min(last, size - 1) - first + 1;
+            return _RangeResult::Satisfiable;
+        }
+    }
+
+    // ================================================================================
+    // =  HttpFileResponse                                                            =
+    // ================================================================================
+
+    /**
+     * Sends the headers of a response followed by a range of a file.
+     */
+    class HttpFileResponse : public std::enable_shared_from_this<HttpFileResponse> {
+        public: // Constructors & destructors
+            NON_COPYABLE(HttpFileResponse);
+            NON_MOVEABLE(HttpFileResponse);
+
+            HttpFileResponse(std::shared_ptr<HttpConnection> connection, boost::beast::file file, uint64_t offset, uint64_t length, BufferPool& pool)
+                    : m_connection(std::move(connection)),
+                      m_file(std::move(file)),
+                      m_offset(offset),
+                      m_remaining(length),
+                      m_pool(pool) {
+            }
+
+        public: // Public methods
+            void Start(http::response_header<> header) {
+                m_header = http::response<http::empty_body>(std::move(header));
+                m_serializer.emplace(m_header);
+
+                m_connection->VisitStream([this](auto& stream) {
+                    http::async_write_header(stream, *m_serializer, boost::asio::bind_executor(m_connection->GetStrand(), [self = shared_from_this()](boost::beast::error_code error, std::size_t) {
+                        self->m_serializer.reset();
+
+                        if (error || self->m_remaining == 0)
+                            self->Finish(error);
+                        else
+                            self->SendNext();
+                    }));
+                });
+            }
+
+        private: // Private methods
+            void SendNext() {
+                m_connection->VisitStream([this](auto& stream) {
+                    #ifdef M_PLATFORM_UNIX
+                    if constexpr (std::is_same_v<std::decay_t<decltype(stream)>, tcp::socket>) {
+                        SendWithSendfile(stream);
+                        return;
+                    }
+                    #endif
+
+                    SendWithCopy(stream);
+                });
+            }
+
+            #ifdef M_PLATFORM_UNIX
+            void SendWithSendfile(tcp::socket& socket) {
+                boost::system::error_code error;
+
+                if (!socket.native_non_blocking()) {
+                    socket.native_non_blocking(true, error);
+
+                    if (error) {
+                        Finish(error);
+                        return;
+                    }
+                }
+
+                size_t sentThisTurn = 0;
+
+                while (m_remaining != 0 && sentThisTurn < MaxSendfileBytesPerTurn) {
+                    auto offset = static_cast<off_t>(m_offset);
+                    const size_t count = static_cast<size_t>(std::min<uint64_t>(m_remaining, MaxSendfileBytesPerTurn));
+                    const ssize_t sent = ::sendfile(socket.native_handle(), m_file.native_handle(), &offset, count);
+
+                    if (sent > 0) {
+                        m_offset += static_cast<uint64_t>(sent);
+                        m_remaining -= static_cast<uint64_t>(sent);
+                        sentThisTurn += static_cast<size_t>(sent);
+                        continue;
+                    }
+
+                    if (sent < 0 && errno == EINTR)
+                        continue;
+
+                    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                        Finish(boost::system::error_code(errno, boost::system::system_category()));
+                        return;
+                    }
+
+                    if (sent == 0) {
+                        // the file was truncated, the promised Content-Length cannot be sent
+                        Finish(boost::asio::error::eof);
+                        return;
+                    }
+
+                    break;
+                }
+
+                if (m_remaining == 0) {
+                    Finish({});
+                    return;
+                }
+
+                socket.async_wait(tcp::socket::wait_write, boost::asio::bind_executor(m_connection->GetStrand(), [self = shared_from_this()](boost::system::error_code waitError) {
+                    if (waitError)
+                        self->Finish(waitError);
+                    else
+                        self->SendNext();
+                }));
+            }
+            #endif
+
+            template<typename Stream>
+            void SendWithCopy(Stream& stream) {
+                if (m_block.IsEmpty())
+                    m_block = m_pool.Acquire(CopyChunkSize);
+
+                boost::beast::error_code error;
+                m_file.seek(m_offset, error);
+
+                const size_t amount = static_cast<size_t>(std::min<uint64_t>(m_remaining, m_block.GetSize()));
+                const size_t read = error ? 0 : m_file.read(m_block.GetData(), amount, error);
+
+                if (error || read == 0) {
+                    Finish(error ? error : boost::asio::error::eof);
+                    return;
+                }
+
+                boost::asio::async_write(stream, boost::asio::buffer(m_block.GetData(), read), boost::asio::bind_executor(m_connection->GetStrand(), [self = shared_from_this()](boost::beast::error_code writeError, std::size_t written) {
+                    self->m_offset += written;
+                    self->m_remaining -= written;
+
+                    if (writeError || self->m_remaining == 0)
+                        self->Finish(writeError);
+                    else
+                        self->SendNext();
+                }));
+            }
+
+            void Finish(boost::beast::error_code error) {
+                boost::beast::error_code closeError;
+                m_block.Reset();
+                m_file.close(closeError);
+                m_connection->OnResponseWritten(m_connection, error);
+            }
+
+        private: // Private fields
+            std::shared_ptr<HttpConnection> m_connection;
+            boost::beast::file m_file;
+            uint64_t m_offset;
+            uint64_t m_remaining;
+            BufferPool& m_pool;
+            BufferPoolBlock m_block{};
+
+            http::response<http::empty_body> m_header{};
+            std::optional<http::response_serializer<http::empty_body>> m_serializer{};
+    };
+
+    void HttpConnection::SendFileResponse(boost::beast::file file, uint64_t offset, uint64_t length) {
+        if (!IsValid())
+            return;
+
+        m_response.body().clear();
+        m_response.content_length(length);
+        PrepareResponseHeaders();
+
+        // the response to HEAD has the headers of the response to GET, but no body
+        const uint64_t bodyLength = m_request.method() == http::verb::head ? 0 : length;
+
+        auto response = std::make_shared<HttpFileResponse>(std::static_pointer_cast<HttpConnection>(shared_from_this()), std::move(file), offset, bodyLength,
+                                                           m_server->m_sendBufferPool);
+        response->Start(std::move(m_response.base()));
+    }
+
+    // ================================================================================
+    // =  HttpStaticFiles                                                             =
+    // ================================================================================
+
+    HttpStaticFiles::HttpStaticFiles(HttpStaticFilesSettings settings) : m_settings(std::move(settings)) {
+        boost::system::error_code error;
+
+        if (!boost::filesystem::is_directory(m_settings.RootDirectory, error))
+            throw HttpStaticFilesException("the static files directory " + m_settings.RootDirectory + " does not exist");
+    }
+
+    void HttpStaticFiles::Serve(const std::shared_ptr<HttpConnection>& connection, std::string_view path) {
+        auto& response = connection->GetResponse();
+
+        // the ETags and the byte ranges refer to the bytes on the disk
+        connection->SetCompressionAllowed(false);
+
+        if (!_IsSafePath(path)) {
+            response.result(http::status::not_found);
+            connection->SendResponse();
+            return;
+        }
+
+        const std::string relativePath(path);
+        uint64_t offset = 0;
+        uint64_t length = 0;
+
+        if (std::shared_ptr<const CachedFile> cachedFile = FindCachedFile(relativePath)) {
+            m_cacheHits.fetch_add(1, std::memory_order_relaxed);
+
+            if (PrepareResponse(*connection, path, cachedFile->ETag, cachedFile->Version.Size, offset, length))
+                response.body().assign(cachedFile->Content, static_cast<size_t>(offset), static_cast<size_t>(length));
+
+            connection->SendResponse();
+            return;
+        }
+
+        const boost::filesystem::path filePath = boost::filesystem::path(m_settings.RootDirectory) / relativePath;
+        boost::system::error_code error;
+
+        if (!boost::filesystem::is_regular_file(filePath, error)) {
+            response.result(http::status::not_found);
+            connection->SendResponse();
+            return;
+        }
+
+        FileVersion version{};
+        version.Size = boost::filesystem::file_size(filePath, error);
+
+        if (!error)
+            version.ModificationTime = boost::filesystem::last_write_time(filePath, error);
+
+        boost::beast::file file;
+        if (!error)
+            file.open(filePath.string().c_str(), boost::beast::file_mode::read, error);
+
+        if (error) {
+            response.result(http::status::not_found);
+            connection->SendResponse();
+            return;
+        }
+
+        m_cacheMisses.fetch_add(1, std::memory_order_relaxed);
+        std::string eTag = _CreateETag(version.Size, version.ModificationTime);
+
+        if (version.Size <= m_settings.MaxCachedFileSize) {
+            auto cachedFile = std::make_shared<CachedFile>();
+            cachedFile->Path = relativePath;
+            cachedFile->Version = version;
+            cachedFile->ETag = std::move(eTag);
+            cachedFile->Content.resize(static_cast<size_t>(version.Size));
+
+            const size_t read = cachedFile->Content.empty() ? 0 : file.read(cachedFile->Content.data(), cachedFile->Content.size(), error);
+
+            if (error || read != cachedFile->Content.size()) {
+                response.result(http::status::internal_server_error);
+                connection->SendResponse();
+                return;
+            }
+
+            if (PrepareResponse(*connection, path, cachedFile->ETag, version.Size, offset, length))
+                response.body().assign(cachedFile->Content, static_cast<size_t>(offset), static_cast<size_t>(length));
+
+            AddCachedFile(std::move(cachedFile));
+            connection->SendResponse();
+            return;
+        }
+
+        if (PrepareResponse(*connection, path, eTag, version.Size, offset, length))
+            connection->SendFileResponse(std::move(file), offset, length);
+        else
+            connection->SendResponse();
+    }
+
+    bool HttpStaticFiles::PrepareResponse(HttpConnection& connection, std::string_view path, const std::string& eTag, uint64_t size, uint64_t& offset,
+                                          uint64_t& length) {
+        const auto& request = connection.GetRequest();
+        auto& response = connection.GetResponse();
+
+        const std::string_view contentType = _GetContentType(path);
+        response.set(http::field::content_type, boost::beast::string_view(contentType.data(), contentType.size()));
+        response.set(http::field::etag, eTag);
+        response.set(http::field::cache_control, "public, max-age=" + std::to_string(m_settings.MaxAge));
+        response.set(http::field::accept_ranges, "bytes");
+
+        const auto ifNoneMatch = request[http::field::if_none_match];
+        if (!ifNoneMatch.empty() && _MatchesETag(std::string_view(ifNoneMatch.data(), ifNoneMatch.size()), eTag)) {
+            m_notModifiedResponses.fetch_add(1, std::memory_order_relaxed);
+            response.result(http::status::not_modified);
+            return false;
+        }
+
+        offset = 0;
+        length = size;
+        response.result(http::status::ok);
+
+        const auto range = request[http::field::range];
+        const auto ifRange = request[http::field::if_range];
+
+        // If-Range with a different ETag (or a date, which is never sent for these files) means the whole file
+        if (range.empty() || (!ifRange.empty() && std::string_view(ifRange.data(), ifRange.size()) != eTag))
+            return true;
+
+        switch (_ParseRange(std::string_view(range.data(), range.size()), size, offset, length)) {
+            case _RangeResult::None:
+                offset = 0;
+                length = size;
+                return true;
+
+            case _RangeResult::Unsatisfiable:
+                response.result(http::status::range_not_satisfiable);
+                response.set(http::field::content_range, "bytes */" + std::to_string(size));
+                return false;
+
+            case _RangeResult::Satisfiable:
+                m_partialResponses.fetch_add(1, std::memory_order_relaxed);
+                response.result(http::status::partial_content);
+                response.set(http::field::content_range,
+                             "bytes " + std::to_string(offset) + "-" + std::to_string(offset + length - 1) + "/" + std::to_string(size));
+                return true;
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<const HttpStaticFiles::CachedFile> HttpStaticFiles::FindCachedFile(const std::string& path) {
+        std::shared_ptr<CachedFile> file;
+
+        {
+            std::scoped_lock lock(m_cacheMutex);
+
+            const auto iterator = m_cacheIndex.find(path);
+            if (iterator == m_cacheIndex.end())
+                return nullptr;
+
+            m_cache.splice(m_cache.begin(), m_cache, iterator->second);
+            file = *iterator->second;
+
+            if (!IsPast(file->ValidUntil))
+                return file;
+        }
+
+        // the disk is checked without holding the lock, concurrent requests may check it at the same time
+        boost::system::error_code sizeError;
+        boost::system::error_code timeError;
+        const boost::filesystem::path filePath = boost::filesystem::path(m_settings.RootDirectory) / path;
+        const uint64_t size = boost::filesystem::file_size(filePath, sizeError);
+        const std::time_t modificationTime = boost::filesystem::last_write_time(filePath, timeError);
+
+        if (sizeError || timeError || size != file->Version.Size || modificationTime != file->Version.ModificationTime) {
+            RemoveCachedFile(path);
+            return nullptr;
+        }
+
+        std::scoped_lock lock(m_cacheMutex);
+        file->ValidUntil = DefaultClock::now() + RevalidateInterval;
+        return file;
+    }
+
+    void HttpStaticFiles::AddCachedFile(std::shared_ptr<CachedFile> file) {
+        const size_t size = file->Content.size();
+
+        if (size > m_settings.MaxCacheSize)
+            return;
+
+        file->ValidUntil = DefaultClock::now() + RevalidateInterval;
+
+        std::scoped_lock lock(m_cacheMutex);
+
+        // another request might have cached the file in the meantime
+        if (const auto iterator = m_cacheIndex.find(file->Path); iterator != m_cacheIndex.end()) {
+            m_cachedBytes -= (*iterator->second)->Content.size();
+            m_cache.erase(iterator->second);
+            m_cacheIndex.erase(iterator);
+        }
+
+        while (!m_cache.empty() && m_cachedBytes + size > m_settings.MaxCacheSize) {
+            const std::shared_ptr<CachedFile>& evicted = m_cache.back();
+            m_cachedBytes -= evicted->Content.size();
+            m_cacheIndex.erase(evicted->Path);
+            m_cache.pop_back();
+        }
+
+        m_cache.push_front(file);
+        m_cacheIndex.emplace(file->Path, m_cache.begin());
+        m_cachedBytes += size;
+    }
+
+    void HttpStaticFiles::RemoveCachedFile(const std::string& path) {
+        std::scoped_lock lock(m_cacheMutex);
+
+        const auto iterator = m_cacheIndex.find(path);
+        if (iterator == m_cacheIndex.end())
+            return;
+
+        m_cachedBytes -= (*iterator->second)->Content.size();
+        m_cache.erase(iterator->second);
+        m_cacheIndex.erase(iterator);
+    }
+
+    const HttpStaticFilesSettings& HttpStaticFiles::GetSettings() const noexcept {
+        return m_settings;
+    }
+
+    HttpStaticFilesStatistics HttpStaticFiles::GetStatistics() const {
+        std::scoped_lock lock(m_cacheMutex);
+
+        return HttpStaticFilesStatistics{
+                m_cacheHits.load(std::memory_order_relaxed),
+                m_cacheMisses.load(std::memory_order_relaxed),
+                m_notModifiedResponses.load(std::memory_order_relaxed),
+                m_partialResponses.load(std::memory_order_relaxed),
+                m_cache.size(),
+                m_cachedBytes,
+        };
+    }
+}
@@ -52,8 +52,18 @@ namespace Merrie {
     void NetworkServer::Stop() {
         m_work.reset();
 
-        if (m_acceptor.is_open())
-            m_acceptor.close();
+        // the acceptor and the sockets are not thread-safe, they are closed from the I/O threads, each socket from its strand
+        boost::asio::post(m_ioContext, [this]() {
+            boost::system::error_code ignored;
+
+            if (m_acceptor.is_open())
+                m_acceptor.close(ignored);
+
+            std::scoped_lock lock(m_connectionsMutex);
+            for (const std::shared_ptr<NetworkConnection>& connection : m_connections) {
+                CloseConnection(connection);
+            }
+        });
 
         m_running = false;
     }
@@ -66,6 +76,10 @@ namespace Merrie {
         return m_endpoint;
     }
 
+    boost::asio::io_context& NetworkServer::GetIoContext() noexcept {
+        return m_ioContext;
+    }
+
     bool NetworkServer::IsRunning() const noexcept {
         return true;
     }
@@ -76,7 +90,10 @@ namespace Merrie {
 
         m_acceptor.async_accept(socket, [this, networkConnection = std::move(networkConnection)](const boost::system::error_code& error) mutable {
             HandleNewConnection(error, std::move(networkConnection));
-            StartAccept();
+
+            // the aborted accept may complete on another worker while Stop() is still closing the acceptor, so is_open() alone is not enough
+            if (error != boost::asio::error::operation_aborted && m_acceptor.is_open())
+                StartAccept();
         });
     }
 
@@ -86,7 +103,15 @@ namespace Merrie {
             return;
         }
 
-        connection->m_remoteEndpoint = connection->GetSocket().remote_endpoint();
+        boost::system::error_code endpointError;
+        const tcp::endpoint remoteEndpoint = connection->GetSocket().remote_endpoint(endpointError);
+
+        // the client has already disconnected
+        if (endpointError) {
+            return;
+        }
+
+        connection->m_remoteEndpoint = remoteEndpoint;
         M_LOG_TRACE_THIS("New connection has connected: " << connection->GetRemoteEndpoint().value());
 
         std::scoped_lock lock(m_connectionsMutex);
@@ -95,10 +120,7 @@ namespace Merrie {
                 return false;
             }
 
-            if (connection->GetSocket().is_open()) {
-                boost::system::error_code ignored;
-                connection->GetSocket().close(ignored);
-            }
+            CloseConnection(connection);
 
             #ifdef M_ENABLE_TRACE
             const auto remoteEndpoint = connection->GetRemoteEndpoint();
@@ -115,7 +137,16 @@ namespace Merrie {
         ReadData(std::move(connection));
     }
 
-    NetworkConnection::NetworkConnection(boost::asio::io_context& ioContext) : m_socket(ioContext) {
+    void NetworkServer::CloseConnection(const std::shared_ptr<NetworkConnection>& connection) {
+        boost::asio::post(connection->GetStrand(), [connection]() {
+            boost::system::error_code ignored;
+
+            if (connection->GetSocket().is_open())
+                connection->GetSocket().close(ignored);
+        });
+    }
+
+    NetworkConnection::NetworkConnection(boost::asio::io_context& ioContext) : m_strand(boost::asio::make_strand(ioContext)), m_socket(m_strand) {
     }
 
     tcp::socket& NetworkConnection::GetSocket() {
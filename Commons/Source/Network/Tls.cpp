@@ -0,0 +1,106 @@
+#include <Commons/Network/Tls.hpp>
+
+#ifdef M_HAS_OPENSSL_SSL
+
+#include <openssl/ssl.h>
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * Identifies the sessions of this server in the session cache, clients can only resume sessions with the same id context.
+         */
+        constexpr const unsigned char SessionIdContext[] = "Merrie";
+
+        ssl::context _CreateSslContext(const TlsSettings& settings) {
+            ssl::context context(ssl::context::tls_server);
+
+            try {
+                context.set_options(ssl::context::default_workarounds | ssl::context::no_sslv2 | ssl::context::no_sslv3 | ssl::context::no_tlsv1 |
+                                    ssl::context::no_tlsv1_1 | ssl::context::single_dh_use);
+                context.use_certificate_chain_file(settings.CertificateChainFile);
+                context.use_private_key_file(settings.PrivateKeyFile, ssl::context::pem);
+            }
+            catch (const boost::system::system_error& e) {
+                throw TlsException("failed to load the certificate: "s + e.what());
+            }
+
+            SSL_CTX* handle = context.native_handle();
+
+            // the session cache is shared by all the connections, no matter which thread they are handled on
+            SSL_CTX_set_session_cache_mode(handle, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_set_session_id_context(handle, SessionIdContext, sizeof(SessionIdContext) - 1);
+
+            if (settings.SessionCacheSize != 0)
+                SSL_CTX_sess_set_cache_size(handle, static_cast<long>(settings.SessionCacheSize));
+
+            if (settings.SessionTimeout != 0)
+                SSL_CTX_set_timeout(handle, static_cast<long>(settings.SessionTimeout));
+
+            if (settings.SessionTickets)
+                SSL_CTX_clear_options(handle, SSL_OP_NO_TICKET);
+            else
+                SSL_CTX_set_options(handle, SSL_OP_NO_TICKET);
+
+            return context;
+        }
+    }
+
+    TlsServerContext::TlsServerContext(const TlsSettings& settings)
+            : m_maxPendingHandshakes(settings.MaxPendingHandshakes),
+              m_context(_CreateSslContext(settings)) {
+
+        if (settings.HandshakeThreadCount != 0)
+            m_handshakePool = std::make_unique<boost::asio::thread_pool>(settings.HandshakeThreadCount);
+    }
+
+    TlsServerContext::~TlsServerContext() {
+        if (m_handshakePool) {
+            m_handshakePool->stop();
+            m_handshakePool->join();
+        }
+    }
+
+    ssl::context& TlsServerContext::GetSslContext() noexcept {
+        return m_context;
+    }
+
+    boost::asio::thread_pool* TlsServerContext::GetHandshakePool() noexcept {
+        return m_handshakePool.get();
+    }
+
+    bool TlsServerContext::TryBeginHandshake() noexcept {
+        const uint64_t pending = m_pendingHandshakes.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_maxPendingHandshakes != 0 && pending >= m_maxPendingHandshakes) {
+            m_pendingHandshakes.fetch_sub(1, std::memory_order_relaxed);
+            m_rejectedHandshakes.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    void TlsServerContext::EndHandshake(bool success, bool resumed) noexcept {
+        m_pendingHandshakes.fetch_sub(1, std::memory_order_relaxed);
+
+        if (!success)
+            m_failedHandshakes.fetch_add(1, std::memory_order_relaxed);
+        else if (resumed)
+            m_resumedHandshakes.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_fullHandshakes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    TlsStatistics TlsServerContext::GetStatistics() const noexcept {
+        return TlsStatistics{
+                m_fullHandshakes.load(std::memory_order_relaxed),
+                m_resumedHandshakes.load(std::memory_order_relaxed),
+                m_failedHandshakes.load(std::memory_order_relaxed),
+                m_rejectedHandshakes.load(std::memory_order_relaxed),
+                m_pendingHandshakes.load(std::memory_order_relaxed),
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,244 @@
+#include <Commons/Network/WebSocket.hpp>
+
+#include <cstring>
+
+#ifdef M_HAS_OPENSSL_SSL
+#include <boost/beast/websocket/ssl.hpp>
+#endif
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * A WebSocketConnection over the given next layer stream.
+         */
+        template<typename NextLayer>
+        class _BasicWebSocketConnection final : public WebSocketConnection {
+            public: // Constructors & destructors
+                _BasicWebSocketConnection(std::shared_ptr<HttpConnection> connection, WebSocketCallbacks callbacks, NextLayer& nextLayer, BufferPool& pool,
+                                          std::chrono::seconds handshakeTimeout, std::chrono::seconds idleTimeout)
+                        : WebSocketConnection(std::move(connection), std::move(callbacks)),
+                          m_stream(nextLayer),
+                          m_buffer(pool, MaxMessageSize + BufferPool::SmallestBlockSize),
+                          m_handshakeTimeout(handshakeTimeout),
+                          m_idleTimeout(idleTimeout) {
+                }
+
+            protected: // Protected methods
+                void Start(const http::request<http::string_body>& request) override {
+                    websocket::stream_base::timeout timeout{};
+                    timeout.handshake_timeout = m_handshakeTimeout;
+                    timeout.idle_timeout = m_idleTimeout.count() != 0 ? m_idleTimeout : websocket::stream_base::none();
+                    timeout.keep_alive_pings = m_idleTimeout.count() != 0;
+
+                    m_stream.set_option(timeout);
+                    m_stream.read_message_max(MaxMessageSize);
+                    m_stream.text(true);
+
+                    m_stream.async_accept(request, boost::asio::bind_executor(m_strand, [this, self = shared_from_this()](boost::beast::error_code error) {
+                        OnAccepted(error);
+                    }));
+                }
+
+                void DoRead() override {
+                    // websocket::stream::async_read borrows the receive buffer before it starts reading, so the first byte of the
+                    // message is read on its own and the idle connections hold no receive memory, the control frames like the
+                    // pongs answering the keep-alive pings are handled without it
+                    m_stream.async_read_some(boost::asio::buffer(&m_firstByte, 1), boost::asio::bind_executor(m_strand, [this, self = shared_from_this()](boost::beast::error_code error, std::size_t bytesTransferred) {
+                        if (error) {
+                            OnRead(error, {});
+                            return;
+                        }
+
+                        if (m_stream.is_message_done()) {
+                            OnRead(error, std::string(&m_firstByte, bytesTransferred));
+                            return;
+                        }
+
+                        std::memcpy(m_buffer.prepare(bytesTransferred).data(), &m_firstByte, bytesTransferred);
+                        m_buffer.commit(bytesTransferred);
+                        ReadRest();
+                    }));
+                }
+
+                void DoWrite(const std::string& message) override {
+                    m_stream.async_write(boost::asio::buffer(message), boost::asio::bind_executor(m_strand, [this, self = shared_from_this()](boost::beast::error_code error, std::size_t) {
+                        OnWritten(error);
+                    }));
+                }
+
+                void DoClose() override {
+                    m_stream.async_close(websocket::close_code::normal, boost::asio::bind_executor(m_strand, [this, self = shared_from_this()](boost::beast::error_code) {
+                        OnClosed();
+                    }));
+                }
+
+            private: // Private methods
+                void ReadRest() {
+                    m_stream.async_read(m_buffer, boost::asio::bind_executor(m_strand, [this, self = shared_from_this()](boost::beast::error_code error, std::size_t) {
+                        std::string message;
+
+                        if (!error) {
+                            const auto data = m_buffer.data();
+                            message.assign(static_cast<const char*>(data.data()), data.size());
+                        }
+
+                        m_buffer.consume(m_buffer.size());
+                        m_buffer.ReleaseIfEmpty();
+
+                        OnRead(error, std::move(message));
+                    }));
+                }
+
+            private: // Private fields
+                websocket::stream<NextLayer&> m_stream;
+                PooledFlatBuffer m_buffer;
+                char m_firstByte{};
+                const std::chrono::seconds m_handshakeTimeout;
+                const std::chrono::seconds m_idleTimeout;
+        };
+    }
+
+    // ================================================================================
+    // =  WebSocketConnection                                                         =
+    // ================================================================================
+
+    WebSocketConnection::WebSocketConnection(std::shared_ptr<HttpConnection> connection, WebSocketCallbacks callbacks)
+            : m_strand(connection->GetStrand()),
+              m_connection(std::move(connection)),
+              m_callbacks(std::move(callbacks)) {
+    }
+
+    void WebSocketConnection::Send(std::string message) {
+        Send(std::make_shared<const std::string>(std::move(message)));
+    }
+
+    void WebSocketConnection::Send(std::shared_ptr<const std::string> message) {
+        boost::asio::post(m_strand, [self = shared_from_this(), message = std::move(message)]() mutable {
+            if (self->m_closed || self->m_closeRequested)
+                return;
+
+            self->m_queue.emplace_back(std::move(message));
+
+            if (!self->m_writing)
+                self->WriteNext();
+        });
+    }
+
+    void WebSocketConnection::Close() {
+        boost::asio::post(m_strand, [self = shared_from_this()] {
+            if (self->m_closed || self->m_closeRequested)
+                return;
+
+            self->m_closeRequested = true;
+
+            if (!self->m_writing)
+                self->DoClose();
+        });
+    }
+
+    bool WebSocketConnection::IsOpen() const noexcept {
+        return m_open.load(std::memory_order_acquire);
+    }
+
+    const std::shared_ptr<HttpConnection>& WebSocketConnection::GetHttpConnection() const noexcept {
+        return m_connection;
+    }
+
+    void WebSocketConnection::OnAccepted(boost::beast::error_code error) {
+        if (error) {
+            m_closed = true;
+            m_connection->m_invalidated = true;
+            return;
+        }
+
+        m_open.store(true, std::memory_order_release);
+        DoRead();
+    }
+
+    void WebSocketConnection::OnRead(boost::beast::error_code error, std::string message) {
+        if (error) {
+            OnClosed();
+            return;
+        }
+
+        if (m_callbacks.OnMessage)
+            m_callbacks.OnMessage(shared_from_this(), std::move(message));
+
+        DoRead();
+    }
+
+    void WebSocketConnection::OnWritten(boost::beast::error_code error) {
+        if (error) {
+            OnClosed();
+            return;
+        }
+
+        m_queue.pop_front();
+        WriteNext();
+    }
+
+    void WebSocketConnection::OnClosed() {
+        if (m_closed)
+            return;
+
+        m_closed = true;
+        m_open.store(false, std::memory_order_release);
+        m_queue.clear();
+
+        // the socket is closed by the NetworkServer once the connection is invalid
+        m_connection->m_invalidated = true;
+
+        if (m_callbacks.OnClose)
+            m_callbacks.OnClose(shared_from_this());
+    }
+
+    void WebSocketConnection::WriteNext() {
+        if (m_closed)
+            return;
+
+        if (m_queue.empty()) {
+            m_writing = false;
+
+            if (m_closeRequested)
+                DoClose();
+
+            return;
+        }
+
+        m_writing = true;
+        DoWrite(*m_queue.front());
+    }
+
+    // ================================================================================
+    // =  HttpConnection                                                              =
+    // ================================================================================
+
+    bool HttpConnection::IsWebSocketUpgrade() const {
+        return websocket::is_upgrade(m_request);
+    }
+
+    std::shared_ptr<WebSocketConnection> HttpConnection::UpgradeToWebSocket(WebSocketCallbacks callbacks) {
+        if (!IsValid() || !IsWebSocketUpgrade())
+            return nullptr;
+
+        const HttpServerSettings& settings = m_server->m_settings;
+        const std::chrono::seconds handshakeTimeout(settings.RequestTimeout);
+        const std::chrono::seconds idleTimeout(settings.KeepAliveTimeout);
+
+        std::shared_ptr<WebSocketConnection> connection;
+
+        VisitStream([&](auto& stream) {
+            using NextLayer = std::remove_reference_t<decltype(stream)>;
+
+            connection = std::make_shared<_BasicWebSocketConnection<NextLayer>>(
+                    std::static_pointer_cast<HttpConnection>(shared_from_this()), std::move(callbacks), stream, m_server->m_receiveBufferPool,
+                    handshakeTimeout, idleTimeout);
+        });
+
+        // the WebSocketConnection owns the socket from now on, the HTTP timeouts no longer apply
+        m_upgraded = true;
+        connection->Start(m_request);
+        return connection;
+    }
+}
@@ -0,0 +1,463 @@
+#include <Commons/Storage/AppendLogStore.hpp>
+
+#include <boost/filesystem.hpp>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * The header of a record, followed by the value.
+         */
+        struct _RecordHeader {
+            uint32_t Checksum; // of the rest of the header and of the value
+            uint32_t Size; // of the value, c_erased for the removals
+            uint64_t Key;
+        };
+
+        static_assert(sizeof(_RecordHeader) == 16, "The records are written as they are in memory");
+
+        constexpr const uint32_t c_erased = std::numeric_limits<uint32_t>::max();
+
+        // the snapshot is written under a temporary name and renamed once it is complete
+        constexpr const char* c_snapshotName = "snapshot";
+        constexpr const char* c_temporarySnapshotName = "snapshot.tmp";
+        constexpr const char* c_logName = "log";
+
+        uint32_t _Checksum(const _RecordHeader& header, std::string_view value) noexcept {
+            // FNV-1a, only torn and damaged records have to be told apart
+            uint32_t hash = 2166136261u;
+
+            const auto add = [&hash](const void* data, size_t size) {
+                const auto* bytes = static_cast<const unsigned char*>(data);
+
+                for (size_t i = 0; i < size; i++) {
+                    hash = (hash ^ bytes[i]) * 16777619u;
+                }
+            };
+
+            add(&header.Size, sizeof(header.Size));
+            add(&header.Key, sizeof(header.Key));
+            add(value.data(), value.size());
+            return hash;
+        }
+
+        void _AppendRecord(std::string& buffer, uint64_t key, const std::optional<std::string>& value) {
+            _RecordHeader header{0, value ? static_cast<uint32_t>(value->size()) : c_erased, key};
+            header.Checksum = _Checksum(header, value ? std::string_view(*value) : std::string_view());
+
+            buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+            if (value)
+                buffer += *value;
+        }
+
+        std::string _GetErrorMessage(const std::string& action) {
+            return action + ": " + std::strerror(errno);
+        }
+
+        int _OpenFile(const boost::filesystem::path& path, int flags) {
+            const int descriptor = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+            if (descriptor < 0)
+                throw StorageException(_GetErrorMessage("cannot open " + path.string()));
+
+            return descriptor;
+        }
+
+        /**
+         * Writes the whole buffer at the end of the file.
+         */
+        bool _WriteAll(int descriptor, std::string_view buffer) {
+            while (!buffer.empty()) {
+                const ssize_t written = ::write(descriptor, buffer.data(), buffer.size());
+
+                if (written < 0) {
+                    if (errno == EINTR)
+                        continue;
+
+                    return false;
+                }
+
+                buffer.remove_prefix(static_cast<size_t>(written));
+            }
+
+            return true;
+        }
+
+        /**
+         * Reads up to size bytes at the offset, less only at the end of the file.
+         */
+        size_t _ReadAt(int descriptor, char* data, size_t size, uint64_t offset) {
+            size_t done = 0;
+
+            while (done < size) {
+                const ssize_t read = ::pread(descriptor, data + done, size - done, static_cast<off_t>(offset + done));
+
+                if (read < 0) {
+                    if (errno == EINTR)
+                        continue;
+
+                    throw StorageException(_GetErrorMessage("cannot read"));
+                }
+
+                if (read == 0)
+                    break;
+
+                done += static_cast<size_t>(read);
+            }
+
+            return done;
+        }
+
+        bool _SyncDirectory(const std::string& directory) {
+            const int descriptor = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (descriptor < 0)
+                return false;
+
+            const bool synced = ::fsync(descriptor) == 0;
+            ::close(descriptor);
+            return synced;
+        }
+    }
+
+    AppendLogStore::AppendLogStore(AppendLogStoreSettings settings) : m_settings(std::move(settings)) {
+        const boost::filesystem::path directory(m_settings.Directory);
+
+        try {
+            boost::filesystem::create_directories(directory);
+            boost::filesystem::remove(directory / c_temporarySnapshotName);
+        } catch (const boost::filesystem::filesystem_error& e) {
+            throw StorageException("cannot prepare the directory "s + m_settings.Directory + ": " + e.what());
+        }
+
+        m_snapshotFile = _OpenFile(directory / c_snapshotName, O_RDWR | O_CREAT);
+        m_logFile = _OpenFile(directory / c_logName, O_RDWR | O_CREAT | O_APPEND);
+
+        // the log is read after the snapshot, its records are newer
+        m_snapshotSize = ReadFile(File::Snapshot, m_snapshotFile);
+        m_logSize = ReadFile(File::Log, m_logFile);
+
+        const auto logFileSize = static_cast<uint64_t>(::lseek(m_logFile, 0, SEEK_END));
+        if (logFileSize != m_logSize) {
+            M_LOG_WARNING_THIS << "Cutting off " << logFileSize - m_logSize << " bytes of a torn record at the end of the log";
+
+            if (::ftruncate(m_logFile, static_cast<off_t>(m_logSize)) != 0)
+                throw StorageException(_GetErrorMessage("cannot cut off the torn record"));
+        }
+
+        m_statistics.Keys = m_index.size();
+        m_statistics.LogSize = m_logSize;
+        m_statistics.SnapshotSize = m_snapshotSize;
+        m_writer = std::thread(&AppendLogStore::RunWriter, this);
+    }
+
+    AppendLogStore::~AppendLogStore() {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_changesQueued.notify_one();
+        m_writer.join();
+
+        ::close(m_snapshotFile);
+        ::close(m_logFile);
+    }
+
+    void AppendLogStore::Put(Key key, std::string value) {
+        M_ASSERT(value.size() < c_erased, "The value is too big");
+
+        {
+            std::scoped_lock lock(m_mutex);
+            m_queued.insert_or_assign(key, std::move(value));
+        }
+
+        m_changesQueued.notify_one();
+    }
+
+    void AppendLogStore::Erase(Key key) {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_queued.insert_or_assign(key, std::nullopt);
+        }
+
+        m_changesQueued.notify_one();
+    }
+
+    std::optional<std::string> AppendLogStore::Load(Key key) const {
+        {
+            std::scoped_lock lock(m_mutex);
+
+            for (const Changes* changes : {&m_queued, &m_writing}) {
+                const auto iterator = changes->find(key);
+                if (iterator != changes->end())
+                    return iterator->second;
+            }
+        }
+
+        std::shared_lock lock(m_indexMutex);
+        const auto iterator = m_index.find(key);
+
+        if (iterator == m_index.end())
+            return std::nullopt;
+
+        return ReadValue(iterator->second);
+    }
+
+    void AppendLogStore::Flush() {
+        std::unique_lock lock(m_mutex);
+
+        // the queued changes go into the batch after the ones that were started
+        const uint64_t batch = m_startedBatches + (m_queued.empty() ? 0 : 1);
+
+        m_batchWritten.wait(lock, [this, batch] {
+            return m_writtenBatches >= batch || m_stopping;
+        });
+    }
+
+    const AppendLogStoreSettings& AppendLogStore::GetSettings() const noexcept {
+        return m_settings;
+    }
+
+    AppendLogStoreStatistics AppendLogStore::GetStatistics() const {
+        std::scoped_lock lock(m_mutex);
+        return m_statistics;
+    }
+
+    uint64_t AppendLogStore::ReadFile(File file, int descriptor) {
+        struct stat status{};
+        if (::fstat(descriptor, &status) != 0)
+            throw StorageException(_GetErrorMessage("cannot get the size of the file"));
+
+        const auto fileSize = static_cast<uint64_t>(status.st_size);
+        std::vector<char> buffer(1024 * 1024);
+        uint64_t bufferOffset = 0; // offset of the buffer in the file
+        size_t start = 0;
+        size_t end = 0;
+
+        // makes the size bytes after the start available in the buffer
+        const auto fill = [&](size_t size) {
+            if (end - start >= size)
+                return true;
+
+            std::memmove(buffer.data(), buffer.data() + start, end - start);
+            bufferOffset += start;
+            end -= start;
+            start = 0;
+
+            if (buffer.size() < size)
+                buffer.resize(size);
+
+            end += _ReadAt(descriptor, buffer.data() + end, buffer.size() - end, bufferOffset + end);
+            return end >= size;
+        };
+
+        while (fill(sizeof(_RecordHeader))) {
+            _RecordHeader header{};
+            std::memcpy(&header, buffer.data() + start, sizeof(header));
+
+            // the size of a torn or damaged record is garbage, it must not be allocated before the checksum is checked
+            const size_t valueSize = header.Size == c_erased ? 0 : header.Size;
+            if (valueSize > fileSize - bufferOffset - start - sizeof(header) || !fill(sizeof(header) + valueSize))
+                break;
+
+            const std::string_view value(buffer.data() + start + sizeof(header), valueSize);
+            if (_Checksum(header, value) != header.Checksum)
+                break;
+
+            if (header.Size == c_erased) {
+                m_index.erase(header.Key);
+            } else {
+                m_index.insert_or_assign(header.Key, Location{file, header.Size, bufferOffset + start + sizeof(header)});
+            }
+
+            start += sizeof(header) + valueSize;
+        }
+
+        return bufferOffset + start;
+    }
+
+    void AppendLogStore::RunWriter() {
+        std::unique_lock lock(m_mutex);
+
+        while (true) {
+            m_changesQueued.wait(lock, [this] {
+                return !m_queued.empty() || m_stopping;
+            });
+
+            if (m_queued.empty())
+                break;
+
+            // everything queued while the previous batch was written goes into this one
+            std::swap(m_queued, m_writing);
+            m_startedBatches++;
+            lock.unlock();
+
+            const bool written = WriteBatch(m_writing);
+            if (written && m_logSize > m_settings.CompactionThreshold && m_logSize > m_snapshotSize)
+                Compact();
+
+            lock.lock();
+
+            if (!written) {
+                // the changes that were not replaced in the meantime are written with the next batch
+                for (auto& [key, value] : m_writing) {
+                    m_queued.try_emplace(key, std::move(value));
+                }
+
+                m_writing.clear();
+                m_startedBatches--;
+
+                if (m_stopping) {
+                    M_LOG_ERROR_THIS << "Giving up on writing " << m_queued.size() << " changes";
+                    break;
+                }
+
+                M_LOG_ERROR_THIS << "Writing the log failed, retrying in a second";
+                m_changesQueued.wait_for(lock, std::chrono::seconds(1), [this] {
+                    return m_stopping;
+                });
+                continue;
+            }
+
+            m_statistics.Commits++;
+            m_statistics.WrittenRecords += m_writing.size();
+            m_writing.clear();
+            m_writtenBatches++;
+            m_batchWritten.notify_all();
+        }
+
+        m_batchWritten.notify_all();
+    }
+
+    bool AppendLogStore::WriteBatch(const Changes& changes) {
+        std::string buffer;
+        std::vector<std::pair<Key, std::optional<Location>>> locations;
+        locations.reserve(changes.size());
+
+        for (const auto& [key, value] : changes) {
+            const uint64_t offset = m_logSize + buffer.size() + sizeof(_RecordHeader);
+            _AppendRecord(buffer, key, value);
+
+            if (value)
+                locations.emplace_back(key, Location{File::Log, static_cast<uint32_t>(value->size()), offset});
+            else
+                locations.emplace_back(key, std::nullopt);
+        }
+
+        // the group commit, one write and one sync for all changes
+        if (!_WriteAll(m_logFile, buffer) || ::fdatasync(m_logFile) != 0) {
+            M_LOG_ERROR_THIS << _GetErrorMessage("Cannot write the log");
+
+            // a partial record would hide the records written after it
+            if (::ftruncate(m_logFile, static_cast<off_t>(m_logSize)) != 0)
+                M_LOG_ERROR_THIS << _GetErrorMessage("Cannot cut off the partial batch");
+
+            return false;
+        }
+
+        std::unique_lock indexLock(m_indexMutex);
+
+        for (const auto& [key, location] : locations) {
+            if (location)
+                m_index.insert_or_assign(key, *location);
+            else
+                m_index.erase(key);
+        }
+
+        m_logSize += buffer.size();
+        indexLock.unlock();
+
+        std::scoped_lock lock(m_mutex);
+        m_statistics.Keys = m_index.size();
+        m_statistics.LogSize = m_logSize;
+        return true;
+    }
+
+    bool AppendLogStore::Compact() {
+        const boost::filesystem::path directory(m_settings.Directory);
+        const boost::filesystem::path temporaryPath = directory / c_temporarySnapshotName;
+
+        int snapshot = -1;
+        std::unordered_map<Key, Location> index;
+        uint64_t snapshotSize = 0;
+
+        try {
+            snapshot = _OpenFile(temporaryPath, O_RDWR | O_CREAT | O_TRUNC | O_APPEND);
+
+            // the writer thread is the only one that changes the index, it stays the same while it is copied
+            std::shared_lock indexLock(m_indexMutex);
+            index.reserve(m_index.size());
+
+            std::string buffer;
+            for (const auto& [key, location] : m_index) {
+                const std::optional<std::string> value = ReadValue(location);
+
+                index.emplace(key, Location{File::Snapshot, location.Size, snapshotSize + buffer.size() + sizeof(_RecordHeader)});
+                _AppendRecord(buffer, key, value);
+
+                if (buffer.size() >= 1024 * 1024) {
+                    if (!_WriteAll(snapshot, buffer))
+                        throw StorageException(_GetErrorMessage("cannot write the snapshot"));
+
+                    snapshotSize += buffer.size();
+                    buffer.clear();
+                }
+            }
+
+            if (!_WriteAll(snapshot, buffer) || ::fsync(snapshot) != 0)
+                throw StorageException(_GetErrorMessage("cannot write the snapshot"));
+
+            snapshotSize += buffer.size();
+        } catch (const StorageException& e) {
+            M_LOG_ERROR_THIS << "Compaction failed, " << e.what();
+
+            if (snapshot >= 0)
+                ::close(snapshot);
+
+            return false;
+        }
+
+        // the old log stays valid over the new snapshot until it is emptied, the values are the same
+        if (::rename(temporaryPath.c_str(), (directory / c_snapshotName).c_str()) != 0 || !_SyncDirectory(m_settings.Directory)) {
+            M_LOG_ERROR_THIS << _GetErrorMessage("Compaction failed, cannot replace the snapshot");
+            ::close(snapshot);
+            return false;
+        }
+
+        {
+            std::unique_lock indexLock(m_indexMutex);
+            ::close(m_snapshotFile);
+            m_snapshotFile = snapshot;
+            m_snapshotSize = snapshotSize;
+            m_index.swap(index);
+
+            if (::ftruncate(m_logFile, 0) != 0 || ::fsync(m_logFile) != 0)
+                M_LOG_ERROR_THIS << _GetErrorMessage("Cannot empty the log");
+
+            m_logSize = static_cast<uint64_t>(::lseek(m_logFile, 0, SEEK_END));
+        }
+
+        std::scoped_lock lock(m_mutex);
+        m_statistics.Compactions++;
+        m_statistics.LogSize = m_logSize;
+        m_statistics.SnapshotSize = m_snapshotSize;
+        return true;
+    }
+
+    std::string AppendLogStore::ReadValue(const Location& location) const {
+        std::string value(location.Size, '\0');
+
+        if (_ReadAt(GetDescriptor(location.File_), value.data(), value.size(), location.Offset) != value.size())
+            throw StorageException("the value ends after the end of the file");
+
+        return value;
+    }
+
+    int AppendLogStore::GetDescriptor(File file) const noexcept {
+        return file == File::Snapshot ? m_snapshotFile : m_logFile;
+    }
+}
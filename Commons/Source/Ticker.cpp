@@ -105,6 +105,7 @@ namespace Merrie {
         m_lastTick = m_tickSection = Ticker::TimeNow();
         m_catchupTime = 0;
         m_tasks.clear();
+        m_endOfTickTasks.clear();
         SetTps(GetTps());
     }
 
@@ -181,6 +182,13 @@ namespace Merrie {
         return m_tasks.emplace_back(task);
     }
 
+    std::shared_ptr<Task> Ticker::DoAtEndOfTick(TaskAction action, bool repeat) {
+        auto task = std::make_shared<Task>(GetMainThread(), std::move(action), repeat);
+
+        std::lock_guard<std::mutex> lock(m_taskMutex);
+        return m_endOfTickTasks.emplace_back(task);
+    }
+
     void Ticker::DoTick() {
         EnsureInMainThread();
 
@@ -209,23 +217,30 @@ namespace Merrie {
     }
 
     void Ticker::RunTasks() {
+        RunTasks(m_tasks);
+
+        // the end of tick tasks see everything that the tasks of this tick have done
+        RunTasks(m_endOfTickTasks);
+    }
+
+    void Ticker::RunTasks(std::vector<std::shared_ptr<Task>>& tasks) {
         std::vector<std::shared_ptr<Task>> tasksToDo;
 
         {
             std::scoped_lock lock(m_taskMutex);
-            tasksToDo.insert(end(tasksToDo), begin(m_tasks), std::end(m_tasks));
+            tasksToDo.insert(end(tasksToDo), begin(tasks), std::end(tasks));
 
-            if (m_tasks.empty()) {
+            if (tasks.empty()) {
                 return;
             }
 
             // we already have a lock so why not remove cancelled tasks here
-            m_tasks.erase(
-                    std::remove_if(begin(m_tasks), end(m_tasks), [](const std::shared_ptr<Task>& task) { return task->m_cancelled; }),
-                    end(m_tasks));
+            tasks.erase(
+                    std::remove_if(begin(tasks), end(tasks), [](const std::shared_ptr<Task>& task) { return task->m_cancelled; }),
+                    end(tasks));
 
             // copy task vector, it only makes copies the shared_ptr's so the overhead is very small
-            tasksToDo = m_tasks;
+            tasksToDo = tasks;
         }
 
         for (const std::shared_ptr<Task>& task : tasksToDo) {
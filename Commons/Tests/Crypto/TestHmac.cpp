@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Crypto/Hmac.hpp>
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+#include <Commons/Crypto/OpenSSL.hpp>
+#include <Commons/Crypto/Digest.hpp>
+
+class TestHmac : public ::testing::Test {
+    private:
+        Merrie::OpenSslContext m_context;
+};
+
+TEST_F(TestHmac, TestHmacSha256) {
+    using namespace Merrie;
+
+    // RFC 4231, test cases 2 and 3
+    EXPECT_EQ(DigestToHex(HmacSha256("Jefe", "what do ya want for nothing?")), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    EXPECT_EQ(DigestToHex(HmacSha256(std::string(20, '\xaa'), std::string(50, '\xdd'))), "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe");
+}
+#endif
+
+TEST(TestConstantTimeEquals, TestConstantTimeEquals) {
+    using namespace Merrie;
+
+    EXPECT_TRUE(ConstantTimeEquals("", ""));
+    EXPECT_TRUE(ConstantTimeEquals("abc", "abc"));
+    EXPECT_FALSE(ConstantTimeEquals("abc", "abd"));
+    EXPECT_FALSE(ConstantTimeEquals("abc", "ab"));
+    EXPECT_FALSE(ConstantTimeEquals("", "a"));
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+#include <Commons/Crypto/OpenSSL.hpp>
+#include <Commons/Crypto/PasswordHashing.hpp>
+#include <boost/asio/io_context.hpp>
+#include <thread>
+
+class TestPasswordHashing : public ::testing::Test {
+    private:
+        Merrie::OpenSslContext m_context;
+};
+
+TEST_F(TestPasswordHashing, TestHashAndVerify) {
+    using namespace Merrie;
+
+    const std::string hash = HashPassword("correct horse", 1000);
+    EXPECT_EQ(hash.rfind("pbkdf2-sha256$1000$", 0), 0u);
+    EXPECT_EQ(GetPasswordHashIterations(hash), 1000u);
+
+    EXPECT_TRUE(VerifyPassword("correct horse", hash));
+    EXPECT_FALSE(VerifyPassword("correct horse ", hash));
+    EXPECT_FALSE(VerifyPassword("", hash));
+
+    // the salts differ
+    EXPECT_NE(HashPassword("correct horse", 1000), hash);
+
+    // malformed
+    EXPECT_FALSE(VerifyPassword("correct horse", ""));
+    EXPECT_FALSE(VerifyPassword("correct horse", "pbkdf2-sha256$1000$zz$00"));
+    EXPECT_FALSE(VerifyPassword("correct horse", "pbkdf2-sha256$0$00$00"));
+    EXPECT_EQ(GetPasswordHashIterations("md5$1000$00$00"), 0u);
+
+    EXPECT_GT(MeasurePasswordHashIterations(std::chrono::milliseconds(5)), 0u);
+}
+
+TEST_F(TestPasswordHashing, TestPool) {
+    using namespace Merrie;
+
+    PasswordHashingPool pool({1, 2, 1000, 0});
+    boost::asio::io_context ioContext;
+
+    std::string hash;
+    ASSERT_TRUE(pool.Hash("secret", ioContext.get_executor(), [&hash](std::string result) {
+        hash = std::move(result);
+    }));
+
+    // the results are only delivered by the executor
+    while (pool.GetStatistics().Pending != 0) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_TRUE(hash.empty());
+    ioContext.run();
+    ioContext.restart();
+    EXPECT_TRUE(VerifyPassword("secret", hash));
+    EXPECT_FALSE(pool.NeedsRehash(hash));
+    EXPECT_TRUE(pool.NeedsRehash(HashPassword("secret", 1001)));
+
+    // slow enough that both checks are still pending when the next one comes
+    const std::string slowHash = HashPassword("secret", 200000);
+
+    int valid = 0;
+    int invalid = 0;
+    for (const char* password : {"secret", "wrong"}) {
+        ASSERT_TRUE(pool.Verify(password, slowHash, ioContext.get_executor(), [&valid, &invalid](bool result) {
+            (result ? valid : invalid)++;
+        }));
+    }
+
+    // saturated
+    EXPECT_FALSE(pool.Verify("secret", hash, ioContext.get_executor(), [](bool) {
+        FAIL() << "A rejected check was done";
+    }));
+
+    while (pool.GetStatistics().Pending != 0) {
+        std::this_thread::yield();
+    }
+
+    ioContext.run();
+    EXPECT_EQ(valid, 1);
+    EXPECT_EQ(invalid, 1);
+
+    const PasswordHashingStatistics statistics = pool.GetStatistics();
+    EXPECT_EQ(statistics.Hashed, 1u);
+    EXPECT_EQ(statistics.Verified, 2u);
+    EXPECT_EQ(statistics.Rejected, 1u);
+
+    EXPECT_THROW(PasswordHashingPool({0, 0, 1000, 0}), PasswordHashingException);
+    EXPECT_THROW(PasswordHashingPool({1, 0, 0, 0}), PasswordHashingException);
+    EXPECT_GT(PasswordHashingPool({1, 0, 0, 5}).GetIterations(), 0u);
+}
+#endif
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#ifdef M_HAS_OPENSSL_CRYPTO
+#include <Commons/Crypto/OpenSSL.hpp>
+#include <Commons/Crypto/SessionToken.hpp>
+
+class TestSessionToken : public ::testing::Test {
+    private:
+        Merrie::OpenSslContext m_context;
+};
+
+TEST_F(TestSessionToken, TestSignAndVerify) {
+    using namespace Merrie;
+
+    const SessionTokenSigner signer("secret");
+    const auto expiry = std::chrono::system_clock::now() + std::chrono::hours(1);
+
+    const std::string token = signer.Sign({42, expiry});
+    EXPECT_EQ(token.rfind("42.", 0), 0u);
+
+    const std::optional<SessionToken> session = signer.Verify(token);
+    ASSERT_TRUE(session);
+    EXPECT_EQ(session->Aid, 42u);
+    EXPECT_EQ(session->Expiry, std::chrono::time_point_cast<std::chrono::seconds>(expiry));
+
+    // other secret
+    EXPECT_FALSE(SessionTokenSigner("other").Verify(token));
+
+    // changed account
+    std::string forged = token;
+    forged[1] = '3';
+    EXPECT_FALSE(signer.Verify(forged));
+
+    // changed MAC
+    forged = token;
+    forged.back() = forged.back() == '0' ? '1' : '0';
+    EXPECT_FALSE(signer.Verify(forged));
+
+    // expired
+    EXPECT_FALSE(signer.Verify(signer.Sign({42, std::chrono::system_clock::now() - std::chrono::seconds(1)})));
+
+    // malformed
+    EXPECT_FALSE(signer.Verify(""));
+    EXPECT_FALSE(signer.Verify("42"));
+    EXPECT_FALSE(signer.Verify("42.abc"));
+    EXPECT_FALSE(signer.Verify("x.1." + token.substr(token.rfind('.') + 1)));
+
+    EXPECT_THROW(SessionTokenSigner(""), SessionTokenException);
+}
+#endif
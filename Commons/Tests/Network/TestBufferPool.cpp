@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/BufferPool.hpp>
+#include <cstring>
+
+using namespace Merrie;
+
+TEST(TestBufferPool, TestAcquireAndReuse) {
+    BufferPool pool(1024 * 1024);
+
+    char* first;
+    {
+        BufferPoolBlock block = pool.Acquire(100);
+        EXPECT_EQ(block.GetSize(), BufferPool::SmallestBlockSize) << "Block size was not rounded up to the smallest size class";
+
+        first = block.GetData();
+        EXPECT_EQ(pool.GetStatistics().BorrowedBlocks, 1u);
+        EXPECT_EQ(pool.GetStatistics().CachedBlocks, 0u);
+    }
+
+    EXPECT_EQ(pool.GetStatistics().BorrowedBlocks, 0u);
+    EXPECT_EQ(pool.GetStatistics().CachedBlocks, 1u);
+
+    BufferPoolBlock reused = pool.Acquire(BufferPool::SmallestBlockSize);
+    EXPECT_EQ(reused.GetData(), first) << "Free block was not reused";
+
+    BufferPoolBlock bigger = pool.Acquire(BufferPool::SmallestBlockSize + 1);
+    EXPECT_EQ(bigger.GetSize(), BufferPool::SmallestBlockSize * 2);
+
+    BufferPoolBlock huge = pool.Acquire(BufferPool::LargestBlockSize * 3);
+    EXPECT_EQ(huge.GetSize(), BufferPool::LargestBlockSize * 3) << "Blocks bigger than the largest size class must have the requested size";
+
+    huge.Reset();
+    EXPECT_TRUE(huge.IsEmpty());
+    EXPECT_EQ(pool.GetStatistics().CachedBlocks, 0u) << "Unpooled blocks must not be cached";
+}
+
+TEST(TestBufferPool, TestCacheLimit) {
+    BufferPool pool(BufferPool::SmallestBlockSize * 2);
+
+    {
+        BufferPoolBlock block1 = pool.Acquire(1);
+        BufferPoolBlock block2 = pool.Acquire(1);
+        BufferPoolBlock block3 = pool.Acquire(1);
+    }
+
+    EXPECT_EQ(pool.GetStatistics().CachedBlocks, 2u) << "Pool cached more blocks than allowed";
+    EXPECT_EQ(pool.GetStatistics().CachedBytes, BufferPool::SmallestBlockSize * 2);
+}
+
+TEST(TestBufferPool, TestPooledFlatBuffer) {
+    BufferPool pool(1024 * 1024);
+    PooledFlatBuffer buffer(pool, BufferPool::SmallestBlockSize * 4);
+
+    EXPECT_EQ(buffer.capacity(), 0u) << "Buffer must not hold memory before it is used";
+
+    const std::string text = "GET / HTTP/1.1\r\n";
+    auto prepared = buffer.prepare(text.size());
+    std::memcpy(prepared.data(), text.data(), text.size());
+    buffer.commit(text.size());
+
+    EXPECT_EQ(buffer.size(), text.size());
+    EXPECT_EQ(buffer.capacity(), BufferPool::SmallestBlockSize);
+
+    // growing keeps the readable bytes
+    prepared = buffer.prepare(BufferPool::SmallestBlockSize * 2);
+    buffer.commit(0);
+    EXPECT_EQ(buffer.capacity(), BufferPool::SmallestBlockSize * 4);
+    EXPECT_EQ(std::string(static_cast<const char*>(buffer.data().data()), buffer.size()), text);
+
+    EXPECT_THROW((void) buffer.prepare(BufferPool::SmallestBlockSize * 4), std::length_error);
+
+    buffer.ReleaseIfEmpty();
+    EXPECT_EQ(buffer.capacity(), BufferPool::SmallestBlockSize * 4) << "Buffer with readable bytes was released";
+
+    buffer.consume(buffer.size());
+    buffer.ReleaseIfEmpty();
+    EXPECT_EQ(buffer.capacity(), 0u) << "Empty buffer was not released";
+    EXPECT_EQ(pool.GetStatistics().BorrowedBlocks, 0u);
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include <Commons/Network/Http.hpp>
+#include <thread>
+
+using namespace Merrie;
 
 TEST(TestHttp, TestDecodeUrlQueryString)
 {
@@ -20,4 +23,97 @@ TEST(TestHttp, TestDecodeUrlQueryString)
     EXPECT_EQ(decoded.Parameters["polish"], "zażółć gęślą jaźń");
     EXPECT_EQ(decoded.Parameters["last"], "correct");
     EXPECT_EQ(decoded.Parameters["keyonly2"], "");
-}
\ No newline at end of file
+}
+namespace {
+    class _OkServer : public HttpServer {
+        public:
+            explicit _OkServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                connection->GetResponse().result(http::status::ok);
+                connection->GetResponse().body() = "ok";
+                connection->SendResponse();
+            }
+    };
+
+    http::response<http::string_body> _Get(tcp::socket& socket, size_t paddingSize, bool keepAlive) {
+        http::request<http::empty_body> request(http::verb::get, "/", 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(keepAlive);
+
+        if (paddingSize != 0)
+            request.set("X-Padding", std::string(paddingSize, 'x'));
+
+        http::write(socket, request);
+
+        boost::beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::read(socket, buffer, response);
+        return response;
+    }
+}
+
+TEST(TestHttp, TestHeaderLimit)
+{
+    // the whole request fits into the receive buffer, so the server reads all of it and closes the connection cleanly
+    HttpServerSettings settings{{"127.0.0.1", 18191, 1}, false, 15, 15, 100, 1024, {}, {}, {}};
+    _OkServer server(settings);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+
+    EXPECT_EQ(_Get(socket, 1500, false).result(), http::status::request_header_fields_too_large);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttp, TestConfiguredHeaderLimitAboveDefault)
+{
+    HttpServerSettings settings{{"127.0.0.1", 18192, 1}, false, 15, 15, 100, 32768, {}, {}, {}};
+    _OkServer server(settings);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+
+    const auto response = _Get(socket, 16384, false);
+    EXPECT_EQ(response.result(), http::status::ok) << "Headers over the default 8 KB should be accepted when the limit allows them";
+    EXPECT_EQ(response.body(), "ok");
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttp, TestIdleKeepAliveHoldsNoReceiveBuffer)
+{
+    HttpServerSettings settings{{"127.0.0.1", 18193, 1}, true, 15, 15, 100, 8192, {}, {}, {}};
+    _OkServer server(settings);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+
+    // the connection is idle before the first request and between the requests, the next read is started right after the response
+    for (int i = 0; i < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(server.GetReceiveBufferStatistics().BorrowedBlocks, 0u) << "An idle connection should not hold a receive buffer";
+
+        const auto response = _Get(socket, 0, true);
+        EXPECT_EQ(response.result(), http::status::ok);
+        EXPECT_TRUE(response.keep_alive());
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(server.GetReceiveBufferStatistics().BorrowedBlocks, 0u);
+    EXPECT_GT(server.GetReceiveBufferStatistics().CachedBlocks, 0u) << "The requests should have been read through the pool";
+
+    server.Stop();
+    server.Join();
+}
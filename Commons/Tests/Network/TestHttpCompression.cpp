@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/HttpCompression.hpp>
+
+#ifdef M_HAS_ZLIB
+#include <zlib.h>
+
+using namespace Merrie;
+
+namespace {
+    std::string _Inflate(std::string_view compressed, int windowBits) {
+        z_stream stream{};
+        EXPECT_EQ(inflateInit2(&stream, windowBits), Z_OK);
+
+        std::string output(64 * 1024, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+        stream.avail_in = static_cast<uInt>(compressed.size());
+        stream.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream.avail_out = static_cast<uInt>(output.size());
+
+        EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+        output.resize(stream.total_out);
+        inflateEnd(&stream);
+        return output;
+    }
+}  // namespace
+
+TEST(TestHttpCompression, TestNegotiateContentEncoding) {
+    EXPECT_EQ(NegotiateContentEncoding(""), HttpContentEncoding::Identity);
+    EXPECT_EQ(NegotiateContentEncoding("identity"), HttpContentEncoding::Identity);
+    EXPECT_EQ(NegotiateContentEncoding("br"), HttpContentEncoding::Identity);
+    EXPECT_EQ(NegotiateContentEncoding("gzip, deflate, br"), HttpContentEncoding::Gzip);
+    EXPECT_EQ(NegotiateContentEncoding("deflate"), HttpContentEncoding::Deflate);
+    EXPECT_EQ(NegotiateContentEncoding("GZIP"), HttpContentEncoding::Gzip);
+    EXPECT_EQ(NegotiateContentEncoding("gzip;q=0.5, deflate;q=0.8"), HttpContentEncoding::Deflate);
+    EXPECT_EQ(NegotiateContentEncoding("gzip;q=0, deflate;q=0"), HttpContentEncoding::Identity);
+    EXPECT_EQ(NegotiateContentEncoding("*"), HttpContentEncoding::Gzip);
+    EXPECT_EQ(NegotiateContentEncoding("gzip;q=0, *"), HttpContentEncoding::Deflate);
+}
+
+TEST(TestHttpCompression, TestCompressHttpBody) {
+    std::string input;
+    for (int i = 0; i < 1000; i++)
+        input += R"({"id":)" + std::to_string(i) + R"(,"nick":"User","lvl":10000},)";
+
+    std::string output;
+
+    CompressHttpBody(HttpContentEncoding::Gzip, 6, input, output);
+    EXPECT_LT(output.size(), input.size());
+    EXPECT_EQ(_Inflate(output, MAX_WBITS + 16), input) << "gzip output does not decompress to the input";
+
+    // the per-thread state must be reset between calls, including a level change
+    CompressHttpBody(HttpContentEncoding::Gzip, 1, input, output);
+    EXPECT_EQ(_Inflate(output, MAX_WBITS + 16), input) << "reused gzip state does not decompress to the input";
+
+    CompressHttpBody(HttpContentEncoding::Deflate, 6, input, output);
+    EXPECT_EQ(_Inflate(output, MAX_WBITS), input) << "deflate output does not decompress to the input";
+
+    EXPECT_THROW(CompressHttpBody(HttpContentEncoding::Identity, 6, input, output), HttpCompressionException);
+}
+
+TEST(TestHttpCompression, TestMetrics) {
+    HttpCompressionMetrics metrics;
+    metrics.RecordCompressed(1000, 100, std::chrono::nanoseconds(50));
+    metrics.RecordCompressed(500, 200, std::chrono::nanoseconds(25));
+    metrics.RecordSkipped();
+
+    const HttpCompressionStatistics statistics = metrics.GetStatistics();
+    EXPECT_EQ(statistics.CompressedResponses, 2u);
+    EXPECT_EQ(statistics.SkippedResponses, 1u);
+    EXPECT_EQ(statistics.UncompressedBytes, 1500u);
+    EXPECT_EQ(statistics.CompressedBytes, 300u);
+    EXPECT_EQ(statistics.GetSavedBytes(), 1200u);
+    EXPECT_EQ(statistics.CompressionTime.count(), 75);
+}
+
+#endif // M_HAS_ZLIB
@@ -0,0 +1,279 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/Http.hpp>
+#include <Commons/Network/HttpResponseStream.hpp>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace Merrie;
+
+namespace {
+    std::string _MakeBody(size_t size) {
+        std::string body(size, '\0');
+        for (size_t i = 0; i < body.size(); i++) {
+            body[i] = static_cast<char>('a' + i % 26);
+        }
+
+        return body;
+    }
+
+    /**
+     * Writes the data to the stream, waits for the stream to drain whenever it does not take all of the data.
+     */
+    void _Write(HttpResponseStream& stream, std::string_view data) {
+        while (true) {
+            data.remove_prefix(stream.Write(data));
+            if (data.empty())
+                return;
+
+            auto drained = std::make_shared<std::promise<void>>();
+            std::future<void> future = drained->get_future();
+
+            stream.WhenDrained([drained]() {
+                drained->set_value();
+            });
+            future.wait();
+        }
+    }
+
+    class _StreamingServer : public HttpServer {
+        public:
+            /**
+             * @param pieceSize size of the pieces that the body is written in
+             */
+            _StreamingServer(HttpServerSettings settings, std::string body, size_t pieceSize = 5000)
+                    : HttpServer(std::move(settings)), m_body(std::move(body)), m_pieceSize(pieceSize) {
+            }
+
+            ~_StreamingServer() override {
+                std::scoped_lock lock(m_producersMutex);
+                for (std::thread& producer : m_producers) {
+                    producer.join();
+                }
+            }
+
+            size_t GetFinishedResponses() const noexcept {
+                return m_finishedResponses.load();
+            }
+
+            size_t GetMaxPendingBytes() const noexcept {
+                return m_maxPendingBytes.load();
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                connection->GetResponse().result(http::status::ok);
+                connection->GetResponse().set(http::field::content_type, "text/plain");
+
+                std::shared_ptr<HttpResponseStream> stream = connection->StartStreamingResponse();
+                if (!stream)
+                    return;
+
+                // the body is produced outside of the I/O threads, in pieces that do not line up with the chunks
+                std::scoped_lock lock(m_producersMutex);
+                m_producers.emplace_back([this, stream = std::move(stream)]() {
+                    std::string_view body = m_body;
+
+                    while (!body.empty()) {
+                        const size_t amount = std::min(body.size(), m_pieceSize);
+                        _Write(*stream, body.substr(0, amount));
+                        body.remove_prefix(amount);
+
+                        const size_t pendingBytes = stream->GetPendingBytes();
+                        if (pendingBytes > m_maxPendingBytes.load())
+                            m_maxPendingBytes.store(pendingBytes);
+
+                        if (body.size() % 3 == 0)
+                            stream->Flush();
+                    }
+
+                    stream->Finish();
+                    m_finishedResponses++;
+                });
+            }
+
+        private:
+            const std::string m_body;
+            const size_t m_pieceSize;
+            std::mutex m_producersMutex{};
+            std::vector<std::thread> m_producers{};
+            std::atomic<size_t> m_finishedResponses = 0;
+            std::atomic<size_t> m_maxPendingBytes = 0;
+    };
+
+    http::response<http::string_body> _Get(tcp::socket& socket, boost::beast::flat_buffer& buffer, bool keepAlive) {
+        http::request<http::empty_body> request(http::verb::get, "/stream", 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(keepAlive);
+        http::write(socket, request);
+
+        http::response<http::string_body> response;
+        http::read(socket, buffer, response);
+        return response;
+    }
+}
+
+TEST(TestHttpResponseStream, TestStreamedResponse) {
+    const std::string body = _MakeBody(5 * HttpResponseStream::ChunkSize + 123);
+
+    HttpServerSettings settings{{"127.0.0.1", 18181, 4}, true, 15, 15, 100, 8192, {}, {}, {}};
+    _StreamingServer server(settings, body);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+    boost::beast::flat_buffer buffer;
+
+    // the connection is kept alive after the last chunk, so the second response is read from the same socket
+    for (int i = 0; i < 2; i++) {
+        auto response = _Get(socket, buffer, i == 0);
+        EXPECT_EQ(response.result(), http::status::ok);
+        EXPECT_TRUE(response.chunked());
+        EXPECT_EQ(response[http::field::content_type], "text/plain");
+        EXPECT_EQ(response.body(), body) << "The streamed body does not match in the response " << i;
+    }
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttpResponseStream, TestConcurrentStreamedResponses) {
+    const std::string body = _MakeBody(3 * HttpResponseStream::ChunkSize);
+
+    HttpServerSettings settings{{"127.0.0.1", 18182, 4}, false, 15, 15, 100, 8192, {}, {}, {}};
+    _StreamingServer server(settings, body);
+    server.Start();
+
+    std::vector<std::thread> clients;
+    std::atomic<size_t> matching = 0;
+
+    for (int i = 0; i < 8; i++) {
+        clients.emplace_back([&]() {
+            boost::asio::io_context ioContext;
+            tcp::socket socket(ioContext);
+            socket.connect(server.GetEndpoint());
+            boost::beast::flat_buffer buffer;
+
+            if (_Get(socket, buffer, false).body() == body)
+                matching++;
+        });
+    }
+
+    for (std::thread& client : clients) {
+        client.join();
+    }
+
+    EXPECT_EQ(matching.load(), clients.size());
+    EXPECT_EQ(server.GetSendBufferStatistics().BorrowedBlocks, 0u) << "All chunks should be returned to the pool";
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttpResponseStream, TestSlowReader) {
+    const std::string body = _MakeBody(512 * HttpResponseStream::ChunkSize);
+
+    HttpServerSettings settings{{"127.0.0.1", 18194, 2}, false, 15, 15, 100, 8192, {}, {}, {}};
+    _StreamingServer server(settings, body);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.open(tcp::v4());
+    socket.set_option(tcp::socket::receive_buffer_size(4096));
+    socket.connect(server.GetEndpoint());
+
+    http::request<http::empty_body> request(http::verb::get, "/stream", 11);
+    request.set(http::field::host, "localhost");
+    request.keep_alive(false);
+    http::write(socket, request);
+
+    // the client does not read, so the producer has to wait for the socket instead of buffering the whole body
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(server.GetFinishedResponses(), 0u) << "The producer should wait for the slow client";
+    EXPECT_LE(server.GetSendBufferStatistics().BorrowedBytes, HttpResponseStream::MaxPendingBytes + 2 * HttpResponseStream::ChunkSize);
+
+    boost::beast::flat_buffer buffer;
+    http::response_parser<http::string_body> parser;
+    parser.body_limit(body.size());
+    http::read(socket, buffer, parser);
+
+    EXPECT_EQ(parser.get().body(), body);
+    EXPECT_LE(server.GetMaxPendingBytes(), HttpResponseStream::MaxPendingBytes) << "The writes should not go over the limit";
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttpResponseStream, TestOversizedWrite) {
+    const std::string body = _MakeBody(512 * HttpResponseStream::ChunkSize);
+
+    // the whole body is written at once
+    HttpServerSettings settings{{"127.0.0.1", 18198, 2}, false, 15, 15, 100, 8192, {}, {}, {}};
+    _StreamingServer server(settings, body, body.size());
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.open(tcp::v4());
+    socket.set_option(tcp::socket::receive_buffer_size(4096));
+    socket.connect(server.GetEndpoint());
+
+    http::request<http::empty_body> request(http::verb::get, "/stream", 11);
+    request.set(http::field::host, "localhost");
+    request.keep_alive(false);
+    http::write(socket, request);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(server.GetFinishedResponses(), 0u) << "The producer should wait for the slow client";
+    EXPECT_LE(server.GetSendBufferStatistics().BorrowedBytes, HttpResponseStream::MaxPendingBytes + HttpResponseStream::ChunkSize)
+                        << "A single write should not be buffered whole";
+
+    boost::beast::flat_buffer buffer;
+    http::response_parser<http::string_body> parser;
+    parser.body_limit(body.size());
+    http::read(socket, buffer, parser);
+
+    EXPECT_EQ(parser.get().body(), body);
+    EXPECT_LE(server.GetMaxPendingBytes(), HttpResponseStream::MaxPendingBytes);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestHttpResponseStream, TestHeadRequest) {
+    const std::string body = _MakeBody(2 * HttpResponseStream::ChunkSize);
+
+    HttpServerSettings settings{{"127.0.0.1", 18195, 2}, true, 15, 15, 100, 8192, {}, {}, {}};
+    _StreamingServer server(settings, body);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+    boost::beast::flat_buffer buffer;
+
+    http::request<http::empty_body> request(http::verb::head, "/stream", 11);
+    request.set(http::field::host, "localhost");
+    request.keep_alive(true);
+    http::write(socket, request);
+
+    http::response_parser<http::empty_body> parser;
+    parser.skip(true);
+    http::read(socket, buffer, parser);
+
+    EXPECT_EQ(parser.get().result(), http::status::ok);
+    EXPECT_TRUE(parser.get().chunked()) << "The response to HEAD should have the headers of the response to GET";
+
+    // no body was sent, so the next response is read correctly from the same connection
+    auto response = _Get(socket, buffer, false);
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response.body(), body);
+    EXPECT_EQ(buffer.size(), 0u);
+
+    server.Stop();
+    server.Join();
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/HttpRouter.hpp>
+
+using namespace Merrie;
+
+namespace {
+    void _NoopHandler(const std::shared_ptr<HttpConnection>&, const DecodedUrl&) {
+    }
+
+    class _RoutedServer : public HttpServer {
+        public:
+            explicit _RoutedServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+                HttpRouteOptions options{};
+                options.Cors.AllowOrigin = "http://localhost";
+                options.Cors.AllowCredentials = true;
+
+                m_router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::get, http::verb::post}, [](std::shared_ptr<HttpConnection> connection, const DecodedUrl&) {
+                    connection->GetResponse().result(http::status::ok);
+                    connection->SendResponse();
+                }, options);
+                m_router.Freeze();
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                m_router.Route(std::move(connection));
+            }
+
+        private:
+            HttpRouter m_router;
+    };
+
+    http::response<http::string_body> _Request(const tcp::endpoint& endpoint, http::verb method, const std::string& target) {
+        boost::asio::io_context ioContext;
+        tcp::socket socket(ioContext);
+        socket.connect(endpoint);
+
+        http::request<http::empty_body> request(method, target, 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(false);
+        http::write(socket, request);
+
+        boost::beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::read(socket, buffer, response);
+        return response;
+    }
+}
+
+TEST(TestHttpRouter, TestExactAndPrefixRoutes) {
+    HttpRouter router;
+    router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::get, http::verb::post}, _NoopHandler);
+    router.AddRoute(HttpRouteMatch::Prefix, "/static/", {http::verb::get}, _NoopHandler);
+    router.AddRoute(HttpRouteMatch::Prefix, "/static/images/", {http::verb::get}, _NoopHandler);
+    router.AddRoute(HttpRouteMatch::Exact, "/static/index.html", {}, _NoopHandler);
+    router.Freeze();
+
+    bool pathMatched = false;
+
+    const HttpRoute* route = router.Find("/engine", http::verb::get, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(route->Path, "/engine");
+
+    EXPECT_EQ(router.Find("/engine/", http::verb::get, pathMatched), nullptr) << "Exact routes must not match longer paths";
+    EXPECT_FALSE(pathMatched);
+    EXPECT_EQ(router.Find("/engin", http::verb::get, pathMatched), nullptr);
+    EXPECT_EQ(router.Find("", http::verb::get, pathMatched), nullptr);
+
+    route = router.Find("/static/images/logo.png", http::verb::get, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(route->Path, "/static/images/") << "The longest prefix must win";
+
+    route = router.Find("/static/style.css", http::verb::get, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(route->Path, "/static/");
+
+    route = router.Find("/static/index.html", http::verb::delete_, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(route->Match, HttpRouteMatch::Exact) << "Exact routes must win over prefix routes";
+}
+
+TEST(TestHttpRouter, TestMethods) {
+    HttpRouter router;
+    router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::get}, _NoopHandler);
+    router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::post}, _NoopHandler, HttpRouteOptions{{}, false});
+    router.AddRoute(HttpRouteMatch::Prefix, "/", {http::verb::put}, _NoopHandler);
+    router.Freeze();
+
+    bool pathMatched = false;
+
+    const HttpRoute* route = router.Find("/engine", http::verb::post, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_FALSE(route->Options.AllowCompression) << "The route for the method was not selected";
+
+    route = router.Find("/engine", http::verb::put, pathMatched);
+    ASSERT_NE(route, nullptr);
+    EXPECT_EQ(route->Match, HttpRouteMatch::Prefix) << "Prefix routes must be used when the exact routes do not accept the method";
+
+    EXPECT_EQ(router.Find("/engine", http::verb::delete_, pathMatched), nullptr);
+    EXPECT_TRUE(pathMatched) << "The path matched, but the method did not";
+
+    EXPECT_EQ(router.Find("/other", http::verb::get, pathMatched), nullptr);
+    EXPECT_TRUE(pathMatched);
+}
+
+TEST(TestHttpRouter, TestRegistration) {
+    HttpRouter router;
+    router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::get}, _NoopHandler);
+
+    EXPECT_THROW(router.AddRoute(HttpRouteMatch::Exact, "/engine", {}, _NoopHandler), HttpRouterException) << "Conflicting routes must not be added";
+    EXPECT_NO_THROW(router.AddRoute(HttpRouteMatch::Prefix, "/engine", {}, _NoopHandler));
+
+    router.Freeze();
+    EXPECT_TRUE(router.IsFrozen());
+    EXPECT_THROW(router.AddRoute(HttpRouteMatch::Exact, "/other", {}, _NoopHandler), HttpRouterException) << "Routes must not be added to a frozen router";
+}
+
+TEST(TestHttpRouter, TestMetrics) {
+    HttpRouteMetrics metrics;
+    metrics.RecordRequest(std::chrono::microseconds(10));
+    metrics.RecordRequest(std::chrono::microseconds(30));
+
+    EXPECT_EQ(metrics.GetRequests(), 2u);
+    EXPECT_EQ(metrics.GetTotalLatency(), std::chrono::microseconds(40));
+    EXPECT_EQ(metrics.GetMaxLatency(), std::chrono::microseconds(30));
+
+    HttpRouter router;
+    router.AddRoute(HttpRouteMatch::Exact, "/engine", {}, _NoopHandler);
+    router.Freeze();
+
+    const std::vector<HttpRouteStatistics> statistics = router.GetStatistics();
+    ASSERT_EQ(statistics.size(), 1u);
+    EXPECT_EQ(statistics[0].Path, "/engine");
+    EXPECT_EQ(statistics[0].Requests, 0u);
+    EXPECT_EQ(statistics[0].GetAverageLatency(), std::chrono::nanoseconds::zero());
+}
+
+TEST(TestHttpRouter, TestRouteRequests) {
+    HttpServerSettings settings{{"127.0.0.1", 18190, 1}, false, 15, 15, 100, 8192, {}, {}, {}};
+    _RoutedServer server(settings);
+    server.Start();
+
+    auto response = _Request(server.GetEndpoint(), http::verb::options, "/engine");
+    EXPECT_EQ(response.result(), http::status::ok) << "Preflight requests are answered by the router";
+    EXPECT_EQ(response[http::field::allow], "GET, POST, OPTIONS");
+    EXPECT_EQ(response[http::field::access_control_allow_origin], "http://localhost");
+    EXPECT_EQ(response[http::field::access_control_allow_credentials], "true");
+    EXPECT_EQ(response[http::field::access_control_max_age], "86400");
+
+    response = _Request(server.GetEndpoint(), http::verb::get, "/engine?a=b");
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response[http::field::access_control_allow_methods], "GET, POST");
+
+    response = _Request(server.GetEndpoint(), http::verb::delete_, "/engine");
+    EXPECT_EQ(response.result(), http::status::method_not_allowed);
+    EXPECT_EQ(response[http::field::allow], "GET, POST");
+
+    response = _Request(server.GetEndpoint(), http::verb::get, "/other");
+    EXPECT_EQ(response.result(), http::status::not_found);
+
+    server.Stop();
+    server.Join();
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/Http.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <thread>
+
+using namespace Merrie;
+
+namespace {
+    class _StaticFilesServer : public HttpServer {
+        public:
+            explicit _StaticFilesServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                const auto target = connection->GetRequest().target();
+                GetStaticFiles()->Serve(connection, std::string_view(target.data(), target.size()).substr(1));
+            }
+    };
+
+    http::response<http::string_body> _Get(const tcp::endpoint& endpoint, const std::string& target, const std::map<http::field, std::string>& headers = {}) {
+        boost::asio::io_context ioContext;
+        tcp::socket socket(ioContext);
+        socket.connect(endpoint);
+
+        http::request<http::empty_body> request(http::verb::get, target, 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(false);
+
+        for (const auto&[field, value] : headers) {
+            request.set(field, value);
+        }
+
+        http::write(socket, request);
+
+        boost::beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::read(socket, buffer, response);
+        return response;
+    }
+
+    http::response<http::string_body> _Head(const tcp::endpoint& endpoint, const std::string& target) {
+        boost::asio::io_context ioContext;
+        tcp::socket socket(ioContext);
+        socket.connect(endpoint);
+
+        http::request<http::empty_body> request(http::verb::head, target, 11);
+        request.set(http::field::host, "localhost");
+        request.keep_alive(false);
+        http::write(socket, request);
+
+        // the Content-Length of the response to HEAD does not describe its body
+        boost::beast::flat_buffer buffer;
+        http::response_parser<http::string_body> parser;
+        parser.skip(true);
+        http::read(socket, buffer, parser);
+
+        // the socket is not closed right after the response, so the body would be noticed as bytes that follow the headers
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EXPECT_EQ(buffer.size() + socket.available(), 0u) << "The response to HEAD must not have a body";
+
+        return parser.release();
+    }
+}
+
+TEST(TestHttpStaticFiles, TestServe) {
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    boost::filesystem::create_directories(directory / "images");
+
+    const std::string small = "hello world";
+    std::string big(300 * 1024, '\0');
+    for (size_t i = 0; i < big.size(); i++) {
+        big[i] = static_cast<char>('a' + i % 26);
+    }
+
+    std::ofstream(directory / "hello.txt") << small;
+    std::ofstream(directory / "images" / "big.png", std::ios::binary) << big;
+
+    HttpServerSettings settings{{"127.0.0.1", 18180, 1}, false, 15, 15, 100, 8192, {}, {}, {true, directory.string(), "/", 1024, 4096, 60}};
+    _StaticFilesServer server(settings);
+    server.Start();
+
+    // cached file
+    auto response = _Get(server.GetEndpoint(), "/hello.txt");
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response.body(), small);
+    EXPECT_EQ(response[http::field::content_type], "text/plain; charset=utf-8");
+
+    const std::string eTag(response[http::field::etag]);
+    EXPECT_FALSE(eTag.empty());
+
+    response = _Get(server.GetEndpoint(), "/hello.txt", {{http::field::if_none_match, eTag}});
+    EXPECT_EQ(response.result(), http::status::not_modified);
+    EXPECT_TRUE(response.body().empty());
+
+    response = _Get(server.GetEndpoint(), "/hello.txt", {{http::field::range, "bytes=6-"}});
+    EXPECT_EQ(response.result(), http::status::partial_content);
+    EXPECT_EQ(response.body(), "world");
+    EXPECT_EQ(response[http::field::content_range], "bytes 6-10/11");
+
+    response = _Get(server.GetEndpoint(), "/hello.txt", {{http::field::range, "bytes=20-30"}});
+    EXPECT_EQ(response.result(), http::status::range_not_satisfiable);
+
+    // file sent from the disk
+    response = _Get(server.GetEndpoint(), "/images/big.png");
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response.body(), big) << "The file sent from the disk does not match";
+
+    response = _Get(server.GetEndpoint(), "/images/big.png", {{http::field::range, "bytes=-100"}});
+    EXPECT_EQ(response.result(), http::status::partial_content);
+    EXPECT_EQ(response.body(), big.substr(big.size() - 100));
+
+    // paths outside of the directory
+    EXPECT_EQ(_Get(server.GetEndpoint(), "/../hello.txt").result(), http::status::not_found);
+    EXPECT_EQ(_Get(server.GetEndpoint(), "/images/").result(), http::status::not_found);
+    EXPECT_EQ(_Get(server.GetEndpoint(), "/missing.txt").result(), http::status::not_found);
+
+    const HttpStaticFilesStatistics statistics = server.GetStaticFiles()->GetStatistics();
+    EXPECT_EQ(statistics.CachedFiles, 1u) << "Only the small file should be cached";
+    EXPECT_EQ(statistics.CachedBytes, small.size());
+    EXPECT_EQ(statistics.CacheHits, 3u);
+    EXPECT_EQ(statistics.NotModifiedResponses, 1u);
+    EXPECT_EQ(statistics.PartialResponses, 2u);
+
+    // HEAD describes both the cached file and the file sent from the disk without sending them
+    response = _Head(server.GetEndpoint(), "/hello.txt");
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response[http::field::content_length], std::to_string(small.size()));
+    EXPECT_EQ(response[http::field::etag], eTag);
+
+    response = _Head(server.GetEndpoint(), "/images/big.png");
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response[http::field::content_length], std::to_string(big.size()));
+
+    server.Stop();
+    server.Join();
+    boost::filesystem::remove_all(directory);
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/Tls.hpp>
+
+#ifdef M_HAS_OPENSSL_SSL
+#include <Commons/Network/WebSocket.hpp>
+#include <boost/beast/websocket/ssl.hpp>
+#include <boost/filesystem.hpp>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <thread>
+
+using namespace Merrie;
+
+namespace {
+    /**
+     * Writes a self-signed certificate for localhost and its private key to the directory.
+     */
+    void _WriteSelfSignedCertificate(const boost::filesystem::path& directory) {
+        EVP_PKEY* key = nullptr;
+        EVP_PKEY_CTX* keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        EVP_PKEY_keygen_init(keyContext);
+        EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext, NID_X9_62_prime256v1);
+        EVP_PKEY_keygen(keyContext, &key);
+        EVP_PKEY_CTX_free(keyContext);
+
+        X509* certificate = X509_new();
+        X509_set_version(certificate, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+        X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+        X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+        X509_set_pubkey(certificate, key);
+
+        X509_NAME* name = X509_get_subject_name(certificate);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(certificate, name);
+        X509_sign(certificate, key, EVP_sha256());
+
+        BIO* certificateFile = BIO_new_file((directory / "certificate.pem").string().c_str(), "w");
+        PEM_write_bio_X509(certificateFile, certificate);
+        BIO_free(certificateFile);
+
+        BIO* keyFile = BIO_new_file((directory / "key.pem").string().c_str(), "w");
+        PEM_write_bio_PrivateKey(keyFile, key, nullptr, nullptr, 0, nullptr, nullptr);
+        BIO_free(keyFile);
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    class _SecureServer : public HttpServer {
+        public:
+            explicit _SecureServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                if (connection->IsWebSocketUpgrade()) {
+                    WebSocketCallbacks callbacks;
+                    callbacks.OnMessage = [](const std::shared_ptr<WebSocketConnection>& webSocket, std::string message) {
+                        webSocket->Send("echo:" + message);
+                    };
+
+                    connection->UpgradeToWebSocket(std::move(callbacks));
+                    return;
+                }
+
+                connection->GetResponse().result(http::status::ok);
+                connection->GetResponse().body() = "secure";
+                connection->SendResponse();
+            }
+    };
+
+    class TestTls : public ::testing::Test {
+        protected:
+            void SetUp() override {
+                m_directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+                boost::filesystem::create_directories(m_directory);
+                _WriteSelfSignedCertificate(m_directory);
+
+                m_clientContext.set_verify_mode(ssl::verify_none);
+            }
+
+            void TearDown() override {
+                boost::filesystem::remove_all(m_directory);
+            }
+
+            HttpServerSettings CreateSettings(NetworkPort port, bool keepAlive, size_t handshakeThreads) const {
+                TlsSettings tls{true, (m_directory / "certificate.pem").string(), (m_directory / "key.pem").string(), 64, 60, false, handshakeThreads, 0};
+                return HttpServerSettings{{"127.0.0.1", port, 2}, keepAlive, 15, 15, 100, 8192, {}, tls, {}};
+            }
+
+            static http::response<http::string_body> Get(ssl::stream<tcp::socket>& stream, boost::beast::flat_buffer& buffer, bool keepAlive) {
+                http::request<http::empty_body> request(http::verb::get, "/", 11);
+                request.set(http::field::host, "localhost");
+                request.keep_alive(keepAlive);
+                http::write(stream, request);
+
+                http::response<http::string_body> response;
+                http::read(stream, buffer, response);
+                return response;
+            }
+
+        protected:
+            boost::filesystem::path m_directory{};
+            boost::asio::io_context m_ioContext{};
+            ssl::context m_clientContext{ssl::context::tls_client};
+    };
+}
+
+TEST_F(TestTls, TestHttpsRoundTrip) {
+    _SecureServer server(CreateSettings(18186, true, 0));
+    server.Start();
+
+    ssl::stream<tcp::socket> stream(m_ioContext, m_clientContext);
+    stream.next_layer().connect(server.GetEndpoint());
+    stream.handshake(ssl::stream_base::client);
+
+    boost::beast::flat_buffer buffer;
+    for (int i = 0; i < 2; i++) {
+        auto response = Get(stream, buffer, true);
+        EXPECT_EQ(response.result(), http::status::ok);
+        EXPECT_EQ(response.body(), "secure");
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(server.GetReceiveBufferStatistics().BorrowedBlocks, 0u) << "An idle TLS connection should not hold a receive buffer";
+
+    const TlsStatistics statistics = server.GetTlsStatistics();
+    EXPECT_EQ(statistics.FullHandshakes, 1u) << "Both requests should use the same connection";
+    EXPECT_EQ(statistics.ResumedHandshakes, 0u);
+    EXPECT_EQ(statistics.FailedHandshakes, 0u);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST_F(TestTls, TestSessionResumptionWithHandshakeThreads) {
+    _SecureServer server(CreateSettings(18187, false, 1));
+    server.Start();
+
+    SSL_SESSION* session = nullptr;
+
+    for (int i = 0; i < 2; i++) {
+        ssl::stream<tcp::socket> stream(m_ioContext, m_clientContext);
+        stream.next_layer().connect(server.GetEndpoint());
+
+        if (session != nullptr)
+            SSL_set_session(stream.native_handle(), session);
+
+        stream.handshake(ssl::stream_base::client);
+
+        boost::beast::flat_buffer buffer;
+        EXPECT_EQ(Get(stream, buffer, false).body(), "secure");
+        EXPECT_EQ(SSL_session_reused(stream.native_handle()) == 1, i == 1) << "Only the second connection should resume the session";
+
+        // the TLS 1.3 session is known after the first response, it comes after the handshake
+        if (session == nullptr)
+            session = SSL_get1_session(stream.native_handle());
+
+        // OpenSSL does not resume the sessions of connections that were not shut down on the client side either
+        boost::system::error_code ignored;
+        stream.shutdown(ignored);
+    }
+
+    SSL_SESSION_free(session);
+
+    const TlsStatistics statistics = server.GetTlsStatistics();
+    EXPECT_EQ(statistics.FullHandshakes, 1u);
+    EXPECT_EQ(statistics.ResumedHandshakes, 1u);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST_F(TestTls, TestSecureWebSocket) {
+    _SecureServer server(CreateSettings(18188, true, 0));
+    server.Start();
+
+    websocket::stream<ssl::stream<tcp::socket>> client(m_ioContext, m_clientContext);
+    client.next_layer().next_layer().connect(server.GetEndpoint());
+    client.next_layer().handshake(ssl::stream_base::client);
+    client.handshake("localhost", "/engine");
+
+    client.write(boost::asio::buffer(std::string("hello")));
+
+    boost::beast::flat_buffer buffer;
+    client.read(buffer);
+    EXPECT_EQ(boost::beast::buffers_to_string(buffer.data()), "echo:hello");
+
+    client.close(websocket::close_code::normal);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST_F(TestTls, TestFailedHandshake) {
+    _SecureServer server(CreateSettings(18189, false, 0));
+    server.Start();
+
+    // a plain HTTP request is not a TLS client hello
+    tcp::socket socket(m_ioContext);
+    socket.connect(server.GetEndpoint());
+    boost::asio::write(socket, boost::asio::buffer(std::string("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n")));
+
+    for (int i = 0; i < 500 && server.GetTlsStatistics().FailedHandshakes == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(server.GetTlsStatistics().FailedHandshakes, 1u);
+    EXPECT_EQ(server.GetTlsStatistics().FullHandshakes, 0u);
+
+    server.Stop();
+    server.Join();
+}
+#endif
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Network/WebSocket.hpp>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace Merrie;
+
+namespace {
+    class _EchoServer : public HttpServer {
+        public:
+            explicit _EchoServer(HttpServerSettings settings) : HttpServer(std::move(settings)) {
+            }
+
+            std::shared_ptr<WebSocketConnection> GetLastConnection() {
+                std::scoped_lock lock(m_mutex);
+                return m_lastConnection;
+            }
+
+            std::future<void> GetClosed() {
+                return m_closed.get_future();
+            }
+
+        protected:
+            void HandleRequest(std::shared_ptr<HttpConnection> connection) override {
+                if (!connection->IsWebSocketUpgrade()) {
+                    connection->GetResponse().result(http::status::ok);
+                    connection->GetResponse().body() = "plain";
+                    connection->SendResponse();
+                    return;
+                }
+
+                WebSocketCallbacks callbacks;
+                callbacks.OnMessage = [this](const std::shared_ptr<WebSocketConnection>& webSocket, std::string message) {
+                    {
+                        std::scoped_lock lock(m_mutex);
+                        m_lastConnection = webSocket;
+                    }
+
+                    webSocket->Send("echo:" + message);
+                };
+                callbacks.OnClose = [this](const std::shared_ptr<WebSocketConnection>&) {
+                    m_closed.set_value();
+                };
+
+                EXPECT_NE(connection->UpgradeToWebSocket(std::move(callbacks)), nullptr);
+            }
+
+        private:
+            std::mutex m_mutex{};
+            std::shared_ptr<WebSocketConnection> m_lastConnection{};
+            std::promise<void> m_closed{};
+    };
+
+    std::string _Read(websocket::stream<tcp::socket>& client) {
+        boost::beast::flat_buffer buffer;
+        client.read(buffer);
+        return boost::beast::buffers_to_string(buffer.data());
+    }
+}
+
+TEST(TestWebSocket, TestUpgradeAndRoundTrip) {
+    HttpServerSettings settings{{"127.0.0.1", 18183, 2}, true, 15, 15, 100, 8192, {}, {}, {}};
+    _EchoServer server(settings);
+    std::future<void> closed = server.GetClosed();
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    websocket::stream<tcp::socket> client(ioContext);
+    client.next_layer().connect(server.GetEndpoint());
+    client.handshake("localhost", "/engine");
+
+    client.write(boost::asio::buffer(std::string("hello")));
+    EXPECT_EQ(_Read(client), "echo:hello");
+
+    // the connection is stored by the first message
+    std::shared_ptr<WebSocketConnection> connection = server.GetLastConnection();
+    ASSERT_NE(connection, nullptr) << "The upgrade request should create a WebSocket connection";
+    EXPECT_EQ(connection->GetHttpConnection()->GetRequest().target(), "/engine");
+
+    // the stream takes its executor from the socket, its timers have to run on the strand of the connection
+    EXPECT_TRUE(connection->GetStrand() == connection->GetHttpConnection()->GetStrand());
+    EXPECT_TRUE(connection->IsOpen());
+
+    // messages pushed from outside of the I/O threads arrive in the order of Send()
+    for (int i = 0; i < 100; i++) {
+        connection->Send(std::to_string(i));
+    }
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(_Read(client), std::to_string(i));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(server.GetReceiveBufferStatistics().BorrowedBlocks, 0u) << "An idle WebSocket connection should not hold a receive buffer";
+
+    // empty messages complete with the first read
+    client.write(boost::asio::buffer(std::string()));
+    EXPECT_EQ(_Read(client), "echo:");
+
+    client.close(websocket::close_code::normal);
+    EXPECT_EQ(closed.wait_for(std::chrono::seconds(5)), std::future_status::ready) << "The close handler should be called";
+    EXPECT_FALSE(connection->IsOpen());
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestWebSocket, TestServerClose) {
+    HttpServerSettings settings{{"127.0.0.1", 18184, 2}, true, 15, 15, 100, 8192, {}, {}, {}};
+    _EchoServer server(settings);
+    std::future<void> closed = server.GetClosed();
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    websocket::stream<tcp::socket> client(ioContext);
+    client.next_layer().connect(server.GetEndpoint());
+    client.handshake("localhost", "/engine");
+
+    client.write(boost::asio::buffer(std::string("hello")));
+    EXPECT_EQ(_Read(client), "echo:hello");
+
+    std::shared_ptr<WebSocketConnection> connection = server.GetLastConnection();
+    ASSERT_NE(connection, nullptr);
+
+    // the queued messages are sent before the close frame, nothing is sent after it
+    connection->Send("last");
+    connection->Close();
+    connection->Send("ignored");
+
+    EXPECT_EQ(_Read(client), "last");
+
+    boost::beast::flat_buffer buffer;
+    boost::beast::error_code error;
+    client.read(buffer, error);
+    EXPECT_EQ(error, websocket::error::closed);
+    EXPECT_EQ(client.reason().code, websocket::close_code::normal);
+
+    EXPECT_EQ(closed.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+
+    server.Stop();
+    server.Join();
+}
+
+TEST(TestWebSocket, TestPlainRequest) {
+    HttpServerSettings settings{{"127.0.0.1", 18185, 1}, false, 15, 15, 100, 8192, {}, {}, {}};
+    _EchoServer server(settings);
+    server.Start();
+
+    boost::asio::io_context ioContext;
+    tcp::socket socket(ioContext);
+    socket.connect(server.GetEndpoint());
+
+    http::request<http::empty_body> request(http::verb::get, "/engine", 11);
+    request.set(http::field::host, "localhost");
+    request.keep_alive(false);
+    http::write(socket, request);
+
+    boost::beast::flat_buffer buffer;
+    http::response<http::string_body> response;
+    http::read(socket, buffer, response);
+
+    EXPECT_EQ(response.result(), http::status::ok);
+    EXPECT_EQ(response.body(), "plain");
+    EXPECT_EQ(server.GetLastConnection(), nullptr) << "Requests without the upgrade headers should stay HTTP";
+
+    server.Stop();
+    server.Join();
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <Commons/Storage/AppendLogStore.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace Merrie;
+
+TEST(TestAppendLogStore, TestPutAndLoad) {
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    {
+        AppendLogStore store({true, directory.string(), 1024 * 1024});
+        EXPECT_EQ(store.Load(1), std::nullopt);
+
+        // queued changes can be loaded before they are written
+        store.Put(1, "first");
+        store.Put(2, "second");
+        store.Put(3, "");
+        EXPECT_EQ(store.Load(1), "first");
+
+        store.Put(1, "replaced");
+        store.Erase(2);
+        store.Flush();
+
+        EXPECT_EQ(store.Load(1), "replaced");
+        EXPECT_EQ(store.Load(2), std::nullopt);
+        EXPECT_EQ(store.Load(3), "");
+
+        const AppendLogStoreStatistics statistics = store.GetStatistics();
+        EXPECT_GE(statistics.Commits, 1u);
+        EXPECT_LE(statistics.Commits, 2u);
+        EXPECT_EQ(statistics.Keys, 2u);
+        EXPECT_GT(statistics.LogSize, 0u);
+    }
+
+    // reopened from the log
+    {
+        AppendLogStore store({true, directory.string(), 1024 * 1024});
+        EXPECT_EQ(store.Load(1), "replaced");
+        EXPECT_EQ(store.Load(2), std::nullopt);
+        EXPECT_EQ(store.Load(3), "");
+        EXPECT_EQ(store.GetStatistics().Keys, 2u);
+    }
+
+    boost::filesystem::remove_all(directory);
+}
+
+TEST(TestAppendLogStore, TestCompaction) {
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    {
+        AppendLogStore store({true, directory.string(), 4096});
+
+        for (int round = 0; round < 20; round++) {
+            for (uint64_t key = 0; key < 10; key++) {
+                store.Put(key, std::string(100, static_cast<char>('a' + round)) + std::to_string(key));
+            }
+
+            store.Flush();
+        }
+
+        store.Erase(9);
+        store.Flush();
+
+        const AppendLogStoreStatistics statistics = store.GetStatistics();
+        EXPECT_GE(statistics.Compactions, 1u);
+        EXPECT_LT(statistics.LogSize, 4096u * 2);
+        EXPECT_GT(statistics.SnapshotSize, 0u);
+
+        EXPECT_EQ(store.Load(0), std::string(100, 't') + "0");
+        EXPECT_EQ(store.Load(9), std::nullopt);
+    }
+
+    // reopened from the snapshot and the log
+    {
+        AppendLogStore store({true, directory.string(), 4096});
+
+        for (uint64_t key = 0; key < 9; key++) {
+            EXPECT_EQ(store.Load(key), std::string(100, 't') + std::to_string(key));
+        }
+
+        EXPECT_EQ(store.Load(9), std::nullopt);
+    }
+
+    boost::filesystem::remove_all(directory);
+}
+
+TEST(TestAppendLogStore, TestTornRecord) {
+    const boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+
+    {
+        AppendLogStore store({true, directory.string(), 1024 * 1024});
+        store.Put(1, "kept");
+        store.Flush();
+    }
+
+    const uint64_t logSize = boost::filesystem::file_size(directory / "log");
+
+    // a record that was written only partially before a crash, its header claims a value of almost 2 GiB
+    std::ofstream(directory / "log", std::ios::binary | std::ios::app) << std::string(20, '\x7f');
+
+    {
+        AppendLogStore store({true, directory.string(), 1024 * 1024});
+        EXPECT_EQ(store.Load(1), "kept");
+        EXPECT_EQ(boost::filesystem::file_size(directory / "log"), logSize);
+
+        // the new records are not hidden behind the torn one
+        store.Put(2, "after");
+        store.Flush();
+    }
+
+    {
+        AppendLogStore store({true, directory.string(), 1024 * 1024});
+        EXPECT_EQ(store.Load(1), "kept");
+        EXPECT_EQ(store.Load(2), "after");
+    }
+
+    boost::filesystem::remove_all(directory);
+}
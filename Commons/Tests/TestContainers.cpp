@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <Commons/Containers.hpp>
+#include <set>
+#include <thread>
 
 using namespace Merrie;
 
@@ -43,4 +45,299 @@ TEST(TestContainers, TestRemoveIf) {
     EXPECT_TRUE(Contains(vector, 5));
     EXPECT_TRUE(Contains(vector, 6));
     EXPECT_TRUE(Contains(vector, 7));
-}
\ No newline at end of file
+}
+
+TEST(TestContainers, TestShardedInbox) {
+    ShardedInbox<int> inbox(4);
+    std::vector<std::thread> threads;
+
+    for (int thread = 0; thread < 8; thread++) {
+        threads.emplace_back([&inbox, thread]() {
+            for (int i = 0; i < 1000; i++) {
+                inbox.Push(thread * 1000 + i);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    const size_t count = inbox.Drain([&values](int value, size_t shard) {
+        EXPECT_LT(shard, 4);
+        values.push_back(value);
+    });
+
+    EXPECT_EQ(count, 8000);
+    EXPECT_EQ(values.size(), 8000);
+
+    // the values of a thread keep their order
+    std::vector<int> lastValues(8, -1);
+    for (int value : values) {
+        EXPECT_GT(value, lastValues[value / 1000]);
+        lastValues[value / 1000] = value;
+    }
+
+    EXPECT_EQ(inbox.Drain([](int, size_t) { FAIL(); }), 0);
+}
+
+TEST(TestContainers, TestShardedInboxThrowingConsumer) {
+    ShardedInbox<std::unique_ptr<int>> inbox(1);
+
+    for (int i = 0; i < 3; i++) {
+        inbox.Push(std::make_unique<int>(i));
+    }
+
+    std::vector<int> values;
+    EXPECT_THROW(inbox.Drain([&values](std::unique_ptr<int>& value, size_t) {
+        const std::unique_ptr<int> taken = std::move(value);
+        values.push_back(*taken);
+
+        if (*taken == 1)
+            throw std::runtime_error("consumer failed");
+    }), std::runtime_error);
+
+    EXPECT_EQ(values, std::vector<int>({0, 1}));
+
+    // the consumed values do not come back with the next pushes
+    inbox.Push(std::make_unique<int>(3));
+    values.clear();
+
+    const size_t count = inbox.Drain([&values](std::unique_ptr<int>& value, size_t) {
+        ASSERT_NE(value, nullptr);
+        values.push_back(*value);
+    });
+
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(values, std::vector<int>({3}));
+}
+
+TEST(TestContainers, TestBoundedMpscQueue) {
+    BoundedMpscQueue<std::unique_ptr<int>> queue(100000);
+    std::atomic<bool> producing{true};
+    std::vector<std::thread> threads;
+
+    for (int thread = 0; thread < 4; thread++) {
+        threads.emplace_back([&queue, thread]() {
+            for (int i = 0; i < 10000; i++) {
+                EXPECT_TRUE(queue.Push(std::make_unique<int>(thread * 10000 + i)));
+            }
+        });
+    }
+
+    // the consumer runs at the same time as the producers
+    std::vector<int> lastValues(4, -1);
+    size_t count = 0;
+
+    auto consume = [&](std::unique_ptr<int>& value) {
+        const int thread = *value / 10000;
+        EXPECT_GT(*value, lastValues[thread]);
+        lastValues[thread] = *value;
+        count++;
+    };
+
+    std::thread consumer([&]() {
+        while (producing) {
+            queue.Drain(consume);
+        }
+
+        queue.Drain(consume);
+    });
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    producing = false;
+    consumer.join();
+
+    EXPECT_EQ(count, 40000);
+    EXPECT_TRUE(queue.IsEmpty());
+    EXPECT_EQ(queue.GetSize(), 0);
+}
+
+TEST(TestContainers, TestBoundedMpscQueueCapacity) {
+    BoundedMpscQueue<std::string> queue(3);
+
+    EXPECT_TRUE(queue.Push("1"));
+    EXPECT_TRUE(queue.Push("2"));
+    EXPECT_TRUE(queue.Push("3"));
+    EXPECT_FALSE(queue.Push("4"));
+    EXPECT_EQ(queue.GetSize(), 3);
+
+    std::string values;
+    EXPECT_EQ(queue.Drain([&values](std::string& value) { values += value; }), 3);
+    EXPECT_EQ(values, "123");
+
+    EXPECT_TRUE(queue.Push("5"));
+    EXPECT_FALSE(queue.IsEmpty());
+
+    // values that are not popped are freed with the queue
+}
+
+TEST(TestContainers, TestShardedHashMap) {
+    ShardedHashMap<uint64_t, std::shared_ptr<uint64_t>> map(6);
+    EXPECT_EQ(map.GetShardCount(), 8);
+
+    std::atomic<int> created{0};
+    std::vector<std::thread> threads;
+
+    // every key is created exactly once, no matter how many threads ask for it
+    for (int thread = 0; thread < 8; thread++) {
+        threads.emplace_back([&map, &created] {
+            for (uint64_t key = 0; key < 1000; key++) {
+                auto[value, isNew] = map.GetOrCreate(key, [key, &created] {
+                    created++;
+                    return std::make_shared<uint64_t>(key);
+                });
+
+                EXPECT_EQ(*value, key);
+                EXPECT_EQ(map.Find(key), value);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(created, 1000);
+    EXPECT_EQ(map.GetSize(), 1000);
+    EXPECT_FALSE(map.Find(1000).has_value());
+
+    EXPECT_EQ(map.RemoveIf([](uint64_t key, const std::shared_ptr<uint64_t>&) { return key % 2 == 0; }), 500);
+    EXPECT_TRUE(map.Remove(1));
+    EXPECT_FALSE(map.Remove(1));
+    EXPECT_EQ(map.GetSize(), 499);
+
+    EXPECT_TRUE(map.InsertOrAssign(1, std::make_shared<uint64_t>(1)));
+    EXPECT_FALSE(map.InsertOrAssign(1, std::make_shared<uint64_t>(2)));
+    EXPECT_EQ(*map.Find(1).value(), 2u);
+    EXPECT_TRUE(map.Remove(1));
+
+    uint64_t sum = 0;
+    map.ForEach([&sum](uint64_t key, const std::shared_ptr<uint64_t>& value) {
+        EXPECT_EQ(key, *value);
+        sum += key;
+    });
+
+    EXPECT_EQ(sum, 250000 - 1);
+}
+
+TEST(TestContainers, TestTimingWheel) {
+    using namespace std::chrono_literals;
+
+    TimingWheel<int> wheel(10ms, 8);
+    const DefaultClock::time_point start = DefaultClock::now();
+
+    wheel.Schedule(1, start - 1s);
+    wheel.Schedule(2, start + 25ms);
+    wheel.Schedule(3, start + 1s); // beyond the horizon
+    EXPECT_EQ(wheel.GetSize(), 3);
+
+    std::vector<int> due;
+    const auto collect = [&due](int& value) {
+        due.emplace_back(value);
+    };
+
+    // nothing comes out before its time
+    wheel.Advance(start + 5ms, collect);
+    EXPECT_TRUE(due.empty());
+
+    EXPECT_EQ(wheel.Advance(start + 50ms, collect), 2);
+    EXPECT_EQ(due, std::vector<int>({1, 2}));
+    due.clear();
+
+    // the value beyond the horizon comes out early and is scheduled again until its time comes
+    size_t early = 0;
+    const auto collectDue = [&](DefaultClock::time_point now) {
+        return [&, now](int& value) {
+            if (now < start + 1s) {
+                wheel.Schedule(value, start + 1s);
+                early++;
+            } else {
+                due.emplace_back(value);
+            }
+        };
+    };
+
+    for (auto now = start + 50ms; now <= start + 1200ms; now += 10ms) {
+        wheel.Advance(now, collectDue(now));
+    }
+
+    EXPECT_EQ(due, std::vector<int>({3}));
+    EXPECT_GT(early, 0);
+    EXPECT_LT(early, 20); // once per horizon
+    EXPECT_EQ(wheel.GetSize(), 0);
+}
+
+TEST(TestContainers, TestSlotMap) {
+    SlotMap<std::string> map;
+
+    const SlotHandle first = map.Insert("first");
+    const SlotHandle second = map.Insert("second");
+    const SlotHandle third = map.Insert("third");
+    EXPECT_NE(first, InvalidSlotHandle);
+    EXPECT_EQ(map.GetSize(), 3);
+    EXPECT_EQ(*map.Get(second), "second");
+    EXPECT_EQ(map.Get(InvalidSlotHandle), nullptr);
+
+    // the last value moves into the place of the removed one, its handle stays valid
+    EXPECT_TRUE(map.Remove(first));
+    EXPECT_FALSE(map.Remove(first));
+    EXPECT_EQ(map.Get(first), nullptr);
+    EXPECT_EQ(*map.Get(third), "third");
+    EXPECT_EQ(map.GetSize(), 2);
+
+    // the slot is reused with a new generation, the old handle does not reach the new value
+    const SlotHandle fourth = map.Insert("fourth");
+    EXPECT_NE(fourth, first);
+    EXPECT_EQ(static_cast<uint32_t>(fourth), static_cast<uint32_t>(first));
+    EXPECT_EQ(map.Get(first), nullptr);
+    EXPECT_EQ(*map.Get(fourth), "fourth");
+
+    std::map<SlotHandle, std::string> values;
+    map.ForEach([&values](SlotHandle handle, std::string& value) {
+        values.emplace(handle, value);
+    });
+
+    EXPECT_EQ(values, (std::map<SlotHandle, std::string>{{second, "second"}, {third, "third"}, {fourth, "fourth"}}));
+}
+
+TEST(TestContainers, TestUniformGrid) {
+    UniformGrid<uint64_t> grid(100, 50, 10);
+
+    const auto query = [&grid](int32_t x, int32_t y, int32_t range) {
+        std::set<uint64_t> values;
+        grid.ForEachInRange(x, y, range, [&values](const UniformGrid<uint64_t>::Entry& entry) {
+            values.insert(entry.Value);
+        });
+        return values;
+    };
+
+    grid.Insert(1, 5, 5);
+    grid.Insert(2, 12, 5);
+    grid.Insert(3, 95, 45);
+    grid.Insert(4, -20, 200); // kept at the edge
+    EXPECT_EQ(grid.GetSize(), 4);
+
+    // the ranges are exact, not rounded to the cells
+    EXPECT_EQ(query(5, 5, 6), (std::set<uint64_t>{1}));
+    EXPECT_EQ(query(5, 5, 7), (std::set<uint64_t>{1, 2}));
+    EXPECT_EQ(query(90, 40, 5), (std::set<uint64_t>{3}));
+    EXPECT_EQ(query(-20, 200, 0), (std::set<uint64_t>{4}));
+    EXPECT_EQ(query(50, 25, 1000), (std::set<uint64_t>{1, 2, 3, 4}));
+
+    // within the cell and into another one
+    EXPECT_TRUE(grid.Move(1, 5, 5, 8, 8));
+    EXPECT_FALSE(grid.Move(1, 30, 30, 8, 8));
+    EXPECT_TRUE(grid.Move(2, 12, 5, 60, 30));
+    EXPECT_EQ(query(5, 5, 7), (std::set<uint64_t>{1}));
+    EXPECT_EQ(query(55, 25, 5), (std::set<uint64_t>{2}));
+
+    EXPECT_TRUE(grid.Remove(2, 60, 30));
+    EXPECT_FALSE(grid.Remove(2, 60, 30));
+    EXPECT_EQ(query(55, 25, 5), (std::set<uint64_t>{}));
+    EXPECT_EQ(grid.GetSize(), 3);
+}
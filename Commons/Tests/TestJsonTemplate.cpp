@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include <Commons/JsonTemplate.hpp>
+
+using namespace Merrie;
+
+namespace {
+    JsonTemplate CreatePlayerTemplate() {
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.Key("id");
+        writer.RawValue(JsonTemplate::Slot);
+        writer.BeginObject("h");
+        writer.Field("img", "/paid/zakon_rm5.gif");
+        writer.Key("nick");
+        writer.RawValue(JsonTemplate::Slot);
+        writer.BeginArray("evade");
+        writer.Value(50);
+        writer.RawValue(JsonTemplate::Slot);
+        writer.EndArray();
+        writer.EndObject();
+        writer.EndObject();
+
+        return JsonTemplate(writer.TakeString());
+    }
+}
+
+TEST(TestJsonTemplate, TestRender) {
+    const JsonTemplate playerTemplate = CreatePlayerTemplate();
+
+    EXPECT_EQ(playerTemplate.GetSlotCount(), 3);
+    EXPECT_EQ(playerTemplate.Render(1234, "Hero \"the\" first", 5.0), R"({"id":1234,"h":{"img":"/paid/zakon_rm5.gif","nick":"Hero \"the\" first","evade":[50,5.0]}})");
+    EXPECT_EQ(playerTemplate.Render(uint64_t(1), std::string("x"), true), R"({"id":1,"h":{"img":"/paid/zakon_rm5.gif","nick":"x","evade":[50,true]}})");
+
+    // the serialized values are rendered as they are
+    EXPECT_EQ(playerTemplate.Render(2, JsonTemplate::Raw{R"("y")"}, JsonTemplate::Raw{"[1,2]"}), R"({"id":2,"h":{"img":"/paid/zakon_rm5.gif","nick":"y","evade":[50,[1,2]]}})");
+}
+
+TEST(TestJsonTemplate, TestNoSlots) {
+    const JsonTemplate constant(R"({"gw2":[],"townname":{}})");
+
+    EXPECT_EQ(constant.GetSlotCount(), 0);
+    EXPECT_EQ(constant.Render(), R"({"gw2":[],"townname":{}})");
+}
+
+TEST(TestJsonTemplate, TestRenderMembers) {
+    const JsonTemplate playerTemplate = CreatePlayerTemplate();
+
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Field("e", "ok");
+    playerTemplate.RenderMembers(writer, 1, "a,\"b\":{", 2);
+    writer.Field("ev", 1.5);
+    writer.EndObject();
+
+    EXPECT_EQ(writer.GetString(), R"({"e":"ok","id":1,"h":{"img":"/paid/zakon_rm5.gif","nick":"a,\"b\":{","evade":[50,2]},"ev":1.5})");
+
+    // only the keys of the root object are remembered, the strings of the values are not keys
+    EXPECT_TRUE(writer.HasRootKey("e"));
+    EXPECT_TRUE(writer.HasRootKey("id"));
+    EXPECT_TRUE(writer.HasRootKey("h"));
+    EXPECT_TRUE(writer.HasRootKey("ev"));
+    EXPECT_FALSE(writer.HasRootKey("nick"));
+    EXPECT_FALSE(writer.HasRootKey("b"));
+    EXPECT_FALSE(writer.HasRootKey("img"));
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <Commons/JsonWriter.hpp>
+#include <nlohmann/json.hpp>
+#include <limits>
+
+using namespace Merrie;
+
+TEST(TestJsonWriter, TestNesting) {
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Field("id", 1234);
+    writer.Field("name", "Ithan");
+    writer.Field("visible", true);
+    writer.BeginArray("evade");
+    writer.Value(50);
+    writer.Value(5.0);
+    writer.Null();
+    writer.EndArray();
+    writer.BeginObject("empty");
+    writer.EndObject();
+    writer.BeginArray("nested");
+    writer.BeginObject();
+    writer.Field("x", -10);
+    writer.EndObject();
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.EndObject();
+
+    EXPECT_TRUE(writer.IsComplete());
+    EXPECT_EQ(writer.GetString(), R"({"id":1234,"name":"Ithan","visible":true,"evade":[50,5.0,null],"empty":{},"nested":[{"x":-10},[]]})");
+}
+
+TEST(TestJsonWriter, TestEscaping) {
+    const std::string text = "quote\" backslash\\ newline\n tab\t bell\x07 zażółć";
+
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Field("key\"", text);
+    writer.EndObject();
+
+    const nlohmann::json parsed = nlohmann::json::parse(writer.GetString());
+    EXPECT_EQ(parsed["key\""], text);
+    EXPECT_NE(writer.GetString().find("\\u0007"), std::string::npos);
+}
+
+TEST(TestJsonWriter, TestNumbers) {
+    JsonWriter writer;
+    writer.BeginArray();
+    writer.Value(100000000000);
+    writer.Value(static_cast<uint64_t>(18446744073709551615ULL));
+    writer.Value(12.34);
+    writer.Value(1792367147.515);
+    writer.Value(std::numeric_limits<double>::infinity());
+    writer.EndArray();
+
+    EXPECT_EQ(writer.GetString(), "[100000000000,18446744073709551615,12.34,1792367147.515,null]");
+}
+
+TEST(TestJsonWriter, TestRawMembers) {
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Field("e", "ok");
+    writer.RawMembers("{}");
+    writer.RawMembers(R"({"a":[1,2],"b":{"c":3}})");
+    writer.Key("t");
+    writer.RawValue(R"({"x":1})");
+    writer.EndObject();
+
+    EXPECT_EQ(writer.GetString(), R"({"e":"ok","a":[1,2],"b":{"c":3},"t":{"x":1}})");
+
+    EXPECT_TRUE(writer.HasRootKey("e"));
+    EXPECT_TRUE(writer.HasRootKey("t"));
+    EXPECT_FALSE(writer.HasRootKey("x"));
+}
+
+TEST(TestJsonWriter, TestTakeString) {
+    JsonWriter writer;
+    writer.BeginObject();
+    writer.Field("e", "ok");
+    writer.EndObject();
+
+    EXPECT_EQ(writer.TakeString(), R"({"e":"ok"})");
+    EXPECT_FALSE(writer.IsComplete());
+    EXPECT_FALSE(writer.HasRootKey("e"));
+
+    // the writer can be reused
+    writer.BeginArray();
+    writer.EndArray();
+    EXPECT_EQ(writer.TakeString(), "[]");
+}
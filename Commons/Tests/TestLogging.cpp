@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <Commons/Logging.hpp>
+
+#include <boost/core/null_deleter.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/attributes/value_extraction.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sinks/sync_frontend.hpp>
+#include <boost/log/sinks/text_ostream_backend.hpp>
+#include <sstream>
+
+using namespace Merrie;
+
+namespace {
+    namespace logging = boost::log;
+    namespace sinks = logging::sinks;
+    namespace expr = logging::expressions;
+
+    using _Sink = sinks::synchronous_sink<sinks::text_ostream_backend>;
+
+    /**
+     * Writes the records into a string as "name|severity|message" while it exists.
+     */
+    class _CapturedLog {
+        public:
+            _CapturedLog() : m_sink(boost::make_shared<_Sink>()) {
+                m_sink->locked_backend()->add_stream(boost::shared_ptr<std::ostream>(&m_stream, boost::null_deleter()));
+                m_sink->set_formatter([](const logging::record_view& record, logging::formatting_ostream& stream) {
+                    stream << logging::extract<std::string>("Name", record) << "|"
+                           << static_cast<int>(logging::extract<LoggingSeverity>("Severity", record).get()) << "|"
+                           << record[expr::smessage];
+                });
+                logging::core::get()->add_sink(m_sink);
+            }
+
+            ~_CapturedLog() {
+                logging::core::get()->remove_sink(m_sink);
+            }
+
+            std::string GetText() {
+                m_sink->flush();
+                return m_stream.str();
+            }
+
+        private:
+            std::stringstream m_stream{};
+            boost::shared_ptr<_Sink> m_sink;
+    };
+}
+
+TEST(TestLogging, TestContextLogger) {
+    ContextLogger logger("Player", 42);
+    EXPECT_EQ(logger.GetName(), "Player#42");
+    EXPECT_LE(sizeof(ContextLogger), 24);
+
+    _CapturedLog log;
+    M_LOG_INFO(logger) << "Joined the game";
+    M_LOG_WARNING(logger) << "Lost " << 3 << " events";
+
+    EXPECT_EQ(log.GetText(), "Player#42|2|Joined the game\nPlayer#42|4|Lost 3 events\n");
+}
+
+TEST(TestLogging, TestContextLoggerDisabled) {
+    ContextLogger logger("Player", 42);
+    _CapturedLog log;
+
+    logging::core::get()->set_logging_enabled(false);
+    M_LOG_INFO(logger) << "Not written";
+    logging::core::get()->set_logging_enabled(true);
+    M_LOG_INFO(logger) << "Written";
+
+    EXPECT_EQ(log.GetText(), "Player#42|2|Written\n");
+}
+
+TEST(TestLogging, TestContextLoggerMinimumSeverity) {
+    ContextLogger logger("Player", 42);
+    _CapturedLog log;
+
+    // the messages below the minimum severity are dropped before their records are created
+    LoggingSystem::UpdateFilters({}, LoggingSeverity::Warning);
+    EXPECT_EQ(LoggingSystem::GetMinimumSeverity(), LoggingSeverity::Warning);
+    M_LOG_INFO(logger) << "Not written";
+    M_LOG_WARNING(logger) << "Written";
+    LoggingSystem::UpdateFilters({});
+
+    M_LOG_INFO(logger) << "Written again";
+
+    EXPECT_EQ(log.GetText(), "Player#42|4|Written\nPlayer#42|2|Written again\n");
+}
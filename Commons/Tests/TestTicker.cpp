@@ -220,4 +220,37 @@ TEST(TickerTest, TestRepeats)
     ticker.DoTick();
 
     EXPECT_EQ(repetitions, repeatingCounter) << "Repeating task was called after being cancelled";
-}
\ No newline at end of file
+}
+
+TEST(TickerTest, TestEndOfTickTasks)
+{
+    Ticker ticker;
+
+    std::vector<int> order;
+
+    ticker.DoAtEndOfTick([&](const std::shared_ptr<Task>&) {
+        order.emplace_back(2);
+    }, false);
+
+    EXPECT_TRUE(order.empty()) << "End of tick task was called on the spot";
+
+    std::thread otherThread([&]() {
+        ticker.DoInMainThread([&](const std::shared_ptr<Task>&) {
+            order.emplace_back(1);
+        }, false);
+    });
+
+    if (otherThread.joinable())
+    {
+        otherThread.join();
+    }
+
+    while (ticker.GetCurrentTick() != 2)
+    {
+        ticker.DoTick();
+    }
+
+    ASSERT_EQ(2u, order.size()) << "Tasks were not called exactly once";
+    EXPECT_EQ(1, order[0]) << "End of tick task was called before the tasks of the tick";
+    EXPECT_EQ(2, order[1]) << "End of tick task was called before the tasks of the tick";
+}
@@ -0,0 +1,144 @@
+// Measures the throughput of the global chat with many recipients.
+//
+// Usage: Merrie_GameServer_Benchmark_Chat [seconds per scenario] [players] [messages per poll]
+//
+// Every message is delivered to all players and the players poll after every few messages, like the main thread does
+// during a tick. The chat of the ChatBroadcaster, serialized once into a shared buffer, is compared with pushing the message
+// to every player as events, which copies and serializes it for every recipient. The time spent delivering the messages is
+// reported separately from the time spent writing them into the responses.
+
+#include <Commons/JsonWriter.hpp>
+#include <Commons/Time.hpp>
+#include <GameServer/Chat.hpp>
+#include <GameServer/Player.hpp>
+
+#include <cstdio>
+
+using namespace Merrie;
+
+namespace {
+    constexpr const std::string_view c_text = "Siemano kolano, who wants to go to the Mushroom Caves with me?";
+
+    struct _Result {
+        uint64_t Messages = 0;
+        DefaultClock::duration DeliveryTime{};
+        DefaultClock::duration ResponseTime{};
+        size_t ResponseBytes = 0;
+    };
+
+    double _ToSeconds(DefaultClock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    void _Print(const char* name, const _Result& result, size_t playerCount) {
+        const double deliveries = static_cast<double>(result.Messages) * static_cast<double>(playerCount);
+
+        std::printf("%-22s %10.0f messages/s, %12.0f deliveries/s, %8.1f ns per delivery, %8.1f ns per written message (%zu bytes of responses)\n",
+                    name, static_cast<double>(result.Messages) / _ToSeconds(result.DeliveryTime + result.ResponseTime),
+                    deliveries / _ToSeconds(result.DeliveryTime + result.ResponseTime), _ToSeconds(result.DeliveryTime) * 1e9 / deliveries,
+                    _ToSeconds(result.ResponseTime) * 1e9 / deliveries, result.ResponseBytes);
+    }
+
+    /**
+     * The message is pushed to every player as events, the way the server events are sent.
+     */
+    _Result _RunEvents(std::vector<std::unique_ptr<Player>>& players, std::chrono::seconds duration, uint64_t messagesPerPoll) {
+        _Result result;
+        const DefaultClock::time_point start = DefaultClock::now();
+
+        while (DefaultClock::now() - start < duration) {
+            const DefaultClock::time_point deliveryStart = DefaultClock::now();
+
+            for (uint64_t message = 0; message < messagesPerPoll; message++) {
+                const nlohmann::json events = {{"c", {{std::to_string(result.Messages++), {{"k", 0}, {"n", "User#1"}, {"i", ""}, {"nd", ""}, {"t", c_text}, {"s", ""}, {"ts", 1577836800.0}}}}}};
+
+                for (const std::unique_ptr<Player>& player : players) {
+                    player->PushEvents(events);
+                }
+            }
+
+            const DefaultClock::time_point responseStart = DefaultClock::now();
+            result.DeliveryTime += responseStart - deliveryStart;
+
+            for (const std::unique_ptr<Player>& player : players) {
+                JsonWriter writer;
+                writer.BeginObject();
+                writer.RawMembers(player->TakePendingEvents().dump());
+                writer.EndObject();
+                result.ResponseBytes += writer.TakeString().size();
+            }
+
+            result.ResponseTime += DefaultClock::now() - responseStart;
+        }
+
+        return result;
+    }
+
+    /**
+     * The message is sent through the ChatBroadcaster, serialized once and shared by the players.
+     */
+    _Result _RunChat(std::vector<std::unique_ptr<Player>>& players, std::chrono::seconds duration, uint64_t messagesPerPoll) {
+        ChatBroadcaster chat;
+
+        for (const std::unique_ptr<Player>& player : players) {
+            chat.Join(*player);
+        }
+
+        _Result result;
+        const DefaultClock::time_point start = DefaultClock::now();
+
+        while (DefaultClock::now() - start < duration) {
+            const DefaultClock::time_point deliveryStart = DefaultClock::now();
+
+            for (uint64_t message = 0; message < messagesPerPoll; message++) {
+                chat.Send(ChatChannel::Global, *players.front(), c_text);
+                result.Messages++;
+            }
+
+            const DefaultClock::time_point responseStart = DefaultClock::now();
+            result.DeliveryTime += responseStart - deliveryStart;
+
+            for (const std::unique_ptr<Player>& player : players) {
+                JsonWriter writer;
+                writer.BeginObject();
+                writer.BeginObject("c");
+
+                for (const std::shared_ptr<const std::string>& message : player->TakeChatMessages()) {
+                    writer.RawMembers(*message);
+                }
+
+                writer.EndObject();
+                writer.EndObject();
+                result.ResponseBytes += writer.TakeString().size();
+            }
+
+            result.ResponseTime += DefaultClock::now() - responseStart;
+        }
+
+        for (const std::unique_ptr<Player>& player : players) {
+            chat.Leave(*player);
+        }
+
+        return result;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::seconds duration(argc > 1 ? std::stoul(argv[1]) : 5);
+    const size_t playerCount = argc > 2 ? std::stoul(argv[2]) : 10000;
+    const uint64_t messagesPerPoll = argc > 3 ? std::stoull(argv[3]) : 8;
+
+    std::printf("%ld seconds per scenario, %zu players, %lu messages per poll\n", static_cast<long>(duration.count()), playerCount,
+                static_cast<unsigned long>(messagesPerPoll));
+
+    std::vector<std::unique_ptr<Player>> players;
+    players.reserve(playerCount);
+
+    for (size_t aid = 1; aid <= playerCount; aid++) {
+        players.push_back(std::make_unique<Player>(aid));
+    }
+
+    _Print("events per player", _RunEvents(players, duration, messagesPerPoll), playerCount);
+    _Print("ChatBroadcaster", _RunChat(players, duration, messagesPerPoll), playerCount);
+    return 0;
+}
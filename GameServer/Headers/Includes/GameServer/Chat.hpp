@@ -0,0 +1,81 @@
+#ifndef MERRIE_GAMESERVER_HEADERS_GAMESERVER_CHAT_HPP
+#define MERRIE_GAMESERVER_HEADERS_GAMESERVER_CHAT_HPP
+
+#include <Commons/Commons.hpp>
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Merrie {
+    class Player; // Player.hpp
+
+    /**
+     * The channels of the chat, the values are the kinds ("k") that the client shows the messages as.
+     */
+    enum class ChatChannel : uint8_t {
+            Global = 0, // every player in the game
+            Town = 1, // the players in the town of the sender
+            Whisper = 3, // one player, the sender gets a copy
+    };
+
+    /**
+     * Delivers the chat messages to the players in their channels.
+     *
+     * A message is serialized once, as the "c" entry that the clients get, into an immutable buffer shared by all of its
+     * recipients. Delivering it only queues a reference to the buffer for every recipient, the buffer is copied straight into
+     * their responses and freed once the last one got it. The players of the global channel are kept in one array, so a
+     * broadcast is a pass over it.
+     *
+     * Must be used from the main thread only.
+     */
+    class ChatBroadcaster {
+        public: // Constants
+            /**
+             * Maximum length of a message in bytes, the longer ones are cut.
+             */
+            static constexpr const size_t MaxMessageLength = 200;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(ChatBroadcaster);
+            NON_MOVEABLE(ChatBroadcaster);
+
+            ChatBroadcaster();
+
+        public: // Public methods
+            /**
+             * Adds the player to the global channel and makes it reachable by whispers.
+             */
+            void Join(Player& player);
+
+            /**
+             * Removes the player from the channels, nothing happens if it did not join.
+             */
+            void Leave(Player& player);
+
+            /**
+             * Sends the message from the player to the channel.
+             *
+             * @param recipient character name of the recipient, only for whispers
+             * @return false if the message is empty or not valid UTF-8, or if the recipient of a whisper is not in the game
+             */
+            bool Send(ChatChannel channel, Player& sender, std::string_view text, std::string_view recipient = {});
+
+            [[nodiscard]] size_t GetPlayerCount() const noexcept;
+
+        private: // Private methods
+            /**
+             * Serializes the message as an object with its only member being the message by its id.
+             */
+            [[nodiscard]] std::shared_ptr<const std::string> Serialize(ChatChannel channel, const Player& sender, std::string_view text, std::string_view recipient);
+
+        private: // Private fields
+            std::vector<Player*> m_players{};
+            std::unordered_map<std::string, size_t> m_playerIndexes{}; // the indexes in m_players by the character names
+            uint64_t m_nextMessageId = 1;
+    };
+
+}
+
+#endif //MERRIE_GAMESERVER_HEADERS_GAMESERVER_CHAT_HPP
@@ -2,20 +2,43 @@
 #define MERRIE_GAMESERVER_HEADERS_GAMESERVER_GAMESERVER_HPP
 
 #include <Commons/Commons.hpp>
+#include <Commons/Containers.hpp>
 #include <Commons/Logging.hpp>
 #include <Commons/Time.hpp>
 #include <Commons/Network/Http.hpp>
-#include <shared_mutex>
+#include <Commons/Storage/AppendLogStore.hpp>
+#include <GameServer/Network/SessionAuthenticator.hpp>
 
 namespace Merrie {
+    class ChatBroadcaster; // Chat.hpp
     class Ticker; // Commons/Ticker.hpp
     class GameHttpServer; // Network/GameHttpServer.hpp
     class Player; // Player.hpp
+    class Town; // Town.hpp
+
+    /**
+     * Settings of the long-polling of the /engine endpoint
+     */
+    struct LongPollSettings {
+        /**
+         * Should empty polls wait for events instead of being responded to right away.
+         */
+        bool Enabled{};
+
+        /**
+         * How long a poll can wait for events in seconds, it has to be shorter than the HTTP timeouts.
+         */
+        uint16_t Timeout{};
+    };
 
     struct GameServerSettings {
         HttpServerSettings HttpServerSettingsValue;
         unsigned int Tps;
         std::vector<std::string> LogFilters;
+        LoggingSeverity LogSeverity{};
+        LongPollSettings LongPollSettingsValue{};
+        AppendLogStoreSettings PlayerStoreSettingsValue{};
+        AuthenticationSettings AuthenticationSettingsValue{};
     };
 
     /*
@@ -41,19 +64,82 @@ namespace Merrie {
 
             [[nodiscard]] const std::unique_ptr<Ticker>& GetTicker() const noexcept;
 
+            /**
+             * Gets the player with the account id, the player joins the game if it is not in it yet. A joining player is
+             * loaded from the player store, so it can wait for the disk. Can be called from any thread but the main thread.
+             */
             std::shared_ptr<Player> GetPlayer(uint64_t aid);
 
+            /**
+             * Parks a long-poll request of the player, it is released at the end of a tick in which the player has events
+             * or is kicked, or once the long-poll timeout passes, right away if the player has left. Must be called from the
+             * main thread.
+             */
+            void ParkPoll(const std::shared_ptr<Player>& player, std::function<void()> release);
+
+        private:
+            /**
+             * The players in the storage of the main thread, with the data that the ticks go over.
+             */
+            struct PlayerRecord {
+                std::shared_ptr<Player> Player_;
+                std::function<void()> ParkedPoll{};
+                DefaultClock::time_point ParkedPollDeadline{};
+                uint64_t ParkedPollId = 0; // counts the parked polls of the player
+            };
+
+            /**
+             * A time in the timeout wheel, the inactivity timeout of a player or the deadline of one of its parked polls.
+             */
+            struct PlayerTimeout {
+                SlotHandle Handle = InvalidSlotHandle;
+                uint64_t ParkedPollId = 0; // the poll that the deadline belongs to, 0 for the inactivity timeout
+            };
+
         private:
+            /**
+             * Moves the players that joined since the last tick into the storage of the main thread.
+             */
+            void AdmitJoinedPlayers();
+
             void Tick();
 
+            /**
+             * Handles a player that came out of the timeout wheel, the player leaves the game if its timeout has passed.
+             */
+            void CheckPlayerTimeout(SlotHandle handle);
+
+            /**
+             * Handles a parked poll deadline that came out of the timeout wheel, the poll is released if it is still parked.
+             */
+            void CheckParkedPollDeadline(const PlayerTimeout& timeout);
+
+            /**
+             * Releases the parked polls of the players marked dirty during the tick and pushes the events of the ones
+             * connected through a WebSocket.
+             */
+            void ReleaseDirtyPlayers();
+
+            /**
+             * Queues the data of the player to be written to the player store, if it changed.
+             */
+            void SavePlayer(Player& player);
+
         private:
             const GameServerSettings m_settings;
             bool m_running = false;
             std::unique_ptr<GameHttpServer> m_gameHttpServer;
             std::unique_ptr<Ticker> m_ticker;
-            std::shared_mutex m_playersMutex{};
-            std::map<uint64_t, std::shared_ptr<Player>> m_players{};
-            DefaultClock::time_point m_oneSecondTasks{};
+            std::unique_ptr<AppendLogStore> m_playerStore{}; // written behind, null if the players are not stored
+            ShardedHashMap<uint64_t, std::shared_ptr<Player>> m_players{};
+            ShardedInbox<std::shared_ptr<Player>> m_joinedPlayers; // the players that are not admitted yet
+            ShardedInbox<SlotHandle> m_dirtyPlayers; // the players that got events since the end of the last tick
+
+            // main thread only
+            SlotMap<PlayerRecord> m_playerRecords{};
+            TimingWheel<PlayerTimeout> m_playerTimeouts;
+            std::unique_ptr<Town> m_town; // every player is in it, there is one town for now
+            std::unique_ptr<ChatBroadcaster> m_chat;
 
             M_DECLARE_LOGGER;
     };
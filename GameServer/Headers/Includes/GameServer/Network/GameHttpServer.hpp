@@ -2,10 +2,16 @@
 #define MERRIE_GAMESERVER_HEADERS_GAMESERVER_NETWORK_GAMEHTTPSERVER_HPP
 
 #include "../GameServer.hpp"
+#include "Packets.hpp"
+#include "SessionAuthenticator.hpp"
 
+#include <Commons/Containers.hpp>
 #include <Commons/Network/Http.hpp>
+#include <Commons/Network/HttpRouter.hpp>
+#include <Commons/Network/WebSocket.hpp>
 
 namespace Merrie {
+    class Player; // Player.hpp
 
     /*
      * TODO Docs
@@ -18,14 +24,133 @@ namespace Merrie {
 
             GameHttpServer(GameServer* gameServer, HttpServerSettings settings);
 
+        public: // Public methods
+            /**
+             * Gets the request counters and latencies of the HTTP routes.
+             */
+            [[nodiscard]] std::vector<HttpRouteStatistics> GetRouteStatistics() const;
+
+            /**
+             * Runs the sync packet handler chain of all engine packets received since the last call in one batch, this is the
+             * network ingest phase of a tick. Must be called from the main thread.
+             */
+            void ProcessInbox();
+
+            /**
+             * Pushes the pending events of the player through its WebSocket connection, as the response to an empty poll that
+             * the client did not have to send. Does nothing if the player is not initialized or has no push connection. Must
+             * be called from the main thread, before FlushResponses().
+             */
+            void PushPendingEvents(const std::shared_ptr<Player>& player);
+
+            /**
+             * Hands the outgoing packets collected during the tick to the network threads, they serialize and send them. Must be
+             * called from the main thread.
+             */
+            void FlushResponses();
+
         protected:
             void HandleRequest(std::shared_ptr<HttpConnection> connection) override;
 
+        private: // Private types
+            /**
+             * Sends the serialized response of an engine packet through the transport that the packet came from.
+             */
+            struct EngineResponder {
+                /**
+                 * Executor of the connection that the packet came from, the response is serialized and sent from it.
+                 */
+                boost::asio::any_io_executor Executor;
+
+                std::function<void(std::string response)> Send;
+            };
+
+            /**
+             * State of an /engine WebSocket connection, accessed only from its strand.
+             */
+            struct EngineWebSocketSession {
+                uint64_t Aid = 0;
+                std::weak_ptr<Player> Player_{};
+            };
+
+            /**
+             * An engine packet that went through the async packet handler chain and waits for the main thread.
+             */
+            struct PendingEnginePacket {
+                HandleResult AsyncResult{};
+                IncomingPacket In;
+                OutgoingPacket Out;
+                EngineResponder Respond;
+                bool AllowParking{};
+            };
+
+            /**
+             * A handled engine packet waiting to be serialized and sent by the network threads.
+             */
+            struct PendingEngineResponse {
+                EngineResponder Respond;
+                OutgoingPacket Out;
+
+                /**
+                 * Reason of the stop packet that is sent instead of the outgoing packet, nullptr if the packet was handled.
+                 */
+                const char* StopReason = nullptr;
+            };
+
         private: // Private methods
+            void RegisterRoutes();
+
+            void HandleEngine(std::shared_ptr<HttpConnection> connection, const DecodedUrl& url);
+
+            #ifdef M_ENABLE_DEBUG
+            static void HandleDebugRequest(const std::shared_ptr<HttpConnection>& connection, const DecodedUrl& url);
+            #endif
+
             void HandleEnginePacket(std::shared_ptr<HttpConnection> connection, const DecodedUrl& url);
 
+            /**
+             * Handles an engine packet of the account, once the session token of the request was checked.
+             */
+            void HandleAuthenticatedEnginePacket(std::shared_ptr<HttpConnection> connection, uint64_t aid, std::string action, std::map<std::string, std::string> parameters);
+
+            /**
+             * Upgrades the connection to a WebSocket of the account.
+             *
+             * @param aid the account that the session token of the upgrade request belongs to, 0 if the authentication is disabled
+             */
+            void HandleEngineWebSocket(const std::shared_ptr<HttpConnection>& connection, uint64_t aid);
+
+            void HandleEngineMessage(EngineWebSocketSession& session, const std::shared_ptr<WebSocketConnection>& connection, const std::string& message);
+
+            /**
+             * Runs the packet handler chains and responds with the outgoing packet, it is the same for all transports.
+             *
+             * @param allowParking whether or not empty polls can wait for events (long-polling)
+             */
+            void ProcessEnginePacket(IncomingPacket in, EngineResponder respond, bool allowParking);
+
+            /**
+             * Parks the packet if it is an empty poll that should wait for events, otherwise responds to it. Must be called from the main thread.
+             */
+            void ProcessPendingEnginePacket(PendingEnginePacket& packet, size_t shard);
+
+            /**
+             * Runs the sync packet handler chain and queues the outgoing packet, it is serialized and sent later by the network
+             * threads. Must be called from the main thread.
+             *
+             * @param shard outbox shard that the response is queued in
+             */
+            void RespondToEnginePacket(HandleResult asyncResult, IncomingPacket& in, OutgoingPacket& out, EngineResponder respond, size_t shard);
+
         private: // Private fields
             GameServer* m_gameServer;
+            HttpRouter m_router;
+            std::unique_ptr<SessionAuthenticator> m_authenticator{}; // null if the aid parameter is trusted
+
+            ShardedInbox<PendingEnginePacket> m_inbox;
+
+            // accessed only by the main thread, each response is posted to the executor of its connection
+            std::vector<std::vector<PendingEngineResponse>> m_outbox;
     };
 
 
@@ -3,8 +3,13 @@
 
 #include "../GameServer.hpp"
 
+#include <Commons/JsonWriter.hpp>
 #include <Commons/Network/Http.hpp>
+#include <charconv>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <tuple>
+#include <utility>
 
 namespace Merrie {
     class Player; // Player.hpp
@@ -20,25 +25,79 @@ namespace Merrie {
 
             OutgoingPacket();
 
+            /**
+             * Gets the document of the packet, for the handlers that need to merge or change the fields. It is merged into the
+             * streamed fields when the packet is serialized.
+             */
             [[nodiscard]] nlohmann::json& GetJson() noexcept;
+
+            /**
+             * Gets the writer of the root object of the packet, the fields are serialized right away and cannot be changed
+             * afterwards. A field must not be written to both the writer and the document.
+             */
+            [[nodiscard]] JsonWriter& GetWriter();
+
+            /**
+             * Checks whether or not the packet has the top-level field, in the writer or in the document.
+             */
+            [[nodiscard]] bool HasField(std::string_view key) const;
+
+            /**
+             * Serializes the packet, it cannot be written to afterwards.
+             *
+             * \throw nlohmann::json::exception if the document cannot be serialized
+             */
+            [[nodiscard]] std::string Serialize();
+
         private:
             nlohmann::json m_json;
+            JsonWriter m_writer;
     };
 
+    /**
+     * Creates the packet that tells the client to stop, rendered from a template.
+     *
+     * @param reason reason shown to the player
+     */
+    [[nodiscard]] std::string CreateStopPacket(std::string_view reason);
+
+    /**
+     * Interned action of a packet, it indexes the dispatch tables built by FreezePacketHandlers().
+     */
+    using PacketActionId = uint32_t;
+
+    /**
+     * Id of the actions that no handler is registered for, only the handlers without action filters run.
+     */
+    constexpr const PacketActionId UnknownPacketAction = 0;
+
+    /**
+     * Id of the '_' action (the empty poll), only the handlers without action filters run.
+     */
+    constexpr const PacketActionId NoPacketAction = 1;
+
     struct IncomingPacket {
         std::shared_ptr<Player> Player_;
         std::string Action;
         std::map<std::string, std::string> Parameters;
+        PacketActionId ActionId = UnknownPacketAction;
     };
 
     enum class HandleResult {
             Ignored, // ignored by the handler
             ContinueHandling, // handled, but handling can continue
-            StopHandling, // handling, but handling should stop immediatly with a fail
+            StopHandling, // handling, but handling should stop immediatly with a fail, the handler may write the stop packet ("t": "stop") itself
     };
 
     using PacketHandler = std::function<HandleResult(const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out)>;
 
+    struct PacketHandlerData;
+
+    /**
+     * Calls the handler of the PacketHandlerData, generated for every registered handler.
+     */
+    using PacketHandlerInvoker = HandleResult (*)(const PacketHandlerData& data, const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out);
+
     enum class RunMode {
             Sync,
             Async
@@ -47,7 +106,18 @@ namespace Merrie {
     struct PacketHandlerData {
         RunMode Mode;
         std::vector<std::string> ActionFilters;
+
+        /**
+         * The handler, only for the handlers registered as a PacketHandler.
+         */
         PacketHandler Handler;
+
+        PacketHandlerInvoker Invoke;
+
+        /**
+         * Names of the typed parameters of the handler, in the order of the handler arguments.
+         */
+        std::vector<std::string> ParameterNames;
     };
 
 
@@ -58,6 +128,136 @@ namespace Merrie {
     [[nodiscard]] const std::vector<std::shared_ptr<PacketHandlerData>>& GetRegisteredAsyncPacketHandlers() noexcept;
 
     void RegisterPacketHandler(RunMode mode, std::vector<std::string> actionFilters, PacketHandler handler) noexcept;
+
+    /**
+     * Registers the prepared handler data, use one of the RegisterPacketHandler functions instead.
+     */
+    void RegisterPacketHandlerData(PacketHandlerData data) noexcept;
+
+    // ================================================================================
+    // =  Typed packet handlers                                                       =
+    // ================================================================================
+
+    /**
+     * Parses a packet parameter into a value of type T, specialized for every supported parameter type.
+     */
+    template<typename T, typename = void>
+    struct PacketParameterParser;
+
+    template<typename T>
+    struct PacketParameterParser<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+        static bool Parse(std::string_view text, T& value) noexcept {
+            const auto[end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size();
+        }
+    };
+
+    template<typename T>
+    struct PacketParameterParser<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+        static bool Parse(std::string_view text, T& value) noexcept {
+            const auto[end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc() && end == text.data() + text.size();
+        }
+    };
+
+    template<>
+    struct PacketParameterParser<std::string> {
+        static bool Parse(std::string_view text, std::string& value) {
+            value = text;
+            return true;
+        }
+    };
+
+    /**
+     * The view points into the parameters of the IncomingPacket, it is valid only during the call of the handler.
+     */
+    template<>
+    struct PacketParameterParser<std::string_view> {
+        static bool Parse(std::string_view text, std::string_view& value) noexcept {
+            value = text;
+            return true;
+        }
+    };
+
+    namespace Detail {
+        template<typename T>
+        bool ParsePacketParameter(const std::map<std::string, std::string>& parameters, const std::string& name, T& value) {
+            const auto iterator = parameters.find(name);
+            return iterator != parameters.end() && PacketParameterParser<T>::Parse(iterator->second, value);
+        }
+
+        template<typename T>
+        bool ParsePacketParameter(const std::map<std::string, std::string>& parameters, const std::string& name, std::optional<T>& value) {
+            const auto iterator = parameters.find(name);
+
+            if (iterator == parameters.end() || !PacketParameterParser<T>::Parse(iterator->second, value.emplace()))
+                value.reset();
+
+            return true;
+        }
+
+        template<typename Function>
+        struct PacketHandlerTraits;
+
+        template<typename... Parameters>
+        struct PacketHandlerTraits<HandleResult (*)(const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&, Parameters...)> {
+            using ParameterTypes = std::tuple<std::decay_t<Parameters>...>;
+            static constexpr const size_t ParameterCount = sizeof...(Parameters);
+        };
+
+        template<auto Handler, typename ParameterTypes, size_t... Indices>
+        HandleResult InvokePacketHandler(const PacketHandlerData& data, const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out,
+                                         std::index_sequence<Indices...>) {
+            ParameterTypes values{};
+
+            if (!(ParsePacketParameter(in.Parameters, data.ParameterNames[Indices], std::get<Indices>(values)) && ...))
+                return HandleResult::StopHandling;
+
+            return Handler(player, in, out, std::move(std::get<Indices>(values))...);
+        }
+
+        template<auto Handler>
+        HandleResult InvokePacketHandler(const PacketHandlerData& data, const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out) {
+            using Traits = PacketHandlerTraits<decltype(Handler)>;
+            return InvokePacketHandler<Handler, typename Traits::ParameterTypes>(data, player, in, out, std::make_index_sequence<Traits::ParameterCount>());
+        }
+    }
+
+    /**
+     * Registers a handler with typed parameters. The handler is a function
+     * HandleResult(const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&, Parameters...), the parameters are parsed
+     * from the packet by the PacketParameterParser of their type and the handler is called directly, without type erasure.
+     *
+     * Handling stops when a parameter is missing or cannot be parsed, std::optional parameters are empty instead.
+     *
+     * @param mode where the handler runs
+     * @param actionFilters actions that the handler handles, all actions when empty
+     * @param parameterNames names of the packet parameters, one for every parameter of the handler
+     */
+    template<auto Handler, typename... Names>
+    void RegisterPacketHandler(RunMode mode, std::vector<std::string> actionFilters, Names... parameterNames) noexcept {
+        static_assert(sizeof...(Names) == Detail::PacketHandlerTraits<decltype(Handler)>::ParameterCount, "Every parameter of the handler needs a name");
+
+        RegisterPacketHandlerData(PacketHandlerData{mode, std::move(actionFilters), {}, &Detail::InvokePacketHandler<Handler>, {std::string(parameterNames)...}});
+    }
+
+    /**
+     * Builds the dispatch tables: every action gets the list of its handlers merged with the handlers without action filters,
+     * in the registration order, and the actions are put into a perfect hash table. No handlers can be registered afterwards.
+     */
+    void FreezePacketHandlers() noexcept;
+
+    /**
+     * Finds the interned id of the action, the packet handlers have to be frozen.
+     *
+     * @return the id or UnknownPacketAction if no handler is registered for the action
+     */
+    [[nodiscard]] PacketActionId FindPacketAction(std::string_view action) noexcept;
+
+    /**
+     * Gets the handlers that run for the action, in the registration order. The packet handlers have to be frozen.
+     */
+    [[nodiscard]] const std::vector<const PacketHandlerData*>& GetPacketHandlerChain(RunMode mode, PacketActionId action) noexcept;
 }
 
 #endif //MERRIE_GAMESERVER_HEADERS_GAMESERVER_NETWORK_GAMEHTTPSERVER_HPP
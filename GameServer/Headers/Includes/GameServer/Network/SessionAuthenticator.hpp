@@ -0,0 +1,142 @@
+#ifndef MERRIE_GAMESERVER_HEADERS_GAMESERVER_NETWORK_SESSIONAUTHENTICATOR_HPP
+#define MERRIE_GAMESERVER_HEADERS_GAMESERVER_NETWORK_SESSIONAUTHENTICATOR_HPP
+
+#include <Commons/Commons.hpp>
+#include <Commons/Containers.hpp>
+#include <Commons/Crypto/SessionToken.hpp>
+
+#include <boost/asio/thread_pool.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Merrie {
+
+    /**
+     * Settings of the authentication of the players
+     */
+    struct AuthenticationSettings {
+        /**
+         * Should the players prove their accounts with session tokens, otherwise the aid parameter is trusted.
+         */
+        bool Enabled{};
+
+        /**
+         * The secret that the session tokens are signed with, shared with whoever issues them.
+         */
+        std::string Secret{};
+
+        /**
+         * Name of the cookie with the session token.
+         */
+        std::string CookieName{};
+
+        /**
+         * Amount of threads dedicated to verifying the tokens.
+         */
+        size_t VerifyThreadCount{};
+
+        /**
+         * Maximum amount of verified sessions that are remembered, the expired ones are dropped when it is reached.
+         */
+        size_t MaxCachedSessions{};
+
+        /**
+         * Maximum amount of tokens waiting for or in verification, the ones above the limit are rejected right away. 0 for
+         * no limit.
+         */
+        size_t MaxPendingVerifications{};
+    };
+
+    /**
+     * Checks the session tokens of the players.
+     *
+     * A token is verified once, on the verify threads so the I/O threads never compute MACs, and the verified session is
+     * remembered by the account, a few sessions per account. The following requests of the session only compare their token
+     * with the remembered ones. All methods can be called from any thread.
+     */
+    class SessionAuthenticator {
+        public: // Constants
+            /**
+             * How many sessions of an account are remembered at once, for example of the same account in several browsers.
+             */
+            static constexpr const size_t MaxSessionsPerAccount = 4;
+
+        public: // Types
+            /**
+             * Called on a verify thread with the session of a verified token, std::nullopt if the token is not valid.
+             */
+            using VerifyCallback = std::function<void(std::optional<SessionToken> session)>;
+
+        public: // Constructors & destructors
+            NON_COPYABLE(SessionAuthenticator);
+            NON_MOVEABLE(SessionAuthenticator);
+
+            /**
+             * Starts the verify threads.
+             *
+             * \throw SessionTokenException if the secret is empty or Merrie was compiled without OpenSSL
+             */
+            explicit SessionAuthenticator(AuthenticationSettings settings);
+
+            /**
+             * Waits for the verify threads to finish.
+             */
+            ~SessionAuthenticator();
+
+        public: // Public methods
+            /**
+             * Checks whether or not the token was verified for the account and did not expire since, without any cryptography.
+             */
+            [[nodiscard]] bool IsVerified(uint64_t aid, std::string_view token) const;
+
+            /**
+             * Verifies the token on a verify thread, valid tokens are remembered for IsVerified().
+             *
+             * @return false if there are too many tokens waiting for verification, the callback is not called then
+             */
+            bool Verify(std::string token, VerifyCallback callback);
+
+            /**
+             * Gets the settings of the authenticator.
+             */
+            [[nodiscard]] const AuthenticationSettings& GetSettings() const noexcept;
+
+        private: // Private types
+            struct VerifiedSession {
+                std::string Token;
+                std::chrono::system_clock::time_point Expiry;
+            };
+
+            using VerifiedSessions = std::vector<VerifiedSession>;
+
+        private: // Private methods
+            /**
+             * Remembers the verified session, unless there are too many accounts with sessions that did not expire yet.
+             */
+            void Remember(std::string token, const SessionToken& session);
+
+            /**
+             * Reserves a place for a verification.
+             *
+             * @return false if it should be rejected
+             */
+            [[nodiscard]] bool TryBegin() noexcept;
+
+        private: // Private fields
+            const AuthenticationSettings m_settings;
+
+            #ifdef M_HAS_OPENSSL_CRYPTO
+            const SessionTokenSigner m_signer;
+            #endif
+
+            // up to MaxSessionsPerAccount sessions per account, the oldest one makes room for a new token
+            ShardedHashMap<uint64_t, std::shared_ptr<const VerifiedSessions>> m_sessions{};
+            std::atomic<size_t> m_pending{0};
+            boost::asio::thread_pool m_verifyPool;
+    };
+
+}
+
+#endif //MERRIE_GAMESERVER_HEADERS_GAMESERVER_NETWORK_SESSIONAUTHENTICATOR_HPP
@@ -2,11 +2,19 @@
 #define MERRIE_GAMESERVER_SOURCE_NETWORK_PLAYERCONNECTION_HPP
 #pragma once
 
+#include <Commons/Containers.hpp>
 #include <Commons/Time.hpp>
 #include "GameServer.hpp"
+#include "PlayerState.hpp"
+#include <deque>
+#include <nlohmann/json.hpp>
 #include <shared_mutex>
 
 namespace Merrie {
+    class ChatBroadcaster; // Chat.hpp
+    class Town; // Town.hpp
+    class WebSocketConnection; // Commons/Network/WebSocket.hpp
+
     /*
      * TODO Docs
      */
@@ -21,6 +29,24 @@ namespace Merrie {
     };
 
     class Player {
+        public: // Constants
+            /**
+             * How many events can wait for the main thread, the later ones are dropped. The events are coalesced into the
+             * pending events by every response, and for the players that do not poll when they come out of the timeout wheel,
+             * about once per InactivityTimeout.
+             */
+            static constexpr const size_t MaxQueuedEvents = 1024;
+
+            /**
+             * How many chat messages can wait for the next response, the oldest ones are dropped.
+             */
+            static constexpr const size_t MaxQueuedChatMessages = 64;
+
+            /**
+             * How long a player stays in the game without sending any packets.
+             */
+            static constexpr const std::chrono::seconds InactivityTimeout{10}; // todo: configurable
+
         public:
             NON_COPYABLE(Player);
             NON_MOVEABLE(Player);
@@ -32,13 +58,19 @@ namespace Merrie {
 
             [[nodiscard]] const std::string& GetCharacterName() const noexcept;
 
-            void SetTimeout();
+            /**
+             * Moves the timeout of the player to InactivityTimeout from now, can be called from any thread.
+             */
+            void SetTimeout() noexcept;
 
             [[nodiscard]] bool IsOnline() const noexcept;
 
             [[nodiscard]] bool IsInitialized() const noexcept;
 
-            [[nodiscard]] const DefaultClock::time_point& GetTimeout() const noexcept;
+            /**
+             * Gets the time the player leaves the game at unless it sends a packet, can be called from any thread.
+             */
+            [[nodiscard]] DefaultClock::time_point GetTimeout() const noexcept;
 
             [[nodiscard]] InitLevel GetInitLevel() const noexcept;
 
@@ -56,7 +88,164 @@ namespace Merrie {
 
             void Kick(std::string_view message);
 
-            Logger& GetLogger() const;
+            /**
+             * Sets the connection that the server pushed messages are sent through, replaces the previous one.
+             */
+            void AttachPushConnection(const std::shared_ptr<WebSocketConnection>& connection);
+
+            /**
+             * Removes the push connection, if it is still the given one.
+             */
+            void DetachPushConnection(const std::shared_ptr<WebSocketConnection>& connection);
+
+            /**
+             * Checks whether or not the player has a connection that messages can be pushed through.
+             */
+            [[nodiscard]] bool HasPushConnection() const;
+
+            /**
+             * Gets the connection that messages can be pushed through, nullptr if there is none or it is closed.
+             */
+            [[nodiscard]] std::shared_ptr<WebSocketConnection> GetPushConnection() const;
+
+            /**
+             * Sends the message to the player without waiting for a request.
+             *
+             * @return false if the player does not have a push connection
+             */
+            bool Push(std::shared_ptr<const std::string> message);
+
+            /**
+             * Puts the handle of the player into the dirty list, so the end of the tick releases its parked poll or pushes its
+             * events. Only the first call until the main thread takes the mark adds the player, can be called from any thread.
+             */
+            void MarkDirty();
+
+            /**
+             * Takes the mark of MarkDirty(), the changes made after it put the player into the dirty list again. Must be
+             * called from the main thread.
+             *
+             * @return whether or not the player was marked dirty
+             */
+            bool TakeDirtyMark() noexcept;
+
+            /**
+             * Sets the dirty list of the game server, before the handle of the player is set. Must be called from the main thread.
+             */
+            void SetDirtyList(ShardedInbox<SlotHandle>* dirtyList) noexcept;
+
+            /**
+             * Queues the events to be sent with the next response, can be called from any thread. The events are merged into
+             * each other, so the later values of the same keys replace the earlier ones, nested objects are merged too.
+             *
+             * @param events object of the events
+             * @return false if the queue is full and the events were dropped
+             */
+            bool PushEvents(nlohmann::json events);
+
+            /**
+             * Merges the queued events into the pending events. Must be called from the main thread.
+             */
+            void CoalesceEvents();
+
+            /**
+             * Queues the chat message to be sent with the next response. Must be called from the main thread.
+             *
+             * @param message the message serialized as an object with the message by its id, shared by all recipients
+             */
+            void QueueChatMessage(std::shared_ptr<const std::string> message);
+
+            /**
+             * Takes the chat messages that were not sent yet, oldest first. Must be called from the main thread.
+             */
+            [[nodiscard]] std::deque<std::shared_ptr<const std::string>> TakeChatMessages();
+
+            /**
+             * Checks whether or not there are events, chat messages or state changes that were not sent yet. Must be called
+             * from the main thread.
+             */
+            [[nodiscard]] bool HasPendingEvents() const noexcept;
+
+            /**
+             * Takes the events that were not sent yet, including the queued ones. Must be called from the main thread.
+             */
+            [[nodiscard]] nlohmann::json TakePendingEvents();
+
+            /**
+             * Puts back the taken events that did not fit into the response, they are sent with the next one. The events
+             * queued in the meantime are newer and take precedence. Must be called from the main thread.
+             */
+            void RestorePendingEvents(nlohmann::json events);
+
+            /**
+             * Gets the state of the game as the client sees it. Must be called from the main thread.
+             */
+            [[nodiscard]] PlayerState& GetState() noexcept;
+
+            /**
+             * Creates the sequence of the next response, it is sent as the "ev" field and acknowledged by the client with the
+             * "ev" parameter. The sequences are the times of the responses in milliseconds, made unique. Must be called from the main thread.
+             */
+            StateSequence CreateResponseSequence();
+
+            /**
+             * Gets the sequence created last. Must be called from the main thread.
+             */
+            [[nodiscard]] StateSequence GetResponseSequence() const noexcept;
+
+            /**
+             * Gets the handle of the player in the storage of the main thread, InvalidSlotHandle until the main thread
+             * admits the player and after it leaves. Can be called from any thread.
+             */
+            [[nodiscard]] SlotHandle GetHandle() const noexcept;
+
+            void SetHandle(SlotHandle handle) noexcept;
+
+            /**
+             * Gets the position of the hero in its town. Must be called from the main thread.
+             */
+            [[nodiscard]] std::pair<int32_t, int32_t> GetPosition() const noexcept;
+
+            /**
+             * Sets the position of the hero, the Town of the player calls it when the player moves. Must be called from the
+             * main thread.
+             */
+            void SetPosition(int32_t x, int32_t y);
+
+            /**
+             * Gets the town that the player is in, nullptr until the main thread admits the player. Must be called from the
+             * main thread.
+             */
+            [[nodiscard]] Town* GetTown() const noexcept;
+
+            void SetTown(Town* town) noexcept;
+
+            /**
+             * Gets the chat that the player sends its messages to, nullptr until the main thread admits the player. Must be
+             * called from the main thread.
+             */
+            [[nodiscard]] ChatBroadcaster* GetChat() const noexcept;
+
+            void SetChat(ChatBroadcaster* chat) noexcept;
+
+            /**
+             * Serializes the data of the player that is kept between the sessions and marks it as saved. Must be called from
+             * the main thread.
+             */
+            [[nodiscard]] std::string Save();
+
+            /**
+             * Checks whether or not the data changed since it was saved last. Must be called from the main thread.
+             */
+            [[nodiscard]] bool HasUnsavedChanges() const noexcept;
+
+            /**
+             * Restores the data saved by Save(), before the player is shared with other threads. Invalid data is reported and
+             * ignored.
+             */
+            void Restore(std::string_view data);
+
+            ContextLogger& GetLogger() const;
         private:
             const uint64_t m_aid;
             const std::string m_username;
@@ -64,11 +253,28 @@ namespace Merrie {
             mutable std::shared_mutex m_dataMutex;
             InitLevel m_initLevel = InitLevel::None;
             uint32_t m_browserToken = 0;
-            DefaultClock::time_point m_timeout{};
+            std::atomic<DefaultClock::time_point> m_timeout{};
             std::string m_kickMessage{};
+            std::weak_ptr<WebSocketConnection> m_pushConnection{};
+            BoundedMpscQueue<nlohmann::json> m_eventQueue{MaxQueuedEvents};
+            std::atomic<bool> m_eventsDropped{false};
+            std::atomic<bool> m_dirty{false};
+            std::atomic<SlotHandle> m_handle{InvalidSlotHandle}; // set by the main thread
+            ShardedInbox<SlotHandle>* m_dirtyList = nullptr; // set by the main thread before the handle
+
+            // main thread only
+            nlohmann::json m_pendingEvents = nlohmann::json::object();
+            PlayerState m_state{};
+            StateSequence m_responseSequence = 0;
+            uint64_t m_savedHeroVersion = 0;
+            Town* m_town = nullptr;
+            ChatBroadcaster* m_chat = nullptr;
+            std::deque<std::shared_ptr<const std::string>> m_chatMessages{};
+            int32_t m_x = 10;
+            int32_t m_y = 10;
 
-            M_DECLARE_LOGGER_EX("Player#"s + std::to_string(m_aid));
-            // TODO: Account
+            M_DECLARE_CONTEXT_LOGGER("Player", m_aid);
+            // TODO: Account, the hero starts with the values of the init packet until it is loaded from the account
     };
 
 }
@@ -0,0 +1,193 @@
+#ifndef MERRIE_GAMESERVER_HEADERS_GAMESERVER_PLAYERSTATE_HPP
+#define MERRIE_GAMESERVER_HEADERS_GAMESERVER_PLAYERSTATE_HPP
+
+#include <Commons/Commons.hpp>
+#include <Commons/JsonWriter.hpp>
+
+#include <array>
+#include <functional>
+#include <limits>
+#include <nlohmann/json_fwd.hpp>
+#include <string_view>
+#include <unordered_map>
+
+namespace Merrie {
+
+    /**
+     * Sequence of a response that carried a state delta, the client acknowledges it by sending it back.
+     */
+    using StateSequence = uint64_t;
+
+    /**
+     * The fields of the hero that are tracked, sent in the "h" object of the responses.
+     */
+    enum class HeroField : uint8_t {
+            X,
+            Y,
+            Dir,
+            Gold,
+            Exp,
+            Level,
+            Honor,
+            Stamina,
+
+            Count // not a field
+    };
+
+    /**
+     * The collections of the entities that are tracked, every collection is sent as an object of the entities by their ids.
+     */
+    enum class EntityCollection : uint8_t {
+            Others, // other players
+            Npcs,
+            Items,
+
+            Count // not a collection
+    };
+
+    /**
+     * The state of the game as the client of a player sees it, only the changes are sent to the client.
+     *
+     * Every change is marked dirty and stays dirty until the client acknowledges a response that carried it. A delta is
+     * written in one pass over the dirty entries: it contains the changes that were not sent yet and the ones that were sent
+     * in responses that the client did not acknowledge, so lost responses are made up for by the next one. Values that are
+     * set to what they already are do not produce changes.
+     *
+     * The values are kept serialized, as they are written into the responses. Must be used from the main thread only.
+     */
+    class PlayerState {
+        public: // Constructors & destructors
+            NON_COPYABLE(PlayerState);
+            NON_MOVEABLE(PlayerState);
+
+            PlayerState();
+
+        public: // Public methods
+            /**
+             * Sets a field of the hero.
+             *
+             * @param value anything that JsonWriter::Value() accepts
+             */
+            template<typename T>
+            void SetHeroField(HeroField field, T&& value);
+
+            /**
+             * Adds or updates an entity.
+             *
+             * @param object the serialized object of the entity
+             */
+            void SetEntity(EntityCollection collection, uint64_t id, std::string object);
+
+            /**
+             * Removes an entity, the client is told to remove it with {"del":1}.
+             */
+            void RemoveEntity(EntityCollection collection, uint64_t id);
+
+            /**
+             * Sets the function that is called when the state gets changes that were not sent yet, after it had none.
+             */
+            void SetChangeListener(std::function<void()> listener);
+
+            /**
+             * Checks whether or not there are changes that were not sent in any response yet.
+             */
+            [[nodiscard]] bool HasUnsentChanges() const noexcept;
+
+            /**
+             * Writes the delta into the root object of the response and marks the unsent changes as sent in it.
+             *
+             * @param sequence sequence of the response, it has to be greater than the sequences of the previous responses
+             * @return whether or not anything was written
+             */
+            bool WriteDelta(JsonWriter& writer, StateSequence sequence);
+
+            /**
+             * Marks the changes sent in the responses up to the sequence as received by the client, sequences that were not
+             * sent are ignored.
+             */
+            void Acknowledge(StateSequence sequence);
+
+            /**
+             * Forgets what the client has, for a client that starts from scratch. Everything is sent with the next delta.
+             */
+            void Reset();
+
+            /**
+             * Gets the sequence acknowledged last by the client.
+             */
+            [[nodiscard]] StateSequence GetAcknowledgedSequence() const noexcept;
+
+            /**
+             * Gets the version of the hero, it changes whenever a field of the hero changes.
+             */
+            [[nodiscard]] uint64_t GetHeroVersion() const noexcept;
+
+            /**
+             * Gets the serialized value of a field of the hero, empty if it was never set.
+             */
+            [[nodiscard]] std::string_view GetHeroFieldJson(HeroField field) const noexcept;
+
+            /**
+             * Writes all fields of the hero as an object, regardless of what the client has.
+             */
+            void WriteHero(JsonWriter& writer) const;
+
+            /**
+             * Sets the fields of the hero from an object written by WriteHero(), unknown keys are ignored.
+             *
+             * @return false if the hero is not an object, the fields are left as they were
+             */
+            bool RestoreHero(const nlohmann::json& hero);
+
+        private: // Private types
+            /**
+             * The response sequence of the changes that were not sent yet.
+             */
+            static constexpr const StateSequence Unsent = std::numeric_limits<StateSequence>::max();
+
+            struct Entry {
+                std::string Value{};
+
+                /**
+                 * Sequence of the response that carried the last change, Unsent if it was not sent yet.
+                 */
+                StateSequence SentIn = Unsent;
+
+                bool Dirty = false;
+                bool Removed = false;
+            };
+
+        private: // Private methods
+            void SetHeroFieldValue(HeroField field, std::string value);
+
+            /**
+             * Marks the entry as changed and not sent.
+             *
+             * @return true if the entry was not dirty before, it has to be added to its dirty list
+             */
+            bool MarkDirty(Entry& entry);
+
+        private: // Private fields
+            std::array<Entry, static_cast<size_t>(HeroField::Count)> m_heroFields{};
+            std::array<std::unordered_map<uint64_t, Entry>, static_cast<size_t>(EntityCollection::Count)> m_entities{};
+
+            // the entries that the client may not have, in the order of their first change
+            std::vector<HeroField> m_dirtyHeroFields{};
+            std::array<std::vector<uint64_t>, static_cast<size_t>(EntityCollection::Count)> m_dirtyEntities{};
+            size_t m_unsentChanges = 0;
+            std::function<void()> m_changeListener{};
+
+            StateSequence m_lastSequence = 0;
+            StateSequence m_acknowledgedSequence = 0;
+            uint64_t m_heroVersion = 0;
+    };
+
+    template<typename T>
+    void PlayerState::SetHeroField(HeroField field, T&& value) {
+        JsonWriter writer;
+        writer.Value(std::forward<T>(value));
+        SetHeroFieldValue(field, writer.TakeString());
+    }
+}
+
+#endif //MERRIE_GAMESERVER_HEADERS_GAMESERVER_PLAYERSTATE_HPP
@@ -0,0 +1,105 @@
+#ifndef MERRIE_GAMESERVER_HEADERS_GAMESERVER_TOWN_HPP
+#define MERRIE_GAMESERVER_HEADERS_GAMESERVER_TOWN_HPP
+
+#include <Commons/Commons.hpp>
+#include <Commons/Containers.hpp>
+
+#include <unordered_map>
+
+namespace Merrie {
+    class Player; // Player.hpp
+
+    /**
+     * A map that the players walk around, it tells every player about the others in its area of interest.
+     *
+     * The players are kept in a uniform grid with the cells as big as the view range, so finding the players that one can
+     * see only goes over the few cells around it. Every player remembers the players it sees, sorted by their ids, and the
+     * new set is compared with it when it moves: the players that came into the range are added to the others of the player
+     * and the player is added to theirs, the ones that went out of the range are removed on both sides and the ones that
+     * stay see the new position. A move costs about the amount of the players nearby, regardless of the amount in the town.
+     *
+     * Must be used from the main thread only.
+     */
+    class Town {
+        public: // Constructors & destructors
+            NON_COPYABLE(Town);
+            NON_MOVEABLE(Town);
+
+            /**
+             * @param width width of the town, the positions are from 0 to width - 1
+             * @param height height of the town, the positions are from 0 to height - 1
+             * @param viewRange how far the players see the others, on both axes
+             */
+            Town(uint32_t id, int32_t width, int32_t height, int32_t viewRange);
+
+        public: // Public methods
+            [[nodiscard]] uint32_t GetId() const noexcept;
+
+            [[nodiscard]] size_t GetPlayerCount() const noexcept;
+
+            /**
+             * Adds the player at its current position, the player and the ones in its range see each other.
+             */
+            void Enter(Player& player);
+
+            /**
+             * Moves the player, the position is clamped to the town. Nothing happens if the player is not in the town.
+             */
+            void Move(Player& player, int32_t x, int32_t y);
+
+            /**
+             * Removes the player, it disappears for the ones that saw it. Nothing happens if the player is not in the town.
+             */
+            void Leave(Player& player);
+
+            /**
+             * Calls the function for every player in the town.
+             *
+             * @param function function called as function(Player& player), it must not change the town
+             */
+            template<typename Function>
+            void ForEachPlayer(Function function) const;
+
+        private: // Private types
+            struct Resident {
+                Player* Player_;
+                int32_t X;
+                int32_t Y;
+
+                /**
+                 * Ids of the players that the player sees, sorted.
+                 */
+                std::vector<uint64_t> Visible{};
+            };
+
+        private: // Private methods
+            /**
+             * Compares the players in the range of the resident with the ones it saw and tells both sides about the changes.
+             */
+            void UpdateVisibility(uint64_t aid, Resident& resident);
+
+            /**
+             * Adds or updates the resident in the others of the observer.
+             */
+            static void ShowResident(Player& observer, const Resident& resident);
+
+        private: // Private fields
+            const uint32_t m_id;
+            const int32_t m_width;
+            const int32_t m_height;
+            const int32_t m_viewRange;
+            UniformGrid<uint64_t> m_grid;
+            std::unordered_map<uint64_t, Resident> m_residents{};
+            std::vector<uint64_t> m_inRange{}; // reused by UpdateVisibility()
+    };
+
+    template<typename Function>
+    void Town::ForEachPlayer(Function function) const {
+        for (const auto&[aid, resident] : m_residents) {
+            function(*resident.Player_);
+        }
+    }
+
+}
+
+#endif //MERRIE_GAMESERVER_HEADERS_GAMESERVER_TOWN_HPP
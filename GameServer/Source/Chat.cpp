@@ -0,0 +1,177 @@
+#include <GameServer/Chat.hpp>
+
+#include <Commons/JsonWriter.hpp>
+#include <GameServer/Player.hpp>
+#include <GameServer/Town.hpp>
+#include <charconv>
+#include <chrono>
+
+namespace Merrie {
+
+    namespace {
+        /**
+         * Cuts the text to the length, without splitting a UTF-8 character.
+         */
+        std::string_view _Truncate(std::string_view text, size_t length) noexcept {
+            if (text.size() <= length)
+                return text;
+
+            // the continuation bytes are 10xxxxxx
+            while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+                length--;
+            }
+
+            return text.substr(0, length);
+        }
+
+        /**
+         * Checks whether or not the text is valid UTF-8, overlong encodings, surrogates and code points above U+10FFFF are not.
+         */
+        bool _IsValidUtf8(std::string_view text) noexcept {
+            size_t i = 0;
+
+            while (i < text.size()) {
+                const auto byte = static_cast<unsigned char>(text[i]);
+                if (byte < 0x80) {
+                    i++;
+                    continue;
+                }
+
+                size_t length;
+                uint32_t codePoint;
+                uint32_t minimum; // the smallest code point that needs this length
+
+                if ((byte & 0xE0) == 0xC0) {
+                    length = 2;
+                    codePoint = byte & 0x1F;
+                    minimum = 0x80;
+                } else if ((byte & 0xF0) == 0xE0) {
+                    length = 3;
+                    codePoint = byte & 0x0F;
+                    minimum = 0x800;
+                } else if ((byte & 0xF8) == 0xF0) {
+                    length = 4;
+                    codePoint = byte & 0x07;
+                    minimum = 0x10000;
+                } else {
+                    return false;
+                }
+
+                if (text.size() - i < length)
+                    return false;
+
+                for (size_t j = 1; j < length; j++) {
+                    const auto continuation = static_cast<unsigned char>(text[i + j]);
+                    if ((continuation & 0xC0) != 0x80)
+                        return false;
+
+                    codePoint = (codePoint << 6) | (continuation & 0x3F);
+                }
+
+                if (codePoint < minimum || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+                    return false;
+
+                i += length;
+            }
+
+            return true;
+        }
+    }
+
+    ChatBroadcaster::ChatBroadcaster() = default;
+
+    void ChatBroadcaster::Join(Player& player) {
+        if (m_playerIndexes.try_emplace(player.GetCharacterName(), m_players.size()).second)
+            m_players.push_back(&player);
+    }
+
+    void ChatBroadcaster::Leave(Player& player) {
+        const auto iterator = m_playerIndexes.find(player.GetCharacterName());
+        if (iterator == m_playerIndexes.end())
+            return;
+
+        // the last player fills the hole
+        const size_t index = iterator->second;
+        m_playerIndexes.erase(iterator);
+
+        if (index != m_players.size() - 1) {
+            m_players[index] = m_players.back();
+            m_playerIndexes[m_players[index]->GetCharacterName()] = index;
+        }
+
+        m_players.pop_back();
+    }
+
+    bool ChatBroadcaster::Send(ChatChannel channel, Player& sender, std::string_view text, std::string_view recipient) {
+        // the serialized message is spliced into the responses as it is, so it has to be valid JSON on its own
+        text = _Truncate(text, MaxMessageLength);
+        if (text.empty() || !_IsValidUtf8(text))
+            return false;
+
+        switch (channel) {
+            case ChatChannel::Global: {
+                const std::shared_ptr<const std::string> message = Serialize(channel, sender, text, {});
+
+                for (Player* player : m_players) {
+                    player->QueueChatMessage(message);
+                }
+
+                return true;
+            }
+            case ChatChannel::Town: {
+                Town* town = sender.GetTown();
+                if (town == nullptr)
+                    return false;
+
+                const std::shared_ptr<const std::string> message = Serialize(channel, sender, text, {});
+
+                town->ForEachPlayer([&message](Player& player) {
+                    player.QueueChatMessage(message);
+                });
+
+                return true;
+            }
+            case ChatChannel::Whisper: {
+                const auto iterator = m_playerIndexes.find(std::string(recipient));
+                if (iterator == m_playerIndexes.end())
+                    return false;
+
+                const std::shared_ptr<const std::string> message = Serialize(channel, sender, text, recipient);
+                Player& player = *m_players[iterator->second];
+
+                player.QueueChatMessage(message);
+                if (&player != &sender)
+                    sender.QueueChatMessage(message);
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    size_t ChatBroadcaster::GetPlayerCount() const noexcept {
+        return m_players.size();
+    }
+
+    std::shared_ptr<const std::string> ChatBroadcaster::Serialize(ChatChannel channel, const Player& sender, std::string_view text, std::string_view recipient) {
+        char digits[24];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), m_nextMessageId++);
+        const double timestamp = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.BeginObject(std::string_view(digits, result.ptr - digits));
+        writer.Field("k", static_cast<int>(channel));
+        writer.Field("n", sender.GetCharacterName());
+        writer.Field("i", "");
+        writer.Field("nd", recipient);
+        writer.Field("t", text);
+        writer.Field("s", "");
+        writer.Field("ts", timestamp);
+        writer.EndObject();
+        writer.EndObject();
+
+        return std::make_shared<const std::string>(writer.TakeString());
+    }
+}
@@ -1,14 +1,49 @@
 #include <GameServer/GameServer.hpp>
 
-#include <Commons/Containers.hpp>
 #include <Commons/Ticker.hpp>
+#include <GameServer/Chat.hpp>
 #include <GameServer/Player.hpp>
+#include <GameServer/Town.hpp>
 #include <GameServer/Network/GameHttpServer.hpp>
 
 namespace Merrie {
-    GameServer::GameServer(GameServerSettings settings) : m_settings(std::move(settings)) {
+    namespace {
+        // the expired players are spread over the ticks of this span
+        constexpr const std::chrono::milliseconds c_timeoutResolution{100};
+
+        // a bit longer than the timeout, the players are taken out of the wheel once per timeout
+        constexpr const size_t c_timeoutSlots = (Player::InactivityTimeout + std::chrono::seconds(1)) / c_timeoutResolution;
+
+        // Ithan, the town of the init packet
+        constexpr const uint32_t c_townId = 1;
+        constexpr const int32_t c_townWidth = 96;
+        constexpr const int32_t c_townHeight = 100;
+
+        // about half of the screen of the client, in tiles
+        constexpr const int32_t c_viewRange = 16;
+    }
+
+    GameServer::GameServer(GameServerSettings settings)
+            : m_settings(std::move(settings)),
+              m_joinedPlayers(m_settings.HttpServerSettingsValue.NetworkServerSettingsValue.WorkerThreadCount),
+              m_dirtyPlayers(m_settings.HttpServerSettingsValue.NetworkServerSettingsValue.WorkerThreadCount + 1), // and the main thread
+              m_playerTimeouts(c_timeoutResolution, c_timeoutSlots),
+              m_town(std::make_unique<Town>(c_townId, c_townWidth, c_townHeight, c_viewRange)),
+              m_chat(std::make_unique<ChatBroadcaster>()) {
         m_gameHttpServer = std::make_unique<GameHttpServer>(this, m_settings.HttpServerSettingsValue);
         m_ticker = std::make_unique<Ticker>();
+
+        if (m_settings.PlayerStoreSettingsValue.Enabled) {
+            m_playerStore = std::make_unique<AppendLogStore>(m_settings.PlayerStoreSettingsValue);
+            M_LOG_INFO_THIS << "Opened the player store with " << m_playerStore->GetStatistics().Keys << " players";
+        }
+
+        const HttpServerSettings& httpSettings = m_settings.HttpServerSettingsValue;
+        const uint16_t httpTimeout = httpSettings.AllowKeepAlive ? std::min(httpSettings.RequestTimeout, httpSettings.KeepAliveTimeout) : httpSettings.RequestTimeout;
+
+        if (m_settings.LongPollSettingsValue.Enabled && m_settings.LongPollSettingsValue.Timeout >= httpTimeout) {
+            M_LOG_WARNING_THIS << "The long-poll timeout is not shorter than the HTTP timeout, parked requests may time out";
+        }
     }
 
     GameServer::~GameServer() {
@@ -25,15 +60,38 @@ namespace Merrie {
         m_running = true;
         m_gameHttpServer->Start();
         m_ticker->ResetAll();
+
+        // network ingest, the packets received since the last tick are handled before anything else, the players that
+        // sent them are admitted first
+        m_ticker->DoInMainThread(std::bind(&GameServer::AdmitJoinedPlayers, this), true);
+        m_ticker->DoInMainThread(std::bind(&GameHttpServer::ProcessInbox, m_gameHttpServer.get()), true);
         m_ticker->DoInMainThread(std::bind(&GameServer::Tick, this), true);
+
+        // the parked polls are released and the WebSocket clients, which do not poll, get the events of the tick pushed
+        m_ticker->DoAtEndOfTick(std::bind(&GameServer::ReleaseDirtyPlayers, this), true);
+
+        // the responses of the whole tick go back to the network threads at once
+        m_ticker->DoAtEndOfTick(std::bind(&GameHttpServer::FlushResponses, m_gameHttpServer.get()), true);
     }
 
     void GameServer::Stop() {
         m_gameHttpServer->Stop();
         m_gameHttpServer->Join();
+
+        m_playerRecords.ForEach([this](SlotHandle, PlayerRecord& record) {
+            SavePlayer(*record.Player_);
+        });
+
+        if (m_playerStore)
+            m_playerStore->Flush();
+
         m_running = false;
     }
 
+    const GameServerSettings& GameServer::GetSettings() const noexcept {
+        return m_settings;
+    }
+
     bool GameServer::IsRunning() const noexcept {
         return m_running;
     }
@@ -43,43 +101,168 @@ namespace Merrie {
     }
 
     std::shared_ptr<Player> GameServer::GetPlayer(uint64_t aid) {
-        {
-            std::shared_lock lock(m_playersMutex);
-            auto player = FindInMap(m_players, aid);
-            if (player)
-                return player.value();
+        if (std::optional<std::shared_ptr<Player>> player = m_players.Find(aid))
+            return std::move(*player);
+
+        // read outside of the lock of the shard, the players of the other accounts in it do not wait for the disk
+        const std::optional<std::string> saved = m_playerStore ? m_playerStore->Load(aid) : std::nullopt;
+
+        auto[player, created] = m_players.GetOrCreate(aid, [aid, &saved]() {
+            auto player = std::make_shared<Player>(aid);
+
+            if (saved)
+                player->Restore(*saved);
+
+            return player;
+        });
+
+        if (created) {
+            M_LOG_INFO(player->GetLogger()) << "Joined the game";
+            m_joinedPlayers.Push(player);
         }
 
-        // create new one if it does not exist
-        std::unique_lock lockUnique(m_playersMutex);
-        auto[iterator, _] = m_players.try_emplace(aid, std::make_shared<Player>(aid));
-        M_LOG_INFO(iterator->second->GetLogger()) << "Joined the game";
-        return iterator->second;
+        return player;
+    }
+
+    void GameServer::AdmitJoinedPlayers() {
+        m_joinedPlayers.Drain([this](std::shared_ptr<Player>& player, size_t) {
+            const DefaultClock::time_point timeout = player->GetTimeout();
+            const SlotHandle handle = m_playerRecords.Insert(PlayerRecord{player});
+
+            player->SetDirtyList(&m_dirtyPlayers);
+            player->SetHandle(handle);
+            m_playerTimeouts.Schedule(PlayerTimeout{handle}, timeout);
+
+            // the player may have been marked before it had a handle
+            if (player->TakeDirtyMark())
+                player->MarkDirty();
+
+            player->SetTown(m_town.get());
+            m_town->Enter(*player);
+
+            player->SetChat(m_chat.get());
+            m_chat->Join(*player);
+        });
     }
 
     void GameServer::Tick() {
-        if (IsPast(m_oneSecondTasks)) {
-            {
-                std::unique_lock lock(m_playersMutex);
-
-                // remove inactive players
-                for (auto iterator = m_players.cbegin(); iterator != m_players.cend();) {
-                    const std::shared_ptr<Player>& player = iterator->second;
-                    std::unique_lock playerLock(player->GetDataMutex());
-
-                    if (IsPast(player->GetTimeout())) {
-                        player->SetInitLevel(InitLevel::None);
-                        M_LOG_INFO(player->GetLogger()) << "Left the game";
-                        playerLock.unlock();
-
-                        m_players.erase(iterator++);
-                    } else {
-                        ++iterator;
-                    }
-                }
-            }
+        // only the players whose timeouts may have passed come out of the wheel
+        m_playerTimeouts.Advance(DefaultClock::now(), [this](const PlayerTimeout& timeout) {
+            if (timeout.ParkedPollId != 0)
+                CheckParkedPollDeadline(timeout);
+            else
+                CheckPlayerTimeout(timeout.Handle);
+        });
+    }
 
-            m_oneSecondTasks = PointInFuture<std::chrono::seconds>(1);
+    void GameServer::CheckPlayerTimeout(SlotHandle handle) {
+        PlayerRecord* record = m_playerRecords.Get(handle);
+        if (record == nullptr)
+            return;
+
+        Player& player = *record->Player_;
+
+        // the events of the players that do not poll are coalesced once per timeout, until then the queue holds at most
+        // Player::MaxQueuedEvents of them
+        player.CoalesceEvents();
+
+        // the timeout moves with every packet, the wheel is only told about it here
+        const DefaultClock::time_point timeout = player.GetTimeout();
+        if (!IsPast(timeout)) {
+            // the players that stay in the game are saved about once per timeout
+            SavePlayer(player);
+            m_playerTimeouts.Schedule(PlayerTimeout{handle}, timeout);
+            return;
+        }
+
+        // players waiting for events are still online, the poll sets the timeout once it is released
+        if (record->ParkedPoll) {
+            m_playerTimeouts.Schedule(PlayerTimeout{handle}, record->ParkedPollDeadline);
+            return;
+        }
+
+        {
+            std::unique_lock playerLock(player.GetDataMutex());
+            player.SetInitLevel(InitLevel::None);
+        }
+
+        player.GetTown()->Leave(player);
+        player.SetTown(nullptr);
+        player.GetChat()->Leave(player);
+        player.SetChat(nullptr);
+        player.SetHandle(InvalidSlotHandle);
+        SavePlayer(player);
+
+        M_LOG_INFO(player.GetLogger()) << "Left the game";
+        m_players.Remove(player.GetAid());
+        m_playerRecords.Remove(handle);
+    }
+
+    void GameServer::CheckParkedPollDeadline(const PlayerTimeout& timeout) {
+        // the poll may have been released or replaced by a newer one since
+        PlayerRecord* record = m_playerRecords.Get(timeout.Handle);
+        if (record == nullptr || !record->ParkedPoll || record->ParkedPollId != timeout.ParkedPollId)
+            return;
+
+        // the deadlines beyond the horizon of the wheel come out early
+        if (!IsPast(record->ParkedPollDeadline)) {
+            m_playerTimeouts.Schedule(timeout, record->ParkedPollDeadline);
+            return;
+        }
+
+        std::exchange(record->ParkedPoll, nullptr)();
+    }
+
+    void GameServer::ParkPoll(const std::shared_ptr<Player>& player, std::function<void()> release) {
+        m_ticker->EnsureInMainThread();
+
+        const SlotHandle handle = player->GetHandle();
+        PlayerRecord* record = m_playerRecords.Get(handle);
+        if (record == nullptr) {
+            release();
+            return;
         }
+
+        std::function<void()> previous = std::exchange(record->ParkedPoll, std::move(release));
+        record->ParkedPollDeadline = PointInFuture<std::chrono::seconds>(m_settings.LongPollSettingsValue.Timeout);
+        m_playerTimeouts.Schedule(PlayerTimeout{handle, ++record->ParkedPollId}, record->ParkedPollDeadline);
+
+        // the client gave up on the previous poll, it only needs to be completed
+        if (previous)
+            previous();
+    }
+
+    void GameServer::ReleaseDirtyPlayers() {
+        // only the players that got events during the tick are visited, not all the parked polls
+        m_dirtyPlayers.Drain([this](SlotHandle handle, size_t) {
+            PlayerRecord* record = m_playerRecords.Get(handle);
+            if (record == nullptr)
+                return;
+
+            // the events that come from now on mark the player for the next tick
+            Player& player = *record->Player_;
+            player.TakeDirtyMark();
+
+            if (!record->ParkedPoll) {
+                if (player.HasPendingEvents())
+                    m_gameHttpServer->PushPendingEvents(record->Player_);
+
+                return;
+            }
+
+            if (!player.HasPendingEvents()) {
+                // a kicked player gets the end of its session right away, even when the stop event did not fit in its queue
+                std::shared_lock lock(player.GetDataMutex());
+                if (player.IsOnline())
+                    return;
+            }
+
+            std::exchange(record->ParkedPoll, nullptr)();
+        });
+    }
+
+    void GameServer::SavePlayer(Player& player) {
+        if (m_playerStore && player.HasUnsavedChanges())
+            m_playerStore->Put(player.GetAid(), player.Save());
     }
 }
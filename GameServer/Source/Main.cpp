@@ -1,11 +1,34 @@
 #include <Commons/ApplicationMain.hpp>
 #include <Commons/Logging.hpp>
+#include <Commons/Random.hpp>
 #include <Commons/Ticker.hpp>
 #include <GameServer/GameServer.hpp>
 #include <boost/filesystem.hpp>
 #include <yaml-cpp/yaml.h>
 
 namespace Merrie {
+    /**
+     * Reads the lowest severity that is logged, unknown names log everything.
+     */
+    LoggingSeverity _ReadLoggingSeverity(const std::string& name) {
+        static const std::pair<const char*, LoggingSeverity> severities[] = {
+                {"trace",   LoggingSeverity::Trace},
+                {"debug",   LoggingSeverity::Debug},
+                {"info",    LoggingSeverity::Info},
+                {"success", LoggingSeverity::Success},
+                {"warning", LoggingSeverity::Warning},
+                {"error",   LoggingSeverity::Error},
+                {"fatal",   LoggingSeverity::Fatal},
+        };
+
+        for (const auto& [severityName, severity] : severities) {
+            if (name == severityName)
+                return severity;
+        }
+
+        return LoggingSeverity::Trace;
+    }
+
     GameServerSettings _ReadSettings() {
 
         const std::string configFile = "config.yml";
@@ -14,16 +37,61 @@ namespace Merrie {
             YAML::Node config;
             config["tps"] = 100;
             config["log_filters"] = std::vector<std::string>{};
+            config["log_severity"] = "trace";
 
             config["http"] = YAML::Node();
             config["http"]["bind_ip"] = "127.0.0.1";
             config["http"]["bind_port"] = 80;
             config["http"]["worker_threads"] = 256;
             config["http"]["request_timeout"] = 15;
+            config["http"]["max_header_size"] = 8192;
             config["http"]["keepalive"] = YAML::Node();
             config["http"]["keepalive"]["enabled"] = true;
             config["http"]["keepalive"]["timeout"] = 15;
             config["http"]["keepalive"]["max"] = 5000;
+            config["http"]["compression"] = YAML::Node();
+            config["http"]["compression"]["enabled"] = true;
+            config["http"]["compression"]["min_size"] = 1024;
+            config["http"]["compression"]["level"] = 6;
+            config["http"]["tls"] = YAML::Node();
+            config["http"]["tls"]["enabled"] = false;
+            config["http"]["tls"]["certificate_chain"] = "certificate.pem";
+            config["http"]["tls"]["private_key"] = "private_key.pem";
+            config["http"]["tls"]["session_cache_size"] = 20480;
+            config["http"]["tls"]["session_timeout"] = 300;
+            config["http"]["tls"]["session_tickets"] = true;
+            config["http"]["tls"]["handshake_threads"] = 2;
+            config["http"]["tls"]["max_pending_handshakes"] = 1024;
+            config["http"]["static_files"] = YAML::Node();
+            config["http"]["static_files"]["enabled"] = false;
+            config["http"]["static_files"]["root"] = "assets";
+            config["http"]["static_files"]["url_prefix"] = "/assets/";
+            config["http"]["static_files"]["max_cached_file_size"] = 262144;
+            config["http"]["static_files"]["max_cache_size"] = 67108864;
+            config["http"]["static_files"]["max_age"] = 3600;
+
+            config["long_poll"] = YAML::Node();
+            config["long_poll"]["enabled"] = false;
+            config["long_poll"]["timeout"] = 10;
+
+            config["storage"] = YAML::Node();
+            config["storage"]["enabled"] = true;
+            config["storage"]["directory"] = "data";
+            config["storage"]["compaction_threshold"] = 67108864;
+
+            // the secret is shared with whoever issues the session tokens, a random one is generated for a new config
+            std::string secret(64, '0');
+            for (char& character : secret) {
+                character = "0123456789abcdef"[GetCommonRandomDevice()() % 16];
+            }
+
+            config["authentication"] = YAML::Node();
+            config["authentication"]["enabled"] = false;
+            config["authentication"]["secret"] = secret;
+            config["authentication"]["cookie"] = "merrie_session";
+            config["authentication"]["verify_threads"] = 2;
+            config["authentication"]["max_cached_sessions"] = 100000;
+            config["authentication"]["max_pending_verifications"] = 4096;
 
             std::ofstream file("config.yml");
             file << config;
@@ -42,9 +110,51 @@ namespace Merrie {
                         config["http"]["request_timeout"].as<uint16_t>(),
                         config["http"]["keepalive"]["timeout"].as<uint16_t>(),
                         config["http"]["keepalive"]["max"].as<uint16_t>(),
+                        config["http"]["max_header_size"].as<size_t>(8192),
+                        {
+                                config["http"]["compression"]["enabled"].as<bool>(false),
+                                config["http"]["compression"]["min_size"].as<size_t>(1024),
+                                config["http"]["compression"]["level"].as<int>(6),
+                        },
+                        {
+                                config["http"]["tls"]["enabled"].as<bool>(false),
+                                config["http"]["tls"]["certificate_chain"].as<std::string>("certificate.pem"),
+                                config["http"]["tls"]["private_key"].as<std::string>("private_key.pem"),
+                                config["http"]["tls"]["session_cache_size"].as<size_t>(20480),
+                                config["http"]["tls"]["session_timeout"].as<uint32_t>(300),
+                                config["http"]["tls"]["session_tickets"].as<bool>(true),
+                                config["http"]["tls"]["handshake_threads"].as<size_t>(2),
+                                config["http"]["tls"]["max_pending_handshakes"].as<size_t>(1024),
+                        },
+                        {
+                                config["http"]["static_files"]["enabled"].as<bool>(false),
+                                config["http"]["static_files"]["root"].as<std::string>("assets"),
+                                config["http"]["static_files"]["url_prefix"].as<std::string>("/assets/"),
+                                config["http"]["static_files"]["max_cached_file_size"].as<size_t>(262144),
+                                config["http"]["static_files"]["max_cache_size"].as<size_t>(67108864),
+                                config["http"]["static_files"]["max_age"].as<uint32_t>(3600),
+                        },
                 },
                 config["tps"].as<unsigned int>(),
-                config["log_filters"].as<std::vector<std::string>>()
+                config["log_filters"].as<std::vector<std::string>>(),
+                _ReadLoggingSeverity(config["log_severity"].as<std::string>("trace")),
+                {
+                        config["long_poll"]["enabled"].as<bool>(false),
+                        config["long_poll"]["timeout"].as<uint16_t>(10),
+                },
+                {
+                        config["storage"]["enabled"].as<bool>(true),
+                        config["storage"]["directory"].as<std::string>("data"),
+                        config["storage"]["compaction_threshold"].as<uint64_t>(67108864),
+                },
+                {
+                        config["authentication"]["enabled"].as<bool>(false),
+                        config["authentication"]["secret"].as<std::string>(""),
+                        config["authentication"]["cookie"].as<std::string>("merrie_session"),
+                        config["authentication"]["verify_threads"].as<size_t>(2),
+                        config["authentication"]["max_cached_sessions"].as<size_t>(100000),
+                        config["authentication"]["max_pending_verifications"].as<size_t>(4096),
+                }
         };
     }
 
@@ -54,7 +164,7 @@ namespace Merrie {
 
         M_LOG_INFO(initLogger) << "Reading the config.yml file";
         GameServerSettings settings = _ReadSettings();
-        LoggingSystem::UpdateFilters(settings.LogFilters);
+        LoggingSystem::UpdateFilters(settings.LogFilters, settings.LogSeverity);
 
         M_LOG_INFO(initLogger) << "Initializing the server";
         std::unique_ptr<GameServer> gameServer = std::make_unique<GameServer>(std::move(settings));
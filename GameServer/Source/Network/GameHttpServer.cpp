@@ -4,7 +4,6 @@
 #include <Commons/Ticker.hpp>
 #include <GameServer/Player.hpp>
 #include <GameServer/Network/Packets.hpp>
-#include <boost/algorithm/string/predicate.hpp>
 #include <boost/lexical_cast.hpp>
 #include <nlohmann/json.hpp>
 
@@ -12,102 +11,189 @@ namespace Merrie {
     const std::string HttpUrlDecodeError = "<h1>Failed to decode URL</h1>";
     const std::string Http404Error = "<h1>Failed to find the requested resource</h1>";
 
-    GameHttpServer::GameHttpServer(GameServer* gameServer, HttpServerSettings settings) : HttpServer(std::move(settings)), m_gameServer(gameServer) {
+    const std::string Http405Error = "<h1>The method is not allowed for the requested resource</h1>";
+
+    /**
+     * The origin of the game client, the only one allowed to call the engine.
+     */
+    const std::string GameClientOrigin = "http://classic.margonem.pl";
+
+    GameHttpServer::GameHttpServer(GameServer* gameServer, HttpServerSettings settings)
+            : HttpServer(std::move(settings)),
+              m_gameServer(gameServer),
+              m_router([](const std::shared_ptr<HttpConnection>& connection, http::status status, std::string_view message) {
+                  // the game client has to be able to read the errors as well, so they keep the CORS headers of the engine
+                  connection->GetResponse().set(http::field::access_control_allow_origin, GameClientOrigin);
+                  connection->GetResponse().set(http::field::access_control_allow_credentials, "true");
+                  connection->GetResponse().set(http::field::access_control_allow_methods, "POST, GET");
+                  connection->GetResponse().set(http::field::access_control_allow_headers, "*");
+
+                  connection->GetResponse().set(http::field::content_type, "text/html");
+                  connection->GetResponse().result(status);
+
+                  if (status == http::status::bad_request)
+                      connection->GetResponse().body() = HttpUrlDecodeError + "<p>" + std::string(message) + "</p>";
+                  else if (status == http::status::method_not_allowed)
+                      connection->GetResponse().body() = Http405Error;
+                  else
+                      connection->GetResponse().body() = Http404Error;
+
+                  connection->SendResponse();
+              }),
+              m_inbox(GetSettings().WorkerThreadCount),
+              m_outbox(m_inbox.GetShardCount()) {
+
+        const AuthenticationSettings& authenticationSettings = m_gameServer->GetSettings().AuthenticationSettingsValue;
+        if (authenticationSettings.Enabled)
+            m_authenticator = std::make_unique<SessionAuthenticator>(authenticationSettings);
+
+        FreezePacketHandlers();
+        RegisterRoutes();
+    }
+
+    void GameHttpServer::RegisterRoutes() {
+        HttpRouteOptions engineOptions{};
+        engineOptions.Cors.AllowOrigin = GameClientOrigin;
+        engineOptions.Cors.AllowCredentials = true;
+
+        m_router.AddRoute(HttpRouteMatch::Exact, "/engine", {http::verb::post, http::verb::get}, [this](std::shared_ptr<HttpConnection> connection, const DecodedUrl& url) {
+            HandleEngine(std::move(connection), url);
+        }, engineOptions);
+
+        if (HttpStaticFiles* staticFiles = GetStaticFiles()) {
+            const size_t prefixLength = staticFiles->GetSettings().UrlPrefix.size();
+
+            HttpRouteOptions staticFilesOptions{};
+            staticFilesOptions.Cors.AllowOrigin = "*";
+
+            m_router.AddRoute(HttpRouteMatch::Prefix, staticFiles->GetSettings().UrlPrefix, {http::verb::get, http::verb::head}, [staticFiles, prefixLength](std::shared_ptr<HttpConnection> connection, const DecodedUrl& url) {
+                staticFiles->Serve(connection, std::string_view(url.Path).substr(prefixLength));
+            }, staticFilesOptions);
+        }
+
+        #ifdef M_ENABLE_DEBUG
+        m_router.AddRoute(HttpRouteMatch::Prefix, "/__DEBUGREQUEST", {}, [](std::shared_ptr<HttpConnection> connection, const DecodedUrl& url) {
+            HandleDebugRequest(connection, url);
+        });
+        #endif
 
+        m_router.Freeze();
+    }
+
+    std::vector<HttpRouteStatistics> GameHttpServer::GetRouteStatistics() const {
+        return m_router.GetStatistics();
     }
 
     void GameHttpServer::HandleRequest(std::shared_ptr<HttpConnection> connection) {
-        // CORS
-        connection->GetResponse().set(http::field::access_control_allow_credentials, "true");
-        connection->GetResponse().set(http::field::access_control_allow_methods, "POST, GET");
-        connection->GetResponse().set(http::field::access_control_allow_origin, "http://classic.margonem.pl");
-        connection->GetResponse().set(http::field::access_control_allow_headers, "*");
-        connection->GetResponse().set(http::field::access_control_max_age, "86400");
-
-
-        // OPTIONS requests
-        if (connection->GetRequest().method() == http::verb::options) {
-            connection->GetResponse().set(http::field::allow, "POST, GET, OPTIONS");
-            connection->GetResponse().result(http::status::ok);
-            connection->SendResponse();
-            return;
-        }
+        m_router.Route(std::move(connection));
+    }
 
-        connection->GetResponse().set(http::field::content_type, "text/html");
-        connection->GetResponse().result(http::status::ok);
+    /**
+     * Finds the value of the cookie in the Cookie header of the request, empty if there is none.
+     */
+    std::string_view _FindCookie(const http::request<http::string_body>& request, std::string_view name) {
+        const auto header = request[http::field::cookie];
+        std::string_view cookies(header.data(), header.size());
 
-        DecodedUrl url;
+        while (!cookies.empty()) {
+            const size_t end = std::min(cookies.find(';'), cookies.size());
+            std::string_view cookie = cookies.substr(0, end);
+            cookies.remove_prefix(std::min(end + 1, cookies.size()));
 
-        try {
-            url = DecodeUrlQueryString(std::string_view(connection->GetRequest().target().data(), connection->GetRequest().target().size()));
+            cookie.remove_prefix(std::min(cookie.find_first_not_of(' '), cookie.size()));
+
+            if (cookie.size() > name.size() && cookie.compare(0, name.size(), name) == 0 && cookie[name.size()] == '=')
+                return cookie.substr(name.size() + 1);
         }
-        catch (const UrlDecodeException& e) {
-            connection->GetResponse().body() = HttpUrlDecodeError + "<p>" + e.what() + "</p>";
-            connection->GetResponse().result(http::status::bad_request);
-            connection->SendResponse();
+
+        return {};
+    }
+
+    void GameHttpServer::HandleEngine(std::shared_ptr<HttpConnection> connection, const DecodedUrl& url) {
+        if (!connection->IsWebSocketUpgrade()) {
+            HandleEnginePacket(std::move(connection), url);
             return;
         }
 
-        #ifdef M_ENABLE_DEBUG
-        if (boost::starts_with(url.Path, "/__DEBUGREQUEST")) {
-            std::string r;
-            r += "<h4>Path</h4>";
-            r += "<p>" + url.Path + "</p>";
-
-            r += "<br><br><h4>Query parameters: </h4>";
-
-            for (const auto&[key, value] : url.Parameters) {
-                r += "<p>";
-                r += key;
-                r += "<b> = </b>";
-                r += value;
-                r += "</p>";
-            }
+        if (!m_authenticator) {
+            HandleEngineWebSocket(connection, 0);
+            return;
+        }
 
-            r += "<br><br><h4>Request headers: </h4>";
+        // the account of the WebSocket comes from the token, it is verified once for the whole connection
+        std::string token(_FindCookie(connection->GetRequest(), m_authenticator->GetSettings().CookieName));
 
-            for (auto const& header : connection->GetRequest().base()) {
-                r += "<p>";
-                r.append(header.name_string().data(), header.name_string().size());
-                r += "<b> = </b>";
-                r.append(header.value().data(), header.value().size());
-                r += "</p>";
-            }
+        const bool verifying = m_authenticator->Verify(std::move(token), [this, connection](std::optional<SessionToken> session) {
+            boost::asio::post(connection->GetStrand(), [this, connection, session]() {
+                if (!session) {
+                    connection->GetResponse().result(http::status::unauthorized);
+                    connection->SendResponse();
+                    return;
+                }
 
-            connection->GetResponse().body() = r;
+                HandleEngineWebSocket(connection, session->Aid);
+            });
+        });
+
+        // too many tokens wait for verification, the client tries again later
+        if (!verifying) {
+            connection->GetResponse().result(http::status::unauthorized);
             connection->SendResponse();
-            return;
         }
-        #endif
+    }
 
-        if (url.Path == "/engine") {
-            HandleEnginePacket(std::move(connection), url);
-        } else {
-            connection->GetResponse().body() = Http404Error;
-            connection->GetResponse().result(http::status::not_found);
-            connection->SendResponse();
+    #ifdef M_ENABLE_DEBUG
+    void GameHttpServer::HandleDebugRequest(const std::shared_ptr<HttpConnection>& connection, const DecodedUrl& url) {
+        std::string r;
+        r += "<h4>Path</h4>";
+        r += "<p>" + url.Path + "</p>";
+
+        r += "<br><br><h4>Query parameters: </h4>";
+
+        for (const auto&[key, value] : url.Parameters) {
+            r += "<p>";
+            r += key;
+            r += "<b> = </b>";
+            r += value;
+            r += "</p>";
+        }
+
+        r += "<br><br><h4>Request headers: </h4>";
+
+        for (auto const& header : connection->GetRequest().base()) {
+            r += "<p>";
+            r.append(header.name_string().data(), header.name_string().size());
+            r += "<b> = </b>";
+            r.append(header.value().data(), header.value().size());
+            r += "</p>";
         }
+
+        connection->GetResponse().set(http::field::content_type, "text/html");
+        connection->GetResponse().body() = r;
+        connection->SendResponse();
     }
+    #endif
 
-    std::string _CreateSimpleStopPacket(std::string_view reason) {
-        nlohmann::json json;
-        json["t"] = "stop";
-        json["e"] = reason;
-        return json.dump();
+    /**
+     * Serializes the outgoing packet, runs on the network threads so it must not throw.
+     */
+    std::string _SerializeOutgoingPacket(OutgoingPacket& out) {
+        try {
+            return out.Serialize();
+        }
+        catch (const nlohmann::json::exception&) {
+            // for example strings that are not valid UTF-8
+            return CreateStopPacket("failed to serialize the response");
+        }
     }
 
-    inline HandleResult _ProcessPacketHandlerChain(const std::vector<std::shared_ptr<PacketHandlerData>>& chain, const IncomingPacket& in, OutgoingPacket& out) {
+    inline HandleResult _ProcessPacketHandlerChain(RunMode mode, const IncomingPacket& in, OutgoingPacket& out) {
         // _ is a 'no action' action, it will never be handled by and of the handlers
-        HandleResult result = in.Action == "_" ? HandleResult::ContinueHandling : HandleResult::Ignored;
+        HandleResult result = in.ActionId == NoPacketAction ? HandleResult::ContinueHandling : HandleResult::Ignored;
 
-        for (const std::shared_ptr<PacketHandlerData>& data : chain) {
-            if (!data->ActionFilters.empty()) {
-                if (in.Action == "_" || !Contains(data->ActionFilters, in.Action)) {
-                    continue;
-                }
-            }
-
-            switch (data->Handler(in.Player_, in, out)) {
+        // the chain holds only the handlers of the action and the ones without action filters
+        for (const PacketHandlerData* data : GetPacketHandlerChain(mode, in.ActionId)) {
+            switch (data->Invoke(*data, in.Player_, in, out)) {
                 case HandleResult::ContinueHandling:
                     if (!data->ActionFilters.empty())
                         result = HandleResult::ContinueHandling;
@@ -128,7 +214,7 @@ namespace Merrie {
         const auto action = FindInMap(url.Parameters, "t"s);
 
         if (!action) {
-            connection->GetResponse().body() = _CreateSimpleStopPacket("invalid action");
+            connection->GetResponse().body() = CreateStopPacket("invalid action");
             connection->SendResponse();
             return;
         }
@@ -148,50 +234,247 @@ namespace Merrie {
         uint64_t aid;
 
         if (!aid_s || !boost::conversion::try_lexical_convert(aid_s.value(), aid)) {
-            connection->GetResponse().body() = _CreateSimpleStopPacket("no aid");
+            connection->GetResponse().body() = CreateStopPacket("no aid");
             connection->SendResponse();
             return;
         }
 
-        // TODO: Authentication (async!)
-        // TODO: Validate via cookies
+        if (m_authenticator) {
+            const std::string_view token = _FindCookie(connection->GetRequest(), m_authenticator->GetSettings().CookieName);
+
+            if (token.empty()) {
+                connection->GetResponse().body() = CreateStopPacket("not logged in");
+                connection->SendResponse();
+                return;
+            }
+
+            // the tokens that were not seen yet are verified on the verify threads, the request continues on the strand of the connection
+            if (!m_authenticator->IsVerified(aid, token)) {
+                std::string tokenCopy(token);
+
+                const bool verifying = m_authenticator->Verify(std::move(tokenCopy), [this, connection, aid, action = action.value(), parameters = url.Parameters](std::optional<SessionToken> session) {
+                    const bool valid = session && session->Aid == aid;
+
+                    boost::asio::post(connection->GetStrand(), [this, connection, valid, aid, action, parameters]() mutable {
+                        if (!valid) {
+                            connection->GetResponse().body() = CreateStopPacket("invalid session");
+                            connection->SendResponse();
+                            return;
+                        }
+
+                        HandleAuthenticatedEnginePacket(std::move(connection), aid, std::move(action), std::move(parameters));
+                    });
+                });
+
+                // too many tokens wait for verification, most likely made up ones
+                if (!verifying) {
+                    connection->GetResponse().body() = CreateStopPacket("not logged in");
+                    connection->SendResponse();
+                }
+
+                return;
+            }
+        }
+
+        HandleAuthenticatedEnginePacket(std::move(connection), aid, action.value(), url.Parameters);
+    }
+
+    void GameHttpServer::HandleAuthenticatedEnginePacket(std::shared_ptr<HttpConnection> connection, uint64_t aid, std::string action, std::map<std::string, std::string> parameters) {
+        IncomingPacket in = {
+                m_gameServer->GetPlayer(aid),
+                std::move(action),
+                std::move(parameters)
+        };
+
+        // the cached response is only touched from the strand of the connection
+        boost::asio::any_io_executor executor = connection->GetStrand();
+        ProcessEnginePacket(std::move(in), EngineResponder{std::move(executor), [connection = std::move(connection)](std::string response) {
+            connection->GetResponse().body() = std::move(response);
+            connection->SendResponse();
+        }}, true);
+    }
+
+    void GameHttpServer::HandleEngineWebSocket(const std::shared_ptr<HttpConnection>& connection, uint64_t aid) {
+        auto session = std::make_shared<EngineWebSocketSession>();
+        session->Aid = aid;
+
+        WebSocketCallbacks callbacks{
+                [this, session](const std::shared_ptr<WebSocketConnection>& webSocket, std::string message) {
+                    HandleEngineMessage(*session, webSocket, message);
+                },
+                [session](const std::shared_ptr<WebSocketConnection>& webSocket) {
+                    if (const std::shared_ptr<Player> player = session->Player_.lock())
+                        player->DetachPushConnection(webSocket);
+                }
+        };
+
+        connection->UpgradeToWebSocket(std::move(callbacks));
+    }
+
+    void GameHttpServer::HandleEngineMessage(EngineWebSocketSession& session, const std::shared_ptr<WebSocketConnection>& connection, const std::string& message) {
+        // the messages are the query strings of the HTTP requests
+        DecodedUrl url;
+
+        try {
+            url = DecodeUrlQueryString("?" + message);
+        }
+        catch (const UrlDecodeException&) {
+            connection->Send(CreateStopPacket("invalid message"));
+            return;
+        }
+
+        const auto action = FindInMap(url.Parameters, "t"s);
+
+        if (!action || action == "getvar_addon") {
+            connection->Send(CreateStopPacket("invalid action"));
+            return;
+        }
+
+        const auto aid_s = FindInMap(url.Parameters, "aid"s);
+        uint64_t aid;
+
+        if (!aid_s || !boost::conversion::try_lexical_convert(aid_s.value(), aid) || aid == 0) {
+            connection->Send(CreateStopPacket("no aid"));
+            return;
+        }
+
+        // a WebSocket connection belongs to a single player
+        if (session.Aid != 0 && session.Aid != aid) {
+            connection->Send(CreateStopPacket("aid mismatch"));
+            connection->Close();
+            return;
+        }
 
         IncomingPacket in = {
                 m_gameServer->GetPlayer(aid),
                 action.value(),
-                url.Parameters
+                std::move(url.Parameters)
         };
-        OutgoingPacket out;
-        const HandleResult asyncResult = _ProcessPacketHandlerChain(GetRegisteredAsyncPacketHandlers(), in, out);
 
-        {
-            std::shared_lock lock(in.Player_->GetDataMutex());
-            in.Player_->SetTimeout();
+        // the player object is recreated after a timeout, so the push connection is attached to the current one every time
+        if (session.Player_.lock() != in.Player_) {
+            session.Aid = aid;
+            session.Player_ = in.Player_;
+            in.Player_->AttachPushConnection(connection);
         }
 
+        // WebSocket clients do not need to wait for events, they are pushed at the end of the tick
+        ProcessEnginePacket(std::move(in), EngineResponder{connection->GetStrand(), [connection](std::string response) {
+            connection->Send(std::move(response));
+        }}, false);
+    }
+
+    void GameHttpServer::ProcessEnginePacket(IncomingPacket in, EngineResponder respond, bool allowParking) {
+        in.ActionId = FindPacketAction(in.Action);
+
+        OutgoingPacket out;
+        const HandleResult asyncResult = _ProcessPacketHandlerChain(RunMode::Async, in, out);
+
+        in.Player_->SetTimeout();
+
+        // the handler that stopped the handling may have written the stop packet itself, like the kick of the player
         if (asyncResult == HandleResult::StopHandling) {
-            connection->GetResponse().body() = _CreateSimpleStopPacket("StopHandling was returned");
-            connection->SendResponse();
+            respond.Send(out.HasField("t") ? _SerializeOutgoingPacket(out) : CreateStopPacket("StopHandling was returned"));
             return;
         }
 
-        m_gameServer->GetTicker()->DoInMainThread([asyncResult, in = std::move(in), out = std::move(out), connection = std::move(connection)](const std::shared_ptr<Task>&) mutable {
-            const HandleResult syncResult = _ProcessPacketHandlerChain(GetRegisteredSyncPacketHandlers(), in, out);
+        // the sync chain runs in the network ingest phase of the next tick, together with all other packets
+        m_inbox.Push(PendingEnginePacket{asyncResult, std::move(in), std::move(out), std::move(respond), allowParking});
+    }
+
+    void GameHttpServer::ProcessInbox() {
+        m_gameServer->GetTicker()->EnsureInMainThread();
 
-            if (syncResult == HandleResult::StopHandling) {
-                connection->GetResponse().body() = _CreateSimpleStopPacket("StopHandling was returned");
-                connection->SendResponse();
+        m_inbox.Drain([this](PendingEnginePacket& packet, size_t shard) {
+            ProcessPendingEnginePacket(packet, shard);
+        });
+    }
+
+    void GameHttpServer::PushPendingEvents(const std::shared_ptr<Player>& player) {
+        m_gameServer->GetTicker()->EnsureInMainThread();
+
+        const std::shared_ptr<WebSocketConnection> connection = player->GetPushConnection();
+        if (!connection)
+            return;
+
+        {
+            std::shared_lock lock(player->GetDataMutex());
+            if (!player->IsInitialized())
                 return;
+        }
+
+        // sent from the strand of the connection and from the last shard, after the responses of the tick that it follows
+        IncomingPacket in = {player, "_", {}, NoPacketAction};
+        OutgoingPacket out;
+
+        RespondToEnginePacket(HandleResult::ContinueHandling, in, out, EngineResponder{connection->GetStrand(), [player](std::string response) {
+            player->Push(std::make_shared<const std::string>(std::move(response)));
+        }}, m_outbox.size() - 1);
+    }
+
+    void GameHttpServer::ProcessPendingEnginePacket(PendingEnginePacket& packet, size_t shard) {
+        IncomingPacket& in = packet.In;
+
+        // _ is the empty poll, with long-polling it waits until there are events for the player
+        if (packet.AllowParking && in.Action == "_" && m_gameServer->GetSettings().LongPollSettingsValue.Enabled) {
+            bool park;
+
+            {
+                std::shared_lock lock(in.Player_->GetDataMutex());
+                park = in.Player_->IsInitialized() && !in.Player_->HasPendingEvents();
             }
 
-            if (syncResult == HandleResult::Ignored && asyncResult == HandleResult::Ignored) {
-                connection->GetResponse().body() = _CreateSimpleStopPacket("invalid action");
-                connection->SendResponse();
+            if (park) {
+                // the packet is moved into the release callback, the player cannot be taken from it in the same call
+                const std::shared_ptr<Player> player = in.Player_;
+
+                m_gameServer->ParkPoll(player, [this, shard, packet = std::move(packet)]() mutable {
+                    packet.In.Player_->SetTimeout();
+                    RespondToEnginePacket(packet.AsyncResult, packet.In, packet.Out, std::move(packet.Respond), shard);
+                });
                 return;
             }
+        }
 
-            connection->GetResponse().body() = out.GetJson().dump();
-            connection->SendResponse();
-        }, false);
+        RespondToEnginePacket(packet.AsyncResult, in, packet.Out, std::move(packet.Respond), shard);
+    }
+
+    void GameHttpServer::FlushResponses() {
+        m_gameServer->GetTicker()->EnsureInMainThread();
+
+        for (std::vector<PendingEngineResponse>& responses : m_outbox) {
+            for (PendingEngineResponse& response : responses) {
+                // the responses are serialized and written by the network threads, the main thread only runs the game logic
+                const boost::asio::any_io_executor executor = response.Respond.Executor;
+
+                boost::asio::post(executor, [response = std::move(response)]() mutable {
+                    response.Respond.Send(response.StopReason != nullptr ? CreateStopPacket(response.StopReason) : _SerializeOutgoingPacket(response.Out));
+                });
+            }
+
+            responses.clear();
+        }
+    }
+
+    void GameHttpServer::RespondToEnginePacket(HandleResult asyncResult, IncomingPacket& in, OutgoingPacket& out, EngineResponder respond, size_t shard) {
+        HandleResult syncResult;
+        const char* stopReason = nullptr;
+
+        try {
+            syncResult = _ProcessPacketHandlerChain(RunMode::Sync, in, out);
+        }
+        catch (const std::exception& e) {
+            // the packet is still answered, the rest of the inbox carries on
+            M_LOG_ERROR(in.Player_->GetLogger()) << "A sync packet handler threw: " << e.what();
+            m_outbox[shard].push_back(PendingEngineResponse{std::move(respond), std::move(out), "failed to handle the packet"});
+            return;
+        }
+
+        if (syncResult == HandleResult::StopHandling)
+            stopReason = "StopHandling was returned";
+        else if (syncResult == HandleResult::Ignored && asyncResult == HandleResult::Ignored)
+            stopReason = "invalid action";
+
+        m_outbox[shard].push_back(PendingEngineResponse{std::move(respond), std::move(out), stopReason});
     }
 }
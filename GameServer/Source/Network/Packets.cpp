@@ -1,24 +1,338 @@
 #include <GameServer/Network/Packets.hpp>
 
 #include <Commons/Containers.hpp>
+#include <Commons/JsonTemplate.hpp>
 #include <Commons/Random.hpp>
 #include <Commons/Time.hpp>
+#include <GameServer/Chat.hpp>
 #include <GameServer/Player.hpp>
+#include <GameServer/Town.hpp>
+#include <cmath>
 #include <utility>
-#include <boost/lexical_cast.hpp>
 
 namespace Merrie {
 
+    /**
+     * The init levels that can be requested, 1 to 4.
+     */
+    template<>
+    struct PacketParameterParser<InitLevel> {
+        static bool Parse(std::string_view text, InitLevel& value) noexcept {
+            if (text.size() != 1 || text[0] < '1' || text[0] > '4')
+                return false;
+
+            value = static_cast<InitLevel>(text[0] - '0');
+            return true;
+        }
+    };
+
     OutgoingPacket::OutgoingPacket() = default;
 
     nlohmann::json& OutgoingPacket::GetJson() noexcept {
         return m_json;
     }
 
+    JsonWriter& OutgoingPacket::GetWriter() {
+        if (m_writer.GetDepth() == 0) {
+            // large enough for the biggest init packets
+            std::string buffer;
+            buffer.reserve(2048);
+
+            m_writer = JsonWriter(std::move(buffer));
+            m_writer.BeginObject();
+        }
+
+        return m_writer;
+    }
+
+    bool OutgoingPacket::HasField(std::string_view key) const {
+        return m_writer.HasRootKey(key) || (m_json.is_object() && m_json.find(key) != m_json.end());
+    }
+
+    std::string OutgoingPacket::Serialize() {
+        // nothing was streamed, the document is the whole packet
+        if (m_writer.GetDepth() == 0)
+            return m_json.dump();
+
+        if (m_json.is_object())
+            m_writer.RawMembers(m_json.dump());
+
+        m_writer.EndObject();
+        return m_writer.TakeString();
+    }
+
     namespace {
         std::vector<std::shared_ptr<PacketHandlerData>> g_packetHandlers;
         std::vector<std::shared_ptr<PacketHandlerData>> g_asyncPacketHandlers;
         std::vector<std::shared_ptr<PacketHandlerData>> g_syncPacketHandlers;
+
+        /**
+         * Dispatch tables built by FreezePacketHandlers(), read-only afterwards.
+         */
+        struct _PacketDispatchTables {
+            bool Frozen = false;
+
+            // interned actions, indexed by the PacketActionId
+            std::vector<std::string> Actions;
+            std::vector<std::vector<const PacketHandlerData*>> SyncChains;
+            std::vector<std::vector<const PacketHandlerData*>> AsyncChains;
+
+            // perfect hash of the actions, the slots hold the ids and UnknownPacketAction when empty
+            uint64_t Seed = 0;
+            uint64_t Mask = 0;
+            std::vector<PacketActionId> Slots;
+        };
+
+        _PacketDispatchTables g_dispatchTables;
+
+        /**
+         * Slots: browser_token, id, exp, gold, honor, lvl, nick, x, y, dir, stamina
+         */
+        JsonTemplate _CreateInitLevel1Template() {
+            JsonWriter writer;
+            writer.BeginObject();
+            writer.Key("browser_token");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.BeginArray("qtrack");
+            writer.Value("*");
+            writer.EndArray();
+            writer.Field("priv_world", 0);
+            writer.Field("wanted_show", 1);
+            writer.Field("tutorial", 0);
+            writer.Field("worldname", "Merrie");
+
+            writer.BeginObject("h");
+            writer.Key("id");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("blockade", 0);
+            writer.Field("uprawnienia", 0);
+            writer.Field("ap", 0);
+            writer.Field("bagi", 1);
+            writer.Field("bint", 1);
+            writer.Field("bstr", 1);
+            writer.Field("credits", 0);
+            writer.Field("runes", 0);
+            writer.Key("exp");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Key("gold");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("goldlim", 100000000000);
+            writer.Field("healpower", 0);
+            writer.Key("honor");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("img", "/paid/zakon_rm5.gif");
+            writer.Key("lvl");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("mails", 0);
+            writer.Field("mails_all", 0);
+            writer.Field("mails_last", "");
+            writer.Field("mpath", "http://classic.margonem.pl/");
+            writer.Key("nick");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("opt", 0);
+            writer.Field("prof", "w");
+            writer.Field("ttl_value", 0);
+            writer.Field("ttl_end", 1577836800);
+            writer.Field("ttl_del", 0);
+            writer.Field("pvp", 0);
+            writer.Field("ttl", 300);
+            writer.Key("x");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Key("y");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Key("dir");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("stasis", 0);
+            writer.Field("bag", 0);
+            writer.Field("party", 0);
+            writer.Field("trade", 0);
+            writer.Field("wanted", 0);
+            writer.Key("stamina");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("stamina_ts", 1577836800);
+            writer.Field("stamina_renew_sec", 0);
+            writer.Field("cur_skill_set", 1);
+            writer.Field("cur_battle_set", 1);
+            writer.Field("attr", 1);
+
+            writer.BeginObject("warrior_stats");
+            writer.Field("hp", 50);
+            writer.Field("maxhp", 50);
+            writer.Field("st", 12);
+            writer.Field("ag", 34);
+            writer.Field("it", 56);
+            writer.Field("sa", 12.34);
+            writer.Field("crit", 56.78);
+            writer.Field("ac", 1234);
+            writer.Field("resfire", 12);
+            writer.Field("resfrost", 34);
+            writer.Field("reslight", 56);
+            writer.Field("act", 78);
+            writer.Field("dmg", 1234);
+            writer.Field("dmgc", 567);
+            writer.BeginArray("evade");
+            writer.Value(50);
+            writer.Value(5.00);
+            writer.EndArray();
+            writer.Field("lowcrit", 1);
+            writer.Field("heal", 234);
+            writer.Field("critmval", 5.67);
+            writer.Field("critmval_f", 6.78);
+            writer.Field("critmval_c", 7.89);
+            writer.Field("critmval_l", 8.90);
+            writer.Field("mana", 123);
+            writer.Field("acmdmg", 4);
+            writer.Field("managain", 56);
+            writer.Field("blok", 789);
+            writer.Field("critval", 10.11);
+            writer.Field("energy", 1213);
+            writer.Field("lowevade", 14);
+            writer.Field("energygain", 50);
+            writer.EndObject(); // warrior_stats
+
+            writer.EndObject(); // h
+            writer.EndObject();
+            return JsonTemplate(writer.TakeString());
+        }
+
+        /**
+         * No slots, the town is the same for everyone
+         */
+        JsonTemplate _CreateInitLevel2Template() {
+            JsonWriter writer;
+            writer.BeginObject();
+            writer.BeginObject("town");
+            writer.Field("id", 1);
+            writer.Field("mainid", 0);
+            writer.Field("x", 96);
+            writer.Field("y", 100);
+            writer.Field("file", "ithan.5.png");
+            writer.Field("name", "Ithan");
+            writer.Field("pvp", 2);
+            writer.Field("mode", 0);
+            writer.Field("water", "");
+            writer.Field("bg", "007.jpg");
+            writer.Field("welcome", "");
+            writer.Field("visibility", 0);
+            writer.EndObject();
+
+            writer.Key("gw2");
+            writer.RawValue("[]");
+            writer.Key("townname");
+            writer.RawValue("{}");
+            writer.Field("worldname", "pandora");
+            writer.Field("cl", "");
+
+            writer.BeginObject("barters");
+            writer.Field("premium", 0);
+            writer.Field("dragon", 0);
+            writer.Field("event", 0);
+            writer.EndObject();
+            writer.EndObject();
+            return JsonTemplate(writer.TakeString());
+        }
+
+        /**
+         * Slots: nd, ts
+         */
+        JsonTemplate _CreateInitLevel4Template() {
+            JsonWriter writer;
+            writer.BeginObject();
+            writer.BeginObject("c");
+            writer.BeginObject("0");
+            writer.Field("k", 3);
+            writer.Field("n", "System");
+            writer.Field("i", "");
+            writer.Key("nd");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.Field("t", "Siemano kolano");
+            writer.Field("s", "sys_info");
+            writer.Key("ts");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.EndObject();
+            writer.EndObject();
+            writer.EndObject();
+            return JsonTemplate(writer.TakeString());
+        }
+
+        /**
+         * Slots: e
+         */
+        JsonTemplate _CreateStopPacketTemplate() {
+            JsonWriter writer;
+            writer.BeginObject();
+            writer.Field("t", "stop");
+            writer.Key("e");
+            writer.RawValue(JsonTemplate::Slot);
+            writer.EndObject();
+            return JsonTemplate(writer.TakeString());
+        }
+
+        // the constant parts of the responses are serialized once, at startup
+        const JsonTemplate g_initLevel1Template = _CreateInitLevel1Template();
+        const JsonTemplate g_initLevel2Template = _CreateInitLevel2Template();
+        const JsonTemplate g_initLevel4Template = _CreateInitLevel4Template();
+        const JsonTemplate g_stopPacketTemplate = _CreateStopPacketTemplate();
+
+        HandleResult _InvokeFunctionHandler(const PacketHandlerData& data, const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out) {
+            return data.Handler(player, in, out);
+        }
+
+        uint64_t _HashAction(std::string_view action, uint64_t seed) noexcept {
+            // FNV-1a with a seeded offset basis
+            uint64_t hash = 14695981039346656037ull ^ seed;
+
+            for (char c : action) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+
+            return hash ^ (hash >> 29);
+        }
+
+        /**
+         * Finds a seed for which the actions do not collide, the table grows when no seed works.
+         */
+        void _BuildPerfectHash(_PacketDispatchTables& tables) {
+            size_t size = 4;
+            while (size < tables.Actions.size() * 2) {
+                size *= 2;
+            }
+
+            for (;;) {
+                for (uint64_t seed = 1; seed <= 1024; seed++) {
+                    std::vector<PacketActionId> slots(size, UnknownPacketAction);
+                    bool collision = false;
+
+                    for (PacketActionId id = NoPacketAction; id < tables.Actions.size() && !collision; id++) {
+                        PacketActionId& slot = slots[_HashAction(tables.Actions[id], seed) & (size - 1)];
+                        collision = slot != UnknownPacketAction;
+                        slot = id;
+                    }
+
+                    if (!collision) {
+                        tables.Seed = seed;
+                        tables.Mask = size - 1;
+                        tables.Slots = std::move(slots);
+                        return;
+                    }
+                }
+
+                size *= 2;
+            }
+        }
+
+        std::vector<const PacketHandlerData*> _BuildChain(const std::vector<std::shared_ptr<PacketHandlerData>>& handlers, PacketActionId id, const std::string& action) {
+            std::vector<const PacketHandlerData*> chain;
+
+            for (const std::shared_ptr<PacketHandlerData>& data : handlers) {
+                // '_' is a 'no action' action, it is never handled by the handlers with action filters
+                if (data->ActionFilters.empty() || (id > NoPacketAction && Contains(data->ActionFilters, action)))
+                    chain.push_back(data.get());
+            }
+
+            return chain;
+        }
     }
 
     const std::vector<std::shared_ptr<PacketHandlerData>>& GetRegisteredPacketHandlers() noexcept {
@@ -33,8 +347,14 @@ namespace Merrie {
         return g_asyncPacketHandlers;
     }
 
-    inline void RegisterPacketHandler(RunMode mode, std::vector<std::string> actionFilters, PacketHandler handler) noexcept {
-        std::shared_ptr<PacketHandlerData> ref = g_packetHandlers.emplace_back(std::make_shared<PacketHandlerData>(PacketHandlerData{mode, std::move(actionFilters), std::move(handler)}));
+    void RegisterPacketHandler(RunMode mode, std::vector<std::string> actionFilters, PacketHandler handler) noexcept {
+        RegisterPacketHandlerData(PacketHandlerData{mode, std::move(actionFilters), std::move(handler), &_InvokeFunctionHandler, {}});
+    }
+
+    void RegisterPacketHandlerData(PacketHandlerData data) noexcept {
+        M_ASSERT(!g_dispatchTables.Frozen, "Packet handlers cannot be registered after they were frozen");
+
+        std::shared_ptr<PacketHandlerData> ref = g_packetHandlers.emplace_back(std::make_shared<PacketHandlerData>(std::move(data)));
 
         if (ref->Mode == RunMode::Sync)
             g_syncPacketHandlers.emplace_back(std::move(ref));
@@ -44,235 +364,318 @@ namespace Merrie {
             M_FAIL("ref.Mode = ???");
     }
 
+    void FreezePacketHandlers() noexcept {
+        _PacketDispatchTables& tables = g_dispatchTables;
+
+        if (tables.Frozen)
+            return;
+
+        tables.Actions = {"", "_"};
+
+        for (const std::shared_ptr<PacketHandlerData>& data : g_packetHandlers) {
+            for (const std::string& action : data->ActionFilters) {
+                if (!Contains(tables.Actions, action))
+                    tables.Actions.push_back(action);
+            }
+        }
+
+        for (PacketActionId id = UnknownPacketAction; id < tables.Actions.size(); id++) {
+            tables.SyncChains.push_back(_BuildChain(g_syncPacketHandlers, id, tables.Actions[id]));
+            tables.AsyncChains.push_back(_BuildChain(g_asyncPacketHandlers, id, tables.Actions[id]));
+        }
+
+        _BuildPerfectHash(tables);
+        tables.Frozen = true;
+    }
+
+    PacketActionId FindPacketAction(std::string_view action) noexcept {
+        const _PacketDispatchTables& tables = g_dispatchTables;
+        M_ASSERT(tables.Frozen, "Packet handlers have to be frozen before dispatching");
+
+        const PacketActionId id = tables.Slots[_HashAction(action, tables.Seed) & tables.Mask];
+        return id != UnknownPacketAction && tables.Actions[id] == action ? id : UnknownPacketAction;
+    }
+
+    const std::vector<const PacketHandlerData*>& GetPacketHandlerChain(RunMode mode, PacketActionId action) noexcept {
+        const _PacketDispatchTables& tables = g_dispatchTables;
+        M_ASSERT(tables.Frozen, "Packet handlers have to be frozen before dispatching");
+
+        return mode == RunMode::Sync ? tables.SyncChains[action] : tables.AsyncChains[action];
+    }
+
+    std::string CreateStopPacket(std::string_view reason) {
+        return g_stopPacketTemplate.Render(reason);
+    }
+
     namespace {
-        void RegisterStandardHandlers() noexcept {
-            RegisterPacketHandler(RunMode::Async, {}, [](const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket&) -> HandleResult {
-                // browser_token and initlvl check task
-                std::scoped_lock lock(player->GetDataMutex());
+        JsonTemplate::Raw _HeroField(const PlayerState& state, HeroField field) {
+            std::string_view json = state.GetHeroFieldJson(field);
+            return {json.empty() ? "null" : json};
+        }
+
+        HandleResult _CheckSession(const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out, std::optional<InitLevel> initLevel,
+                                   std::optional<uint32_t> browserToken) {
+            // browser_token and initlvl check task
+            std::scoped_lock lock(player->GetDataMutex());
 
-                // check initlvl
-                if (in.Action != "init" && player->GetInitLevel() != InitLevel::FullyInitialized) {
-                    return HandleResult::StopHandling;
+            // check initlvl
+            if (in.Action != "init" && player->GetInitLevel() != InitLevel::FullyInitialized) {
+                // a kicked player is told why its session ended, the stop event in its queue is not sent to it anymore
+                if (player->GetInitLevel() == InitLevel::None && !player->GetKickMessage().empty()) {
+                    out.GetWriter().Field("t", "stop");
+                    out.GetWriter().Field("e", player->GetKickMessage());
                 }
 
-                // check browser token
-                if (player->GetBrowserToken() != 0) {
-                    // we don't care about browser_token if its the first init request
-                    if (!(in.Action == "init" && FindInMap(in.Parameters, "initlvl"s) == "1")) {
-                        const auto browserTokenParam = FindInMap(in.Parameters, "browser_token"s);
-                        uint32_t browserToken;
-                        if (!browserTokenParam || !boost::conversion::try_lexical_convert(browserTokenParam.value(), browserToken) || browserToken != player->GetBrowserToken()) {
-                            return HandleResult::StopHandling;
-                        }
+                return HandleResult::StopHandling;
+            }
+
+            // check browser token
+            if (player->GetBrowserToken() != 0) {
+                // we don't care about browser_token if its the first init request
+                if (!(in.Action == "init" && initLevel == InitLevel::Level1)) {
+                    if (!browserToken || browserToken.value() != player->GetBrowserToken()) {
+                        return HandleResult::StopHandling;
                     }
                 }
+            }
 
-                return HandleResult::Ignored;
-            });
+            return HandleResult::Ignored;
+        }
 
+        HandleResult _HandleInit(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out, InitLevel requestedInitLevel) {
+            // 'init' action handler
+            std::unique_lock lock(player->GetDataMutex());
 
-            RegisterPacketHandler(RunMode::Sync, {"init"}, [](const std::shared_ptr<Player>& player, const IncomingPacket& in, OutgoingPacket& out) -> HandleResult {
-                std::unique_lock lock(player->GetDataMutex());
+            const auto nextInitLevel = static_cast<InitLevel>(static_cast<int>(player->GetInitLevel()) + 1);
 
-                // 'init' action handler
-                const auto initLvl = FindInMap(in.Parameters, "initlvl"s);
-
-                InitLevel requestedInitLevel;
-                if (initLvl == "1") {
-                    requestedInitLevel = InitLevel::Level1;
-                } else if (initLvl == "2") {
-                    requestedInitLevel = InitLevel::Level2;
-                } else if (initLvl == "3") {
-                    requestedInitLevel = InitLevel::Level3;
-                } else if (initLvl == "4") {
-                    requestedInitLevel = InitLevel::Level4;
-                } else {
-                    return HandleResult::StopHandling;
-                }
+            // you can  always request initlvl 1
+            if (requestedInitLevel != InitLevel::Level1 && requestedInitLevel != nextInitLevel) {
+                return HandleResult::StopHandling;
+            }
 
-                const auto nextInitLevel = static_cast<InitLevel>(static_cast<int>(player->GetInitLevel()) + 1);
+            switch (requestedInitLevel) {
+                case InitLevel::Level1: {
+                    static RandomNumberGenerator<uint32_t> c_browserTokenGenerator = CreateRandomNumberGenerator<uint32_t>();
+                    player->SetBrowserToken(c_browserTokenGenerator());
 
-                // you can  always request initlvl 1
-                if (requestedInitLevel != InitLevel::Level1 && requestedInitLevel != nextInitLevel) {
-                    return HandleResult::StopHandling;
-                }
+                    // a new client, it gets the whole state once it is initialized
+                    player->GetState().Reset();
 
-                switch (requestedInitLevel) {
-                    case InitLevel::Level1: {
-                        static RandomNumberGenerator<uint32_t> c_browserTokenGenerator = CreateRandomNumberGenerator<uint32_t>();
-                        player->SetBrowserToken(c_browserTokenGenerator());
-
-                        out.GetJson() = {
-                                {"browser_token", player->GetBrowserToken()},
-                                {"qtrack",        {"*"}},
-                                {"priv_world",    0},
-                                {"wanted_show",   1},
-                                {"tutorial",      0},
-                                {"worldname",     "Merrie"},
-                                {"h",
-                                                  {
-                                                   {"id", player->GetAid()},
-                                                          {"blockade", 0},
-                                                          {"uprawnienia", 0},
-                                                          {"ap", 0},
-                                                          {"bagi", 1},
-                                                          {"bint", 1},
-                                                          {"bstr", 1},
-                                                          {"credits", 0},
-                                                          {"runes", 0},
-                                                          {"exp", 0},
-                                                          {"gold", 0},
-                                                          {"goldlim", 100000000000},
-                                                          {"healpower", 0},
-                                                          {"honor", 812},
-                                                          {"img", "/paid/zakon_rm5.gif"},
-                                                          {"lvl", 10000},
-                                                          {"mails", 0},
-                                                          {"mails_all", 0},
-                                                          {"mails_last", ""},
-                                                          {"mpath", "http://classic.margonem.pl/"},
-                                                          {"nick", player->GetCharacterName()},
-                                                          {"opt", 0},
-                                                          {"prof", "w"},
-                                                          {"ttl_value", 0},
-                                                          {"ttl_end", 1577836800},
-                                                          {"ttl_del", 0},
-                                                          {"pvp", 0},
-                                                          {"ttl", 300},
-                                                          {"x", 10},
-                                                          {"y", 10},
-                                                          {"dir", 1},
-                                                          {"stasis", 0},
-                                                          {"bag", 0},
-                                                          {"party", 0},
-                                                          {"trade", 0},
-                                                          {"wanted", 0},
-                                                          {"stamina", 50},
-                                                          {"stamina_ts", 1577836800},
-                                                          {"stamina_renew_sec", 0},
-                                                          {"cur_skill_set", 1},
-                                                          {"cur_battle_set", 1},
-                                                          {"attr", 1},
-                                                          {
-                                                                  "warrior_stats",
-                                                                  {
-                                                                          {"hp", 50},
-                                                                          {"maxhp", 50},
-                                                                          {"st", 12},
-                                                                          {"ag", 34},
-                                                                          {"it", 56},
-                                                                          {"sa", 12.34},
-                                                                          {"crit", 56.78},
-                                                                          {"ac", 1234},
-                                                                          {"resfire", 12},
-                                                                          {"resfrost", 34},
-                                                                          {"reslight", 56},
-                                                                          {"act", 78},
-                                                                          {"dmg", 1234},
-                                                                          {"dmgc", 567},
-                                                                          {"evade", {50, 5.00}},
-                                                                          {"lowcrit", 1},
-                                                                          {"heal", 234},
-                                                                          {"critmval", 5.67},
-                                                                          {"critmval_f", 6.78},
-                                                                          {"critmval_c", 7.89},
-                                                                          {"critmval_l", 8.90},
-                                                                          {"mana", 123},
-                                                                          {"acmdmg", 4},
-                                                                          {"managain", 56},
-                                                                          {"blok", 789},
-                                                                          {"critval", 10.11},
-                                                                          {"energy", 1213},
-                                                                          {"lowevade", 14},
-                                                                          {"energygain", 50}
-                                                                  }
-                                                          }
-                                                  }
-                                }
-                        };
-                        break;
-                    }
-                    case InitLevel::Level2: {
-                        out.GetJson() = {
-                                {"town",
-                                              {
-                                                      {"id",      1},
-                                                      {"mainid", 0},
-                                                      {"x",     96},
-                                                      {"y", 100},
-                                                      {"file", "ithan.5.png"},
-                                                      {"name", "Ithan"},
-                                                      {"pvp", 2},
-                                                      {"mode", 0},
-                                                      {"water", ""},
-                                                      {"bg", "007.jpg"},
-                                                      {"welcome", ""},
-                                                      {"visibility", 0}
-                                              }},
-                                {"gw2",       nlohmann::json::array()},
-                                {"townname",  nlohmann::json::object()},
-                                {"worldname", "pandora"},
-                                {"cl",        ""},
-                                {
-                                 "barters",
-                                              {
-                                                      {"premium", 0},
-                                                      {"dragon", 0},
-                                                      {"event", 0}
-                                              },
-                                }
-                        };
-                        break;
-                    }
-                    case InitLevel::Level3: {
-                        break;
-                    }
-                    case InitLevel::Level4: {
-                        out.GetJson() = {
-                                {"c",
-                                        {
-                                                {"0",
-                                                        {
-                                                                {"k", 3},
-                                                                {"n", "System"},
-                                                                {"i", ""},
-                                                                {"nd", player->GetCharacterName()},
-                                                                {"t", "Siemano kolano"},
-                                                                {"s", "sys_info"},
-                                                                {"ts", static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(DefaultClock::now().time_since_epoch()).count()) /
-                                                                       1000.0f}
-                                                        }
-                                                }
-                                        }
-                                }
-                        };
-                        break;
-                    }
-                    default:
-                        M_FAIL("how did we even get here");
+                    // the hero is the persisted one, Reset() does not touch the values
+                    const PlayerState& state = player->GetState();
+                    g_initLevel1Template.RenderMembers(out.GetWriter(), player->GetBrowserToken(), player->GetAid(), _HeroField(state, HeroField::Exp),
+                                                       _HeroField(state, HeroField::Gold), _HeroField(state, HeroField::Honor),
+                                                       _HeroField(state, HeroField::Level), player->GetCharacterName(), _HeroField(state, HeroField::X),
+                                                       _HeroField(state, HeroField::Y), _HeroField(state, HeroField::Dir),
+                                                       _HeroField(state, HeroField::Stamina));
+                    break;
+                }
+                case InitLevel::Level2: {
+                    g_initLevel2Template.RenderMembers(out.GetWriter());
+                    break;
+                }
+                case InitLevel::Level3: {
+                    break;
                 }
+                case InitLevel::Level4: {
+                    g_initLevel4Template.RenderMembers(out.GetWriter(), player->GetCharacterName(),
+                                                       static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(DefaultClock::now().time_since_epoch()).count()) / 1000.0f);
+                    break;
+                }
+                default:
+                    M_FAIL("how did we even get here");
+            }
+
 
+            player->SetInitLevel(requestedInitLevel);
 
-                player->SetInitLevel(requestedInitLevel);
+            return HandleResult::ContinueHandling;
+        }
 
-                return HandleResult::ContinueHandling;
-            });
+        /**
+         * Acknowledges the state changes that the client received, the "ev" parameter is the "ev" field of the last response it got.
+         */
+        HandleResult _AcknowledgeState(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket&, std::optional<double> ev) {
+            if (ev && *ev > 0)
+                player->GetState().Acknowledge(static_cast<StateSequence>(std::llround(*ev * 1000.0)));
+
+            return HandleResult::Ignored;
+        }
 
-            // Finishing up tasks
-            RegisterPacketHandler(RunMode::Sync, {}, [](const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out) -> HandleResult {
+        /**
+         * Moves the hero, the "ml" parameter is the path walked since the last packet as "x,y;x,y;...", only the last step
+         * counts.
+         */
+        HandleResult _HandleMovement(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket&, std::optional<std::string_view> ml) {
+            if (!ml || ml->empty() || player->GetTown() == nullptr)
+                return HandleResult::Ignored;
+
+            {
                 std::shared_lock lock(player->GetDataMutex());
+                if (!player->IsInitialized())
+                    return HandleResult::Ignored;
+            }
+
+            const std::string_view step = ml->substr(ml->rfind(';') + 1);
+            const size_t separator = step.find(',');
+
+            int32_t x = 0;
+            int32_t y = 0;
+
+            // a malformed path does not end the session, the hero stays where it was
+            if (separator == std::string_view::npos || !PacketParameterParser<int32_t>::Parse(step.substr(0, separator), x) ||
+                !PacketParameterParser<int32_t>::Parse(step.substr(separator + 1), y))
+                return HandleResult::Ignored;
+
+            player->GetTown()->Move(*player, x, y);
+            return HandleResult::Ignored;
+        }
+
+        /**
+         * Sends a chat message, the "c" parameter is the text and the "k" parameter the kind of the channel, global if it is
+         * not set. A text starting with "@<nick> " is whispered to the player with the character name.
+         */
+        HandleResult _HandleChat(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out, std::string_view c, std::optional<uint8_t> k) {
+            if (player->GetChat() == nullptr)
+                return HandleResult::StopHandling;
+
+            {
+                std::shared_lock lock(player->GetDataMutex());
+                if (!player->IsInitialized())
+                    return HandleResult::Ignored;
+            }
+
+            ChatChannel channel = k == static_cast<uint8_t>(ChatChannel::Town) ? ChatChannel::Town : ChatChannel::Global;
+            std::string_view recipient{};
 
-                if (out.GetJson().find("e") == out.GetJson().end()) {
-                    out.GetJson()["e"] = "ok";
+            if (!c.empty() && c.front() == '@') {
+                // a typo in the whisper does not end the session
+                const size_t separator = c.find(' ');
+                if (separator == std::string_view::npos) {
+                    out.GetWriter().Field("e", "The message has no text");
+                    return HandleResult::ContinueHandling;
                 }
 
-                if (player->IsInitialized()) {
-                    out.GetJson()["ev"] = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count()) / 1000.0;
+                channel = ChatChannel::Whisper;
+                recipient = c.substr(1, separator - 1);
+                c.remove_prefix(separator + 1);
+            }
+
+            if (!player->GetChat()->Send(channel, *player, c, recipient))
+                out.GetWriter().Field("e", channel == ChatChannel::Whisper ? "The player is not in the game" : "The message cannot be sent");
+
+            return HandleResult::ContinueHandling;
+        }
+
+        /**
+         * Adds the chat messages received since the last response. The messages are shared buffers, they are copied into the
+         * response as they are. The "c" of the init packets goes first, the messages wait for the next response then.
+         */
+        HandleResult _AddChatMessages(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out) {
+            if (out.HasField("c"))
+                return HandleResult::Ignored;
+
+            const std::deque<std::shared_ptr<const std::string>> messages = player->TakeChatMessages();
+            if (messages.empty())
+                return HandleResult::Ignored;
+
+            JsonWriter& writer = out.GetWriter();
+            writer.BeginObject("c");
+
+            for (const std::shared_ptr<const std::string>& message : messages) {
+                writer.RawMembers(*message);
+            }
+
+            writer.EndObject();
+            return HandleResult::ContinueHandling;
+        }
+
+        /**
+         * Adds the events produced since the last response.
+         */
+        HandleResult _AddPendingEvents(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out) {
+            if (!player->HasPendingEvents()) {
+                return HandleResult::Ignored;
+            }
+
+            nlohmann::json events = player->TakePendingEvents();
+
+            // the player was kicked, the session ends with this response, so it has the whole kick with its message in it. The
+            // kick is never deferred, the next request of a kicked player does not get to the sync handlers
+            if (const auto stop = events.find("t"); stop != events.end() && *stop == "stop") {
+                bool collides = false;
+
+                for (const auto& [key, value] : events.items()) {
+                    collides = collides || out.HasField(key);
                 }
 
-                return HandleResult::ContinueHandling;
-            });
+                // the response of the action is dropped in favour of the kick
+                if (collides)
+                    out = OutgoingPacket();
+
+                std::unique_lock lock(player->GetDataMutex());
+                player->SetInitLevel(InitLevel::None);
+            }
+
+            // the response of the action takes precedence over the events, the colliding ones are sent with the next response
+            nlohmann::json deferred = nlohmann::json::object();
+
+            for (auto& [key, value] : events.items()) {
+                if (out.HasField(key))
+                    deferred.emplace(key, std::move(value));
+                else
+                    out.GetJson().emplace(key, std::move(value));
+            }
+
+            if (!deferred.empty())
+                player->RestorePendingEvents(std::move(deferred));
+
+            return HandleResult::ContinueHandling;
+        }
+
+        /**
+         * Adds the state changes that the client did not acknowledge yet, only for the initialized clients.
+         */
+        HandleResult _AddStateDelta(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out) {
+            {
+                std::shared_lock lock(player->GetDataMutex());
+                if (!player->IsInitialized())
+                    return HandleResult::Ignored;
+            }
+
+            // every response of an initialized client gets a sequence, the ev field, even without changes
+            const StateSequence sequence = player->CreateResponseSequence();
 
+            return player->GetState().WriteDelta(out.GetWriter(), sequence) ? HandleResult::ContinueHandling : HandleResult::Ignored;
+        }
+
+        /**
+         * Finishing up tasks
+         */
+        HandleResult _FinishPacket(const std::shared_ptr<Player>& player, const IncomingPacket&, OutgoingPacket& out) {
+            std::shared_lock lock(player->GetDataMutex());
+
+            if (!out.HasField("e")) {
+                out.GetWriter().Field("e", "ok");
+            }
+
+            if (player->IsInitialized()) {
+                out.GetWriter().Field("ev", static_cast<double>(player->GetResponseSequence()) / 1000.0);
+            }
+
+            return HandleResult::ContinueHandling;
+        }
+
+        void RegisterStandardHandlers() noexcept {
+            RegisterPacketHandler<_CheckSession>(RunMode::Async, {}, "initlvl", "browser_token");
+            RegisterPacketHandler<_HandleInit>(RunMode::Sync, {"init"}, "initlvl");
+            RegisterPacketHandler<_AcknowledgeState>(RunMode::Sync, {}, "ev");
+            RegisterPacketHandler<_HandleMovement>(RunMode::Sync, {}, "ml");
+            RegisterPacketHandler<_HandleChat>(RunMode::Sync, {"chat"}, "c", "k");
+            RegisterPacketHandler<_AddStateDelta>(RunMode::Sync, {});
+            RegisterPacketHandler<_AddChatMessages>(RunMode::Sync, {});
+            RegisterPacketHandler<_AddPendingEvents>(RunMode::Sync, {});
+            RegisterPacketHandler<_FinishPacket>(RunMode::Sync, {});
         }
 
         M_INITIALIZER(RegisterStandardHandlers);
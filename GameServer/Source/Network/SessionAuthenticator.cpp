@@ -0,0 +1,113 @@
+#include <GameServer/Network/SessionAuthenticator.hpp>
+
+#include <Commons/Crypto/Hmac.hpp>
+#include <algorithm>
+#include <boost/asio/post.hpp>
+
+namespace Merrie {
+
+    namespace {
+        AuthenticationSettings _CheckSettings(AuthenticationSettings settings) {
+            #ifdef M_HAS_OPENSSL_CRYPTO
+            return settings;
+            #else
+            throw SessionTokenException("Authentication is enabled, but Merrie was compiled without OpenSSL");
+            #endif
+        }
+    }
+
+    SessionAuthenticator::SessionAuthenticator(AuthenticationSettings settings)
+            : m_settings(_CheckSettings(std::move(settings))),
+              #ifdef M_HAS_OPENSSL_CRYPTO
+              m_signer(m_settings.Secret),
+              #endif
+              m_verifyPool(std::max<size_t>(m_settings.VerifyThreadCount, 1)) {
+    }
+
+    SessionAuthenticator::~SessionAuthenticator() {
+        m_verifyPool.stop();
+        m_verifyPool.join();
+    }
+
+    bool SessionAuthenticator::IsVerified(uint64_t aid, std::string_view token) const {
+        const std::optional<std::shared_ptr<const VerifiedSessions>> sessions = m_sessions.Find(aid);
+        if (!sessions)
+            return false;
+
+        const auto now = std::chrono::system_clock::now();
+
+        return std::any_of((*sessions)->begin(), (*sessions)->end(), [token, now](const VerifiedSession& session) {
+            return ConstantTimeEquals(session.Token, token) && session.Expiry > now;
+        });
+    }
+
+    bool SessionAuthenticator::Verify(std::string token, VerifyCallback callback) {
+        if (!TryBegin())
+            return false;
+
+        boost::asio::post(m_verifyPool, [this, token = std::move(token), callback = std::move(callback)]() mutable {
+            std::optional<SessionToken> session;
+
+            #ifdef M_HAS_OPENSSL_CRYPTO
+            session = m_signer.Verify(token);
+            #endif
+
+            if (session)
+                Remember(std::move(token), *session);
+
+            m_pending.fetch_sub(1, std::memory_order_release);
+            callback(session);
+        });
+
+        return true;
+    }
+
+    const AuthenticationSettings& SessionAuthenticator::GetSettings() const noexcept {
+        return m_settings;
+    }
+
+    void SessionAuthenticator::Remember(std::string token, const SessionToken& session) {
+        if (m_sessions.GetSize() >= m_settings.MaxCachedSessions) {
+            const auto now = std::chrono::system_clock::now();
+
+            m_sessions.RemoveIf([now](uint64_t, const std::shared_ptr<const VerifiedSessions>& verified) {
+                return std::all_of(verified->begin(), verified->end(), [now](const VerifiedSession& session) {
+                    return session.Expiry <= now;
+                });
+            });
+
+            // the session is verified again with its next request
+            if (m_sessions.GetSize() >= m_settings.MaxCachedSessions)
+                return;
+        }
+
+        // the sessions are copied on write, a session remembered by another thread at the same time may be lost, it is
+        // verified again with its next request then
+        const auto now = std::chrono::system_clock::now();
+        auto sessions = std::make_shared<VerifiedSessions>();
+
+        if (const std::optional<std::shared_ptr<const VerifiedSessions>> previous = m_sessions.Find(session.Aid)) {
+            for (const VerifiedSession& verified : **previous) {
+                if (verified.Expiry > now && verified.Token != token)
+                    sessions->push_back(verified);
+            }
+
+            if (sessions->size() >= MaxSessionsPerAccount)
+                sessions->erase(sessions->begin(), sessions->end() - (MaxSessionsPerAccount - 1));
+        }
+
+        sessions->push_back(VerifiedSession{std::move(token), session.Expiry});
+        m_sessions.InsertOrAssign(session.Aid, std::move(sessions));
+    }
+
+    bool SessionAuthenticator::TryBegin() noexcept {
+        const size_t pending = m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (m_settings.MaxPendingVerifications != 0 && pending >= m_settings.MaxPendingVerifications) {
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+}
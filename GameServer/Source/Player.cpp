@@ -1,5 +1,9 @@
 #include <GameServer/Player.hpp>
+
+#include <Commons/Network/WebSocket.hpp>
+#include <GameServer/Network/Packets.hpp>
 #include <mutex>
+#include <utility>
 
 namespace Merrie {
 
@@ -8,6 +12,21 @@ namespace Merrie {
             m_username("User#" + std::to_string(aid)) {
 
         SetTimeout();
+
+        // the changes of the state are events of the player too
+        m_state.SetChangeListener([this]() {
+            MarkDirty();
+        });
+
+        // the values of the init packet
+        m_state.SetHeroField(HeroField::X, m_x);
+        m_state.SetHeroField(HeroField::Y, m_y);
+        m_state.SetHeroField(HeroField::Dir, 1);
+        m_state.SetHeroField(HeroField::Gold, 0);
+        m_state.SetHeroField(HeroField::Exp, 0);
+        m_state.SetHeroField(HeroField::Level, 10000);
+        m_state.SetHeroField(HeroField::Honor, 812);
+        m_state.SetHeroField(HeroField::Stamina, 50);
     }
 
     uint64_t Player::GetAid() const noexcept {
@@ -18,8 +37,8 @@ namespace Merrie {
         return m_username;
     }
 
-    void Player::SetTimeout() {
-        m_timeout = PointInFuture<std::chrono::seconds>(10); // todo: configurable
+    void Player::SetTimeout() noexcept {
+        m_timeout.store(DefaultClock::now() + InactivityTimeout, std::memory_order_relaxed);
     }
 
     bool Player::IsOnline() const noexcept {
@@ -46,8 +65,8 @@ namespace Merrie {
         m_browserToken = browserToken;
     }
 
-    const DefaultClock::time_point& Player::GetTimeout() const noexcept {
-        return m_timeout;
+    DefaultClock::time_point Player::GetTimeout() const noexcept {
+        return m_timeout.load(std::memory_order_relaxed);
     }
 
     std::shared_mutex& Player::GetDataMutex() const noexcept {
@@ -63,12 +82,203 @@ namespace Merrie {
     }
 
     void Player::Kick(std::string_view message) {
+        {
+            std::scoped_lock lock(m_dataMutex);
+            m_kickMessage = message;
+            m_initLevel = InitLevel::None;
+        }
+
+        // the session ends right away, players connected through a WebSocket are also notified right away, the others get
+        // the stop event with their next response
+        Push(std::make_shared<const std::string>(CreateStopPacket(message)));
+        PushEvents({{"t", "stop"}, {"e", message}});
+    }
+
+    void Player::AttachPushConnection(const std::shared_ptr<WebSocketConnection>& connection) {
         std::scoped_lock lock(m_dataMutex);
-        m_kickMessage = message;
-        m_initLevel = InitLevel::None;
+        m_pushConnection = connection;
+    }
+
+    void Player::DetachPushConnection(const std::shared_ptr<WebSocketConnection>& connection) {
+        std::scoped_lock lock(m_dataMutex);
+
+        if (m_pushConnection.lock() == connection)
+            m_pushConnection.reset();
+    }
+
+    bool Player::HasPushConnection() const {
+        return GetPushConnection() != nullptr;
+    }
+
+    std::shared_ptr<WebSocketConnection> Player::GetPushConnection() const {
+        std::shared_ptr<WebSocketConnection> connection;
+
+        {
+            std::shared_lock lock(m_dataMutex);
+            connection = m_pushConnection.lock();
+        }
+
+        return connection && connection->IsOpen() ? connection : nullptr;
+    }
+
+    bool Player::Push(std::shared_ptr<const std::string> message) {
+        const std::shared_ptr<WebSocketConnection> connection = GetPushConnection();
+
+        if (!connection)
+            return false;
+
+        connection->Send(std::move(message));
+        return true;
+    }
+
+    void Player::MarkDirty() {
+        if (m_dirty.exchange(true, std::memory_order_acq_rel))
+            return;
+
+        // the marks made before the admission are taken by it
+        const SlotHandle handle = m_handle.load(std::memory_order_acquire);
+        if (handle != InvalidSlotHandle)
+            m_dirtyList->Push(handle);
+    }
+
+    bool Player::TakeDirtyMark() noexcept {
+        return m_dirty.exchange(false, std::memory_order_acq_rel);
+    }
+
+    void Player::SetDirtyList(ShardedInbox<SlotHandle>* dirtyList) noexcept {
+        m_dirtyList = dirtyList;
+    }
+
+    bool Player::PushEvents(nlohmann::json events) {
+        const bool pushed = m_eventQueue.Push(std::move(events));
+
+        // reported once by the main thread, not for every dropped event
+        if (!pushed)
+            m_eventsDropped = true;
+
+        // a full queue is marked too, so a kicked player is released even when its stop event did not fit
+        MarkDirty();
+        return pushed;
+    }
+
+    void Player::CoalesceEvents() {
+        m_eventQueue.Drain([this](nlohmann::json& events) {
+            m_pendingEvents.update(events, true);
+        });
+
+        if (m_eventsDropped.exchange(false))
+            M_LOG_WARNING_THIS << "The event queue was full, some events were dropped";
+    }
+
+    void Player::QueueChatMessage(std::shared_ptr<const std::string> message) {
+        if (m_chatMessages.size() == MaxQueuedChatMessages)
+            m_chatMessages.pop_front();
+
+        m_chatMessages.push_back(std::move(message));
+        MarkDirty();
+    }
+
+    std::deque<std::shared_ptr<const std::string>> Player::TakeChatMessages() {
+        return std::exchange(m_chatMessages, {});
+    }
+
+    bool Player::HasPendingEvents() const noexcept {
+        return !m_pendingEvents.empty() || !m_eventQueue.IsEmpty() || !m_chatMessages.empty() || m_state.HasUnsentChanges();
+    }
+
+    nlohmann::json Player::TakePendingEvents() {
+        CoalesceEvents();
+        return std::exchange(m_pendingEvents, nlohmann::json::object());
+    }
+
+    void Player::RestorePendingEvents(nlohmann::json events) {
+        for (auto& [key, value] : events.items()) {
+            m_pendingEvents.emplace(key, std::move(value));
+        }
+    }
+
+    PlayerState& Player::GetState() noexcept {
+        return m_state;
+    }
+
+    StateSequence Player::CreateResponseSequence() {
+        const auto now = static_cast<StateSequence>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+
+        m_responseSequence = std::max(now, m_responseSequence + 1);
+        return m_responseSequence;
+    }
+
+    StateSequence Player::GetResponseSequence() const noexcept {
+        return m_responseSequence;
+    }
+
+    SlotHandle Player::GetHandle() const noexcept {
+        return m_handle.load(std::memory_order_acquire);
+    }
+
+    void Player::SetHandle(SlotHandle handle) noexcept {
+        m_handle.store(handle, std::memory_order_release);
+    }
+
+    std::pair<int32_t, int32_t> Player::GetPosition() const noexcept {
+        return {m_x, m_y};
+    }
+
+    void Player::SetPosition(int32_t x, int32_t y) {
+        m_x = x;
+        m_y = y;
+        m_state.SetHeroField(HeroField::X, x);
+        m_state.SetHeroField(HeroField::Y, y);
+    }
+
+    Town* Player::GetTown() const noexcept {
+        return m_town;
+    }
+
+    void Player::SetTown(Town* town) noexcept {
+        m_town = town;
+    }
+
+    ChatBroadcaster* Player::GetChat() const noexcept {
+        return m_chat;
+    }
+
+    void Player::SetChat(ChatBroadcaster* chat) noexcept {
+        m_chat = chat;
+    }
+
+    std::string Player::Save() {
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.Key("hero");
+        m_state.WriteHero(writer);
+        writer.EndObject();
+
+        m_savedHeroVersion = m_state.GetHeroVersion();
+        return writer.TakeString();
+    }
+
+    bool Player::HasUnsavedChanges() const noexcept {
+        return m_state.GetHeroVersion() != m_savedHeroVersion;
+    }
+
+    void Player::Restore(std::string_view data) {
+        const nlohmann::json saved = nlohmann::json::parse(data.begin(), data.end(), nullptr, false);
+
+        if (saved.is_discarded() || !saved.is_object() || !saved.contains("hero") || !m_state.RestoreHero(saved.at("hero"))) {
+            M_LOG_WARNING_THIS << "The saved data is not valid, starting from scratch";
+            return;
+        }
+
+        // the town clamps the position once the player enters it
+        const nlohmann::json& hero = saved.at("hero");
+        if (hero.contains("x") && hero.at("x").is_number_integer() && hero.contains("y") && hero.at("y").is_number_integer())
+            SetPosition(hero.at("x").get<int32_t>(), hero.at("y").get<int32_t>());
+
+        m_savedHeroVersion = m_state.GetHeroVersion();
     }
 
-    Logger& Player::GetLogger() const {
+    ContextLogger& Player::GetLogger() const {
         return m_logger;
     }
 }
\ No newline at end of file
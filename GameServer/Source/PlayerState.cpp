@@ -0,0 +1,258 @@
+#include <GameServer/PlayerState.hpp>
+
+#include <Commons/Containers.hpp>
+#include <charconv>
+#include <nlohmann/json.hpp>
+
+namespace Merrie {
+
+    namespace {
+        constexpr const std::array<std::string_view, static_cast<size_t>(HeroField::Count)> c_heroFieldNames = {
+                "x",
+                "y",
+                "dir",
+                "gold",
+                "exp",
+                "lvl",
+                "honor",
+                "stamina",
+        };
+
+        constexpr const std::array<std::string_view, static_cast<size_t>(EntityCollection::Count)> c_entityCollectionNames = {
+                "other",
+                "npc",
+                "item",
+        };
+
+        constexpr const std::string_view c_removedEntity = R"({"del":1})";
+    }
+
+    PlayerState::PlayerState() = default;
+
+    void PlayerState::SetHeroFieldValue(HeroField field, std::string value) {
+        Entry& entry = m_heroFields[static_cast<size_t>(field)];
+
+        if (entry.Value == value)
+            return;
+
+        entry.Value = std::move(value);
+        m_heroVersion++;
+
+        if (MarkDirty(entry))
+            m_dirtyHeroFields.push_back(field);
+    }
+
+    void PlayerState::SetEntity(EntityCollection collection, uint64_t id, std::string object) {
+        Entry& entry = m_entities[static_cast<size_t>(collection)][id];
+
+        if (!entry.Removed && entry.Value == object)
+            return;
+
+        entry.Value = std::move(object);
+        entry.Removed = false;
+
+        if (MarkDirty(entry))
+            m_dirtyEntities[static_cast<size_t>(collection)].push_back(id);
+    }
+
+    void PlayerState::RemoveEntity(EntityCollection collection, uint64_t id) {
+        auto& entities = m_entities[static_cast<size_t>(collection)];
+        const auto iterator = entities.find(id);
+
+        if (iterator == entities.end() || iterator->second.Removed)
+            return;
+
+        Entry& entry = iterator->second;
+        entry.Value.clear();
+        entry.Removed = true;
+
+        if (MarkDirty(entry))
+            m_dirtyEntities[static_cast<size_t>(collection)].push_back(id);
+    }
+
+    void PlayerState::SetChangeListener(std::function<void()> listener) {
+        m_changeListener = std::move(listener);
+    }
+
+    bool PlayerState::HasUnsentChanges() const noexcept {
+        return m_unsentChanges != 0;
+    }
+
+    bool PlayerState::WriteDelta(JsonWriter& writer, StateSequence sequence) {
+        M_ASSERT(sequence > m_lastSequence && sequence != Unsent, "The sequences of the responses have to increase");
+
+        bool written = false;
+
+        auto markSent = [this, sequence](Entry& entry) {
+            if (entry.SentIn == Unsent) {
+                entry.SentIn = sequence;
+                m_unsentChanges--;
+            }
+        };
+
+        if (!m_dirtyHeroFields.empty()) {
+            writer.BeginObject("h");
+
+            for (HeroField field : m_dirtyHeroFields) {
+                Entry& entry = m_heroFields[static_cast<size_t>(field)];
+
+                writer.Key(c_heroFieldNames[static_cast<size_t>(field)]);
+                writer.RawValue(entry.Value);
+                markSent(entry);
+            }
+
+            writer.EndObject();
+            written = true;
+        }
+
+        for (size_t collection = 0; collection < m_dirtyEntities.size(); collection++) {
+            if (m_dirtyEntities[collection].empty())
+                continue;
+
+            writer.BeginObject(c_entityCollectionNames[collection]);
+
+            for (uint64_t id : m_dirtyEntities[collection]) {
+                Entry& entry = m_entities[collection].at(id);
+
+                char digits[24];
+                const auto result = std::to_chars(std::begin(digits), std::end(digits), id);
+                writer.Key(std::string_view(digits, result.ptr - digits));
+                writer.RawValue(entry.Removed ? c_removedEntity : entry.Value);
+                markSent(entry);
+            }
+
+            writer.EndObject();
+            written = true;
+        }
+
+        if (written)
+            m_lastSequence = sequence;
+
+        return written;
+    }
+
+    void PlayerState::Acknowledge(StateSequence sequence) {
+        if (sequence <= m_acknowledgedSequence || sequence > m_lastSequence)
+            return;
+
+        m_acknowledgedSequence = sequence;
+
+        // the client has the changes sent up to the sequence, unless they changed again since
+        auto isAcknowledged = [sequence](Entry& entry) {
+            if (entry.SentIn > sequence)
+                return false;
+
+            entry.Dirty = false;
+            return true;
+        };
+
+        RemoveIf(m_dirtyHeroFields, [&](HeroField field) {
+            return isAcknowledged(m_heroFields[static_cast<size_t>(field)]);
+        });
+
+        for (size_t collection = 0; collection < m_dirtyEntities.size(); collection++) {
+            auto& entities = m_entities[collection];
+
+            RemoveIf(m_dirtyEntities[collection], [&](uint64_t id) {
+                const auto iterator = entities.find(id);
+
+                if (!isAcknowledged(iterator->second))
+                    return false;
+
+                // the client removed the entity, it does not have to be remembered anymore
+                if (iterator->second.Removed)
+                    entities.erase(iterator);
+
+                return true;
+            });
+        }
+    }
+
+    void PlayerState::Reset() {
+        m_dirtyHeroFields.clear();
+        m_unsentChanges = 0;
+        m_acknowledgedSequence = m_lastSequence;
+
+        for (size_t field = 0; field < m_heroFields.size(); field++) {
+            Entry& entry = m_heroFields[field];
+            entry.Dirty = false;
+
+            if (!entry.Value.empty() && MarkDirty(entry))
+                m_dirtyHeroFields.push_back(static_cast<HeroField>(field));
+        }
+
+        for (size_t collection = 0; collection < m_entities.size(); collection++) {
+            auto& entities = m_entities[collection];
+            m_dirtyEntities[collection].clear();
+
+            for (auto iterator = entities.begin(); iterator != entities.end();) {
+                Entry& entry = iterator->second;
+
+                // the client never had it
+                if (entry.Removed) {
+                    iterator = entities.erase(iterator);
+                    continue;
+                }
+
+                entry.Dirty = false;
+                if (MarkDirty(entry))
+                    m_dirtyEntities[collection].push_back(iterator->first);
+
+                ++iterator;
+            }
+        }
+    }
+
+    StateSequence PlayerState::GetAcknowledgedSequence() const noexcept {
+        return m_acknowledgedSequence;
+    }
+
+    uint64_t PlayerState::GetHeroVersion() const noexcept {
+        return m_heroVersion;
+    }
+
+    std::string_view PlayerState::GetHeroFieldJson(HeroField field) const noexcept {
+        return m_heroFields[static_cast<size_t>(field)].Value;
+    }
+
+    void PlayerState::WriteHero(JsonWriter& writer) const {
+        writer.BeginObject();
+
+        for (size_t field = 0; field < m_heroFields.size(); field++) {
+            if (m_heroFields[field].Value.empty())
+                continue; // never set
+
+            writer.Key(c_heroFieldNames[field]);
+            writer.RawValue(m_heroFields[field].Value);
+        }
+
+        writer.EndObject();
+    }
+
+    bool PlayerState::RestoreHero(const nlohmann::json& hero) {
+        if (!hero.is_object())
+            return false;
+
+        for (size_t field = 0; field < m_heroFields.size(); field++) {
+            const auto iterator = hero.find(c_heroFieldNames[field]);
+
+            if (iterator != hero.end())
+                SetHeroFieldValue(static_cast<HeroField>(field), iterator->dump());
+        }
+
+        return true;
+    }
+
+    bool PlayerState::MarkDirty(Entry& entry) {
+        if ((!entry.Dirty || entry.SentIn != Unsent) && m_unsentChanges++ == 0 && m_changeListener)
+            m_changeListener();
+
+        entry.SentIn = Unsent;
+
+        if (entry.Dirty)
+            return false;
+
+        entry.Dirty = true;
+        return true;
+    }
+}
@@ -0,0 +1,130 @@
+#include <GameServer/Town.hpp>
+
+#include <Commons/JsonWriter.hpp>
+#include <GameServer/Player.hpp>
+#include <algorithm>
+
+namespace Merrie {
+
+    Town::Town(uint32_t id, int32_t width, int32_t height, int32_t viewRange)
+            : m_id(id),
+              m_width(width),
+              m_height(height),
+              m_viewRange(viewRange),
+              m_grid(width, height, viewRange) {
+    }
+
+    uint32_t Town::GetId() const noexcept {
+        return m_id;
+    }
+
+    size_t Town::GetPlayerCount() const noexcept {
+        return m_residents.size();
+    }
+
+    void Town::Enter(Player& player) {
+        const auto[savedX, savedY] = player.GetPosition();
+        const int32_t x = std::clamp(savedX, 0, m_width - 1);
+        const int32_t y = std::clamp(savedY, 0, m_height - 1);
+
+        auto[iterator, inserted] = m_residents.try_emplace(player.GetAid(), Resident{&player, x, y});
+        if (!inserted)
+            return;
+
+        player.SetPosition(x, y);
+        m_grid.Insert(player.GetAid(), x, y);
+        UpdateVisibility(player.GetAid(), iterator->second);
+    }
+
+    void Town::Move(Player& player, int32_t x, int32_t y) {
+        const auto iterator = m_residents.find(player.GetAid());
+        if (iterator == m_residents.end())
+            return;
+
+        Resident& resident = iterator->second;
+        x = std::clamp(x, 0, m_width - 1);
+        y = std::clamp(y, 0, m_height - 1);
+
+        player.SetPosition(x, y);
+
+        if (x == resident.X && y == resident.Y)
+            return;
+
+        m_grid.Move(player.GetAid(), resident.X, resident.Y, x, y);
+        resident.X = x;
+        resident.Y = y;
+
+        UpdateVisibility(player.GetAid(), resident);
+    }
+
+    void Town::Leave(Player& player) {
+        const auto iterator = m_residents.find(player.GetAid());
+        if (iterator == m_residents.end())
+            return;
+
+        const uint64_t aid = player.GetAid();
+        Resident& resident = iterator->second;
+
+        for (uint64_t other : resident.Visible) {
+            Resident& observer = m_residents.at(other);
+            observer.Visible.erase(std::lower_bound(observer.Visible.begin(), observer.Visible.end(), aid));
+            observer.Player_->GetState().RemoveEntity(EntityCollection::Others, aid);
+            player.GetState().RemoveEntity(EntityCollection::Others, other);
+        }
+
+        m_grid.Remove(aid, resident.X, resident.Y);
+        m_residents.erase(iterator);
+    }
+
+    void Town::UpdateVisibility(uint64_t aid, Resident& resident) {
+        m_inRange.clear();
+        m_grid.ForEachInRange(resident.X, resident.Y, m_viewRange, [this, aid](const UniformGrid<uint64_t>::Entry& entry) {
+            if (entry.Value != aid)
+                m_inRange.push_back(entry.Value);
+        });
+
+        std::sort(m_inRange.begin(), m_inRange.end());
+
+        // one pass over both sorted sets, the players only in the new one came into the range, the ones only in the old
+        // one went out of it
+        Player& player = *resident.Player_;
+        auto previous = resident.Visible.begin();
+        auto current = m_inRange.begin();
+
+        while (previous != resident.Visible.end() || current != m_inRange.end()) {
+            if (current == m_inRange.end() || (previous != resident.Visible.end() && *previous < *current)) {
+                Resident& other = m_residents.at(*previous);
+                other.Visible.erase(std::lower_bound(other.Visible.begin(), other.Visible.end(), aid));
+                other.Player_->GetState().RemoveEntity(EntityCollection::Others, aid);
+                player.GetState().RemoveEntity(EntityCollection::Others, *previous);
+                ++previous;
+                continue;
+            }
+
+            Resident& other = m_residents.at(*current);
+
+            if (previous == resident.Visible.end() || *current < *previous) {
+                other.Visible.insert(std::lower_bound(other.Visible.begin(), other.Visible.end(), aid), aid);
+                ShowResident(player, other);
+            } else {
+                ++previous;
+            }
+
+            ShowResident(*other.Player_, resident);
+            ++current;
+        }
+
+        resident.Visible.swap(m_inRange);
+    }
+
+    void Town::ShowResident(Player& observer, const Resident& resident) {
+        JsonWriter writer;
+        writer.BeginObject();
+        writer.Field("nick", resident.Player_->GetCharacterName());
+        writer.Field("x", resident.X);
+        writer.Field("y", resident.Y);
+        writer.EndObject();
+
+        observer.GetState().SetEntity(EntityCollection::Others, resident.Player_->GetAid(), writer.TakeString());
+    }
+}
@@ -0,0 +1,555 @@
+#include <gtest/gtest.h>
+#include <Commons/Ticker.hpp>
+#include <Commons/Network/WebSocket.hpp>
+#include <GameServer/Chat.hpp>
+#include <GameServer/GameServer.hpp>
+#include <GameServer/Network/Packets.hpp>
+#include <GameServer/Player.hpp>
+#include <future>
+#include <set>
+
+using namespace Merrie;
+
+namespace {
+    /**
+     * Handlers registered by the tests, next to the standard ones.
+     */
+    struct _TestHandlers {
+        const PacketHandlerData* Move = nullptr;
+        const PacketHandlerData* MoveOrTalk = nullptr;
+        const PacketHandlerData* Any = nullptr;
+        const PacketHandlerData* AsyncTalk = nullptr;
+        std::vector<std::string> ManyActions{};
+    };
+
+    const PacketHandlerData* _Register(RunMode mode, std::vector<std::string> actionFilters) {
+        RegisterPacketHandler(mode, std::move(actionFilters), [](const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&) {
+            return HandleResult::ContinueHandling;
+        });
+
+        return GetRegisteredPacketHandlers().back().get();
+    }
+
+    /**
+     * Registers the test handlers and freezes the tables, once for all tests.
+     */
+    const _TestHandlers& _GetTestHandlers() {
+        static const _TestHandlers handlers = [] {
+            _TestHandlers result;
+            result.Move = _Register(RunMode::Sync, {"test_move"});
+            result.MoveOrTalk = _Register(RunMode::Sync, {"test_move", "test_talk"});
+            result.Any = _Register(RunMode::Sync, {});
+            result.AsyncTalk = _Register(RunMode::Async, {"test_talk"});
+
+            // enough actions for the perfect hash to need a bigger table than the first one
+            for (int i = 0; i < 200; i++) {
+                result.ManyActions.push_back("test_action_" + std::to_string(i));
+            }
+
+            _Register(RunMode::Async, result.ManyActions);
+            FreezePacketHandlers();
+            return result;
+        }();
+
+        return handlers;
+    }
+
+    struct _ReceivedParameters {
+        int Calls = 0;
+        int32_t Number = 0;
+        std::string_view Text{};
+        std::optional<uint8_t> Small{};
+        std::optional<double> Real{};
+        float Single = 0;
+    };
+
+    _ReceivedParameters g_received;
+
+    HandleResult _HandleRequired(const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&, int32_t number, std::string_view text) {
+        g_received.Calls++;
+        g_received.Number = number;
+        g_received.Text = text;
+        return HandleResult::ContinueHandling;
+    }
+
+    HandleResult _HandleOptional(const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&, std::optional<uint8_t> small, std::optional<double> real) {
+        g_received.Calls++;
+        g_received.Small = small;
+        g_received.Real = real;
+        return HandleResult::ContinueHandling;
+    }
+
+    HandleResult _HandleFloat(const std::shared_ptr<Player>&, const IncomingPacket&, OutgoingPacket&, float single) {
+        g_received.Calls++;
+        g_received.Single = single;
+        return HandleResult::ContinueHandling;
+    }
+
+    /**
+     * Invokes the typed handler the way the registered handlers are invoked, without registering it.
+     */
+    template<auto Handler, typename... Names>
+    HandleResult _Invoke(std::map<std::string, std::string> parameters, Names... parameterNames) {
+        const PacketHandlerData data{RunMode::Sync, {}, {}, &Detail::InvokePacketHandler<Handler>, {std::string(parameterNames)...}};
+        const IncomingPacket in{nullptr, "test", std::move(parameters)};
+        OutgoingPacket out;
+
+        g_received = {};
+        return data.Invoke(data, in.Player_, in, out);
+    }
+
+    template<typename T>
+    std::optional<T> _Parse(std::string_view text) {
+        T value{};
+        return PacketParameterParser<T>::Parse(text, value) ? std::make_optional(value) : std::nullopt;
+    }
+
+    /**
+     * Runs the sync chain of the empty poll for the player, like the main thread does, and parses the response.
+     */
+    nlohmann::json _Poll(const std::shared_ptr<Player>& player, OutgoingPacket out) {
+        _GetTestHandlers();
+        const IncomingPacket in{player, "_", {}, NoPacketAction};
+
+        for (const PacketHandlerData* data : GetPacketHandlerChain(RunMode::Sync, NoPacketAction)) {
+            data->Invoke(*data, player, in, out);
+        }
+
+        return nlohmann::json::parse(out.Serialize());
+    }
+
+    /**
+     * Runs the async and the sync chain for the packet like the GameHttpServer does, and parses the response.
+     *
+     * @param betweenChains called after the async chain, where the packet waits for the main thread
+     */
+    nlohmann::json _Handle(IncomingPacket in, const std::function<void()>& betweenChains = {}) {
+        _GetTestHandlers();
+        in.ActionId = FindPacketAction(in.Action);
+        OutgoingPacket out;
+
+        for (const PacketHandlerData* data : GetPacketHandlerChain(RunMode::Async, in.ActionId)) {
+            if (data->Invoke(*data, in.Player_, in, out) == HandleResult::StopHandling)
+                return nlohmann::json::parse(out.HasField("t") ? out.Serialize() : CreateStopPacket("StopHandling was returned"));
+        }
+
+        if (betweenChains)
+            betweenChains();
+
+        for (const PacketHandlerData* data : GetPacketHandlerChain(RunMode::Sync, in.ActionId)) {
+            if (data->Invoke(*data, in.Player_, in, out) == HandleResult::StopHandling)
+                return nlohmann::json::parse(CreateStopPacket("StopHandling was returned"));
+        }
+
+        return nlohmann::json::parse(out.Serialize());
+    }
+
+    bool _ChainContains(RunMode mode, PacketActionId action, const PacketHandlerData* data) {
+        const std::vector<const PacketHandlerData*>& chain = GetPacketHandlerChain(mode, action);
+        return std::find(chain.begin(), chain.end(), data) != chain.end();
+    }
+}
+
+TEST(TestPackets, TestFindPacketAction) {
+    const _TestHandlers& handlers = _GetTestHandlers();
+
+    EXPECT_EQ(FindPacketAction("_"), NoPacketAction);
+    EXPECT_EQ(FindPacketAction(""), UnknownPacketAction);
+    EXPECT_EQ(FindPacketAction("test_unknown"), UnknownPacketAction);
+    EXPECT_EQ(FindPacketAction("test_mov"), UnknownPacketAction);
+    EXPECT_EQ(FindPacketAction("test_move "), UnknownPacketAction);
+
+    // every registered action has its own id, also the ones of the standard handlers
+    std::set<PacketActionId> ids;
+
+    for (const std::string& action : handlers.ManyActions) {
+        ids.insert(FindPacketAction(action));
+    }
+
+    for (const char* action : {"test_move", "test_talk", "init", "chat"}) {
+        ids.insert(FindPacketAction(action));
+    }
+
+    EXPECT_EQ(ids.size(), handlers.ManyActions.size() + 4);
+    EXPECT_EQ(ids.count(UnknownPacketAction), 0);
+    EXPECT_EQ(ids.count(NoPacketAction), 0);
+
+    // the lookup is stable
+    EXPECT_EQ(FindPacketAction("test_move"), FindPacketAction(std::string("test_") + "move"));
+}
+
+TEST(TestPackets, TestHandlerChains) {
+    const _TestHandlers& handlers = _GetTestHandlers();
+    const PacketActionId move = FindPacketAction("test_move");
+    const PacketActionId talk = FindPacketAction("test_talk");
+
+    // the handlers of the action are merged with the ones without filters, in the registration order
+    const std::vector<const PacketHandlerData*>& moveChain = GetPacketHandlerChain(RunMode::Sync, move);
+    const auto moveHandler = std::find(moveChain.begin(), moveChain.end(), handlers.Move);
+    const auto moveOrTalkHandler = std::find(moveChain.begin(), moveChain.end(), handlers.MoveOrTalk);
+    const auto anyHandler = std::find(moveChain.begin(), moveChain.end(), handlers.Any);
+
+    ASSERT_NE(moveHandler, moveChain.end());
+    ASSERT_NE(moveOrTalkHandler, moveChain.end());
+    ASSERT_NE(anyHandler, moveChain.end());
+    EXPECT_LT(moveHandler, moveOrTalkHandler);
+    EXPECT_LT(moveOrTalkHandler, anyHandler);
+
+    EXPECT_FALSE(_ChainContains(RunMode::Sync, talk, handlers.Move));
+    EXPECT_TRUE(_ChainContains(RunMode::Sync, talk, handlers.MoveOrTalk));
+    EXPECT_TRUE(_ChainContains(RunMode::Sync, talk, handlers.Any));
+
+    // the chains of the modes are separate
+    EXPECT_TRUE(_ChainContains(RunMode::Async, talk, handlers.AsyncTalk));
+    EXPECT_FALSE(_ChainContains(RunMode::Sync, talk, handlers.AsyncTalk));
+    EXPECT_FALSE(_ChainContains(RunMode::Async, move, handlers.AsyncTalk));
+    EXPECT_FALSE(_ChainContains(RunMode::Async, move, handlers.Any));
+}
+
+TEST(TestPackets, TestWildcardOnlyChains) {
+    const _TestHandlers& handlers = _GetTestHandlers();
+
+    // '_' and the unknown actions only run the handlers without action filters
+    for (PacketActionId action : {NoPacketAction, UnknownPacketAction}) {
+        EXPECT_TRUE(_ChainContains(RunMode::Sync, action, handlers.Any));
+        EXPECT_FALSE(_ChainContains(RunMode::Sync, action, handlers.Move));
+        EXPECT_FALSE(_ChainContains(RunMode::Sync, action, handlers.MoveOrTalk));
+        EXPECT_FALSE(_ChainContains(RunMode::Async, action, handlers.AsyncTalk));
+
+        for (const PacketHandlerData* data : GetPacketHandlerChain(RunMode::Sync, action)) {
+            EXPECT_TRUE(data->ActionFilters.empty());
+        }
+
+        for (const PacketHandlerData* data : GetPacketHandlerChain(RunMode::Async, action)) {
+            EXPECT_TRUE(data->ActionFilters.empty());
+        }
+    }
+
+    EXPECT_EQ(GetPacketHandlerChain(RunMode::Sync, NoPacketAction), GetPacketHandlerChain(RunMode::Sync, UnknownPacketAction));
+}
+
+TEST(TestPackets, TestRequiredParameters) {
+    EXPECT_EQ((_Invoke<_HandleRequired>({{"n", "-42"}, {"t", "hello"}}, "n", "t")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_EQ(g_received.Number, -42);
+    EXPECT_EQ(g_received.Text, "hello");
+
+    // a missing or unparsable parameter stops the handling without calling the handler
+    EXPECT_EQ((_Invoke<_HandleRequired>({{"t", "hello"}}, "n", "t")), HandleResult::StopHandling);
+    EXPECT_EQ(g_received.Calls, 0);
+
+    EXPECT_EQ((_Invoke<_HandleRequired>({{"n", "42"}}, "n", "t")), HandleResult::StopHandling);
+    EXPECT_EQ(g_received.Calls, 0);
+
+    EXPECT_EQ((_Invoke<_HandleRequired>({{"n", "4x2"}, {"t", "hello"}}, "n", "t")), HandleResult::StopHandling);
+    EXPECT_EQ(g_received.Calls, 0);
+
+    // an empty string is still a string
+    EXPECT_EQ((_Invoke<_HandleRequired>({{"n", "0"}, {"t", ""}}, "n", "t")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_EQ(g_received.Text, "");
+}
+
+TEST(TestPackets, TestOptionalParameters) {
+    EXPECT_EQ((_Invoke<_HandleOptional>({{"s", "255"}, {"r", "0.5"}}, "s", "r")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_EQ(g_received.Small, 255);
+    EXPECT_EQ(g_received.Real, 0.5);
+
+    // the missing and unparsable ones are empty, the handler is still called
+    EXPECT_EQ((_Invoke<_HandleOptional>({}, "s", "r")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_EQ(g_received.Small, std::nullopt);
+    EXPECT_EQ(g_received.Real, std::nullopt);
+
+    EXPECT_EQ((_Invoke<_HandleOptional>({{"s", "256"}, {"r", "half"}}, "s", "r")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_EQ(g_received.Small, std::nullopt);
+    EXPECT_EQ(g_received.Real, std::nullopt);
+
+    EXPECT_EQ((_Invoke<_HandleOptional>({{"s", "-1"}, {"r", "2"}}, "s", "r")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Small, std::nullopt);
+    EXPECT_EQ(g_received.Real, 2.0);
+}
+
+TEST(TestPackets, TestFloatingPointParameters) {
+    EXPECT_EQ((_Invoke<_HandleFloat>({{"f", "-2.25e1"}}, "f")), HandleResult::ContinueHandling);
+    EXPECT_EQ(g_received.Calls, 1);
+    EXPECT_FLOAT_EQ(g_received.Single, -22.5f);
+
+    EXPECT_EQ((_Invoke<_HandleFloat>({{"f", "1.5f"}}, "f")), HandleResult::StopHandling);
+    EXPECT_EQ(g_received.Calls, 0);
+}
+
+TEST(TestPackets, TestParameterParsers) {
+    // the whole text has to be the number, without signs that from_chars does not take or whitespace
+    EXPECT_EQ(_Parse<int32_t>("2147483647"), 2147483647);
+    EXPECT_EQ(_Parse<int32_t>("-2147483648"), -2147483647 - 1);
+    EXPECT_EQ(_Parse<int32_t>("2147483648"), std::nullopt);
+    EXPECT_EQ(_Parse<int32_t>("+1"), std::nullopt);
+    EXPECT_EQ(_Parse<int32_t>(" 1"), std::nullopt);
+    EXPECT_EQ(_Parse<int32_t>("1 "), std::nullopt);
+    EXPECT_EQ(_Parse<int32_t>(""), std::nullopt);
+    EXPECT_EQ(_Parse<uint64_t>("18446744073709551615"), 18446744073709551615ull);
+    EXPECT_EQ(_Parse<uint32_t>("-1"), std::nullopt);
+    EXPECT_EQ(_Parse<uint8_t>("0"), 0);
+
+    EXPECT_EQ(_Parse<double>("3.25"), 3.25);
+    EXPECT_EQ(_Parse<double>("-1e3"), -1000.0);
+    EXPECT_EQ(_Parse<double>("7"), 7.0);
+    EXPECT_EQ(_Parse<double>("1e400"), std::nullopt);
+    EXPECT_EQ(_Parse<double>("."), std::nullopt);
+    EXPECT_EQ(_Parse<double>("1.5.2"), std::nullopt);
+    EXPECT_EQ(_Parse<double>(""), std::nullopt);
+    EXPECT_EQ(_Parse<float>("0.125"), 0.125f);
+}
+
+TEST(TestPackets, TestCollidingEvents) {
+    const auto player = std::make_shared<Player>(1);
+    player->PushEvents({{"h", 1}, {"other", 2}});
+
+    // the fields of the response win, the colliding events wait for the next response instead of being dropped
+    OutgoingPacket out;
+    out.GetWriter().Field("h", 0);
+
+    nlohmann::json response = _Poll(player, std::move(out));
+    EXPECT_EQ(response.at("h"), 0);
+    EXPECT_EQ(response.at("other"), 2);
+    EXPECT_TRUE(player->HasPendingEvents());
+
+    response = _Poll(player, {});
+    EXPECT_EQ(response.at("h"), 1);
+    EXPECT_EQ(response.count("other"), 0);
+    EXPECT_EQ(_Poll(player, {}).count("h"), 0);
+
+    // the newer events win over the restored ones
+    player->PushEvents({{"h", 3}});
+    out = {};
+    out.GetWriter().Field("h", 0);
+    EXPECT_EQ(_Poll(player, std::move(out)).at("h"), 0);
+
+    player->PushEvents({{"h", 4}});
+    EXPECT_EQ(_Poll(player, {}).at("h"), 4);
+}
+
+TEST(TestPackets, TestCollidingKick) {
+    const auto player = std::make_shared<Player>(1);
+    player->Kick("kicked");
+
+    // the kick replaces the response of the action, so its message is not lost to the error of the action
+    OutgoingPacket out;
+    out.GetWriter().Field("e", "The message cannot be sent");
+
+    const nlohmann::json response = _Poll(player, std::move(out));
+    EXPECT_EQ(response.at("t"), "stop");
+    EXPECT_EQ(response.at("e"), "kicked");
+    EXPECT_EQ(_Poll(player, {}).count("t"), 0);
+}
+
+TEST(TestPackets, TestKickThroughAsyncChain) {
+    ChatBroadcaster chat;
+    const auto player = std::make_shared<Player>(1);
+    player->SetChat(&chat);
+    chat.Join(*player);
+
+    const std::string browserToken = std::to_string(_Handle({player, "init", {{"initlvl", "1"}}}).at("browser_token").get<uint32_t>());
+
+    for (int level = 2; level <= 4; level++) {
+        _Handle({player, "init", {{"initlvl", std::to_string(level)}, {"browser_token", browserToken}}});
+    }
+
+    // kicked while the failing chat message waits for the main thread, the kick wins over its error
+    nlohmann::json response = _Handle({player, "chat", {{"c", ""}, {"browser_token", browserToken}}}, [&player]() {
+        player->Kick("kicked");
+    });
+
+    EXPECT_EQ(response.at("t"), "stop");
+    EXPECT_EQ(response.at("e"), "kicked");
+
+    // the later requests stop in the async chain, they still tell why
+    response = _Handle({player, "_", {{"browser_token", browserToken}}});
+    EXPECT_EQ(response.at("t"), "stop");
+    EXPECT_EQ(response.at("e"), "kicked");
+
+    chat.Leave(*player);
+}
+
+TEST(TestPackets, TestInitLevel1Hero) {
+    const auto player = std::make_shared<Player>(1);
+    player->Restore(R"({"hero":{"x":5,"y":7,"dir":2,"gold":123,"exp":456,"lvl":3,"honor":78,"stamina":9}})");
+
+    // the client starts from the persisted hero, not from the defaults
+    const nlohmann::json hero = _Handle({player, "init", {{"initlvl", "1"}}}).at("h");
+    EXPECT_EQ(hero.at("x"), 5);
+    EXPECT_EQ(hero.at("y"), 7);
+    EXPECT_EQ(hero.at("dir"), 2);
+    EXPECT_EQ(hero.at("gold"), 123);
+    EXPECT_EQ(hero.at("exp"), 456);
+    EXPECT_EQ(hero.at("lvl"), 3);
+    EXPECT_EQ(hero.at("honor"), 78);
+    EXPECT_EQ(hero.at("stamina"), 9);
+    EXPECT_EQ(hero.at("id"), 1);
+}
+
+namespace {
+    /**
+     * Sends the message through the WebSocket and reads the response to it.
+     */
+    nlohmann::json _Send(websocket::stream<tcp::socket>& client, const std::string& message) {
+        client.write(boost::asio::buffer(message));
+
+        boost::beast::flat_buffer buffer;
+        client.read(buffer);
+        return nlohmann::json::parse(boost::beast::buffers_to_string(buffer.data()));
+    }
+
+    /**
+     * Connects to the /engine WebSocket and initializes the player of the account.
+     *
+     * @return the browser token of the player
+     */
+    std::string _Initialize(websocket::stream<tcp::socket>& client, const tcp::endpoint& endpoint, uint64_t aid) {
+        client.next_layer().connect(endpoint);
+        client.handshake("localhost", "/engine");
+
+        const std::string prefix = "aid=" + std::to_string(aid) + "&t=init&initlvl=";
+        const std::string browserToken = std::to_string(_Send(client, prefix + "1").at("browser_token").get<uint32_t>());
+
+        for (int level = 2; level <= 4; level++) {
+            _Send(client, prefix + std::to_string(level) + "&browser_token=" + browserToken);
+        }
+
+        return browserToken;
+    }
+}
+
+TEST(TestPackets, TestWebSocketPush) {
+    // the game server freezes the handler tables, the test handlers have to be in them
+    _GetTestHandlers();
+
+    GameServerSettings settings{{{"127.0.0.1", 18196, 2}, true, 15, 15, 100, 8192, {}, {}, {}}, 100, {}, LoggingSeverity::Warning};
+    GameServer server(settings);
+    server.Start();
+
+    std::future<std::string> received = std::async(std::launch::async, [endpoint = tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 18196)]() {
+        boost::asio::io_context ioContext;
+        websocket::stream<tcp::socket> sender(ioContext);
+        websocket::stream<tcp::socket> recipient(ioContext);
+
+        const std::string browserToken = _Initialize(sender, endpoint, 1);
+        _Initialize(recipient, endpoint, 2);
+
+        sender.write(boost::asio::buffer("aid=1&t=chat&c=hello&browser_token=" + browserToken));
+
+        // the recipient sends nothing, the state changes of the sender joining the town may be pushed before the message
+        for (int i = 0; i < 10; i++) {
+            boost::beast::flat_buffer buffer;
+            recipient.read(buffer);
+
+            const nlohmann::json pushed = nlohmann::json::parse(boost::beast::buffers_to_string(buffer.data()));
+            if (pushed.contains("c"))
+                return pushed.at("c").dump();
+        }
+
+        return std::string();
+    });
+
+    // the test thread is the main thread of the game server
+    const DefaultClock::time_point deadline = PointInFuture<std::chrono::seconds>(10);
+    while (received.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready && !IsPast(deadline)) {
+        server.GetTicker()->DoTick();
+    }
+
+    // a message that never arrives fails the read once the server stops
+    server.Stop();
+    EXPECT_NE(received.get().find("hello"), std::string::npos) << "The chat message should be pushed without a request";
+}
+
+namespace {
+    /**
+     * Sends the engine packet as an HTTP request and reads the response to it.
+     */
+    nlohmann::json _Request(tcp::socket& client, const std::string& query) {
+        http::request<http::empty_body> request{http::verb::get, "/engine?" + query, 11};
+        request.set(http::field::host, "localhost");
+        http::write(client, request);
+
+        boost::beast::flat_buffer buffer;
+        http::response<http::string_body> response;
+        http::read(client, buffer, response);
+        return nlohmann::json::parse(response.body());
+    }
+
+    /**
+     * Initializes the player of the account through HTTP requests.
+     *
+     * @return the query string prefix of the following packets, with the account and the browser token
+     */
+    std::string _InitializeOverHttp(tcp::socket& client, const tcp::endpoint& endpoint, uint64_t aid) {
+        client.connect(endpoint);
+
+        const std::string prefix = "aid=" + std::to_string(aid);
+        const std::string browserToken = std::to_string(_Request(client, prefix + "&t=init&initlvl=1").at("browser_token").get<uint32_t>());
+
+        for (int level = 2; level <= 4; level++) {
+            _Request(client, prefix + "&t=init&initlvl=" + std::to_string(level) + "&browser_token=" + browserToken);
+        }
+
+        return prefix + "&browser_token=" + browserToken;
+    }
+}
+
+TEST(TestPackets, TestLongPoll) {
+    _GetTestHandlers();
+
+    GameServerSettings settings{{{"127.0.0.1", 18197, 2}, true, 15, 15, 100, 8192, {}, {}, {}}, 100, {}, LoggingSeverity::Warning, {true, 1}};
+    GameServer server(settings);
+    server.Start();
+
+    struct Result {
+        std::chrono::milliseconds IdleWait{};
+        bool IdleHasMessages = true;
+        std::chrono::milliseconds ReleasedWait{};
+        bool ReleasedHasMessages = false;
+    };
+
+    std::future<Result> result = std::async(std::launch::async, [endpoint = tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 18197)]() {
+        boost::asio::io_context ioContext;
+        tcp::socket poller(ioContext);
+        tcp::socket sender(ioContext);
+
+        const std::string senderPrefix = _InitializeOverHttp(sender, endpoint, 4);
+        const std::string pollerPrefix = _InitializeOverHttp(poller, endpoint, 3);
+        Result result;
+
+        // nothing happens, the poll waits for its deadline
+        const DefaultClock::time_point start = DefaultClock::now();
+        result.IdleHasMessages = _Request(poller, pollerPrefix + "&t=_").contains("c");
+        result.IdleWait = std::chrono::duration_cast<std::chrono::milliseconds>(DefaultClock::now() - start);
+
+        // the chat message marks the poller dirty, its poll is released by the end of the tick, long before the deadline
+        const DefaultClock::time_point parked = DefaultClock::now();
+        std::future<nlohmann::json> released = std::async(std::launch::async, [&poller, &pollerPrefix]() {
+            return _Request(poller, pollerPrefix + "&t=_");
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        _Request(sender, senderPrefix + "&t=chat&c=hello");
+        result.ReleasedHasMessages = released.get().contains("c");
+        result.ReleasedWait = std::chrono::duration_cast<std::chrono::milliseconds>(DefaultClock::now() - parked);
+        return result;
+    });
+
+    const DefaultClock::time_point deadline = PointInFuture<std::chrono::seconds>(10);
+    while (result.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready && !IsPast(deadline)) {
+        server.GetTicker()->DoTick();
+    }
+
+    server.Stop();
+
+    const Result received = result.get();
+    EXPECT_GE(received.IdleWait, std::chrono::milliseconds(900)) << "An idle poll should be released by its deadline";
+    EXPECT_FALSE(received.IdleHasMessages);
+    EXPECT_TRUE(received.ReleasedHasMessages);
+    EXPECT_LT(received.ReleasedWait, std::chrono::milliseconds(700)) << "A chat message should release the parked poll";
+}
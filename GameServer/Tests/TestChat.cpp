@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <GameServer/Chat.hpp>
+#include <GameServer/Player.hpp>
+#include <GameServer/Town.hpp>
+#include <nlohmann/json.hpp>
+
+using namespace Merrie;
+using namespace std::string_literals;
+
+namespace {
+    /**
+     * Takes the chat messages of the player, every one parsed into the message without its id.
+     */
+    std::vector<nlohmann::json> TakeMessages(Player& player) {
+        std::vector<nlohmann::json> messages;
+
+        for (const std::shared_ptr<const std::string>& message : player.TakeChatMessages()) {
+            const nlohmann::json object = nlohmann::json::parse(*message);
+            EXPECT_EQ(object.size(), 1);
+            messages.push_back(object.begin().value());
+        }
+
+        return messages;
+    }
+}
+
+TEST(TestChat, TestGlobal) {
+    ChatBroadcaster chat;
+    Player sender(1);
+    Player recipient(2);
+    Player left(3);
+
+    chat.Join(sender);
+    chat.Join(recipient);
+    chat.Join(left);
+    chat.Join(left); // joining twice does nothing
+    chat.Leave(left);
+
+    EXPECT_EQ(chat.GetPlayerCount(), 2);
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, sender, "hello"));
+    EXPECT_FALSE(chat.Send(ChatChannel::Global, sender, ""));
+
+    // all recipients share the same buffer
+    const auto senderMessages = sender.TakeChatMessages();
+    const auto recipientMessages = recipient.TakeChatMessages();
+
+    ASSERT_EQ(senderMessages.size(), 1);
+    ASSERT_EQ(recipientMessages.size(), 1);
+    EXPECT_EQ(senderMessages.front(), recipientMessages.front());
+    EXPECT_TRUE(left.TakeChatMessages().empty());
+
+    const nlohmann::json message = nlohmann::json::parse(*senderMessages.front()).begin().value();
+    EXPECT_EQ(message.at("k"), static_cast<int>(ChatChannel::Global));
+    EXPECT_EQ(message.at("n"), sender.GetCharacterName());
+    EXPECT_EQ(message.at("t"), "hello");
+}
+
+TEST(TestChat, TestTown) {
+    ChatBroadcaster chat;
+    Town town(1, 100, 100, 16);
+    Player sender(1);
+    Player neighbour(2);
+    Player outsider(3);
+
+    for (Player* player : {&sender, &neighbour, &outsider}) {
+        chat.Join(*player);
+    }
+
+    // the players of a town hear the message wherever they are in it
+    neighbour.SetPosition(99, 99);
+
+    for (Player* player : {&sender, &neighbour}) {
+        player->SetTown(&town);
+        town.Enter(*player);
+    }
+
+    EXPECT_FALSE(chat.Send(ChatChannel::Town, outsider, "nobody hears me"));
+    EXPECT_TRUE(chat.Send(ChatChannel::Town, sender, "hello town"));
+
+    const std::vector<nlohmann::json> messages = TakeMessages(neighbour);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages.front().at("k"), static_cast<int>(ChatChannel::Town));
+    EXPECT_EQ(messages.front().at("t"), "hello town");
+
+    EXPECT_EQ(TakeMessages(sender).size(), 1);
+    EXPECT_TRUE(TakeMessages(outsider).empty());
+}
+
+TEST(TestChat, TestWhisper) {
+    ChatBroadcaster chat;
+    Player sender(1);
+    Player recipient(2);
+    Player bystander(3);
+
+    for (Player* player : {&sender, &recipient, &bystander}) {
+        chat.Join(*player);
+    }
+
+    EXPECT_FALSE(chat.Send(ChatChannel::Whisper, sender, "anyone?", "User#404"));
+    EXPECT_TRUE(chat.Send(ChatChannel::Whisper, sender, "psst", recipient.GetCharacterName()));
+
+    // the sender gets a copy
+    const std::vector<nlohmann::json> messages = TakeMessages(recipient);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages.front().at("k"), static_cast<int>(ChatChannel::Whisper));
+    EXPECT_EQ(messages.front().at("nd"), recipient.GetCharacterName());
+    EXPECT_EQ(messages.front().at("t"), "psst");
+
+    EXPECT_EQ(TakeMessages(sender).size(), 1);
+    EXPECT_TRUE(TakeMessages(bystander).empty());
+
+    // whispering to yourself is delivered once
+    EXPECT_TRUE(chat.Send(ChatChannel::Whisper, sender, "echo", sender.GetCharacterName()));
+    EXPECT_EQ(TakeMessages(sender).size(), 1);
+}
+
+TEST(TestChat, TestQueueLimit) {
+    ChatBroadcaster chat;
+    Player player(1);
+    chat.Join(player);
+
+    for (size_t i = 0; i < Player::MaxQueuedChatMessages + 10; i++) {
+        EXPECT_TRUE(chat.Send(ChatChannel::Global, player, std::to_string(i)));
+    }
+
+    // the oldest messages are dropped
+    const std::vector<nlohmann::json> messages = TakeMessages(player);
+    ASSERT_EQ(messages.size(), Player::MaxQueuedChatMessages);
+    EXPECT_EQ(messages.front().at("t"), "10");
+    EXPECT_EQ(messages.back().at("t"), std::to_string(Player::MaxQueuedChatMessages + 9));
+}
+
+TEST(TestChat, TestTruncation) {
+    ChatBroadcaster chat;
+    Player player(1);
+    chat.Join(player);
+
+    // the two bytes of ż would be split at the limit
+    const std::string cut = std::string(ChatBroadcaster::MaxMessageLength - 1, 'a') + "żółć";
+    const std::string exact = std::string(ChatBroadcaster::MaxMessageLength - 2, 'a') + "ż";
+
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, player, cut));
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, player, exact));
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, player, exact + "a"));
+
+    const std::vector<nlohmann::json> messages = TakeMessages(player);
+    ASSERT_EQ(messages.size(), 3);
+    EXPECT_EQ(messages[0].at("t"), std::string(ChatBroadcaster::MaxMessageLength - 1, 'a'));
+    EXPECT_EQ(messages[1].at("t"), exact);
+    EXPECT_EQ(messages[2].at("t"), exact);
+
+    // nothing is left of a message that starts with a character cut in the middle
+    EXPECT_FALSE(chat.Send(ChatChannel::Global, player, std::string(ChatBroadcaster::MaxMessageLength + 1, '\x80')));
+}
+
+TEST(TestChat, TestInvalidUtf8) {
+    ChatBroadcaster chat;
+    Player player(1);
+    chat.Join(player);
+
+    // the messages are not serialized again by the responses, so they are rejected up front
+    for (const std::string& text : {"\xFF"s, "abc\xC3"s, "\xC3\x28"s, "\xC0\xAF"s, "\xED\xA0\x80"s, "\xF4\x90\x80\x80"s}) {
+        EXPECT_FALSE(chat.Send(ChatChannel::Global, player, text));
+    }
+
+    EXPECT_TRUE(player.TakeChatMessages().empty());
+
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, player, "żółć \xF0\x9F\x98\x80"));
+
+    const std::vector<nlohmann::json> messages = TakeMessages(player);
+    ASSERT_EQ(messages.size(), 1);
+    EXPECT_EQ(messages.front().at("t"), "żółć \xF0\x9F\x98\x80");
+}
+
+TEST(TestChat, TestLeave) {
+    ChatBroadcaster chat;
+    Player first(1);
+    Player second(2);
+    Player third(3);
+
+    for (Player* player : {&first, &second, &third}) {
+        chat.Join(*player);
+    }
+
+    // the last player takes the place of the first one
+    chat.Leave(first);
+    chat.Leave(first);
+    EXPECT_EQ(chat.GetPlayerCount(), 2);
+
+    EXPECT_FALSE(chat.Send(ChatChannel::Whisper, second, "gone", first.GetCharacterName()));
+    EXPECT_TRUE(chat.Send(ChatChannel::Whisper, second, "moved", third.GetCharacterName()));
+    EXPECT_EQ(TakeMessages(third).size(), 1);
+    EXPECT_TRUE(TakeMessages(first).empty());
+
+    // the moved player can leave too, the index of the remaining one stays valid
+    chat.Leave(third);
+    EXPECT_FALSE(chat.Send(ChatChannel::Whisper, second, "gone too", third.GetCharacterName()));
+
+    chat.Join(first);
+    EXPECT_TRUE(chat.Send(ChatChannel::Whisper, second, "back", first.GetCharacterName()));
+    EXPECT_TRUE(chat.Send(ChatChannel::Global, second, "all"));
+
+    EXPECT_EQ(TakeMessages(first).size(), 2);
+    EXPECT_TRUE(TakeMessages(third).empty());
+    EXPECT_EQ(chat.GetPlayerCount(), 2);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <GameServer/PlayerState.hpp>
+#include <nlohmann/json.hpp>
+
+using namespace Merrie;
+
+namespace {
+    /**
+     * Writes the delta of the response with the sequence into an object, empty if nothing was written.
+     */
+    nlohmann::json WriteDelta(PlayerState& state, StateSequence sequence) {
+        JsonWriter writer;
+        writer.BeginObject();
+        const bool written = state.WriteDelta(writer, sequence);
+        writer.EndObject();
+
+        const nlohmann::json delta = nlohmann::json::parse(writer.GetString());
+        EXPECT_EQ(written, !delta.empty());
+        return delta;
+    }
+}
+
+TEST(TestPlayerState, TestWriteDelta) {
+    PlayerState state;
+    EXPECT_FALSE(state.HasUnsentChanges());
+    EXPECT_TRUE(WriteDelta(state, 1).empty());
+
+    state.SetHeroField(HeroField::X, 10);
+    state.SetHeroField(HeroField::Gold, 500);
+    state.SetEntity(EntityCollection::Others, 42, R"({"nick":"User#42"})");
+    EXPECT_TRUE(state.HasUnsentChanges());
+
+    const nlohmann::json expected = nlohmann::json::parse(R"({"h":{"x":10,"gold":500},"other":{"42":{"nick":"User#42"}}})");
+    EXPECT_EQ(WriteDelta(state, 2), expected);
+    EXPECT_FALSE(state.HasUnsentChanges());
+
+    // the response may have been lost, the changes are sent again until they are acknowledged
+    EXPECT_EQ(WriteDelta(state, 3), expected);
+
+    state.Acknowledge(3);
+    EXPECT_EQ(state.GetAcknowledgedSequence(), 3);
+    EXPECT_TRUE(WriteDelta(state, 4).empty());
+
+    // setting the values that the client already has changes nothing
+    state.SetHeroField(HeroField::X, 10);
+    state.SetEntity(EntityCollection::Others, 42, R"({"nick":"User#42"})");
+    EXPECT_FALSE(state.HasUnsentChanges());
+    EXPECT_TRUE(WriteDelta(state, 5).empty());
+}
+
+TEST(TestPlayerState, TestAcknowledge) {
+    PlayerState state;
+
+    state.SetHeroField(HeroField::X, 1);
+    EXPECT_EQ(WriteDelta(state, 10).at("h").at("x"), 1);
+
+    // the change after the response is not acknowledged with it
+    state.SetHeroField(HeroField::X, 2);
+    state.SetHeroField(HeroField::Y, 3);
+    EXPECT_TRUE(state.HasUnsentChanges());
+    EXPECT_EQ(WriteDelta(state, 20), nlohmann::json::parse(R"({"h":{"x":2,"y":3}})"));
+
+    state.Acknowledge(10);
+    EXPECT_EQ(WriteDelta(state, 30), nlohmann::json::parse(R"({"h":{"x":2,"y":3}})"));
+
+    // the sequences that were not sent and the older ones are ignored
+    state.Acknowledge(31);
+    state.Acknowledge(5);
+    EXPECT_EQ(state.GetAcknowledgedSequence(), 10);
+    EXPECT_FALSE(WriteDelta(state, 40).empty());
+
+    state.Acknowledge(40);
+    EXPECT_TRUE(WriteDelta(state, 50).empty());
+}
+
+TEST(TestPlayerState, TestChangeListener) {
+    PlayerState state;
+    int calls = 0;
+    state.SetChangeListener([&calls]() {
+        calls++;
+    });
+
+    // called once the state gets unsent changes, not for every change
+    state.SetHeroField(HeroField::X, 1);
+    state.SetHeroField(HeroField::Y, 2);
+    state.SetHeroField(HeroField::X, 1);
+    EXPECT_EQ(calls, 1);
+
+    WriteDelta(state, 1);
+    state.SetEntity(EntityCollection::Npcs, 7, R"({"x":1})");
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(TestPlayerState, TestRemoveEntity) {
+    PlayerState state;
+
+    // removing an entity the client never got does nothing
+    state.RemoveEntity(EntityCollection::Npcs, 7);
+    EXPECT_FALSE(state.HasUnsentChanges());
+
+    state.SetEntity(EntityCollection::Npcs, 7, R"({"x":1})");
+    state.SetEntity(EntityCollection::Items, 8, R"({"x":2})");
+    WriteDelta(state, 1);
+    state.Acknowledge(1);
+
+    state.RemoveEntity(EntityCollection::Npcs, 7);
+    state.RemoveEntity(EntityCollection::Npcs, 7);
+    EXPECT_EQ(WriteDelta(state, 2), nlohmann::json::parse(R"({"npc":{"7":{"del":1}}})"));
+
+    state.Acknowledge(2);
+    EXPECT_TRUE(WriteDelta(state, 3).empty());
+
+    // the acknowledged removal is forgotten, the entity can come back
+    state.RemoveEntity(EntityCollection::Npcs, 7);
+    EXPECT_FALSE(state.HasUnsentChanges());
+
+    state.SetEntity(EntityCollection::Npcs, 7, R"({"x":1})");
+    EXPECT_EQ(WriteDelta(state, 4), nlohmann::json::parse(R"({"npc":{"7":{"x":1}}})"));
+
+    // a removal replaces the change that was not acknowledged yet
+    state.SetEntity(EntityCollection::Items, 8, R"({"x":3})");
+    state.RemoveEntity(EntityCollection::Items, 8);
+    EXPECT_EQ(WriteDelta(state, 5), nlohmann::json::parse(R"({"npc":{"7":{"x":1}},"item":{"8":{"del":1}}})"));
+}
+
+TEST(TestPlayerState, TestReset) {
+    PlayerState state;
+
+    state.SetHeroField(HeroField::Level, 5);
+    state.SetEntity(EntityCollection::Others, 1, R"({"x":1})");
+    state.SetEntity(EntityCollection::Others, 2, R"({"x":2})");
+    WriteDelta(state, 1);
+    state.Acknowledge(1);
+
+    state.RemoveEntity(EntityCollection::Others, 2);
+    WriteDelta(state, 2);
+
+    // a client that starts from scratch gets everything, but not the removals of what it never had
+    state.Reset();
+    EXPECT_TRUE(state.HasUnsentChanges());
+    EXPECT_EQ(state.GetAcknowledgedSequence(), 2);
+    EXPECT_EQ(WriteDelta(state, 3), nlohmann::json::parse(R"({"h":{"lvl":5},"other":{"1":{"x":1}}})"));
+
+    state.Acknowledge(3);
+    EXPECT_TRUE(WriteDelta(state, 4).empty());
+}
+
+TEST(TestPlayerState, TestSaveHero) {
+    PlayerState state;
+    state.SetHeroField(HeroField::X, 12);
+    state.SetHeroField(HeroField::Gold, 300);
+
+    const uint64_t version = state.GetHeroVersion();
+    state.SetHeroField(HeroField::Gold, 300);
+    EXPECT_EQ(state.GetHeroVersion(), version);
+
+    JsonWriter writer;
+    state.WriteHero(writer);
+    EXPECT_EQ(writer.GetString(), R"({"x":12,"gold":300})");
+
+    PlayerState restored;
+    EXPECT_FALSE(restored.RestoreHero(nlohmann::json::array()));
+    EXPECT_TRUE(restored.RestoreHero(nlohmann::json::parse(writer.GetString())));
+    EXPECT_EQ(WriteDelta(restored, 1), nlohmann::json::parse(R"({"h":{"x":12,"gold":300}})"));
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <GameServer/Player.hpp>
+#include <GameServer/Town.hpp>
+#include <nlohmann/json.hpp>
+#include <map>
+
+using namespace Merrie;
+
+namespace {
+    /**
+     * The other players as the client of the player sees them, kept up to date with the deltas of the player.
+     */
+    class OthersView {
+        public:
+            explicit OthersView(Player& player) : m_player(player) {
+            }
+
+            /**
+             * Applies the changes since the last call and gets the others by their ids.
+             */
+            const std::map<uint64_t, nlohmann::json>& Update() {
+                JsonWriter writer;
+                writer.BeginObject();
+                const StateSequence sequence = m_player.CreateResponseSequence();
+                const bool written = m_player.GetState().WriteDelta(writer, sequence);
+                writer.EndObject();
+
+                if (written) {
+                    m_player.GetState().Acknowledge(sequence);
+                    const nlohmann::json delta = nlohmann::json::parse(writer.GetString());
+
+                    if (delta.contains("other")) {
+                        for (const auto& [id, other] : delta.at("other").items()) {
+                            if (other.contains("del"))
+                                EXPECT_EQ(m_others.erase(std::stoull(id)), 1) << "Removed an other that was not seen";
+                            else
+                                m_others[std::stoull(id)] = other;
+                        }
+                    }
+                }
+
+                return m_others;
+            }
+
+        private:
+            Player& m_player;
+            std::map<uint64_t, nlohmann::json> m_others{};
+    };
+}
+
+TEST(TestTown, TestEnter) {
+    Town town(1, 100, 100, 10);
+    Player first(1);
+    Player second(2);
+    Player far(3);
+
+    first.SetPosition(10, 10);
+    second.SetPosition(15, 20);
+    far.SetPosition(50, 50);
+
+    OthersView firstView(first);
+    OthersView secondView(second);
+    OthersView farView(far);
+
+    town.Enter(first);
+    town.Enter(second);
+    town.Enter(far);
+    town.Enter(far); // entering twice does nothing
+
+    EXPECT_EQ(town.GetPlayerCount(), 3);
+
+    // the players in the range see each other, with the positions they have
+    const auto& firstOthers = firstView.Update();
+    ASSERT_EQ(firstOthers.size(), 1);
+    EXPECT_EQ(firstOthers.at(2).at("x"), 15);
+    EXPECT_EQ(firstOthers.at(2).at("y"), 20);
+    EXPECT_EQ(firstOthers.at(2).at("nick"), second.GetCharacterName());
+
+    const auto& secondOthers = secondView.Update();
+    ASSERT_EQ(secondOthers.size(), 1);
+    EXPECT_EQ(secondOthers.at(1).at("x"), 10);
+
+    EXPECT_TRUE(farView.Update().empty());
+
+    // the positions outside of the town are clamped
+    Player outside(4);
+    outside.SetPosition(-5, 500);
+    town.Enter(outside);
+    EXPECT_EQ(outside.GetPosition(), std::make_pair(0, 99));
+}
+
+TEST(TestTown, TestMove) {
+    Town town(1, 100, 100, 10);
+    Player walker(1);
+    Player left(2);
+    Player right(3);
+    Player stranger(4);
+
+    walker.SetPosition(20, 50);
+    left.SetPosition(12, 50);
+    right.SetPosition(32, 50);
+    stranger.SetPosition(20, 90);
+
+    OthersView walkerView(walker);
+    OthersView leftView(left);
+    OthersView rightView(right);
+    OthersView strangerView(stranger);
+
+    for (Player* player : {&walker, &left, &right, &stranger}) {
+        town.Enter(*player);
+    }
+
+    EXPECT_EQ(walkerView.Update().size(), 1);
+    EXPECT_EQ(leftView.Update().count(1), 1);
+    EXPECT_TRUE(rightView.Update().empty());
+    EXPECT_TRUE(strangerView.Update().empty());
+
+    // left stays in the range and sees the new position, right comes into it
+    town.Move(walker, 22, 50);
+
+    const auto& walkerOthers = walkerView.Update();
+    EXPECT_EQ(walkerOthers.size(), 2);
+    EXPECT_EQ(walkerOthers.count(2), 1);
+    EXPECT_EQ(walkerOthers.count(3), 1);
+    EXPECT_EQ(leftView.Update().at(1).at("x"), 22);
+    EXPECT_EQ(rightView.Update().at(1).at("x"), 22);
+
+    // left goes out of the range, right stays
+    town.Move(walker, 30, 50);
+
+    EXPECT_EQ(walkerView.Update().count(2), 0);
+    EXPECT_EQ(walkerView.Update().count(3), 1);
+    EXPECT_TRUE(leftView.Update().empty());
+    EXPECT_EQ(rightView.Update().at(1).at("x"), 30);
+
+    // all of them out and the stranger in at once
+    town.Move(walker, 20, 85);
+
+    const auto& strangerOthers = strangerView.Update();
+    EXPECT_EQ(walkerView.Update().size(), 1);
+    EXPECT_EQ(walkerView.Update().count(4), 1);
+    EXPECT_TRUE(rightView.Update().empty());
+    ASSERT_EQ(strangerOthers.size(), 1);
+    EXPECT_EQ(strangerOthers.at(1).at("y"), 85);
+
+    // a step that is clamped to the same position changes nothing
+    town.Move(walker, 20, 85);
+    EXPECT_FALSE(stranger.GetState().HasUnsentChanges());
+}
+
+TEST(TestTown, TestLeave) {
+    Town town(1, 100, 100, 10);
+    Player leaving(1);
+    Player first(2);
+    Player second(3);
+    Player far(4);
+
+    leaving.SetPosition(50, 50);
+    first.SetPosition(45, 45);
+    second.SetPosition(55, 54);
+    far.SetPosition(5, 5);
+
+    OthersView leavingView(leaving);
+    OthersView firstView(first);
+    OthersView secondView(second);
+    OthersView farView(far);
+
+    for (Player* player : {&leaving, &first, &second, &far}) {
+        town.Enter(*player);
+    }
+
+    EXPECT_EQ(leavingView.Update().size(), 2);
+    EXPECT_EQ(firstView.Update().size(), 2);
+    EXPECT_EQ(secondView.Update().size(), 2);
+
+    town.Leave(leaving);
+    town.Leave(leaving); // leaving twice does nothing
+
+    // every observer forgets the player, the player forgets the others
+    EXPECT_EQ(town.GetPlayerCount(), 3);
+    EXPECT_TRUE(leavingView.Update().empty());
+    EXPECT_EQ(firstView.Update().count(1), 0);
+    EXPECT_EQ(secondView.Update().count(1), 0);
+    EXPECT_EQ(firstView.Update().count(3), 1);
+    EXPECT_TRUE(farView.Update().empty());
+
+    // the ones that stayed do not see the player when they move around it
+    town.Move(first, 50, 50);
+    EXPECT_EQ(firstView.Update().count(1), 0);
+    EXPECT_EQ(town.GetPlayerCount(), 3);
+}